@@ -5,8 +5,17 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Delta.h"
+#include "ROBO_WCOM_Publisher.h"
+#include "ROBO_WCOM_Recorder.h"
+#include "ROBO_WCOM_Trace.h"
+#include "ROBO_WCOM_Bridge.h"
+#include "ROBO_WCOM_Rpc.h"
+#include "ROBO_WCOM_Param.h"
+#include "ROBO_WCOM_Hello.h"
 #include <controller_packet.h>
 #include <robo_packet.h>
+#include <packet_codec.h>
 
 
 //---------------------------------------------
@@ -16,23 +25,57 @@ uint8_t MACADDRESS_BOARD_CONTROLLER[6] = {  0x08, 0xB6, 0x1F, 0xEE, 0x42, 0xF4};
 uint8_t MACADDRESS_BOARD_ROBO[6] = {        0xEC, 0xE3, 0x34, 0xD1, 0x36, 0xBC};
 
 
+/** ブリッジモード **/
+// 1 にすると受信データを文字列にせず、バイナリのまま PC へ中継する（PC側は tools/bridge/ で受信）
+// 指令も PC から送るため、loop() での指令生成は行わない
+#define CONFORG_BRIDGE_MODE     0
+#define CONFORG_BRIDGE_BAUD     921600
+#define CONFORG_BRIDGE_PRD_MS   5
+
+/** 問い合わせ **/
+#define CONFORG_RPC_PRD_MS      1000    // ロボットの電源情報を問い合わせる周期
+#define CONFORG_RPC_TIMEOUT_MS  200     // 応答を待つ時間
+
+/** パラメータ **/
+#define CONFORG_MOTOR_LIMIT     80.0f   // ロボットのモータ出力の上限
+#define CONFORG_PARAM_RETRY_MS  100     // パラメータ同期の再送間隔
+
+/** ハンドシェイク **/
+#define CONFORG_HELLO_RETRY_MS  200     // 通知を送り直す間隔
+#define CONFORG_HELLO_ATTEMPTS  5       // 応答がなければ従来版のロボットとみなす通知回数
+
 /** モータ配列のインデックス値 **/
 #define MOTOR_CH_FL 0
 #define MOTOR_CH_FR 1
 #define MOTOR_CH_RL 2
 #define MOTOR_CH_RR 3
 
-void statusViewer(void* pvParameters);  // ROBO側のステータスを取得して表示
+void statusViewer(void* pvParameters);  // ROBO側のステータスを取得して記録
+void dumpRecorderIfRequested(void);     // 要求時・途絶時に記録をダンプ
+void bridgeTask(void* pvParameters);    // 受信データを PC へ中継
+void onPowerReply(ROBO_WCOM::RpcHandle handle, ROBO_WCOM::Status status,
+                  const uint8_t* reply, uint8_t replySize, void* context); // 電源情報の応答
 TaskHandle_t thp[1];                    // タスクハンドラ
 
 RoboCommand_t sendCommand;                // 送信するコマンド
 RoboStatus_t rcvStatus;                   // 受信したステータス
+ROBO_WCOM::DeltaDecoder<RoboStatusCompact> statusDecoder; // ステータスの差分復元
+uint8_t rcvFrame[ROBO_WCOM::CARRIED_DATA_MAX_SIZE];        // 受信した差分フレーム
 uint32_t rcvTimeStamp;                  // 受信したロボット側の時刻
 uint8_t rcvAddress[6];                  // 受信したロボット側のアドレス
 uint8_t rcvSize;                        // 受信したデータのサイズ
 
 void setup()
 {
+#if CONFORG_BRIDGE_MODE
+    // 送信リングバッファを広げ、まとめて書き出したメッセージをそのまま受け取れるようにする
+    Serial.setTxBufferSize(4096);
+    Serial.begin(CONFORG_BRIDGE_BAUD);
+    ROBO_WCOM::Init(MACADDRESS_BOARD_CONTROLLER, MACADDRESS_BOARD_ROBO, millis(), 1000);
+    ROBO_WCOM::BridgeBegin(Serial);
+    xTaskCreateUniversal(bridgeTask, "Bridge", 4096, nullptr, 1, nullptr, tskNO_AFFINITY);
+    return;
+#endif
     Serial.begin(115200);
     Serial.println("Board Boot");
     Serial.println("==== THIS IS CONTROLLER ====");
@@ -50,6 +93,18 @@ void setup()
     auto initStatus = ROBO_WCOM::Init(MACADDRESS_BOARD_CONTROLLER, MACADDRESS_BOARD_ROBO, millis(), 1000);
     Serial.print("Controller started. : Status=");
     Serial.println(ROBO_WCOM::ToString(initStatus));
+
+    // 指令は20ms周期でタイマから送信し、変化がなければ200msごとにハートビートのみ送る
+    ROBO_WCOM::PublisherStart(20000, 200);
+    // 通信途絶で記録を止める設定は、リンクが一度確立してから dumpRecorderIfRequested() で有効にする
+    // ロボットへの問い合わせ（RPC）を使う
+    ROBO_WCOM::RpcBegin();
+    // 調整用のパラメータは指令に載せず、変更時だけロボットへ送る
+    ROBO_WCOM::ParamBegin(CONFORG_PARAM_RETRY_MS);
+    ROBO_WCOM::ParamSetFloat(ROBO_PARAM_MOTOR_LIMIT, CONFORG_MOTOR_LIMIT);
+    // ロボットの版に合わせて送信形式を選ぶ（従来版のロボットにも従来形式で送り続ける）
+    ROBO_WCOM::HelloConfig helloConfig = { CONFORG_HELLO_RETRY_MS, CONFORG_HELLO_ATTEMPTS, ROBO_WCOM::Wire::HELLO_CAPS_ALL };
+    ROBO_WCOM::HelloBegin(helloConfig);
 }
 
 /**
@@ -59,7 +114,7 @@ void setup()
  */
 void statusViewer(void* pvParameters)
 {
-    char reportedString[128];
+    float logFields[ROBO_WCOM::Record::FIELD_MAX];
     TickType_t lastWake = xTaskGetTickCount();
     // 実行周期=50ms
     const TickType_t period = pdMS_TO_TICKS(50);
@@ -70,7 +125,7 @@ void statusViewer(void* pvParameters)
         // ロボット側からの受信データをバッファから取り出す
         for (;;)
         {
-            readBufferStatus = ROBO_WCOM::PopOldestPacket(millis(), &rcvTimeStamp, rcvAddress, reinterpret_cast<uint8_t*>(&rcvStatus), &rcvSize);
+            readBufferStatus = ROBO_WCOM::PopOldestPacket(millis(), &rcvTimeStamp, rcvAddress, rcvFrame, &rcvSize);
             // バッファからデータを取り出せなくなったら受信を中止
             if (readBufferStatus == ROBO_WCOM::Status::BufferEmpty)
             {
@@ -80,22 +135,29 @@ void statusViewer(void* pvParameters)
             else if (readBufferStatus == ROBO_WCOM::Status::Timeout)
             {
                 Serial.println("CONNECTION REFUSE");
+                ROBO_WCOM::RecorderLog(ROBO_WCOM::Record::Kind::Received, readBufferStatus, 0, 0, nullptr, 0);
                 break;
             }
-            // CRCエラーの場合エラーを通知
+            // CRCエラーの場合はエラーとして記録する
             else if (readBufferStatus == ROBO_WCOM::Status::CrcError)
             {
-                Serial.println("!!CRC ERROR!!");
+                ROBO_WCOM::RecorderLog(ROBO_WCOM::Record::Kind::Received, readBufferStatus, rcvTimeStamp, rcvSize, nullptr, 0);
+            }
+            // キーフレーム未受信などで復元できない場合は読み飛ばす
+            else if (!statusDecoder.decode(rcvFrame, rcvSize, rcvStatus))
+            {
+                continue;
             }
-            // 正常に受信できているならデータを
+            // 正常に受信できているならデータの要点を記録する
             else
             {
-                snprintf(reportedString, 128, "Time,%ld,POWER,%f,%f,%f,MOTORS,%f,%f,%f,%f,FLAGS,%0x,%0x",
-                                                rcvTimeStamp,
-                                                rcvStatus.Power.voltage, rcvStatus.Power.current, rcvStatus.Power.wh,
-                                                rcvStatus.motors[MOTOR_CH_FL], rcvStatus.motors[MOTOR_CH_FR], rcvStatus.motors[MOTOR_CH_RL], rcvStatus.motors[MOTOR_CH_RR],
-                                                rcvStatus.WEAPON_FLAGS.FLAGS, rcvStatus.MANSWICH.SWITCHES);
-                Serial.println(reportedString);
+                WCOM_TRACE(Handoff, rcvTimeStamp, 0);
+                logFields[0] = rcvStatus.Power.voltage;
+                logFields[1] = rcvStatus.Power.current;
+                logFields[2] = rcvStatus.motors[MOTOR_CH_FL];
+                logFields[3] = rcvStatus.motors[MOTOR_CH_FR];
+                ROBO_WCOM::RecorderLog(ROBO_WCOM::Record::Kind::Received, readBufferStatus, rcvTimeStamp, rcvSize,
+                                       logFields, ROBO_WCOM::Record::FIELD_MAX);
             }
         }
         vTaskDelayUntil(&lastWake, period);
@@ -113,6 +175,11 @@ void loop(void)
 {
     char cmdString[32];
     uint32_t nowMillis;
+#if CONFORG_BRIDGE_MODE
+    // ブリッジモードでは指令は PC から届く
+    delay(1000);
+    return;
+#endif
     // 武器フラグは乱数にしておく
     wp = random(0, 0xFF);
     // vx, vyを -100~100の間で増減させる
@@ -152,16 +219,108 @@ void loop(void)
         vw_mode = false;
     }
     
-    // ロボット側へ送信するデータをまとめて送信
+    // ロボット側へ送信するデータをまとめて登録（送信はパブリッシャが周期的に行う）
     sendCommand.velocity.x = vx;
     sendCommand.velocity.y = 0;
     sendCommand.velocity.omega = vw;
     sendCommand.WEAPON_FLAGS.FLAGS = wp;
     nowMillis = millis();
-    ROBO_WCOM::SendPacket(nowMillis, reinterpret_cast<uint8_t*>(&sendCommand), sizeof(RoboCommand_t));
+    ROBO_WCOM::PublisherUpdate(reinterpret_cast<uint8_t*>(&sendCommand), sizeof(RoboCommand_t));
+
+    // 電源情報を定期的に問い合わせる（応答は RpcService() からコールバックで届く）
+    static uint32_t lastRpcMillis = 0;
+    if (nowMillis - lastRpcMillis >= CONFORG_RPC_PRD_MS)
+    {
+        lastRpcMillis = nowMillis;
+        ROBO_WCOM::RpcCall(ROBO_RPC_READ_POWER, nullptr, 0, nowMillis, CONFORG_RPC_TIMEOUT_MS,
+                           onPowerReply, nullptr, nullptr);
+    }
+    ROBO_WCOM::RpcService(nowMillis);
+    ROBO_WCOM::ParamService(nowMillis);
+    ROBO_WCOM::HelloService(nowMillis);
     
-    // デバッグ用に送信した時刻だけ表示する
+    // デバッグ用に登録した時刻だけ表示する
     snprintf(cmdString, 32, "<< SEND CMD : %ld >>", nowMillis);
     Serial.println(cmdString);
+    dumpRecorderIfRequested();
     delay(20);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 電源情報の問い合わせに対する応答
+ */
+void onPowerReply(ROBO_WCOM::RpcHandle, ROBO_WCOM::Status status, const uint8_t* reply, uint8_t replySize, void*)
+{
+    float power[3];
+    if (status != ROBO_WCOM::Status::Ok || replySize != sizeof(power))
+    {
+        Serial.print("<< POWER : ");
+        Serial.print(ROBO_WCOM::ToString(status));
+        Serial.println(" >>");
+        return;
+    }
+    char powerString[48];
+    memcpy(power, reply, sizeof(power));
+    snprintf(powerString, sizeof(powerString), "<< POWER : %.2fV %.2fA %.4fWh >>", power[0], power[1], power[2]);
+    Serial.println(powerString);
+}
+
+/**
+ * @brief 'D' を受信したとき、または途絶で記録が止まったときに記録をダンプする
+ * @details
+ * ダンプはバイナリなので tools/wcom_rec2csv.cpp で CSV に変換する。
+ * 'T' を受信したときはトレース（-DROBO_WCOM_TRACE=1 でビルドした場合）をダンプして消去する。
+ * こちらは tools/wcom_trace2json.cpp で Chrome / Perfetto のトレース形式に変換する
+ */
+void dumpRecorderIfRequested(void)
+{
+    static bool failsafeArmed = false;
+    bool requested = false;
+    while (Serial.available() > 0)
+    {
+        int c = Serial.read();
+        if (c == 'D')
+        {
+            requested = true;
+        }
+        else if (c == 'T')
+        {
+            ROBO_WCOM::TraceDump(Serial);
+            ROBO_WCOM::TraceClear();
+        }
+    }
+    // 起動直後の未接続を途絶として記録を止めないよう、リンクが確立してから途絶の検出を有効にする
+    if (!failsafeArmed && ROBO_WCOM::GetLinkState() == ROBO_WCOM::LinkState::Up)
+    {
+        ROBO_WCOM::RecorderSetFreezeOnFailsafe(true);
+        failsafeArmed = true;
+    }
+    bool failsafe = ROBO_WCOM::RecorderIsFrozen();
+    if (requested || failsafe)
+    {
+        ROBO_WCOM::RecorderDump(Serial);
+    }
+    if (failsafe)
+    {
+        // ダンプしたら記録を再開し、リンクが再び確立してから次の途絶に備える
+        ROBO_WCOM::RecorderSetFreezeOnFailsafe(false);
+        ROBO_WCOM::RecorderFreeze(false);
+        failsafeArmed = false;
+    }
+}
+
+/**
+ * @brief 受信データを PC へ中継するタスク
+ *
+ * @param pvParameters
+ */
+void bridgeTask(void* pvParameters)
+{
+    TickType_t lastWake = xTaskGetTickCount();
+    const TickType_t period = pdMS_TO_TICKS(CONFORG_BRIDGE_PRD_MS);
+    for (;;)
+    {
+        ROBO_WCOM::BridgeService(millis());
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
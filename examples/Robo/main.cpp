@@ -5,14 +5,33 @@
 #include <stdio.h>
 #include <string.h>
 #include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Delta.h"
+#include "ROBO_WCOM_Publisher.h"
+#include "ROBO_WCOM_Recorder.h"
+#include "ROBO_WCOM_Rpc.h"
+#include "ROBO_WCOM_Param.h"
+#include "ROBO_WCOM_Rate.h"
+#include "ROBO_WCOM_Trace.h"
+#include "ROBO_WCOM_Hello.h"
 #include <robo_packet.h>
 #include <controller_packet.h>
+#include <packet_codec.h>
 
 #define CH_IRQ_TIMER    1
 #define CONFORG_TIMER_DIV       80
 #define CONFORG_TIMER_PRD_10MS  10000
 #define CONFORG_TASK0_PRD_US    20000
 #define CONFORG_TASK1_PRD_US    20000
+#define CONFORG_KEYFRAME_INTERVAL   20      // 20フレーム(1秒)ごとにキーフレーム
+#define CONFORG_PUBLISH_PRD_US      50000   // ステータス送信周期
+#define CONFORG_HEARTBEAT_MS        500     // 変化がない場合のハートビート間隔
+#define CONFORG_ROBOT_ID            0       // 一斉送信（SendFleetPacket）で受け取るロボットID
+#define CONFORG_MOTOR_LIMIT         100.0f  // モータ出力の上限の初期値（コントローラから書き換えられる）
+#define CONFORG_PARAM_RETRY_MS      100     // パラメータ同期の再送間隔
+#define CONFORG_HELLO_RETRY_MS      200     // ハンドシェイクの通知を送り直す間隔
+#define CONFORG_HELLO_ATTEMPTS      5       // 応答がなければ従来版のコントローラとみなす通知回数
+#define CONFORG_RX_TASK_CORE        0       // 受信処理を行うコア（指令を使う MainTaskCore0 と同じ）
+#define CONFORG_RX_TASK_PRIORITY    3       // 受信タスクの優先度（MainTaskCore0 より高くする）
 
 //---------------------------------------------
 //  タスクハンドラ
@@ -44,10 +63,16 @@ uint16_t sw_flg;
 /**送受信するデータ**/
 RoboCommand_t rcvCommand;
 RoboStatus_t sendStatus;
+ROBO_WCOM::DeltaEncoder<RoboStatusCompact> statusEncoder(CONFORG_KEYFRAME_INTERVAL); // パブリッシャの周期処理からのみ使う
+static_assert(sizeof(RoboStatus_t) <= ROBO_WCOM::CARRIED_DATA_MAX_SIZE, "RoboStatus_t must fit in one packet");
+static_assert(ROBO_WCOM::DeltaEncoder<RoboStatusCompact>::MAX_FRAME_SIZE <= ROBO_WCOM::CARRIED_DATA_MAX_SIZE, "Status frame must fit in one packet");
 
 void MainTaskCore0(void *pvParameters);
 void MainTaskCore1(void *pvParameters);
 void TimerInterrupt(void);
+void dumpRecorderIfRequested(void);
+uint8_t encodeStatus(const uint8_t* data, uint8_t size, uint8_t* out);
+ROBO_WCOM::Status rpcReadPower(const uint8_t* args, uint8_t argSize, uint8_t* reply, uint8_t* replySize);
 
 void setup()
 {
@@ -58,6 +83,33 @@ void setup()
     auto initStatus = ROBO_WCOM::Init(MACADDRESS_BOARD_ROBO, MACADDRESS_BOARD_CONTROLLER, millis(), 1000);
     Serial.print("Communication started. : Status=");
     Serial.println(ROBO_WCOM::ToString(initStatus));
+    // 受信処理は Wi-Fiタスクではなく、指令を使うコアの受信タスクで行う
+    // （-DROBO_WCOM_RECEIVE_TASK_FRAMES を指定していなければ TaskFail となり、従来どおり受信コールバックで処理する）
+    ROBO_WCOM::ReceiveTaskConfig rxTaskConfig = { CONFORG_RX_TASK_CORE, CONFORG_RX_TASK_PRIORITY, 4096 };
+    auto rxTaskStatus = ROBO_WCOM::StartReceiveTask(rxTaskConfig);
+    Serial.print("Receive task : Status=");
+    Serial.println(ROBO_WCOM::ToString(rxTaskStatus));
+    // コントローラが複数台へ一斉送信した場合は、このIDの指令だけを受け取る
+    ROBO_WCOM::SetRobotId(CONFORG_ROBOT_ID);
+    // ステータスは差分のみ送るので、コントローラが対応していれば可変長フレームで送信する
+    // （従来版のコントローラなら従来形式のまま。切り替えは loop() の HelloService() で行う）
+    ROBO_WCOM::HelloConfig helloConfig = { CONFORG_HELLO_RETRY_MS, CONFORG_HELLO_ATTEMPTS, ROBO_WCOM::Wire::HELLO_CAPS_ALL };
+    ROBO_WCOM::HelloBegin(helloConfig);
+    // ステータスはテレメトリとして送り、チャネルが混雑したら間引いて指令の受信を優先する
+    ROBO_WCOM::RateConfig rateConfig = { 1000000 / CONFORG_PUBLISH_PRD_US, 2, 1, 50, 20, 3, 500 };
+    ROBO_WCOM::SetRateConfig(rateConfig);
+    ROBO_WCOM::SetRateControl(true);
+    ROBO_WCOM::PublisherSetClass(ROBO_WCOM::TrafficClass::Telemetry);
+    // 差分符号化は実際に送る周期で行い、間引かれた周期のキーフレームを捨てないようにする
+    ROBO_WCOM::PublisherSetEncoder(encodeStatus);
+    ROBO_WCOM::PublisherStart(CONFORG_PUBLISH_PRD_US, CONFORG_HEARTBEAT_MS);
+    // 通信途絶で記録を止める設定は、リンクが一度確立してから dumpRecorderIfRequested() で有効にする
+    // コントローラからの問い合わせに応答する（処理は loop() の RpcService() で行う）
+    ROBO_WCOM::RpcBegin();
+    ROBO_WCOM::RpcRegister(ROBO_RPC_READ_POWER, rpcReadPower);
+    // 調整用のパラメータはコントローラから変更時だけ届く
+    ROBO_WCOM::ParamDefineFloat(ROBO_PARAM_MOTOR_LIMIT, CONFORG_MOTOR_LIMIT);
+    ROBO_WCOM::ParamBegin(CONFORG_PARAM_RETRY_MS);
 
     hwtimer = timerBegin(CH_IRQ_TIMER, CONFORG_TIMER_DIV, true);
     timerAttachInterrupt(hwtimer, &TimerInterrupt, true);
@@ -82,15 +134,6 @@ void setup()
 void loop()
 {
     uint32_t nowMillis = millis();
-    char loggingString[128];
-    // コントローラ側に送り返すデータをローカルでも表示しておく
-    snprintf(loggingString, 128,    "RoboTime,%ld,POWER,%f,%f,%f,MOTORS,%f,%f,%f,%f,FLAGS,0x%02X,0x%04X",
-                                    nowMillis,
-                                    battery_voltage, power_current, wh,
-                                    motor_power[MOTOR_CH_FL], motor_power[MOTOR_CH_FR], motor_power[MOTOR_CH_RL], motor_power[MOTOR_CH_RR], 
-                                    wp_flg, sw_flg);
-    Serial.println(loggingString);
-    
     // コントローラ側へ送信するデータをまとめる
     sendStatus.Power.voltage = battery_voltage;
     sendStatus.Power.current = power_current;
@@ -101,14 +144,111 @@ void loop()
     sendStatus.motors[MOTOR_CH_RR] = motor_power[MOTOR_CH_RR];
     sendStatus.WEAPON_FLAGS.FLAGS = wp_flg;
     sendStatus.MANSWICH.SWITCHES = sw_flg;
-    ROBO_WCOM::SendPacket(millis(), reinterpret_cast<uint8_t*>(&sendStatus), sizeof(sendStatus));
+    // 最新のステータスを登録する（差分符号化と送信はパブリッシャが周期的に行う）
+    auto updateStatus = ROBO_WCOM::PublisherUpdate(reinterpret_cast<const uint8_t*>(&sendStatus), sizeof(sendStatus));
+
+    // 文字列整形はせず、送り返すデータの要点をレコーダへ記録しておく
+    float logFields[ROBO_WCOM::Record::FIELD_MAX] = {
+        battery_voltage, power_current, motor_power[MOTOR_CH_FL], motor_power[MOTOR_CH_FR]
+    };
+    ROBO_WCOM::RecorderLog(ROBO_WCOM::Record::Kind::Sent, updateStatus, nowMillis, sizeof(sendStatus),
+                           logFields, ROBO_WCOM::Record::FIELD_MAX);
+    ROBO_WCOM::RpcService(nowMillis);
+    ROBO_WCOM::ParamService(nowMillis);
+    ROBO_WCOM::HelloService(nowMillis);
+    dumpRecorderIfRequested();
     delay(50);
 }
 
+/**
+ * @brief 登録したステータスを前回のキーフレームからの差分へ符号化する
+ * @details パブリッシャが送信する周期にだけ呼ばれる。変化したフィールドのみ送る
+ */
+uint8_t encodeStatus(const uint8_t* data, uint8_t size, uint8_t* out)
+{
+    RoboStatus_t status;
+    if (size != sizeof(status))
+    {
+        return 0;
+    }
+    memcpy(&status, data, sizeof(status));
+    return static_cast<uint8_t>(statusEncoder.encode(status, out));
+}
+
+/**
+ * @brief 電源情報の問い合わせに応答する
+ */
+ROBO_WCOM::Status rpcReadPower(const uint8_t*, uint8_t, uint8_t* reply, uint8_t* replySize)
+{
+    float power[3] = { battery_voltage, power_current, wh };
+    memcpy(reply, power, sizeof(power));
+    *replySize = sizeof(power);
+    return ROBO_WCOM::Status::Ok;
+}
+
+/**
+ * @brief 'D' を受信したとき、または途絶で記録が止まったときに記録をダンプする
+ * @details
+ * ダンプはバイナリなので tools/wcom_rec2csv.cpp で CSV に変換する。
+ * 'T' を受信したときはトレース（-DROBO_WCOM_TRACE=1 でビルドした場合）をダンプして消去する。
+ * こちらは tools/wcom_trace2json.cpp で Chrome / Perfetto のトレース形式に変換する
+ */
+void dumpRecorderIfRequested(void)
+{
+    static bool failsafeArmed = false;
+    bool requested = false;
+    while (Serial.available() > 0)
+    {
+        int c = Serial.read();
+        if (c == 'D')
+        {
+            requested = true;
+        }
+        else if (c == 'T')
+        {
+            ROBO_WCOM::TraceDump(Serial);
+            ROBO_WCOM::TraceClear();
+        }
+    }
+    // 起動直後の未接続を途絶として記録を止めないよう、リンクが確立してから途絶の検出を有効にする
+    if (!failsafeArmed && ROBO_WCOM::GetLinkState() == ROBO_WCOM::LinkState::Up)
+    {
+        ROBO_WCOM::RecorderSetFreezeOnFailsafe(true);
+        failsafeArmed = true;
+    }
+    bool failsafe = ROBO_WCOM::RecorderIsFrozen();
+    if (requested || failsafe)
+    {
+        ROBO_WCOM::RecorderDump(Serial);
+    }
+    if (failsafe)
+    {
+        // ダンプしたら記録を再開し、リンクが再び確立してから次の途絶に備える
+        ROBO_WCOM::RecorderSetFreezeOnFailsafe(false);
+        ROBO_WCOM::RecorderFreeze(false);
+        failsafeArmed = false;
+    }
+}
+
 /** Measurement **/
 /**計測関係は同時性が大事なのでハードウェア割り込みに入れておく**/
 void TimerInterrupt(void)
 {
+    // 通信が途絶したら、制御タスクを待たずに次の割り込み（10ms）でモータを止める
+    // 割り込みからはロックを取らない PeekLatestPacketFromISR() だけを使う
+    static uint8_t isrFrame[ROBO_WCOM::RECEIVE_PAYLOAD_MAX];
+    uint32_t isrTimeStamp;
+    uint8_t isrAddress[6];
+    uint8_t isrSize;
+    auto isrStatus = ROBO_WCOM::PeekLatestPacketFromISR(millis(), &isrTimeStamp, isrAddress, isrFrame, &isrSize);
+    if (isrStatus == ROBO_WCOM::Status::Timeout)
+    {
+        motor_power[MOTOR_CH_FL] = 0;
+        motor_power[MOTOR_CH_FR] = 0;
+        motor_power[MOTOR_CH_RL] = 0;
+        motor_power[MOTOR_CH_RR] = 0;
+    }
+
     // 仮想的に電流を計測したことにする(モータが動けば電流を消費するイメージ)
     float current = (   motor_power[MOTOR_CH_FL] * motor_power[MOTOR_CH_FL] +
                         motor_power[MOTOR_CH_FR] * motor_power[MOTOR_CH_FR] +
@@ -138,11 +278,15 @@ void MainTaskCore0(void *pvParameters)
         auto rcvStatus = ROBO_WCOM::PeekLatestPacket(millis(), &rcvTimeStamp, controllerAddress, reinterpret_cast<uint8_t*>(&rcvCommand), &rcvSize);
         if (rcvStatus == ROBO_WCOM::Status::Ok)
         {
-            motor_power[MOTOR_CH_FL] = rcvCommand.velocity.x - rcvCommand.velocity.omega;
-            motor_power[MOTOR_CH_FR] = rcvCommand.velocity.x + rcvCommand.velocity.omega;
+            float limit = CONFORG_MOTOR_LIMIT;
+            ROBO_WCOM::ParamGetFloat(ROBO_PARAM_MOTOR_LIMIT, &limit);
+            motor_power[MOTOR_CH_FL] = constrain(rcvCommand.velocity.x - rcvCommand.velocity.omega, -limit, limit);
+            motor_power[MOTOR_CH_FR] = constrain(rcvCommand.velocity.x + rcvCommand.velocity.omega, -limit, limit);
             motor_power[MOTOR_CH_RL] = motor_power[MOTOR_CH_FL];
             motor_power[MOTOR_CH_RR] = motor_power[MOTOR_CH_FR];
             wp_flg = rcvCommand.WEAPON_FLAGS.FLAGS;
+            // 指令がモータ出力へ反映された時点（トレースの終点）
+            WCOM_TRACE(Handoff, rcvTimeStamp, 0);
         }
         // 正常な受信ができていない場合モータを止めておく
         else
@@ -1,36 +1,250 @@
 #include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_Wire.h"
+#include "ROBO_WCOM_Capture.h"
+#include "ROBO_WCOM_Rate.h"
+#include "ROBO_WCOM_Trace.h"
+#include "ROBO_WCOM_Ring.h"
+#include "ROBO_WCOM_ByteRing.h"
 #include <WiFi.h>
 #include <esp_now.h>
 #include <cstring>
+#include <cstddef>
+#include <atomic>
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <mutex>
+#endif
+
+/**
+ * @brief 受信タスクを使えるか
+ */
+#if defined(ESP_PLATFORM) && ROBO_WCOM_RECEIVE_TASK_FRAMES > 0
+#define ROBO_WCOM_HAS_RECEIVE_TASK 1
+#else
+#define ROBO_WCOM_HAS_RECEIVE_TASK 0
+#endif
 
 namespace ROBO_WCOM
 {
 
     /**
-     * @brief 送受信パケット構造（CRC付き）
+     * @brief 受信バッファに保持するパケット
+     * @details CRCは受信時に送信形式のバイト列に対して検証し、結果のみを保持する
      */
-    struct __attribute__((packed)) Packet {
+    struct Packet {
         PacketData data; ///< データ部
-        uint32_t crc32;  ///< CRC32値
+        bool crcOk;      ///< CRC検証結果
+    };
+
+    /**
+     * @brief 割り込みから読む最新パケットの控え
+     * @details 受信バッファのスロットと同じく RECEIVE_PAYLOAD_MAX を超える搬送データは保持せず、CRCエラーとして扱う
+     */
+    struct LatestCopy {
+        uint32_t timestamp;                         ///< タイムスタンプ
+        uint8_t  address[6];                        ///< 送信元MAC
+        uint8_t  carriedSize;                       ///< 搬送データサイズ
+        bool     crcOk;                             ///< CRC検証結果
+        bool     valid;                             ///< 控えがあるか（false: 未受信・破棄後）
+        uint8_t  carriedData[RECEIVE_PAYLOAD_MAX];  ///< 搬送データ本体
     };
 
+    /**
+     * @brief PeekLatestPacketFromISR() が控えを読み直す回数
+     */
+    constexpr int LATEST_READ_ATTEMPTS = 3;
+
+    /**
+     * @brief パケットヘッダの送信形式
+     * @details
+     * メモリ上の配置やエンディアンに依存せず、Wire::PACKET_HEADER_SIZE バイトの
+     * 定義済みレイアウトへ変換する。リトルエンディアンの ESP32 では単純なロード/ストアになる。
+     */
+    typedef Codec::Schema<PacketData,
+        Codec::U32<offsetof(PacketData, timestamp)>,
+        Codec::Bytes<offsetof(PacketData, address), sizeof(PacketData::address)>,
+        Codec::U8<offsetof(PacketData, carriedSize)>
+    > PacketHeaderSchema;
+    static_assert(PacketHeaderSchema::WIRE_SIZE == Wire::PACKET_HEADER_SIZE, "Packet header layout mismatch");
+    static_assert(CARRIED_DATA_MAX_SIZE == Wire::CARRIED_MAX_SIZE, "Carried data size mismatch");
+    static_assert(ROBOT_ID_ALL == Wire::FLEET_ID_ALL && ROBOT_ID_NONE == Wire::FLEET_ID_NONE, "Robot ID mismatch");
+
+    /**
+     * @brief 冗長データフレームの順序の逆転とみなす、シーケンス番号の後戻りの上限
+     * @details これより大きく戻ったフレームは送信側が再起動したものとみなし、シーケンス番号を合わせ直す
+     */
+    constexpr uint16_t REDUNDANT_REORDER_WINDOW = 8;
+
+    /**
+     * @brief ESP-NOW のブロードキャストアドレス
+     */
+    static const uint8_t BROADCAST_ADDR[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+    /**
+     * @brief 拡張フレームのハンドラの最大登録数
+     */
+    constexpr size_t EXT_HANDLER_MAX = 8;
+
     //=== 内部状態 ===//
-    static Packet recvBuffer[RECEIVE_BUFFER_SIZE]; ///< 受信リングバッファ
-    static volatile uint16_t head = 0;             ///< バッファ書き込み位置
-    static volatile uint16_t tail = 0;             ///< バッファ読み出し位置
-    static volatile int16_t  count = 0;            ///< バッファ内パケット数
+#if ROBO_WCOM_RECEIVE_STORE_BYTES > 0
+    static PacketByteRing<ROBO_WCOM_RECEIVE_STORE_BYTES> recvRing;     ///< 受信リングバッファ（可変長）
+#else
+    static PacketRing<RECEIVE_BUFFER_SIZE, RECEIVE_PAYLOAD_MAX> recvRing; ///< 受信リングバッファ
+#endif
+    static uint32_t arrivalSeq = 0;                ///< 受信順序の通し番号
+    static volatile uint32_t latestSeq = 0;        ///< 受信バッファ最新パケットの通し番号
 
-    static Packet sendPacket;                      ///< 送信用パケット
+    static Packet prioritySlot;                    ///< 優先パケット専用スロット
+    static volatile bool priorityReady = false;    ///< 未読の優先パケットがあるか
+    static volatile uint32_t prioritySeq = 0;      ///< 優先パケットの通し番号
+    static PriorityCallback priorityCallback = nullptr; ///< 優先パケット受信コールバック
+
+    static PacketData sendData;                    ///< 送信用パケットデータ
+    static uint8_t sendFrame[Wire::MAX_FRAME_SIZE];///< 送信フレームバッファ
+    // 以下の優先送信用の状態は送信経路の排他（SendGuard）の中でのみ読み書きする
+    static PacketData priorityData;                ///< 優先送信用パケットデータ
+    static uint8_t priorityFrame[Wire::MAX_FRAME_SIZE]; ///< 優先送信フレームバッファ
+    static size_t  priorityFrameLen = 0;           ///< 優先送信フレーム長
+    static bool    priorityTxPending = false;      ///< 送信待ちの優先フレームがあるか
+    // 送信経路の排他を待ちきれなかった優先パケット。排他の外から書くため PRIORITY_LOCK で保護する
+    static PacketData deferredPriorityData;        ///< 組み立て待ちの優先パケットデータ
+    static bool    priorityDeferred = false;       ///< 組み立て待ちの優先パケットがあるか
+
+    static bool     redundancyEnabled = false;     ///< 冗長送信を行うか
+    static uint16_t redundantSendSeq = 0;          ///< 冗長データフレームの送信シーケンス番号
+    static PacketData prevSendData;                ///< 直前に送信したパケットデータ
+    static bool     prevSendValid = false;         ///< prevSendData が有効か
+    static uint16_t redundantRecvSeq = 0;          ///< 最後に受信した冗長データフレームのシーケンス番号
+    static bool     redundantRecvValid = false;    ///< redundantRecvSeq が有効か
+    static FecStats fecStats{};                    ///< 前方誤り訂正の統計
+    static FrameFormat sendFormat = FrameFormat::Full; ///< 送信フレーム形式
+    static bool     encryptionEnabled = false;     ///< 通信相手を暗号化Peerとして登録しているか
+    static IntegrityCheck integrityCheck = IntegrityCheck::Crc32; ///< 型付きフレームの整合性検査
+    static uint16_t peerCapabilities = Wire::HELLO_CAPS_ALL; ///< 通信相手が受け付けるフレーム（Wire::HELLO_CAP_*）
+    static uint8_t  peerMaxPayload = CARRIED_DATA_MAX_SIZE;  ///< 通信相手が受信できる最大搬送データサイズ
+    static uint16_t heartbeatSeq = 0;              ///< ハートビートのシーケンス番号
+    static bool     suppressUnchanged = false;     ///< 変化のない送信をハートビートへ置き換えるか
+    static uint8_t  heartbeatRefresh  = 1;         ///< パケット再送までのハートビート連続回数
+    static uint8_t  heartbeatRun      = 0;         ///< ハートビートの連続回数
+    static bool     lastSendValid     = false;     ///< sendData が前回送信済みの内容か
+    static uint8_t  robotId = ROBOT_ID_NONE;       ///< 一斉送信で受け取るロボットID
+    static uint8_t  fleetFrame[Wire::MAX_FRAME_SIZE]; ///< 一斉送信フレームバッファ
+    static bool     broadcastPeerAdded = false;    ///< ブロードキャストアドレスをPeer登録済みか
+    static uint8_t  extTypes[EXT_HANDLER_MAX];     ///< 拡張フレームのハンドラ登録済み種別
+    static FrameHandler extHandlers[EXT_HANDLER_MAX] = {}; ///< 拡張フレームのハンドラ
     static uint8_t ownAddr[6];                     ///< 自デバイスMAC
     static uint8_t peerAddr[6];                    ///< 通信相手MAC
     static esp_now_peer_info_t peerInfo{};         ///< ESP-NOW Peer情報
-    static uint32_t lastRecvMillis = 0;            ///< 最終受信時刻
-    static uint32_t timeoutMillis  = 0;            ///< タイムアウト時間
+    static volatile uint32_t lastRecvMillis = 0;   ///< 最終受信時刻
+    static LinkConfig linkConfig{};                ///< リンク状態の判定条件
+    static volatile LinkState linkState = LinkState::Recovering; ///< リンク状態
+    static uint8_t  goodRun = 0;                   ///< 連続正常受信数
+    static LinkStateCallback linkCallback = nullptr; ///< リンク状態遷移コールバック
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE linkMux = portMUX_INITIALIZER_UNLOCKED; ///< リンク状態保護
+    #define LINK_LOCK()     portENTER_CRITICAL(&linkMux)
+    #define LINK_UNLOCK()   portEXIT_CRITICAL(&linkMux)
+#else
+    #define LINK_LOCK()
+    #define LINK_UNLOCK()
+#endif
+
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE recvMux = portMUX_INITIALIZER_UNLOCKED; ///< 受信バッファ・優先スロット保護（受信タスクと loop() から触るため）
+    #define RECV_LOCK()     portENTER_CRITICAL(&recvMux)
+    #define RECV_UNLOCK()   portEXIT_CRITICAL(&recvMux)
+#else
+    #define RECV_LOCK()
+    #define RECV_UNLOCK()
+#endif
+
+#if defined(ESP_PLATFORM)
+    static StaticSemaphore_t sendMutexBuffer;      ///< sendMutex の領域
+    static SemaphoreHandle_t sendMutex = nullptr;  ///< 送信経路の排他（パブリッシャのタイマと loop() から同時に送るため）
+    #define SEND_LOCK()     do { if (sendMutex) { xSemaphoreTakeRecursive(sendMutex, portMAX_DELAY); } } while (0)
+    #define SEND_TRY_LOCK(waitMillis) \
+        (sendMutex == nullptr || xSemaphoreTakeRecursive(sendMutex, pdMS_TO_TICKS(waitMillis)) == pdTRUE)
+    #define SEND_UNLOCK()   do { if (sendMutex) { xSemaphoreGiveRecursive(sendMutex); } } while (0)
+    static portMUX_TYPE priorityMux = portMUX_INITIALIZER_UNLOCKED; ///< 組み立て待ちの優先パケット保護
+    #define PRIORITY_LOCK()     portENTER_CRITICAL(&priorityMux)
+    #define PRIORITY_UNLOCK()   portEXIT_CRITICAL(&priorityMux)
+#else
+    // PC上でもスレッドから送信APIを呼ぶツールで待ち時間付きの排他を試せるよう、実際に排他する
+    static std::recursive_timed_mutex sendMutex;   ///< 送信経路の排他
+    #define SEND_LOCK()     sendMutex.lock()
+    #define SEND_TRY_LOCK(waitMillis) sendMutex.try_lock_for(std::chrono::milliseconds(waitMillis))
+    #define SEND_UNLOCK()   sendMutex.unlock()
+    static std::mutex priorityMutex;               ///< 組み立て待ちの優先パケット保護
+    #define PRIORITY_LOCK()     priorityMutex.lock()
+    #define PRIORITY_UNLOCK()   priorityMutex.unlock()
+#endif
+
+    constexpr uint32_t PRIORITY_SEND_WAIT_MS = ROBO_WCOM_PRIORITY_SEND_WAIT_MS; ///< 優先送信が排他を待つ最大時間
+
+    /**
+     * @brief 関数を抜けるまで送信経路を排他する
+     * @details esp_now_send() はクリティカルセクション内で呼べないため、再帰ミューテックスで排他する
+     */
+    struct SendGuard {
+        SendGuard() { SEND_LOCK(); }
+        ~SendGuard() { SEND_UNLOCK(); }
+    };
+
+    static LatestCopy latestCopies[2];             ///< 最新パケットの控え（通し番号の下位1ビットで交互に使う）
+    static std::atomic<uint32_t> latestPublished(0); ///< 読み出してよい控えの通し番号
+    static std::atomic<uint32_t> latestWriting(0); ///< 書き込みを始めた控えの通し番号
+
+#if ROBO_WCOM_HAS_RECEIVE_TASK
+    constexpr size_t RECEIVE_TASK_FRAMES = ROBO_WCOM_RECEIVE_TASK_FRAMES;
+    static_assert(RECEIVE_TASK_FRAMES <= 0xFF, "ROBO_WCOM_RECEIVE_TASK_FRAMES must be 255 or less");
+    static uint8_t taskFrames[RECEIVE_TASK_FRAMES][Wire::MAX_FRAME_SIZE]; ///< 受信タスクへ渡すフレーム
+    static uint8_t taskFrameLens[RECEIVE_TASK_FRAMES];  ///< taskFrames のフレーム長
+    static uint8_t taskFrameMacs[RECEIVE_TASK_FRAMES][6]; ///< taskFrames の送信元MAC
+    static QueueHandle_t freeFrameQueue = nullptr; ///< 空いている taskFrames の番号
+    static QueueHandle_t readyFrameQueue = nullptr;///< 処理待ちの taskFrames の番号
+    static TaskHandle_t receiveTask = nullptr;     ///< 受信タスク
+#endif
+    static ReceiveTaskStats receiveTaskStats{};    ///< 受信タスクの統計
 
     //=== 内部関数プロトタイプ ===//
-    static uint32_t calcCRC32(const PacketData& data);
+    static IntegrityCheck frameCheck(uint8_t frameType);
+    static size_t checkLength(IntegrityCheck check);
+    static size_t checkSize(uint8_t frameType);
+    static size_t sealTypedFrame(uint8_t* frame, size_t len);
+    static size_t typedFrameLength(IntegrityCheck check, size_t body);
+    static bool receivedCheck(const uint8_t* frame, int len, size_t body, bool trusted, IntegrityCheck& check);
+    static bool verifyTypedFrame(const uint8_t* frame, size_t body, IntegrityCheck check);
+    static size_t buildLegacyFrame(const PacketData& data, uint8_t* frame);
+    static size_t buildDataFrame(Wire::FrameType type, const PacketData& data, uint8_t* frame);
+    static bool peerSupports(uint16_t capability);
+    static size_t buildPlainFrame(const PacketData& data, uint8_t* frame);
+    static bool transmitFrame(const uint8_t* dest, const uint8_t* frame, size_t len);
+    static void buildPriorityFrame(void);
+    static bool flushPendingPriority(void);
+    static Status sendPriorityLocked(uint32_t timestamp, const uint8_t* data, uint8_t size);
+    static void noteLinkReceive(uint32_t nowMillis, uint32_t lossCount);
+    static void resetFecState(void);
+    static void notifyLinkState(LinkState from, LinkState to);
+    static bool parseLegacyFrame(const uint8_t* frame, int len, Packet& pkt);
+    static bool parseDataFrame(const uint8_t* frame, int len, bool trusted, Packet& pkt);
+    static bool parseHeartbeatFrame(const uint8_t* frame, int len, bool trusted);
+    static size_t buildRedundantFrame(uint16_t seq, const PacketData& data, const PacketData* prev, uint8_t* frame);
+    static bool parseRedundantFrame(const uint8_t* frame, int len, bool trusted, Packet& pkt, Packet& prev, bool& hasPrev, uint16_t& seq);
+    static void receiveRedundantFrame(const uint8_t* frame, int len, bool trusted);
+    static bool fromPeer(const uint8_t* mac);
+    static void receiveFleetFrame(const uint8_t* mac, const uint8_t* frame, int len);
+    static bool receiveExtFrame(const uint8_t* frame, int len, bool trusted);
     static void pushToBuffer(const Packet& pkt);
+    static void publishLatest(const PacketData* data, bool crcOk);
+    static void processFrame(const uint8_t* mac, const uint8_t* frame, int len);
     static bool popFromBuffer(Packet& pkt);
+    static bool peekLatestInBuffer(Packet& pkt);
     static void onDataRecv(const uint8_t* mac, const uint8_t* incomingData, int len);
     static void onDataSent(const uint8_t*, esp_now_send_status_t);
     static Status extractPacketData(const Packet& pkt, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size);
@@ -39,281 +253,1800 @@ namespace ROBO_WCOM
     //=== 内部関数実装 ===//
 
     /**
-     * @brief CRC32計算
-     * @param data パケットデータ部
-     * @return CRC32値
+     * @brief フレーム種別ごとに使う整合性検査
+     * @details ハンドシェイクフレームは検査の設定を合わせるために使うため、設定によらず常に CRC32
+     * @param frameType フレーム種別
+     * @return 整合性検査
+     */
+    static IntegrityCheck frameCheck(uint8_t frameType)
+    {
+        if (frameType == static_cast<uint8_t>(Wire::FrameType::Hello))
+        {
+            return IntegrityCheck::Crc32;
+        }
+        return integrityCheck;
+    }
+
+    /**
+     * @brief 整合性検査の検査値の長さ
+     * @param check 整合性検査
+     * @return 検査値のバイト数
+     */
+    static size_t checkLength(IntegrityCheck check)
+    {
+        switch (check)
+        {
+            case IntegrityCheck::Crc16: return Wire::CRC16_SIZE;
+            case IntegrityCheck::None:  return 0;
+            default:                    return Wire::CRC32_SIZE;
+        }
+    }
+
+    /**
+     * @brief 型付きフレームの送信時に付ける検査値の長さ
+     * @param frameType フレーム種別
+     * @return 検査値のバイト数
+     */
+    static size_t checkSize(uint8_t frameType)
+    {
+        return checkLength(frameCheck(frameType));
+    }
+
+    /**
+     * @brief 型付きフレームの末尾に検査値を付ける
+     * @details 従来形式と同じ長さになる場合は詰め物も付けて区別する
+     * @param frame フレーム（Wire::MAX_FRAME_SIZE バイト）
+     * @param len   検査値を除くフレーム長
+     * @return フレーム長
+     */
+    static size_t sealTypedFrame(uint8_t* frame, size_t len)
+    {
+        switch (frameCheck(frame[0]))
+        {
+            case IntegrityCheck::Crc16:
+                Codec::storeLE16(frame + len, Codec::crc16(frame, len));
+                break;
+            case IntegrityCheck::None:
+                break;
+            default:
+                Codec::storeLE32(frame + len, Codec::crc32(frame, len));
+                break;
+        }
+        len += checkSize(frame[0]);
+        if (len == Wire::LEGACY_FRAME_SIZE)
+        {
+            frame[len++] = 0;
+        }
+        return len;
+    }
+
+    /**
+     * @brief 型付きフレームの受信時に期待するフレーム長
+     * @param check 整合性検査
+     * @param body  検査値を除くフレーム長
+     * @return 検査値・詰め物を含むフレーム長
+     */
+    static size_t typedFrameLength(IntegrityCheck check, size_t body)
+    {
+        size_t len = body + checkLength(check);
+        return (len == Wire::LEGACY_FRAME_SIZE) ? len + 1 : len;
+    }
+
+    /**
+     * @brief 受信した型付きフレームの整合性検査をフレーム長から判別する
+     * @details
+     * 合意による検査の切り替えは両側で同時には起きないため、自分の設定ではなく受け付けてよい検査をすべて試す。
+     * CRC32 は常に受け付け、CRC16・検査なしは暗号化Peerとして登録した通信相手から届いた場合に限る。
+     * ハンドシェイクフレームは CRC32 だけを受け付ける。同じ本体長で検査ごとのフレーム長は重ならない
+     * @param frame   受信フレーム
+     * @param len     受信フレーム長
+     * @param body    検査値を除くフレーム長
+     * @param trusted 暗号化された通信相手から届いたフレームか
+     * @param check   判別した整合性検査
+     * @return true:判別できた / false:どの検査のフレーム長とも合わない
+     */
+    static bool receivedCheck(const uint8_t* frame, int len, size_t body, bool trusted, IntegrityCheck& check)
+    {
+        static const IntegrityCheck CANDIDATES[] = { IntegrityCheck::Crc32, IntegrityCheck::Crc16, IntegrityCheck::None };
+        bool weakAllowed = trusted && frame[0] != static_cast<uint8_t>(Wire::FrameType::Hello);
+        for (IntegrityCheck candidate : CANDIDATES)
+        {
+            if (candidate != IntegrityCheck::Crc32 && !weakAllowed)
+            {
+                break;
+            }
+            if (static_cast<size_t>(len) == typedFrameLength(candidate, body))
+            {
+                check = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 型付きフレームの検査値を検証する
+     * @param frame 受信フレーム（長さは receivedCheck() で確認済みであること）
+     * @param body  検査値を除くフレーム長
+     * @param check receivedCheck() で判別した整合性検査
+     * @return true:一致（検査なしの場合は常に true） / false:不一致
+     */
+    static bool verifyTypedFrame(const uint8_t* frame, size_t body, IntegrityCheck check)
+    {
+        switch (check)
+        {
+            case IntegrityCheck::Crc16:
+                return Codec::loadLE16(frame + body) == Codec::crc16(frame, body);
+            case IntegrityCheck::None:
+                return true;
+            default:
+                return Codec::loadLE32(frame + body) == Codec::crc32(frame, body);
+        }
+    }
+
+#if ROBO_WCOM_TRACE
+    /**
+     * @brief トレースでフレームを対応付けるための識別子（フレームに載ったタイムスタンプ）
+     * @param frame フレーム
+     * @param len   フレーム長
+     * @return タイムスタンプ（持たないフレームは 0）
+     */
+    static uint32_t traceFrameId(const uint8_t* frame, size_t len)
+    {
+        if (len == Wire::LEGACY_FRAME_SIZE)
+        {
+            return Codec::loadLE32(frame + Wire::LEGACY_OFFSET_HEADER);
+        }
+        if (len < Wire::HEARTBEAT_FRAME_SIZE)
+        {
+            return 0;
+        }
+        switch (static_cast<Wire::FrameType>(frame[0]))
+        {
+            case Wire::FrameType::Data:
+            case Wire::FrameType::Redundant:
+            case Wire::FrameType::Priority:
+                return Codec::loadLE32(frame + Wire::DATA_OFFSET_HEADER);
+            case Wire::FrameType::Heartbeat:
+                return Codec::loadLE32(frame + Wire::HEARTBEAT_OFFSET_TIMESTAMP);
+            case Wire::FrameType::Fleet:
+                return Codec::loadLE32(frame + Wire::FLEET_OFFSET_TIMESTAMP);
+            default:
+                return 0;
+        }
+    }
+
+    /**
+     * @brief トレースに記録するフレーム種別（従来形式は 0）
+     */
+    static uint32_t traceFrameType(const uint8_t* frame, size_t len)
+    {
+        return (len == Wire::LEGACY_FRAME_SIZE || len == 0) ? 0 : frame[0];
+    }
+#endif
+
+    /**
+     * @brief リンク状態遷移を通知する
+     * @param from 遷移前
+     * @param to   遷移後
+     */
+    static void notifyLinkState(LinkState from, LinkState to)
+    {
+        LinkStateCallback cb = linkCallback;
+        if (from != to && cb)
+        {
+            cb(from, to);
+        }
+    }
+
+    /**
+     * @brief 途絶に合わせて前方誤り訂正の状態を捨てる
+     * @details
+     * 途絶の間に相手が再起動していることがあるため、受信側は次の冗長データフレームでシーケンス番号を取り直し、
+     * 送信側は途絶前の送信内容を前回データとして添えない（変化がなくてもハートビートで代用しない）。
+     * LINK_LOCK() の中から呼ぶ
+     */
+    static void resetFecState(void)
+    {
+        redundantRecvValid = false;
+        prevSendValid = false;
+        lastSendValid = false;
+    }
+
+    /**
+     * @brief 受信イベントでリンク状態を更新する
+     * @param nowMillis 受信時刻
+     * @param lossCount この受信で判明した欠落・破損フレーム数
+     */
+    static void noteLinkReceive(uint32_t nowMillis, uint32_t lossCount)
+    {
+        LINK_LOCK();
+        LinkState from = linkState;
+        LinkState to = from;
+        lastRecvMillis = nowMillis;
+        if (from == LinkState::Lost)
+        {
+            to = LinkState::Recovering;
+            goodRun = (lossCount == 0) ? 1 : 0;
+            resetFecState();
+        }
+        else if (lossCount != 0)
+        {
+            goodRun = 0;
+            if (from == LinkState::Up)
+            {
+                to = LinkState::Degraded;
+            }
+        }
+        else if (goodRun < 0xFF)
+        {
+            goodRun++;
+        }
+        if (to != LinkState::Up && to != LinkState::Lost && goodRun >= linkConfig.recoverFrames)
+        {
+            to = LinkState::Up;
+        }
+        linkState = to;
+        LINK_UNLOCK();
+        notifyLinkState(from, to);
+    }
+
+    /**
+     * @brief 従来形式フレームを組み立てる
+     * @param data  送信パケットデータ（搬送データの未使用部分も送信される）
+     * @param frame 出力先（Wire::LEGACY_FRAME_SIZE バイト以上）
+     * @return フレーム長
+     */
+    static size_t buildLegacyFrame(const PacketData& data, uint8_t* frame)
+    {
+        PacketHeaderSchema::encode(data, frame + Wire::LEGACY_OFFSET_HEADER);
+        memcpy(frame + Wire::LEGACY_OFFSET_CARRIED, data.carriedData, Wire::CARRIED_MAX_SIZE);
+        Codec::storeLE32(frame + Wire::LEGACY_OFFSET_CRC, Codec::crc32(frame, Wire::LEGACY_OFFSET_CRC));
+        return Wire::LEGACY_FRAME_SIZE;
+    }
+
+    /**
+     * @brief 型付きデータフレームを組み立てる
+     * @param type  フレーム種別（Data / Priority）
+     * @param data  送信パケットデータ（搬送データは carriedSize 分のみ送信）
+     * @param frame 出力先（Wire::MAX_FRAME_SIZE バイト）
+     * @return フレーム長
+     */
+    static size_t buildDataFrame(Wire::FrameType type, const PacketData& data, uint8_t* frame)
+    {
+        size_t len = Wire::DATA_HEADER_SIZE + data.carriedSize;
+        frame[Wire::DATA_OFFSET_TYPE] = static_cast<uint8_t>(type);
+        PacketHeaderSchema::encode(data, frame + Wire::DATA_OFFSET_HEADER);
+        memcpy(frame + Wire::DATA_OFFSET_CARRIED, data.carriedData, data.carriedSize);
+        return sealTypedFrame(frame, len);
+    }
+
+    /**
+     * @brief 通信相手がフレームの種類に対応しているか
+     * @param capability 機能（Wire::HELLO_CAP_*）
+     * @return true:対応している
+     */
+    static bool peerSupports(uint16_t capability)
+    {
+        return (peerCapabilities & capability) != 0;
+    }
+
+    /**
+     * @brief 送信フレーム形式に従って通常のデータフレームを組み立てる
+     * @details 通信相手が可変長データフレームに対応していなければ従来形式にする
+     * @param data  送信パケットデータ
+     * @param frame 出力先（Wire::MAX_FRAME_SIZE バイト）
+     * @return フレーム長
+     */
+    static size_t buildPlainFrame(const PacketData& data, uint8_t* frame)
+    {
+        if (sendFormat == FrameFormat::Compact && peerSupports(Wire::HELLO_CAP_COMPACT))
+        {
+            return buildDataFrame(Wire::FrameType::Data, data, frame);
+        }
+        return buildLegacyFrame(data, frame);
+    }
+
+    /**
+     * @brief 従来形式フレームをパケットへ展開する
+     * @param frame 受信フレーム
+     * @param len   受信フレーム長
+     * @param pkt   展開先パケット
+     * @return true:展開した / false:形式不正で破棄
+     */
+    static bool parseLegacyFrame(const uint8_t* frame, int len, Packet& pkt)
+    {
+        if (len != static_cast<int>(Wire::LEGACY_FRAME_SIZE))
+        {
+            return false;
+        }
+        PacketHeaderSchema::decode(frame + Wire::LEGACY_OFFSET_HEADER, Wire::PACKET_HEADER_SIZE, pkt.data);
+        if (pkt.data.carriedSize > CARRIED_DATA_MAX_SIZE)
+        {
+            return false;
+        }
+        memcpy(pkt.data.carriedData, frame + Wire::LEGACY_OFFSET_CARRIED, Wire::CARRIED_MAX_SIZE);
+        pkt.crcOk = (Codec::loadLE32(frame + Wire::LEGACY_OFFSET_CRC) == Codec::crc32(frame, Wire::LEGACY_OFFSET_CRC));
+        return true;
+    }
+
+    /**
+     * @brief 型付きデータフレームをパケットへ展開する
+     * @details 搬送データの後ろはゼロ埋めする
+     * @param frame   受信フレーム
+     * @param len     受信フレーム長
+     * @param trusted 暗号化された通信相手から届いたフレームか（receivedCheck()）
+     * @param pkt     展開先パケット
+     * @return true:展開した / false:形式不正で破棄
+     */
+    static bool parseDataFrame(const uint8_t* frame, int len, bool trusted, Packet& pkt)
+    {
+        if (len < static_cast<int>(Wire::DATA_HEADER_SIZE))
+        {
+            return false;
+        }
+        uint8_t size = frame[Wire::DATA_OFFSET_SIZE];
+        size_t body = Wire::DATA_HEADER_SIZE + size;
+        IntegrityCheck check;
+        if (size > CARRIED_DATA_MAX_SIZE || !receivedCheck(frame, len, body, trusted, check))
+        {
+            return false;
+        }
+
+        PacketHeaderSchema::decode(frame + Wire::DATA_OFFSET_HEADER, Wire::PACKET_HEADER_SIZE, pkt.data);
+        memcpy(pkt.data.carriedData, frame + Wire::DATA_OFFSET_CARRIED, size);
+        memset(pkt.data.carriedData + size, 0, CARRIED_DATA_MAX_SIZE - size);
+        pkt.crcOk = verifyTypedFrame(frame, body, check);
+        return true;
+    }
+
+    /**
+     * @brief 冗長データフレームを組み立てる
+     * @param seq   シーケンス番号
+     * @param data  送信パケットデータ
+     * @param prev  直前に送信したパケットデータ（nullptr で含めない）
+     * @param frame 出力先（Wire::MAX_FRAME_SIZE バイト）
+     * @return フレーム長
+     */
+    static size_t buildRedundantFrame(uint16_t seq, const PacketData& data, const PacketData* prev, uint8_t* frame)
+    {
+        // フレームに収まらない場合は前回データを省く
+        if (prev && Wire::REDUNDANT_HEADER_SIZE + data.carriedSize + prev->carriedSize
+            + checkSize(static_cast<uint8_t>(Wire::FrameType::Redundant)) + 1 > Wire::MAX_FRAME_SIZE)
+        {
+            prev = nullptr;
+        }
+
+        size_t len = Wire::REDUNDANT_OFFSET_CARRIED;
+        frame[Wire::DATA_OFFSET_TYPE] = static_cast<uint8_t>(Wire::FrameType::Redundant);
+        PacketHeaderSchema::encode(data, frame + Wire::DATA_OFFSET_HEADER);
+        Codec::storeLE16(frame + Wire::REDUNDANT_OFFSET_SEQ, seq);
+        Codec::storeLE32(frame + Wire::REDUNDANT_OFFSET_PREV_TIMESTAMP, prev ? prev->timestamp : 0);
+        frame[Wire::REDUNDANT_OFFSET_PREV_SIZE] = prev ? prev->carriedSize : Wire::REDUNDANT_NO_PREVIOUS;
+        memcpy(frame + len, data.carriedData, data.carriedSize);
+        len += data.carriedSize;
+        if (prev)
+        {
+            memcpy(frame + len, prev->carriedData, prev->carriedSize);
+            len += prev->carriedSize;
+        }
+        return sealTypedFrame(frame, len);
+    }
+
+    /**
+     * @brief 冗長データフレームを展開する
+     * @param frame   受信フレーム
+     * @param len     受信フレーム長
+     * @param trusted 暗号化された通信相手から届いたフレームか（receivedCheck()）
+     * @param pkt     今回のパケットの展開先
+     * @param prev    前回のパケットの展開先
+     * @param hasPrev 前回のパケットを含むか
+     * @param seq     シーケンス番号
+     * @return true:展開した / false:形式不正で破棄
+     */
+    static bool parseRedundantFrame(const uint8_t* frame, int len, bool trusted, Packet& pkt, Packet& prev, bool& hasPrev, uint16_t& seq)
+    {
+        if (len < static_cast<int>(Wire::REDUNDANT_HEADER_SIZE))
+        {
+            return false;
+        }
+        PacketHeaderSchema::decode(frame + Wire::DATA_OFFSET_HEADER, Wire::PACKET_HEADER_SIZE, pkt.data);
+        uint8_t prevSize = frame[Wire::REDUNDANT_OFFSET_PREV_SIZE];
+        hasPrev = (prevSize != Wire::REDUNDANT_NO_PREVIOUS);
+        if (!hasPrev)
+        {
+            prevSize = 0;
+        }
+        size_t body = Wire::REDUNDANT_HEADER_SIZE + pkt.data.carriedSize + prevSize;
+        IntegrityCheck check;
+        if (pkt.data.carriedSize > CARRIED_DATA_MAX_SIZE || prevSize > CARRIED_DATA_MAX_SIZE ||
+            !receivedCheck(frame, len, body, trusted, check))
+        {
+            return false;
+        }
+
+        const uint8_t* carried = frame + Wire::REDUNDANT_OFFSET_CARRIED;
+        seq = Codec::loadLE16(frame + Wire::REDUNDANT_OFFSET_SEQ);
+        pkt.crcOk = verifyTypedFrame(frame, body, check);
+        memcpy(pkt.data.carriedData, carried, pkt.data.carriedSize);
+        memset(pkt.data.carriedData + pkt.data.carriedSize, 0, CARRIED_DATA_MAX_SIZE - pkt.data.carriedSize);
+        if (hasPrev)
+        {
+            prev.data.timestamp = Codec::loadLE32(frame + Wire::REDUNDANT_OFFSET_PREV_TIMESTAMP);
+            memcpy(prev.data.address, pkt.data.address, sizeof(prev.data.address));
+            prev.data.carriedSize = prevSize;
+            memcpy(prev.data.carriedData, carried + pkt.data.carriedSize, prevSize);
+            memset(prev.data.carriedData + prevSize, 0, CARRIED_DATA_MAX_SIZE - prevSize);
+            prev.crcOk = pkt.crcOk;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 冗長データフレームの受信処理
+     * @details
+     * シーケンス番号がちょうど1つ飛んでいれば、欠落したフレームを前回データから復元して先に積む。
+     * 重複と REDUNDANT_REORDER_WINDOW 以内の後戻りは破棄し、それより大きく戻った場合は送信側の再起動とみなして受け入れる
+     * @param frame   受信フレーム
+     * @param len     受信フレーム長
+     * @param trusted 暗号化された通信相手から届いたフレームか（receivedCheck()）
+     */
+    static void receiveRedundantFrame(const uint8_t* frame, int len, bool trusted)
+    {
+        Packet pkt;
+        Packet prev;
+        bool hasPrev;
+        uint16_t seq;
+        if (!parseRedundantFrame(frame, len, trusted, pkt, prev, hasPrev, seq))
+        {
+            return;
+        }
+
+        // 破損フレームのシーケンス番号は信用できないので、CRCエラーとして積むだけにする
+        if (!pkt.crcOk)
+        {
+            noteLinkReceive(millis(), 1);
+            pushToBuffer(pkt);
+            return;
+        }
+
+        uint32_t lost = 0;
+        fecStats.received++;
+        // 途絶中に届いたフレームは noteLinkReceive() で状態を捨てた後の最初のフレームとして扱う
+        if (redundantRecvValid && linkState != LinkState::Lost)
+        {
+            uint16_t gap = static_cast<uint16_t>(seq - redundantRecvSeq);
+            uint16_t back = static_cast<uint16_t>(redundantRecvSeq - seq);
+            if (back <= REDUNDANT_REORDER_WINDOW)
+            {
+                // 重複または順序の逆転したフレームは破棄する
+                return;
+            }
+            if (gap > 0x8000)
+            {
+                // 大きく戻った場合は送信側が番号を振り直している。欠落は数えずに合わせ直す
+                fecStats.resyncs++;
+            }
+            else if (gap == 2 && hasPrev)
+            {
+                pushToBuffer(prev);
+                fecStats.recovered++;
+            }
+            else if (gap >= 2)
+            {
+                lost = gap - 1;
+                fecStats.lost += lost;
+            }
+        }
+        noteLinkReceive(millis(), lost);
+        redundantRecvSeq = seq;
+        redundantRecvValid = true;
+        pushToBuffer(pkt);
+    }
+
+    /**
+     * @brief 通信相手から届いたフレームか
+     * @param mac 送信元MAC（nullptr は InjectFrame() で投入されたフレームで、通信相手からとみなす）
+     * @return true:通信相手から
+     */
+    static bool fromPeer(const uint8_t* mac)
+    {
+        return !mac || memcmp(mac, peerAddr, sizeof(peerAddr)) == 0;
+    }
+
+    /**
+     * @brief 一斉送信フレームの受信処理
+     * @details
+     * 自分のIDのエントリ（なければ全ロボット宛てのエントリ）だけを受信バッファへ積む。
+     * ブロードキャストは暗号化できないため、整合性検査の設定によらず常に CRC32 で検証する。
+     * ブロードキャストは誰でも送れるため、通信相手以外から届いたものは捨てる
+     * @param mac   送信元MAC
+     * @param frame 受信フレーム
+     * @param len   受信フレーム長
      */
-    static uint32_t calcCRC32(const PacketData& data)
+    static void receiveFleetFrame(const uint8_t* mac, const uint8_t* frame, int len)
     {
-        uint32_t crc = 0xFFFFFFFF;
-        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&data);
-        for (size_t i = 0; i < sizeof(PacketData); ++i)
+        if (!fromPeer(mac) || len < static_cast<int>(Wire::FLEET_HEADER_SIZE + Wire::CRC32_SIZE))
+        {
+            return;
+        }
+
+        // エントリを辿って本体の終端を求める
+        uint8_t entries = frame[Wire::FLEET_OFFSET_COUNT];
+        size_t body = Wire::FLEET_OFFSET_ENTRIES;
+        const uint8_t* own = nullptr;
+        const uint8_t* all = nullptr;
+        for (uint8_t i = 0; i < entries; ++i)
         {
-            crc ^= bytes[i];
-            for (int j = 0; j < 8; ++j)
+            if (body + Wire::FLEET_ENTRY_HEADER_SIZE + Wire::CRC32_SIZE > static_cast<size_t>(len))
+            {
+                return;
+            }
+            const uint8_t* entry = frame + body;
+            if (entry[0] == robotId && robotId != ROBOT_ID_NONE)
             {
-                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+                own = entry;
             }
+            else if (entry[0] == Wire::FLEET_ID_ALL)
+            {
+                all = entry;
+            }
+            body += Wire::FLEET_ENTRY_HEADER_SIZE + entry[1];
+        }
+        size_t expected = body + Wire::CRC32_SIZE;
+        if (expected == Wire::LEGACY_FRAME_SIZE)
+        {
+            expected++;
         }
-        return crc ^ 0xFFFFFFFF;
+        if (static_cast<size_t>(len) != expected)
+        {
+            return;
+        }
+        if (Codec::loadLE32(frame + body) != Codec::crc32(frame, body))
+        {
+            // 宛先が読めないため、指令の欠落として扱う
+            noteLinkReceive(millis(), 1);
+            return;
+        }
+
+        const uint8_t* entry = own ? own : all;
+        if (!entry || entry[1] > CARRIED_DATA_MAX_SIZE)
+        {
+            return;
+        }
+        Packet pkt;
+        pkt.data.timestamp = Codec::loadLE32(frame + Wire::FLEET_OFFSET_TIMESTAMP);
+        memcpy(pkt.data.address, frame + Wire::FLEET_OFFSET_ADDRESS, sizeof(pkt.data.address));
+        pkt.data.carriedSize = entry[1];
+        memcpy(pkt.data.carriedData, entry + Wire::FLEET_ENTRY_HEADER_SIZE, entry[1]);
+        memset(pkt.data.carriedData + entry[1], 0, CARRIED_DATA_MAX_SIZE - entry[1]);
+        pkt.crcOk = true;
+        noteLinkReceive(millis(), 0);
+        pushToBuffer(pkt);
+    }
+
+    /**
+     * @brief 拡張フレームの受信処理
+     * @details 登録済みのハンドラへ本体を渡す。受信バッファには積まない
+     * @param frame   受信フレーム
+     * @param len     受信フレーム長
+     * @param trusted 暗号化された通信相手から届いたフレームか（receivedCheck()）
+     * @return true:ハンドラが登録された種別だった / false:未登録の種別
+     */
+    static bool receiveExtFrame(const uint8_t* frame, int len, bool trusted)
+    {
+        FrameHandler handler = nullptr;
+        for (size_t i = 0; i < EXT_HANDLER_MAX; ++i)
+        {
+            if (extHandlers[i] && extTypes[i] == frame[0])
+            {
+                handler = extHandlers[i];
+                break;
+            }
+        }
+        if (!handler)
+        {
+            return false;
+        }
+        if (len < static_cast<int>(Wire::EXT_HEADER_SIZE))
+        {
+            return true;
+        }
+        size_t body = Wire::EXT_HEADER_SIZE + frame[Wire::EXT_OFFSET_LENGTH];
+        IntegrityCheck check;
+        if (!receivedCheck(frame, len, body, trusted, check))
+        {
+            return true;
+        }
+        if (!verifyTypedFrame(frame, body, check))
+        {
+            noteLinkReceive(millis(), 1);
+            return true;
+        }
+        noteLinkReceive(millis(), 0);
+        handler(frame + Wire::EXT_OFFSET_BODY, frame[Wire::EXT_OFFSET_LENGTH]);
+        return true;
+    }
+
+    /**
+     * @brief 生存通知フレームを検証する
+     * @param frame   受信フレーム
+     * @param len     受信フレーム長
+     * @param trusted 暗号化された通信相手から届いたフレームか（receivedCheck()）
+     * @return true:正常 / false:形式不正またはCRC不一致
+     */
+    static bool parseHeartbeatFrame(const uint8_t* frame, int len, bool trusted)
+    {
+        IntegrityCheck check;
+        if (!receivedCheck(frame, len, Wire::HEARTBEAT_OFFSET_CRC, trusted, check))
+        {
+            return false;
+        }
+        return verifyTypedFrame(frame, Wire::HEARTBEAT_OFFSET_CRC, check);
+    }
+
+    /**
+     * @brief 受信バッファにパケットを追加
+     * @param pkt 追加するパケット
+     */
+    static void pushToBuffer(const Packet& pkt)
+    {
+        WCOM_TRACE(Push, pkt.data.timestamp, pkt.crcOk ? 1 : 0);
+        RECV_LOCK();
+        recvRing.push(pkt.data, pkt.crcOk);
+        latestSeq = ++arrivalSeq;
+        publishLatest(&pkt.data, pkt.crcOk);
+        RECV_UNLOCK();
+    }
+
+    /**
+     * @brief 最新パケットの控えを更新する
+     * @details
+     * 書き込むのは読み出してよい面とは別の面で、書き始める前に latestWriting を進める。
+     * 読み出し側は読んだ後に latestWriting を確かめ、読んだ面へ書き始めていれば読み直す。
+     * 書き手は受信処理と FlushBuffer() の2つあり、同じ面を同時に書かないよう RECV_LOCK() の中から呼ぶ
+     * （受信バッファの更新と同じロックの中で書くため、控えとバッファの順序も食い違わない）
+     * @param data  パケットデータ（nullptr で控えを無効にする）
+     * @param crcOk CRC検証結果
+     */
+    static void publishLatest(const PacketData* data, bool crcOk)
+    {
+        uint32_t next = latestPublished.load(std::memory_order_relaxed) + 1;
+        latestWriting.store(next, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        LatestCopy& copy = latestCopies[next & 1];
+        copy.valid = (data != nullptr);
+        if (data)
+        {
+            copy.timestamp = data->timestamp;
+            memcpy(copy.address, data->address, sizeof(copy.address));
+            if (data->carriedSize <= RECEIVE_PAYLOAD_MAX)
+            {
+                copy.carriedSize = data->carriedSize;
+                copy.crcOk = crcOk;
+                memcpy(copy.carriedData, data->carriedData, data->carriedSize);
+            }
+            else
+            {
+                copy.carriedSize = 0;
+                copy.crcOk = false;
+            }
+        }
+        latestPublished.store(next, std::memory_order_release);
+    }
+
+    /**
+     * @brief 受信処理を切り替えるための定数
+     * 
+     */
+    enum class BufferMode { Pop, Peek };
+
+    /**
+     * @brief パケットを受信する処理。バッファ操作を行う場合と行わない場合での切り替えが可能
+     * 
+     * @param mode 受信状態切り替え
+     * @param nowMillis 現在時刻（millis）
+     * @param timestamp 受信パケットのタイムスタンプ格納先
+     * @param address   送信元アドレス格納先（6バイト）
+     * @param data      受信データ格納先
+     * @param size      受信データサイズ格納先
+     * @return ステータスコード (Status)
+     */
+    static Status getPacket(BufferMode mode, uint32_t nowMillis,
+                            uint32_t* timestamp, uint8_t* address,
+                            uint8_t* data, uint8_t* size)
+    {
+        Packet pkt;
+
+        // 優先パケットは受信バッファより先に取り出す
+        RECV_LOCK();
+        bool fromPriority = priorityReady &&
+                            (mode == BufferMode::Pop || (int32_t)(prioritySeq - latestSeq) > 0);
+        if (fromPriority)
+        {
+            pkt = prioritySlot;
+            if (mode == BufferMode::Pop)
+            {
+                priorityReady = false;
+            }
+        }
+        RECV_UNLOCK();
+        if (fromPriority)
+        {
+            return extractPacketData(pkt, timestamp, address, data, size);
+        }
+
+        if (UpdateLinkState(nowMillis) == LinkState::Lost)
+        {
+            return Status::Timeout;
+        }
+
+        if (mode == BufferMode::Pop)
+        {
+            // POP処理ではデータを取り出すとともにバッファ操作を行う
+            if (!popFromBuffer(pkt))
+            {
+                // バッファが空の場合、ゼロ埋めしたうえで、空であることを通知する
+                fillWithEmptyPacket(timestamp, address, data, size);
+                return Status::BufferEmpty;
+            }
+        }
+        else if (!peekLatestInBuffer(pkt))
+        {
+            fillWithEmptyPacket(timestamp, address, data, size);
+            return Status::BufferEmpty;
+        }
+        return extractPacketData(pkt, timestamp, address, data, size);
+    }
+    /**
+     * @brief 受信バッファからパケットを取り出す
+     * @param pkt 取り出したパケット格納先
+     * @return true:成功 / false:空
+     */
+    static bool popFromBuffer(Packet& pkt)
+    {
+        RECV_LOCK();
+        bool ok = recvRing.pop(pkt.data, pkt.crcOk);
+        RECV_UNLOCK();
+        return ok;
+    }
+
+    /**
+     * @brief 受信バッファの最新パケットを参照する（取り出さない）
+     * @param pkt 参照したパケット格納先
+     * @return true:成功 / false:空
+     */
+    static bool peekLatestInBuffer(Packet& pkt)
+    {
+        RECV_LOCK();
+        bool ok = recvRing.peekLatest(pkt.data, pkt.crcOk);
+        RECV_UNLOCK();
+        return ok;
+    }
+
+#if ROBO_WCOM_HAS_RECEIVE_TASK
+    /**
+     * @brief 受信フレームを事前確保したバッファへ写して受信タスクへ渡す
+     * @details 空きがなければ捨てる（Wi-Fiタスクは待たせない）
+     * @param mac   送信元MAC（nullptr なら通信相手のMACを写す）
+     * @param frame 受信フレーム
+     * @param len   受信フレーム長
+     */
+    static void queueFrame(const uint8_t* mac, const uint8_t* frame, int len)
+    {
+        uint8_t index;
+        if (xQueueReceive(freeFrameQueue, &index, 0) != pdTRUE)
+        {
+            receiveTaskStats.dropped++;
+            return;
+        }
+        memcpy(taskFrames[index], frame, static_cast<size_t>(len));
+        taskFrameLens[index] = static_cast<uint8_t>(len);
+        memcpy(taskFrameMacs[index], mac ? mac : peerAddr, sizeof(taskFrameMacs[index]));
+        // 番号の総数はキューの長さと同じなので、積めないことはない
+        xQueueSend(readyFrameQueue, &index, 0);
+        receiveTaskStats.queued++;
+        UBaseType_t pending = uxQueueMessagesWaiting(readyFrameQueue);
+        if (pending > receiveTaskStats.maxPending)
+        {
+            receiveTaskStats.maxPending = static_cast<uint8_t>(pending);
+        }
+    }
+
+    /**
+     * @brief 受信タスク本体
+     */
+    static void receiveTaskMain(void*)
+    {
+        for (;;)
+        {
+            uint8_t index;
+            if (xQueueReceive(readyFrameQueue, &index, portMAX_DELAY) != pdTRUE)
+            {
+                continue;
+            }
+            processFrame(taskFrameMacs[index], taskFrames[index], taskFrameLens[index]);
+            xQueueSend(freeFrameQueue, &index, 0);
+        }
+    }
+#endif
+
+    /**
+     * @brief ESP-NOW受信コールバック
+     * @details 受信タスクを起動していれば、フレームを渡すだけで戻る
+     * @param mac 送信元MACアドレス
+     * @param incomingData 受信データ
+     * @param len データ長
+     */
+    static void onDataRecv(const uint8_t* mac, const uint8_t* incomingData, int len)
+    {
+        if (len > 0)
+        {
+            WCOM_TRACE(Recv, traceFrameId(incomingData, static_cast<size_t>(len)),
+                       static_cast<uint32_t>(len) | (traceFrameType(incomingData, static_cast<size_t>(len)) << 16));
+        }
+#if ROBO_WCOM_HAS_RECEIVE_TASK
+        if (receiveTask && len > 0 && len <= static_cast<int>(Wire::MAX_FRAME_SIZE))
+        {
+            queueFrame(mac, incomingData, len);
+            return;
+        }
+#endif
+        processFrame(mac, incomingData, len);
+    }
+
+    /**
+     * @brief 受信フレームの検証・受信バッファへの格納・ハンドラの呼び出し
+     * @details 受信コールバック（Wi-Fiタスク）または受信タスクから呼ばれる
+     * @param mac          送信元MAC（nullptr: InjectFrame() で投入されたフレーム）
+     * @param incomingData 受信フレーム
+     * @param len          受信フレーム長
+     */
+    static void processFrame(const uint8_t* mac, const uint8_t* incomingData, int len)
+    {
+        Packet pkt;
+        if (len > 0)
+        {
+            CaptureFrame(Capture::Direction::Rx, Status::Ok, incomingData, static_cast<size_t>(len));
+        }
+        // CRC32 より弱い検査は暗号化を前提にしている。ESP-NOW は暗号化Peer以外からの平文フレームも
+        // 受け取るため、通信相手以外から届いた型付きフレームは検査の前に捨てる
+        if (len > 0 && len != static_cast<int>(Wire::LEGACY_FRAME_SIZE) &&
+            frameCheck(incomingData[0]) != IntegrityCheck::Crc32 && !fromPeer(mac))
+        {
+            return;
+        }
+        bool trusted = encryptionEnabled && fromPeer(mac);
+        if (len == static_cast<int>(Wire::LEGACY_FRAME_SIZE))
+        {
+            if (!parseLegacyFrame(incomingData, len, pkt))
+            {
+                return;
+            }
+        }
+        else if (len > 0 && incomingData[0] == static_cast<uint8_t>(Wire::FrameType::Data))
+        {
+            if (!parseDataFrame(incomingData, len, trusted, pkt))
+            {
+                return;
+            }
+        }
+        else if (len > 0 && incomingData[0] == static_cast<uint8_t>(Wire::FrameType::Redundant))
+        {
+            receiveRedundantFrame(incomingData, len, trusted);
+            return;
+        }
+        else if (len > 0 && incomingData[0] == static_cast<uint8_t>(Wire::FrameType::Priority))
+        {
+            // 優先パケットはFIFOを経由せず専用スロットへ格納する。破損したものは採用しない
+            if (!parseDataFrame(incomingData, len, trusted, pkt) || !pkt.crcOk)
+            {
+                return;
+            }
+            noteLinkReceive(millis(), 0);
+            WCOM_TRACE(Push, pkt.data.timestamp, 1 | 2);
+            RECV_LOCK();
+            prioritySlot = pkt;
+            prioritySeq = ++arrivalSeq;
+            priorityReady = true;
+            publishLatest(&pkt.data, true);
+            RECV_UNLOCK();
+            if (priorityCallback)
+            {
+                priorityCallback(pkt.data);
+            }
+            return;
+        }
+        else if (len > 0 && incomingData[0] == static_cast<uint8_t>(Wire::FrameType::Fleet))
+        {
+            receiveFleetFrame(mac, incomingData, len);
+            return;
+        }
+        else if (len > 0 && incomingData[0] == static_cast<uint8_t>(Wire::FrameType::Heartbeat))
+        {
+            // ハートビートは生存確認のみでバッファには積まない
+            if (parseHeartbeatFrame(incomingData, len, trusted))
+            {
+                noteLinkReceive(millis(), 0);
+            }
+            return;
+        }
+        else
+        {
+            // 拡張フレームは登録されたハンドラが処理する
+            if (len > 0)
+            {
+                receiveExtFrame(incomingData, len, trusted);
+            }
+            return;
+        }
+        noteLinkReceive(millis(), pkt.crcOk ? 0 : 1);
+        pushToBuffer(pkt);
+    }
+
+    /**
+     * @brief 組み立て済みのフレームを送信する
+     * @param dest  送信先MAC
+     * @param frame 送信フレーム
+     * @param len   フレーム長
+     * @return true:送信要求成功 / false:失敗
+     */
+    static bool transmitFrame(const uint8_t* dest, const uint8_t* frame, size_t len)
+    {
+        bool ok = (esp_now_send(dest, frame, len) == ESP_OK);
+        WCOM_TRACE(EspNowSend, traceFrameId(frame, len), (ok ? 1 : 0) | (traceFrameType(frame, len) << 8));
+        CaptureFrame(Capture::Direction::Tx, ok ? Status::Ok : Status::SendFail, frame, len);
+        RateNoteSubmit(ok);
+        return ok;
+    }
+
+    /**
+     * @brief priorityData から優先フレームを組み立て、送信待ちにする
+     * @details 送信経路の排他（SendGuard）を取った状態で呼ぶ
+     */
+    static void buildPriorityFrame(void)
+    {
+        // 優先データフレームに対応していない相手には通常のデータフレームで送る（受信バッファ経由で届く）
+        if (peerSupports(Wire::HELLO_CAP_PRIORITY))
+        {
+            priorityFrameLen = buildDataFrame(Wire::FrameType::Priority, priorityData, priorityFrame);
+        }
+        else
+        {
+            priorityFrameLen = buildPlainFrame(priorityData, priorityFrame);
+        }
+        priorityTxPending = true;
+    }
+
+    /**
+     * @brief 送信待ちの優先フレームを送信する
+     * @details
+     * 優先フレームのバッファを触るため、送信経路の排他（SendGuard）を取った状態で呼ぶ。
+     * 排他を待ちきれずに保留された優先パケットがあれば、ここで組み立てて送信待ちのものと置き換える
+     * @return true:送信待ちなし / false:まだ送信できない
+     */
+    static bool flushPendingPriority(void)
+    {
+        PRIORITY_LOCK();
+        bool deferred = priorityDeferred;
+        if (deferred)
+        {
+            priorityData = deferredPriorityData;
+            priorityDeferred = false;
+        }
+        PRIORITY_UNLOCK();
+        // 保留した後に相手の最大搬送データサイズが縮んだ場合は送らない
+        if (deferred && priorityData.carriedSize <= peerMaxPayload)
+        {
+            buildPriorityFrame();
+        }
+
+        if (!priorityTxPending)
+        {
+            return true;
+        }
+        if (!transmitFrame(peerAddr, priorityFrame, priorityFrameLen))
+        {
+            return false;
+        }
+        priorityTxPending = false;
+        return true;
+    }
+
+    /**
+     * @brief 優先パケットを組み立てて送信する
+     * @details 送信経路の排他を取った状態で呼ぶ
+     * @return ステータスコード (Status)
+     */
+    static Status sendPriorityLocked(uint32_t timestamp, const uint8_t* data, uint8_t size)
+    {
+        if (size > peerMaxPayload)
+        {
+            return Status::InvalidArg;
+        }
+
+        // 保留中の古い優先フレーム（排他を待ちきれなかったものを含む）は新しいもので置き換える
+        PRIORITY_LOCK();
+        priorityDeferred = false;
+        PRIORITY_UNLOCK();
+        priorityData.timestamp = timestamp;
+        memcpy(priorityData.address, ownAddr, sizeof(ownAddr));
+        priorityData.carriedSize = size;
+        memcpy(priorityData.carriedData, data, size);
+        buildPriorityFrame();
+
+        if (flushPendingPriority())
+        {
+            return Status::Ok;
+        }
+        return Status::SendFail;
+    }
+
+    /**
+     * @brief ESP-NOW送信完了コールバック
+     * @details 成否をレート制御（ROBO_WCOM_Rate.h）の混雑判定に使う
+     * @param mac_addr 送信先MAC
+     * @param status   送信ステータス
+     */
+    static void onDataSent(const uint8_t*, esp_now_send_status_t status)
+    {
+        WCOM_TRACE(SendDone, 0, status == ESP_NOW_SEND_SUCCESS ? 1 : 0);
+        RateNoteComplete(status == ESP_NOW_SEND_SUCCESS);
+    }
+
+
+    /**
+     * @brief パケットからデータを抽出（CRCチェック付き）
+     * @param pkt     対象パケット
+     * @param timestamp タイムスタンプ格納先
+     * @param address   アドレス格納先（6バイト）
+     * @param data      データ本体格納先
+     * @param size      データサイズ格納先
+     * @return Status::Ok / Status::CrcError / Status::InvalidArg
+     */
+    static Status extractPacketData(const Packet& pkt, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
+    {
+
+        if(!timestamp || !address || !data || !size)
+        {
+            return Status::InvalidArg;
+        }
+        if (!pkt.crcOk)
+        {
+            return Status::CrcError;
+        }
+
+        *timestamp = pkt.data.timestamp;
+        memcpy(address, pkt.data.address, sizeof(pkt.data.address));
+        *size = pkt.data.carriedSize;
+        memcpy(data, pkt.data.carriedData, *size);
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 空パケットを作成
+     * 
+     * @return Packet 空のパケット
+     */
+    static Packet makeEmptyPacket()
+    {
+        Packet zeroPkt;
+        zeroPkt.data.timestamp = 0;
+        memset(zeroPkt.data.address, 0, sizeof(zeroPkt.data.address));
+        zeroPkt.data.carriedSize = 0;
+        memset(zeroPkt.data.carriedData, 0, sizeof(zeroPkt.data.carriedData));
+        zeroPkt.crcOk = true;
+        return zeroPkt;
+    }
+
+    /**
+     * @brief 空のパケットを生成し、データをゼロにして返す
+     * 
+     * @param timestamp ゼロを格納
+     * @param address   ゼロを格納
+     * @param data      ゼロを格納
+     * @param size      ゼロを格納
+     */
+    static void fillWithEmptyPacket(uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
+    {
+        Packet zeroPkt = makeEmptyPacket();
+        extractPacketData(zeroPkt, timestamp, address, data, size);
+    }
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief 通信初期化
+     * @param sourceAddress 自デバイスのMACアドレス（6バイト）
+     * @param distAddress   通信相手のMACアドレス（6バイト）
+     * @param nowMillis     受信タイムアウト時間（ミリ秒）
+     * @param timeoutMS     受信タイムアウト時間（ミリ秒）
+     * @return ステータスコード (Status)
+     */
+    Status Init(const uint8_t sourceAddress[6], const uint8_t distAddress[6], uint32_t nowMillis, uint32_t timeoutMS)
+    {
+#if defined(ESP_PLATFORM)
+        if (sendMutex == nullptr)
+        {
+            sendMutex = xSemaphoreCreateRecursiveMutexStatic(&sendMutexBuffer);
+        }
+#endif
+        SendGuard guard;
+        linkConfig.degradedAfterMs = timeoutMS / 2;
+        linkConfig.lostAfterMs = timeoutMS;
+        linkConfig.recoverFrames = 3;
+        lastRecvMillis = nowMillis;
+        linkState = LinkState::Recovering;
+        goodRun = 0;
+        lastSendValid = false;
+        heartbeatRun = 0;
+        priorityTxPending = false;
+        PRIORITY_LOCK();
+        priorityDeferred = false;
+        PRIORITY_UNLOCK();
+        redundantSendSeq = 0;
+        prevSendValid = false;
+        redundantRecvValid = false;
+        fecStats = FecStats{};
+        broadcastPeerAdded = false;
+        encryptionEnabled = false;
+        integrityCheck = IntegrityCheck::Crc32;
+        peerCapabilities = Wire::HELLO_CAPS_ALL;
+        peerMaxPayload = CARRIED_DATA_MAX_SIZE;
+
+        // バッファは読み書き位置を戻すだけで初期化する
+        FlushBuffer();
+
+        // アドレスをコピー
+        memcpy(ownAddr, sourceAddress, sizeof(ownAddr));
+        memcpy(peerAddr, distAddress, sizeof(peerAddr));
+
+        // WiFiをステーションモードで初期化
+        WiFi.mode(WIFI_STA);
+ 
+        // ESP-NOWを初期化
+        if (esp_now_init() != ESP_OK)
+        {
+            return Status::EspNowInitFail;
+        }
+        memset(&peerInfo, 0, sizeof(peerInfo));
+        memcpy(peerInfo.peer_addr, distAddress, sizeof(peerAddr));
+        peerInfo.channel = 0;
+        peerInfo.encrypt = false;
+
+        // ペアリング
+        if (esp_now_add_peer(&peerInfo) != ESP_OK)
+        {
+            return Status::AddPeerFail;
+        }
+
+        // コールバック関数を設定
+        esp_now_register_recv_cb(onDataRecv);
+        esp_now_register_send_cb(onDataSent);
+        return Status::Ok;
+    }
+
+    /**
+     * @brief パケット送信
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @param data      送信データへのポインタ
+     * @param size      送信データサイズ（最大 CARRIED_DATA_MAX_SIZE）
+     * @return ステータスコード (Status)
+     */
+    Status SendPacket(uint32_t timestamp, const uint8_t* data, uint8_t size)
+    {
+        SendGuard guard;
+        WCOM_TRACE(SendPacket, timestamp, size);
+        // 送信データが大きすぎたらリミット
+        if (size > CARRIED_DATA_MAX_SIZE)
+        {
+            size = CARRIED_DATA_MAX_SIZE;
+        }
+        // 相手が受信できない大きさは送らない（相手では CRCエラーになるだけ）
+        if (size > peerMaxPayload)
+        {
+            return Status::InvalidArg;
+        }
+
+        // 前回と同じ内容ならハートビートで代用する
+        if (suppressUnchanged && peerSupports(Wire::HELLO_CAP_HEARTBEAT) && lastSendValid && heartbeatRun < heartbeatRefresh &&
+            size == sendData.carriedSize && memcmp(sendData.carriedData, data, size) == 0)
+        {
+            Status hbStatus = SendHeartbeat(timestamp);
+            if (hbStatus == Status::Ok)
+            {
+                heartbeatRun++;
+            }
+            return hbStatus;
+        }
+
+        // 冗長送信では直前に送った内容を退避しておく
+        bool redundant = redundancyEnabled && peerSupports(Wire::HELLO_CAP_REDUNDANT);
+        if (redundant)
+        {
+            prevSendValid = lastSendValid;
+            if (prevSendValid)
+            {
+                prevSendData = sendData;
+            }
+        }
+
+        sendData.timestamp = timestamp;
+        memcpy(sendData.address, ownAddr, sizeof(ownAddr));
+
+        // 送信データを格納
+        sendData.carriedSize = size;
+        memcpy(sendData.carriedData, data, size);
+
+        // 送信フレームを組み立てる（可変長形式では搬送データサイズ分だけ送信する）
+        size_t len;
+        if (redundant)
+        {
+            len = buildRedundantFrame(redundantSendSeq, sendData, prevSendValid ? &prevSendData : nullptr, sendFrame);
+        }
+        else
+        {
+            len = buildPlainFrame(sendData, sendFrame);
+        }
+
+        // 優先フレームが送信待ちなら先に送る
+        if (!flushPendingPriority())
+        {
+            lastSendValid = false;
+            return Status::SendFail;
+        }
+
+        // 送信処理
+        if (transmitFrame(peerAddr, sendFrame, len))
+        {
+            lastSendValid = true;
+            heartbeatRun = 0;
+            if (redundant)
+            {
+                redundantSendSeq++;
+            }
+            return Status::Ok;
+        }
+        else
+        {
+            lastSendValid = false;
+            return Status::SendFail;
+        }
+    }
+
+    /**
+     * @brief 優先パケット送信
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @param data      送信データへのポインタ
+     * @param size      送信データサイズ（最大 CARRIED_DATA_MAX_SIZE）
+     * @return ステータスコード (Status)。送信経路の排他を待ちきれず保留した場合は Status::Busy
+     */
+    Status SendPriorityPacket(uint32_t timestamp, const uint8_t* data, uint8_t size)
+    {
+        if (!data || size > CARRIED_DATA_MAX_SIZE || size > peerMaxPayload)
+        {
+            return Status::InvalidArg;
+        }
+        if (!SEND_TRY_LOCK(PRIORITY_SEND_WAIT_MS))
+        {
+            // 他のタスクが送信中。保留し、次の送信処理で通常フレームより先に送る
+            PRIORITY_LOCK();
+            deferredPriorityData.timestamp = timestamp;
+            memcpy(deferredPriorityData.address, ownAddr, sizeof(ownAddr));
+            deferredPriorityData.carriedSize = size;
+            memcpy(deferredPriorityData.carriedData, data, size);
+            priorityDeferred = true;
+            PRIORITY_UNLOCK();
+            return Status::Busy;
+        }
+        Status result = sendPriorityLocked(timestamp, data, size);
+        SEND_UNLOCK();
+        return result;
+    }
+
+    /**
+     * @brief 自分のロボットIDを設定
+     * @param id ロボットID
+     * @return ステータスコード (Status)
+     */
+    Status SetRobotId(uint8_t id)
+    {
+        if (id == ROBOT_ID_ALL)
+        {
+            return Status::InvalidArg;
+        }
+        robotId = id;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 複数ロボット宛ての搬送データを1フレームで一斉送信
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @param entries   エントリの配列
+     * @param count     エントリ数
+     * @return ステータスコード (Status)
+     */
+    Status SendFleetPacket(uint32_t timestamp, const FleetEntry* entries, uint8_t count)
+    {
+        SendGuard guard;
+        if (!entries || count == 0)
+        {
+            return Status::InvalidArg;
+        }
+
+        // フレームを組み立てる（収まらない場合は送らない）
+        size_t len = Wire::FLEET_OFFSET_ENTRIES;
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            const FleetEntry& e = entries[i];
+            if ((e.size > 0 && !e.data) || e.robotId == ROBOT_ID_NONE ||
+                len + Wire::FLEET_ENTRY_HEADER_SIZE + e.size + Wire::CRC32_SIZE + 1 > Wire::MAX_FRAME_SIZE)
+            {
+                return Status::InvalidArg;
+            }
+            fleetFrame[len] = e.robotId;
+            fleetFrame[len + 1] = e.size;
+            memcpy(fleetFrame + len + Wire::FLEET_ENTRY_HEADER_SIZE, e.data, e.size);
+            len += Wire::FLEET_ENTRY_HEADER_SIZE + e.size;
+        }
+        fleetFrame[Wire::DATA_OFFSET_TYPE] = static_cast<uint8_t>(Wire::FrameType::Fleet);
+        Codec::storeLE32(fleetFrame + Wire::FLEET_OFFSET_TIMESTAMP, timestamp);
+        memcpy(fleetFrame + Wire::FLEET_OFFSET_ADDRESS, ownAddr, sizeof(ownAddr));
+        fleetFrame[Wire::FLEET_OFFSET_COUNT] = count;
+        // ブロードキャストは暗号化できないため、整合性検査の設定によらず CRC32 を付ける
+        Codec::storeLE32(fleetFrame + len, Codec::crc32(fleetFrame, len));
+        len += Wire::CRC32_SIZE;
+        // 従来形式と同じ長さになる場合は詰め物を付けて区別する
+        if (len == Wire::LEGACY_FRAME_SIZE)
+        {
+            fleetFrame[len++] = 0;
+        }
+
+        // ブロードキャストアドレスは最初の一斉送信時にPeer登録する
+        if (!broadcastPeerAdded)
+        {
+            esp_now_peer_info_t broadcastPeer;
+            memset(&broadcastPeer, 0, sizeof(broadcastPeer));
+            memcpy(broadcastPeer.peer_addr, BROADCAST_ADDR, sizeof(BROADCAST_ADDR));
+            broadcastPeer.channel = 0;
+            broadcastPeer.encrypt = false;
+            if (esp_now_add_peer(&broadcastPeer) != ESP_OK)
+            {
+                return Status::AddPeerFail;
+            }
+            broadcastPeerAdded = true;
+        }
+
+        // 優先フレームが送信待ちなら先に送る
+        if (!flushPendingPriority())
+        {
+            return Status::SendFail;
+        }
+        if (transmitFrame(BROADCAST_ADDR, fleetFrame, len))
+        {
+            return Status::Ok;
+        }
+        return Status::SendFail;
+    }
+
+    /**
+     * @brief リンク状態の判定条件を設定
+     * @param config 判定条件
+     * @return ステータスコード (Status)
+     */
+    Status SetLinkConfig(const LinkConfig& config)
+    {
+        if (config.degradedAfterMs > config.lostAfterMs || config.recoverFrames == 0)
+        {
+            return Status::InvalidArg;
+        }
+        LINK_LOCK();
+        linkConfig = config;
+        LINK_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief リンク状態遷移時のコールバックを設定
+     * @param callback コールバック関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetLinkStateCallback(LinkStateCallback callback)
+    {
+        linkCallback = callback;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 現在時刻でリンク状態を更新して返す
+     * @details
+     * 経過時間は符号付き差分で求めるため millis() の周回をまたいでも正しく判定できる。
+     * 受信コールバックが nowMillis より新しい受信時刻を書き込んでいても経過 0 として扱う。
+     * @param nowMillis 現在時刻（millis）
+     * @return 更新後のリンク状態
+     */
+    LinkState UpdateLinkState(uint32_t nowMillis)
+    {
+        LINK_LOCK();
+        LinkState from = linkState;
+        LinkState to = from;
+        int32_t elapsed = static_cast<int32_t>(nowMillis - lastRecvMillis);
+        if (elapsed > static_cast<int32_t>(linkConfig.lostAfterMs))
+        {
+            to = LinkState::Lost;
+            goodRun = 0;
+            if (from != LinkState::Lost)
+            {
+                resetFecState();
+            }
+        }
+        else if (elapsed > static_cast<int32_t>(linkConfig.degradedAfterMs) && from == LinkState::Up)
+        {
+            to = LinkState::Degraded;
+            goodRun = 0;
+        }
+        linkState = to;
+        LINK_UNLOCK();
+        notifyLinkState(from, to);
+        return to;
+    }
+
+    /**
+     * @brief 最後に更新されたリンク状態を取得
+     * @return リンク状態
+     */
+    LinkState GetLinkState(void)
+    {
+        return linkState;
+    }
+
+    /**
+     * @brief 前方誤り訂正（冗長送信）を設定
+     * @param enable 有効/無効
+     * @return ステータスコード (Status)
+     */
+    Status SetRedundancy(bool enable)
+    {
+        SendGuard guard;
+        redundancyEnabled = enable;
+        prevSendValid = false;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 前方誤り訂正の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetFecStats(FecStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        *stats = fecStats;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 優先パケット受信時のコールバックを設定
+     * @param callback コールバック関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetPriorityCallback(PriorityCallback callback)
+    {
+        priorityCallback = callback;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 生存通知（ハートビート）を送信
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @return ステータスコード (Status)
+     */
+    Status SendHeartbeat(uint32_t timestamp)
+    {
+        SendGuard guard;
+        // 優先フレームが送信待ちなら先に送る
+        if (!flushPendingPriority())
+        {
+            return Status::SendFail;
+        }
+
+        // 生存通知に対応していない相手には直前のパケットを送り直す（まだ送っていなければ何もしない）
+        uint8_t frame[Wire::MAX_FRAME_SIZE];
+        size_t len;
+        if (!peerSupports(Wire::HELLO_CAP_HEARTBEAT))
+        {
+            if (!lastSendValid)
+            {
+                return Status::Ok;
+            }
+            len = buildPlainFrame(sendData, frame);
+        }
+        else
+        {
+            frame[0] = static_cast<uint8_t>(Wire::FrameType::Heartbeat);
+            Codec::storeLE16(frame + Wire::HEARTBEAT_OFFSET_SEQ, heartbeatSeq++);
+            Codec::storeLE32(frame + Wire::HEARTBEAT_OFFSET_TIMESTAMP, timestamp);
+            len = sealTypedFrame(frame, Wire::HEARTBEAT_OFFSET_CRC);
+        }
+
+        if (transmitFrame(peerAddr, frame, len))
+        {
+            return Status::Ok;
+        }
+        return Status::SendFail;
+    }
+
+    /**
+     * @brief 内容が変化していない送信をハートビートへ置き換える
+     * @param enable          有効/無効
+     * @param refreshInterval パケットを再送するまでのハートビート連続回数（1以上）
+     * @return ステータスコード (Status)
+     */
+    Status SetHeartbeatSuppression(bool enable, uint8_t refreshInterval)
+    {
+        if (enable && refreshInterval == 0)
+        {
+            return Status::InvalidArg;
+        }
+        SendGuard guard;
+        suppressUnchanged = enable;
+        heartbeatRefresh = refreshInterval;
+        heartbeatRun = 0;
+        return Status::Ok;
     }
 
     /**
-     * @brief 受信バッファにパケットを追加
-     * @param pkt 追加するパケット
+     * @brief 送信フレーム形式を設定
+     * @param format 送信フレーム形式
+     * @return ステータスコード (Status)
      */
-    static void pushToBuffer(const Packet& pkt)
+    Status SetFrameFormat(FrameFormat format)
     {
-        recvBuffer[head] = pkt;
-        head = (head + 1) % RECEIVE_BUFFER_SIZE;
-        if (count < RECEIVE_BUFFER_SIZE)
+        if (format != FrameFormat::Full && format != FrameFormat::Compact)
         {
-            count++;
-        }
-        else
-        {
-            // 上書き時はtailも進める
-            tail = (tail + 1) % RECEIVE_BUFFER_SIZE;
+            return Status::InvalidArg;
         }
+        SendGuard guard;
+        sendFormat = format;
+        return Status::Ok;
     }
 
     /**
-     * @brief 受信処理を切り替えるための定数
-     * 
-     */
-    enum class BufferMode { Pop, Peek };
-
-    /**
-     * @brief パケットを受信する処理。バッファ操作を行う場合と行わない場合での切り替えが可能
-     * 
-     * @param mode 受信状態切り替え
-     * @param nowMillis 現在時刻（millis）
-     * @param timestamp 受信パケットのタイムスタンプ格納先
-     * @param address   送信元アドレス格納先（6バイト）
-     * @param data      受信データ格納先
-     * @param size      受信データサイズ格納先
+     * @brief 通信相手を暗号化Peerとして登録し直す
+     * @param pmk 主鍵（ESP_NOW_KEY_LEN バイト、nullptr で暗号化を解除）
+     * @param lmk 通信相手との鍵（ESP_NOW_KEY_LEN バイト、nullptr で暗号化を解除）
      * @return ステータスコード (Status)
      */
-    static Status getPacket(BufferMode mode, uint32_t nowMillis,
-                            uint32_t* timestamp, uint8_t* address,
-                            uint8_t* data, uint8_t* size)
+    Status SetEncryption(const uint8_t* pmk, const uint8_t* lmk)
     {
-        Packet pkt;
-        if ((int32_t)nowMillis - (int32_t)lastRecvMillis > (int32_t)timeoutMillis)
+        if ((pmk == nullptr) != (lmk == nullptr))
         {
-            return Status::Timeout;
+            return Status::InvalidArg;
         }
-
-        if (mode == BufferMode::Pop)
+        if (!pmk)
         {
-            // POP処理ではデータを取り出すとともにバッファ操作を行う
-            if (!popFromBuffer(pkt))
+            // 暗号化なしで CRC32 より弱い検査は許さないため、検査も既定に戻す
+            peerInfo.encrypt = false;
+            memset(peerInfo.lmk, 0, sizeof(peerInfo.lmk));
+            if (esp_now_mod_peer(&peerInfo) != ESP_OK)
             {
-                // バッファが空の場合、ゼロ埋めしたうえで、空であることを通知する
-                fillWithEmptyPacket(timestamp, address, data, size);
-                return Status::BufferEmpty;
+                return Status::EncryptFail;
             }
+            encryptionEnabled = false;
+            integrityCheck = IntegrityCheck::Crc32;
+            return Status::Ok;
         }
-        else
+
+        if (esp_now_set_pmk(pmk) != ESP_OK)
         {
-            pkt = recvBuffer[tail];
+            return Status::EncryptFail;
         }
-        return extractPacketData(pkt, timestamp, address, data, size);
+        memcpy(peerInfo.lmk, lmk, sizeof(peerInfo.lmk));
+        peerInfo.encrypt = true;
+        if (esp_now_mod_peer(&peerInfo) != ESP_OK)
+        {
+            peerInfo.encrypt = false;
+            memset(peerInfo.lmk, 0, sizeof(peerInfo.lmk));
+            return Status::EncryptFail;
+        }
+        encryptionEnabled = true;
+        return Status::Ok;
     }
+
     /**
-     * @brief 受信バッファからパケットを取り出す
-     * @param pkt 取り出したパケット格納先
-     * @return true:成功 / false:空
+     * @brief 型付きフレームの整合性検査を設定
+     * @param check 整合性検査
+     * @return ステータスコード (Status)
      */
-    static bool popFromBuffer(Packet& pkt)
+    Status SetIntegrityCheck(IntegrityCheck check)
     {
-        if (count <= 0)
+        if (check != IntegrityCheck::Crc32 && check != IntegrityCheck::Crc16 && check != IntegrityCheck::None)
         {
-            return false;
+            return Status::InvalidArg;
         }
-        pkt = recvBuffer[tail];
-        tail = (tail + 1) % RECEIVE_BUFFER_SIZE;
-        --count;
-        return true;
+        if (check != IntegrityCheck::Crc32 && !encryptionEnabled)
+        {
+            return Status::NotEncrypted;
+        }
+        SendGuard guard;
+        integrityCheck = check;
+        return Status::Ok;
     }
 
     /**
-     * @brief ESP-NOW受信コールバック
-     * @param mac 送信元MACアドレス
-     * @param incomingData 受信データ
-     * @param len データ長
+     * @brief 通信相手が受け付けるフレームを設定
+     * @param capabilities 対応機能（Wire::HELLO_CAP_* の論理和）
+     * @return ステータスコード (Status)
      */
-    static void onDataRecv(const uint8_t* mac, const uint8_t* incomingData, int len)
+    Status SetPeerCapabilities(uint16_t capabilities)
     {
-        if (len != sizeof(Packet))
-        {
-            return;
-        }
-        lastRecvMillis = millis();
-        Packet pkt;
-        memcpy(&pkt, incomingData, sizeof(Packet));
-        pushToBuffer(pkt);
+        SendGuard guard;
+        peerCapabilities = capabilities & Wire::HELLO_CAPS_ALL;
+        prevSendValid = false;
+        heartbeatRun = 0;
+        return Status::Ok;
     }
 
     /**
-     * @brief ESP-NOW送信完了コールバック
-     * @param mac_addr 送信先MAC
-     * @param status   送信ステータス
+     * @brief 通信相手が受け付けるフレームを取得
+     * @return 対応機能（Wire::HELLO_CAP_* の論理和）
      */
-    static void onDataSent(const uint8_t*, esp_now_send_status_t)
+    uint16_t GetPeerCapabilities(void)
     {
-        // 送信完了時の処理（必要なら実装）
-        // 今回は特に何もしない
-        return;
+        return peerCapabilities;
     }
 
-
     /**
-     * @brief パケットからデータを抽出（CRCチェック付き）
-     * @param pkt     対象パケット
-     * @param timestamp タイムスタンプ格納先
-     * @param address   アドレス格納先（6バイト）
-     * @param data      データ本体格納先
-     * @param size      データサイズ格納先
-     * @return Status::Ok / Status::CrcError / Status::InvalidArg
+     * @brief 通信相手が受信できる最大搬送データサイズを設定
+     * @param size 最大搬送データサイズ（1～CARRIED_DATA_MAX_SIZE）
+     * @return ステータスコード (Status)
      */
-    static Status extractPacketData(const Packet& pkt, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
+    Status SetPeerMaxPayload(uint8_t size)
     {
-
-        if(!timestamp || !address || !data || !size)
+        if (size == 0 || size > CARRIED_DATA_MAX_SIZE)
         {
             return Status::InvalidArg;
         }
-        if (calcCRC32(pkt.data) != pkt.crc32)
-        {
-            return Status::CrcError;
-        }
-
-        *timestamp = pkt.data.timestamp;
-        memcpy(address, pkt.data.address, sizeof(pkt.data.address));
-        *size = pkt.data.carriedSize;
-        memcpy(data, pkt.data.carriedData, *size);
+        SendGuard guard;
+        peerMaxPayload = size;
         return Status::Ok;
     }
 
     /**
-     * @brief 空パケットを作成
-     * 
-     * @return Packet 空のパケット
+     * @brief 通信相手が受信できる最大搬送データサイズを取得
+     * @return 最大搬送データサイズ
      */
-    static Packet makeEmptyPacket()
+    uint8_t GetPeerMaxPayload(void)
     {
-        Packet zeroPkt;
-        zeroPkt.data.timestamp = 0;
-        memset(zeroPkt.data.address, 0, sizeof(zeroPkt.data.address));
-        zeroPkt.data.carriedSize = 0;
-        memset(zeroPkt.data.carriedData, 0, sizeof(zeroPkt.data.carriedData));
-        zeroPkt.crc32 = calcCRC32(zeroPkt.data);
-        return zeroPkt;
+        return peerMaxPayload;
     }
 
     /**
-     * @brief 空のパケットを生成し、データをゼロにして返す
-     * 
-     * @param timestamp ゼロを格納
-     * @param address   ゼロを格納
-     * @param data      ゼロを格納
-     * @param size      ゼロを格納
+     * @brief 送信経路の排他を待ち時間付きで取る
+     * @param waitMillis 待つ最大時間（ミリ秒、0 で待たない）
+     * @return true:取れた / false:待ち時間内に取れなかった
      */
-    static void fillWithEmptyPacket(uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
+    bool SendTryLock(uint32_t waitMillis)
     {
-        Packet zeroPkt = makeEmptyPacket();
-        extractPacketData(zeroPkt, timestamp, address, data, size);
+        return SEND_TRY_LOCK(waitMillis);
     }
-    //======= 公開API実装 =======//
 
     /**
-     * @brief 通信初期化
-     * @param sourceAddress 自デバイスのMACアドレス（6バイト）
-     * @param distAddress   通信相手のMACアドレス（6バイト）
-     * @param nowMillis     受信タイムアウト時間（ミリ秒）
-     * @param timeoutMS     受信タイムアウト時間（ミリ秒）
-     * @return ステータスコード (Status)
+     * @brief SendTryLock() で取った送信経路の排他を返す
      */
-    Status Init(const uint8_t sourceAddress[6], const uint8_t distAddress[6], uint32_t nowMillis, uint32_t timeoutMS)
+    void SendUnlock(void)
     {
-        uint8_t i;
-        Packet zeroPkt = makeEmptyPacket();     // 中身が空でCRCが成立しているデータを作成
-        timeoutMillis = timeoutMS;
-        lastRecvMillis = nowMillis;
-        head = 0;
-        tail = 0;
-        count = 0;
+        SEND_UNLOCK();
+    }
+
+    /**
+     * @brief 自分が受け付けるフレームと暗号化の状態を取得
+     * @return 対応機能（Wire::HELLO_CAP_* の論理和。暗号化Peerなら Wire::HELLO_CAP_ENCRYPTED を含む）
+     */
+    uint16_t GetLocalCapabilities(void)
+    {
+        return Wire::HELLO_CAPS_ALL | (encryptionEnabled ? Wire::HELLO_CAP_ENCRYPTED : 0);
+    }
 
-        // バッファをゼロ埋めして初期化する
-        for (i = 0; i < RECEIVE_BUFFER_SIZE; i++)
+    /**
+     * @brief 拡張フレームの受信ハンドラを登録する
+     * @param frameType フレーム種別
+     * @param handler   ハンドラ（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetFrameHandler(uint8_t frameType, FrameHandler handler)
+    {
+        switch (static_cast<Wire::FrameType>(frameType))
         {
-            pushToBuffer(zeroPkt);
+            case Wire::FrameType::Data:
+            case Wire::FrameType::Redundant:
+            case Wire::FrameType::Priority:
+            case Wire::FrameType::Heartbeat:
+            case Wire::FrameType::Fleet:
+                return Status::InvalidArg;
+            default:
+                break;
         }
-        FlushBuffer();
-
-        // アドレスをコピー
-        memcpy(ownAddr, sourceAddress, sizeof(ownAddr));
-        memcpy(peerAddr, distAddress, sizeof(peerAddr));
 
-        // WiFiをステーションモードで初期化
-        WiFi.mode(WIFI_STA);
- 
-        // ESP-NOWを初期化
-        if (esp_now_init() != ESP_OK)
+        // 登録済みなら置き換え、未登録なら空きへ登録する
+        size_t slot = EXT_HANDLER_MAX;
+        for (size_t i = 0; i < EXT_HANDLER_MAX; ++i)
         {
-            return Status::EspNowInitFail;
+            if (extHandlers[i] && extTypes[i] == frameType)
+            {
+                slot = i;
+                break;
+            }
+            if (!extHandlers[i] && slot == EXT_HANDLER_MAX)
+            {
+                slot = i;
+            }
         }
-        memset(&peerInfo, 0, sizeof(peerInfo));
-        memcpy(peerInfo.peer_addr, distAddress, sizeof(peerAddr));
-        peerInfo.channel = 0;
-        peerInfo.encrypt = false;
-
-        // ペアリング
-        if (esp_now_add_peer(&peerInfo) != ESP_OK)
+        if (slot == EXT_HANDLER_MAX)
         {
-            return Status::AddPeerFail;
+            return handler ? Status::InvalidArg : Status::Ok;
         }
-
-        // コールバック関数を設定
-        esp_now_register_recv_cb(onDataRecv);
-        esp_now_register_send_cb(onDataSent);
+        extHandlers[slot] = nullptr;
+        extTypes[slot] = frameType;
+        extHandlers[slot] = handler;
         return Status::Ok;
     }
 
     /**
-     * @brief パケット送信
-     * @param timestamp 送信時刻（任意の基準でOK）
-     * @param data      送信データへのポインタ
-     * @param size      送信データサイズ（最大 CARRIED_DATA_MAX_SIZE）
+     * @brief 拡張フレームを通信相手へ送信する
+     * @param frameType フレーム種別
+     * @param body      本体
+     * @param size      本体長
      * @return ステータスコード (Status)
      */
-    Status SendPacket(uint32_t timestamp, const uint8_t* data, uint8_t size)
+    Status SendExtFrame(uint8_t frameType, const uint8_t* body, uint8_t size)
     {
+        SendGuard guard;
+        if ((size > 0 && !body) || size > Wire::EXT_BODY_MAX)
+        {
+            return Status::InvalidArg;
+        }
+        // ハンドシェイクは最大搬送データサイズを伝え合うためのものなので制限しない
+        if (size > peerMaxPayload && frameType != static_cast<uint8_t>(Wire::FrameType::Hello))
+        {
+            return Status::InvalidArg;
+        }
 
-        sendPacket.data.timestamp = timestamp;
-        memcpy(sendPacket.data.address, ownAddr, sizeof(ownAddr));
-
-        // 送信データが大きすぎたらリミット
-        if (size > CARRIED_DATA_MAX_SIZE)
+        // 優先フレームが送信待ちなら先に送る
+        if (!flushPendingPriority())
         {
-            size = CARRIED_DATA_MAX_SIZE;
+            return Status::SendFail;
         }
 
-        // 送信データを格納
-        sendPacket.data.carriedSize = size;
-        memcpy(sendPacket.data.carriedData, data, size);
-        sendPacket.crc32 = calcCRC32(sendPacket.data);
+        uint8_t frame[Wire::MAX_FRAME_SIZE];
+        frame[0] = frameType;
+        frame[Wire::EXT_OFFSET_LENGTH] = size;
+        memcpy(frame + Wire::EXT_OFFSET_BODY, body, size);
+        size_t len = sealTypedFrame(frame, Wire::EXT_HEADER_SIZE + size);
 
-        // 送信処理
-        if (esp_now_send(peerAddr, reinterpret_cast<uint8_t*>(&sendPacket), sizeof(Packet)) == ESP_OK)
+        if (transmitFrame(peerAddr, frame, len))
         {
             return Status::Ok;
         }
-        else
+        return Status::SendFail;
+    }
+
+    /**
+     * @brief 受信フレームを受信コールバックと同じ経路で処理する
+     * @param frame 受信フレーム
+     * @param len   受信フレーム長
+     * @return ステータスコード (Status)
+     */
+    Status InjectFrame(const uint8_t* frame, int len)
+    {
+        if (!frame || len <= 0 || len > static_cast<int>(Wire::MAX_FRAME_SIZE))
         {
-            return Status::SendFail;
+            return Status::InvalidArg;
         }
+        onDataRecv(nullptr, frame, len);
+        return Status::Ok;
     }
 
     /**
@@ -327,7 +2060,12 @@ namespace ROBO_WCOM
      */
     Status PopOldestPacket(uint32_t nowMillis, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
     {
-        return getPacket(BufferMode::Pop, nowMillis, timestamp, address, data, size);
+        Status status = getPacket(BufferMode::Pop, nowMillis, timestamp, address, data, size);
+        if (status == Status::Ok || status == Status::CrcError)
+        {
+            WCOM_TRACE(Pop, *timestamp, static_cast<uint8_t>(status));
+        }
+        return status;
     }
 
     /**
@@ -342,7 +2080,127 @@ namespace ROBO_WCOM
      */
     Status PeekLatestPacket(uint32_t nowMillis, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
     {
-        return getPacket(BufferMode::Peek, nowMillis, timestamp, address, data, size);
+        Status status = getPacket(BufferMode::Peek, nowMillis, timestamp, address, data, size);
+        if (status == Status::Ok || status == Status::CrcError)
+        {
+            WCOM_TRACE(Peek, *timestamp, static_cast<uint8_t>(status));
+        }
+        return status;
+    }
+
+    /**
+     * @brief 最後に受信したパケットを参照する（割り込みから呼べる版）
+     * @param nowMillis 現在時刻（millis）
+     * @param timestamp 受信パケットのタイムスタンプ格納先
+     * @param address   送信元アドレス格納先（6バイト）
+     * @param data      受信データ格納先
+     * @param size      受信データサイズ格納先
+     * @return ステータスコード (Status)
+     */
+    Status PeekLatestPacketFromISR(uint32_t nowMillis, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size)
+    {
+        if (!timestamp || !address || !data || !size)
+        {
+            return Status::InvalidArg;
+        }
+        // リンク状態は更新せず（ロックもコールバックも使わない）、最終受信時刻だけで判断する
+        int32_t elapsed = static_cast<int32_t>(nowMillis - lastRecvMillis);
+        if (linkState == LinkState::Lost || elapsed > static_cast<int32_t>(linkConfig.lostAfterMs))
+        {
+            return Status::Timeout;
+        }
+
+        for (int attempt = 0; attempt < LATEST_READ_ATTEMPTS; ++attempt)
+        {
+            uint32_t seq = latestPublished.load(std::memory_order_acquire);
+            const LatestCopy& copy = latestCopies[seq & 1];
+            bool valid = copy.valid;
+            bool crcOk = copy.crcOk;
+            uint32_t copiedTimestamp = copy.timestamp;
+            uint8_t copiedSize = copy.carriedSize;
+            memcpy(address, copy.address, sizeof(copy.address));
+            memcpy(data, copy.carriedData, copiedSize);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // 読んでいる間にこの面へ書き始めていなければ、読んだ内容はそろっている
+            if (latestWriting.load(std::memory_order_relaxed) - seq > 1)
+            {
+                continue;
+            }
+            if (!valid)
+            {
+                fillWithEmptyPacket(timestamp, address, data, size);
+                return Status::BufferEmpty;
+            }
+            if (!crcOk)
+            {
+                return Status::CrcError;
+            }
+            *timestamp = copiedTimestamp;
+            *size = copiedSize;
+            return Status::Ok;
+        }
+        return Status::Busy;
+    }
+
+    /**
+     * @brief 受信処理を専用タスクへ移す
+     * @param config 設定
+     * @return ステータスコード (Status)
+     */
+    Status StartReceiveTask(const ReceiveTaskConfig& config)
+    {
+#if ROBO_WCOM_HAS_RECEIVE_TASK
+        if (config.core < -1 || config.core >= static_cast<int8_t>(portNUM_PROCESSORS) || config.stackSize == 0)
+        {
+            return Status::InvalidArg;
+        }
+        if (receiveTask)
+        {
+            return Status::Ok;
+        }
+        if (!freeFrameQueue)
+        {
+            freeFrameQueue = xQueueCreate(RECEIVE_TASK_FRAMES, sizeof(uint8_t));
+            readyFrameQueue = xQueueCreate(RECEIVE_TASK_FRAMES, sizeof(uint8_t));
+            if (!freeFrameQueue || !readyFrameQueue)
+            {
+                return Status::TaskFail;
+            }
+            for (size_t i = 0; i < RECEIVE_TASK_FRAMES; ++i)
+            {
+                uint8_t index = static_cast<uint8_t>(i);
+                xQueueSend(freeFrameQueue, &index, 0);
+            }
+        }
+        BaseType_t core = (config.core < 0) ? tskNO_AFFINITY : config.core;
+        TaskHandle_t handle = nullptr;
+        if (xTaskCreatePinnedToCore(receiveTaskMain, "ROBO_WCOM_Rx", config.stackSize, nullptr,
+                                    config.priority, &handle, core) != pdPASS)
+        {
+            return Status::TaskFail;
+        }
+        // 受信コールバックはこれ以降に届いたフレームから受信タスクへ渡す
+        receiveTask = handle;
+        return Status::Ok;
+#else
+        (void)config;
+        return Status::TaskFail;
+#endif
+    }
+
+    /**
+     * @brief 受信タスクの統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetReceiveTaskStats(ReceiveTaskStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        *stats = receiveTaskStats;
+        return Status::Ok;
     }
 
 
@@ -353,6 +2211,9 @@ namespace ROBO_WCOM
      */
     int16_t ReceivedCapacity()
     {
+        RECV_LOCK();
+        int16_t count = recvRing.size();
+        RECV_UNLOCK();
         return count;
     }
 
@@ -363,9 +2224,11 @@ namespace ROBO_WCOM
      */
     Status FlushBuffer(void)
     {
-        head = 0;
-        tail = 0;
-        count = 0;
+        RECV_LOCK();
+        recvRing.clear();
+        priorityReady = false;
+        publishLatest(nullptr, false);
+        RECV_UNLOCK();
         return Status::Ok;
     }
 
@@ -382,9 +2245,36 @@ namespace ROBO_WCOM
             case Status::CrcError:        return "CRC error";
             case Status::BufferEmpty:     return "Buffer empty";
             case Status::InvalidArg:      return "Invalid argument";
+            case Status::Busy:            return "Busy";
             case Status::EspNowInitFail:  return "ESP-NOW init failed";
             case Status::AddPeerFail:     return "Add peer failed";
+            case Status::EncryptFail:     return "Encryption setup failed";
+            case Status::NotEncrypted:    return "Peer not encrypted";
             case Status::SendFail:        return "Send failed";
+            case Status::TimerFail:       return "Timer failed";
+            case Status::TaskFail:        return "Task failed";
+            case Status::RpcPending:      return "RPC pending";
+            case Status::RpcNoHandler:    return "RPC no handler";
+            case Status::RpcTableFull:    return "RPC table full";
+            case Status::ParamTableFull:  return "Param table full";
+            case Status::BulkBusy:        return "Bulk transfer busy";
+            case Status::BulkAborted:     return "Bulk transfer aborted";
+            default:                      return "Unknown";
+        }
+    }
+
+    /**
+     * @brief リンク状態を文字列に変換
+     * @param s リンク状態
+     * @return 文字列
+     */
+    const char* ToString(LinkState s)
+    {
+        switch (s) {
+            case LinkState::Up:           return "Up";
+            case LinkState::Degraded:     return "Degraded";
+            case LinkState::Lost:         return "Lost";
+            case LinkState::Recovering:   return "Recovering";
             default:                      return "Unknown";
         }
     }
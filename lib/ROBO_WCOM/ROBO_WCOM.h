@@ -3,6 +3,57 @@
 
 #include <Arduino.h>
 
+/**
+ * @brief 受信バッファのスロット数
+ * @details ビルドフラグ（-DROBO_WCOM_RECEIVE_SLOTS=...）で変更可能
+ */
+#ifndef ROBO_WCOM_RECEIVE_SLOTS
+#define ROBO_WCOM_RECEIVE_SLOTS 64
+#endif
+
+/**
+ * @brief 受信バッファ1スロットあたりの最大搬送データサイズ
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_RECEIVE_PAYLOAD_MAX=...）で変更可能。
+ * 受信するデータが小さい場合（例: sizeof(RoboCommand_t)）に縮めると RAM を節約できる
+ */
+#ifndef ROBO_WCOM_RECEIVE_PAYLOAD_MAX
+#define ROBO_WCOM_RECEIVE_PAYLOAD_MAX 200
+#endif
+
+/**
+ * @brief 可変長受信バッファのバイト数（0: 固定長スロットを使う）
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_RECEIVE_STORE_BYTES=...）で 0 以外を指定すると、受信バッファを
+ * 実際の長さで詰めて保持する可変長リング（ROBO_WCOM_ByteRing.h）に切り替える。
+ * この場合 ROBO_WCOM_RECEIVE_SLOTS / ROBO_WCOM_RECEIVE_PAYLOAD_MAX は使わない。
+ * 大小のパケットが混在する通信で、同じ RAM により多くのパケットを溜められる
+ */
+#ifndef ROBO_WCOM_RECEIVE_STORE_BYTES
+#define ROBO_WCOM_RECEIVE_STORE_BYTES 0
+#endif
+
+/**
+ * @brief 受信タスクへ渡すために事前確保するフレーム数（0: 受信タスクを使わない）
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_RECEIVE_TASK_FRAMES=...）で 0 以外を指定すると StartReceiveTask() が使える。
+ * 1フレームあたり 250 バイトの RAM を使う。受信タスクが処理するまでに届いたフレームがこの数を超えると捨てる
+ */
+#ifndef ROBO_WCOM_RECEIVE_TASK_FRAMES
+#define ROBO_WCOM_RECEIVE_TASK_FRAMES 0
+#endif
+
+/**
+ * @brief SendPriorityPacket() が送信経路の排他を待つ最大時間（ミリ秒）
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_PRIORITY_SEND_WAIT_MS=...）で変更可能。
+ * 他のタスクの送信がこれより長く続く場合、優先パケットは保留して Status::Busy を返す。
+ * 緊急停止を送るタスクが止まっていられる時間に合わせる
+ */
+#ifndef ROBO_WCOM_PRIORITY_SEND_WAIT_MS
+#define ROBO_WCOM_PRIORITY_SEND_WAIT_MS 2
+#endif
+
 namespace ROBO_WCOM
 {
 
@@ -20,13 +71,32 @@ namespace ROBO_WCOM
         CrcError         = -2,
         BufferEmpty      = -3,
         InvalidArg       = -4,
+        Busy             = -5,
 
         // 初期化
         EspNowInitFail   = -10,
         AddPeerFail      = -11,
+        EncryptFail      = -12,
+        NotEncrypted     = -13,
 
         // 送信
         SendFail         = -20,
+
+        // タイマ・タスク
+        TimerFail        = -30,
+        TaskFail         = -31,
+
+        // RPC
+        RpcPending       = -40,
+        RpcNoHandler     = -41,
+        RpcTableFull     = -42,
+
+        // パラメータ
+        ParamTableFull   = -50,
+
+        // 一括転送
+        BulkBusy         = -60,
+        BulkAborted      = -61,
     };
 
 
@@ -38,7 +108,99 @@ namespace ROBO_WCOM
     /**
      * @brief 受信バッファの最大保持パケット数
      */
-    constexpr size_t RECEIVE_BUFFER_SIZE   = 64;
+    constexpr size_t RECEIVE_BUFFER_SIZE   = ROBO_WCOM_RECEIVE_SLOTS;
+
+    /**
+     * @brief 受信バッファに保持できる最大搬送データサイズ
+     * @details これを超える搬送データを受信した場合、受信APIは Status::CrcError を返す
+     */
+    constexpr size_t RECEIVE_PAYLOAD_MAX   = ROBO_WCOM_RECEIVE_PAYLOAD_MAX;
+
+    /**
+     * @brief 一斉送信で全ロボット宛てのエントリを示すロボットID
+     */
+    constexpr uint8_t ROBOT_ID_ALL  = 0xFF;
+
+    /**
+     * @brief ロボットID未設定（一斉送信では全ロボット宛てのエントリのみ受け取る）
+     */
+    constexpr uint8_t ROBOT_ID_NONE = 0xFE;
+
+    /**
+     * @brief 送信フレーム形式
+     * @details 受信側はどちらの形式も常に受け付ける
+     */
+    enum class FrameFormat : uint8_t {
+        Full    = 0,    ///< 従来形式（常に215バイト固定長）
+        Compact = 1,    ///< 型付き可変長形式（搬送データサイズ分だけ送信）
+    };
+
+    /**
+     * @brief 型付きフレームの整合性検査
+     * @details
+     * 暗号化Peer（SetEncryption()）では ESP-NOW の CCMP が改ざん・破損したフレームを受信前に破棄するため、
+     * ソフトウェアの検査を弱めてフレーム長と計算時間を節約できる。
+     * 従来形式（FrameFormat::Full）・一斉送信・ハンドシェイクのフレームは設定によらず常に CRC32 を使う。
+     * 送信側と受信側で同じ設定にすること（異なる場合はフレーム長が合わず破棄される）。
+     */
+    enum class IntegrityCheck : uint8_t {
+        Crc32 = 0,      ///< CRC32（4バイト、既定値）
+        Crc16 = 1,      ///< CRC16（2バイト、暗号化時のみ）
+        None  = 2,      ///< 検査なし（暗号化時のみ）
+    };
+
+    /**
+     * @brief リンク状態
+     */
+    enum class LinkState : uint8_t {
+        Up         = 0,     ///< 正常
+        Degraded   = 1,     ///< 受信間隔の延び、または欠落・CRCエラーを検出
+        Lost       = 2,     ///< 途絶（受信APIは Timeout を返す）
+        Recovering = 3,     ///< 途絶後（または初期化直後）に受信を再開し、安定待ち
+    };
+
+    /**
+     * @brief リンク状態の判定条件
+     */
+    struct LinkConfig {
+        uint32_t degradedAfterMs;   ///< この時間受信がなければ Degraded
+        uint32_t lostAfterMs;       ///< この時間受信がなければ Lost
+        uint8_t  recoverFrames;     ///< Degraded/Recovering から Up へ戻るのに必要な連続正常受信数
+    };
+
+    /**
+     * @brief リンク状態遷移時に呼ばれるコールバック
+     * @details 受信コールバック（Wi-Fiタスクまたは受信タスク）か受信APIの呼び出し元から呼ばれるため、短時間で戻ること
+     */
+    typedef void (*LinkStateCallback)(LinkState from, LinkState to);
+
+    /**
+     * @brief 前方誤り訂正の統計
+     */
+    struct FecStats {
+        uint32_t received;      ///< 受信した冗長データフレーム数
+        uint32_t recovered;     ///< 前回データから復元したフレーム数
+        uint32_t lost;          ///< 復元できなかった欠落フレーム数
+        uint32_t resyncs;       ///< 送信側の再起動などでシーケンス番号を合わせ直した回数
+    };
+
+    /**
+     * @brief 受信タスクの設定
+     */
+    struct ReceiveTaskConfig {
+        int8_t   core;          ///< 配置するコア（0 / 1、-1 でコア指定なし）
+        uint8_t  priority;      ///< 優先度（受信したフレームを使うタスクより高くする）
+        uint32_t stackSize;     ///< スタックサイズ（バイト）
+    };
+
+    /**
+     * @brief 受信タスクの統計
+     */
+    struct ReceiveTaskStats {
+        uint32_t queued;        ///< 受信タスクへ渡したフレーム数
+        uint32_t dropped;       ///< 事前確保したバッファが空いておらず捨てたフレーム数
+        uint8_t  maxPending;    ///< 処理待ちのフレーム数の最大値
+    };
 
     /**
      * @brief 通信パケットのデータ部構造
@@ -53,6 +215,29 @@ namespace ROBO_WCOM
         uint8_t  carriedData[CARRIED_DATA_MAX_SIZE];///< 搬送データ本体
     };
 
+    /**
+     * @brief 一斉送信の1ロボット分のエントリ
+     */
+    struct FleetEntry {
+        uint8_t robotId;            ///< 宛先ロボットID（ROBOT_ID_ALL で全ロボット）
+        const uint8_t* data;        ///< 搬送データ
+        uint8_t size;               ///< 搬送データサイズ
+    };
+
+    /**
+     * @brief 優先パケット受信時に呼ばれるコールバック
+     * @details ESP-NOW の受信コールバック（Wi-Fiタスク）または受信タスクから呼ばれるため、短時間で戻ること
+     */
+    typedef void (*PriorityCallback)(const PacketData& data);
+
+    /**
+     * @brief 拡張フレーム受信時に呼ばれるハンドラ
+     * @details
+     * 整合性検査済みの本体（種別・本体長・検査値を除く）が渡される。
+     * ESP-NOW の受信コールバック（Wi-Fiタスク）または受信タスクから呼ばれるため、短時間で戻ること
+     */
+    typedef void (*FrameHandler)(const uint8_t* body, uint8_t size);
+
     /**
      * @brief 通信初期化
      * @param sourceAddress 自デバイスのMACアドレス（6バイト）
@@ -67,13 +252,261 @@ namespace ROBO_WCOM
      * @brief パケット送信
      * @param timestamp 送信時刻（任意の基準でOK）
      * @param data      送信データへのポインタ
-     * @param size      送信データサイズ（最大 CARRIED_DATA_MAX_SIZE）
+     * @param size      送信データサイズ（CARRIED_DATA_MAX_SIZE を超える分は切り捨てる。
+     *                  相手の最大搬送データサイズ（SetPeerMaxPayload()）を超えると Status::InvalidArg）
      * @return ステータスコード (Status)
      */
     Status SendPacket(uint32_t timestamp, const uint8_t* data, uint8_t size);
 
+    /**
+     * @brief 送信フレーム形式を設定
+     * @details 既定値は FrameFormat::Full（従来の受信側とも互換）
+     * @param format 送信フレーム形式
+     * @return ステータスコード (Status)
+     */
+    Status SetFrameFormat(FrameFormat format);
+
+    /**
+     * @brief 通信相手を暗号化Peer（ESP-NOW の CCMP）として登録し直す
+     * @details
+     * - Init() の後に呼ぶ。Init() を呼び直すと暗号化は解除される
+     * - 通信相手も同じ PMK・LMK で暗号化を有効にすること
+     * - 解除すると整合性検査は IntegrityCheck::Crc32 に戻る
+     * - 一斉送信（ブロードキャスト）は暗号化されない
+     * @param pmk 主鍵（ESP_NOW_KEY_LEN バイト、nullptr で暗号化を解除）
+     * @param lmk 通信相手との鍵（ESP_NOW_KEY_LEN バイト、nullptr で暗号化を解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetEncryption(const uint8_t* pmk, const uint8_t* lmk);
+
+    /**
+     * @brief 型付きフレームの整合性検査を設定
+     * @details
+     * 既定値は IntegrityCheck::Crc32。暗号化していない場合、これより弱い検査は
+     * Status::NotEncrypted で拒否する。
+     * ESP-NOW は暗号化Peer以外から届いた平文フレームも受け取るため、Crc16 / None の間は
+     * 送信元MACが通信相手（暗号化Peer）でない型付きフレームをすべて捨てる
+     * （ハンドシェイクフレームは常に CRC32 で検証するため対象外）。
+     * 設定するのは送信する検査で、受信側はフレーム長から検査を判別する。CRC32 は常に、
+     * Crc16 / None は暗号化した通信相手から届いたものに限り、設定によらず受け付ける
+     * （合意による切り替えが片側だけ先に進んでも読める）
+     * @param check 整合性検査
+     * @return ステータスコード (Status)
+     */
+    Status SetIntegrityCheck(IntegrityCheck check);
+
+    /**
+     * @brief 通信相手が受け付けるフレームを設定
+     * @details
+     * 通常はハンドシェイク（ROBO_WCOM_Hello.h）が設定する。相手が対応していないフレームは送らず、次のように送る。
+     * - 可変長データフレーム : 従来形式（SetFrameFormat() の設定は保持する）
+     * - 冗長データフレーム   : 冗長データを含まないデータフレーム
+     * - 優先データフレーム   : 通常のデータフレーム（相手の受信バッファを経由して届く）
+     * - 生存通知             : 直前に送ったパケットの再送（まだ送っていなければ何も送らない）
+     *
+     * Init() 直後はすべてに対応しているとみなす。
+     * @param capabilities 対応機能（Wire::HELLO_CAP_* の論理和。0 は従来形式しか受け付けない相手）
+     * @return ステータスコード (Status)
+     */
+    Status SetPeerCapabilities(uint16_t capabilities);
+
+    /**
+     * @brief 通信相手が受け付けるフレームを取得
+     * @return 対応機能（Wire::HELLO_CAP_* の論理和）
+     */
+    uint16_t GetPeerCapabilities(void);
+
+    /**
+     * @brief 通信相手が受信できる最大搬送データサイズを設定
+     * @details
+     * 通常はハンドシェイク（ROBO_WCOM_Hello.h）が相手から届いた値を設定する。相手はこれを超える
+     * 搬送データを CRCエラーとして捨てるため、次の送信は送らずに Status::InvalidArg を返す。
+     * - SendPacket()・SendPriorityPacket() の送信データサイズ
+     * - SendExtFrame() の本体長（ハンドシェイクを除く。パラメータ・一括転送はこの大きさに収めて送る）
+     * - PublisherUpdate() の送信データサイズ
+     *
+     * Init() 直後は CARRIED_DATA_MAX_SIZE。
+     * @param size 最大搬送データサイズ（1～CARRIED_DATA_MAX_SIZE）
+     * @return ステータスコード (Status)
+     */
+    Status SetPeerMaxPayload(uint8_t size);
+
+    /**
+     * @brief 通信相手が受信できる最大搬送データサイズを取得
+     * @return 最大搬送データサイズ
+     */
+    uint8_t GetPeerMaxPayload(void);
+
+    /**
+     * @brief 送信経路の排他を待ち時間付きで取る
+     * @details
+     * 送信APIは内部で送信経路を排他し、他のタスクが送信中なら終わるまで待つ。
+     * esp_timer のコールバックのように長く待てない文脈から送信する場合は、先にこれで排他を取り、
+     * 取れた場合だけ送信APIを呼ぶ。同じタスクからは送信APIの中で重ねて取れる。
+     * 取れた場合は必ず SendUnlock() で返すこと
+     * @param waitMillis 待つ最大時間（ミリ秒、0 で待たない）
+     * @return true:取れた / false:待ち時間内に取れなかった
+     */
+    bool SendTryLock(uint32_t waitMillis);
+
+    /**
+     * @brief SendTryLock() で取った送信経路の排他を返す
+     */
+    void SendUnlock(void);
+
+    /**
+     * @brief 自分が受け付けるフレームと暗号化の状態を取得（ハンドシェイクで相手へ伝える内容）
+     * @return 対応機能（Wire::HELLO_CAP_* の論理和。暗号化Peerなら Wire::HELLO_CAP_ENCRYPTED を含む）
+     */
+    uint16_t GetLocalCapabilities(void);
+
+    /**
+     * @brief 優先パケット送信（緊急停止・安全系フレーム用）
+     * @details
+     * - 受信側では通常の受信バッファ（FIFO）を経由せず専用スロットへ格納され、
+     *   PopOldestPacket() / PeekLatestPacket() で最優先に取り出される
+     * - 直ちに送信できなかった場合は保留され、以降の送信処理で通常フレームより先に再送される
+     * - 他のタスクが送信中なら ROBO_WCOM_PRIORITY_SEND_WAIT_MS ミリ秒まで待つ。待ちきれない場合も保留し、
+     *   Status::Busy を返す（以降の送信処理で通常フレームより先に送られる。その前に呼び直せば新しいもので置き換わる）
+     * - 通信相手が優先データフレームに対応していない場合（SetPeerCapabilities()）は通常のデータフレームで送る
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @param data      送信データへのポインタ
+     * @param size      送信データサイズ（最大 CARRIED_DATA_MAX_SIZE・相手の最大搬送データサイズ（SetPeerMaxPayload()））
+     * @return ステータスコード (Status)。送信経路の排他を待ちきれず保留した場合は Status::Busy
+     */
+    Status SendPriorityPacket(uint32_t timestamp, const uint8_t* data, uint8_t size);
+
+    /**
+     * @brief 優先パケット受信時のコールバックを設定
+     * @param callback コールバック関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetPriorityCallback(PriorityCallback callback);
+
+    /**
+     * @brief 自分のロボットIDを設定
+     * @details 一斉送信フレームから、このIDのエントリ（なければ ROBOT_ID_ALL のエントリ）を受け取る
+     * @param id ロボットID（0～0xFD、ROBOT_ID_NONE で未設定）
+     * @return ステータスコード (Status)
+     */
+    Status SetRobotId(uint8_t id);
+
+    /**
+     * @brief 複数ロボット宛ての搬送データを1フレームで一斉送信
+     * @details
+     * ESP-NOW のブロードキャストアドレスへ送るため、ロボット台数によらず送信は1回で済む。
+     * 各ロボットは受信コールバックで自分宛てのエントリだけを受信バッファへ積み、他は無視する。
+     * 自分宛てのエントリがないフレームはリンク状態の更新にも使わない。
+     * フレームは最大250バイトのため、エントリごとに2バイト + 搬送データサイズが必要。
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @param entries   エントリの配列
+     * @param count     エントリ数
+     * @return ステータスコード (Status)
+     */
+    Status SendFleetPacket(uint32_t timestamp, const FleetEntry* entries, uint8_t count);
+
+    /**
+     * @brief 生存通知（ハートビート）を送信
+     * @details
+     * シーケンス番号とタイムスタンプのみの数バイトのフレームで、受信側のタイムアウトを更新する。
+     * 受信バッファには積まれない。従来版の受信側には破棄される。
+     * @param timestamp 送信時刻（任意の基準でOK）
+     * @return ステータスコード (Status)
+     */
+    Status SendHeartbeat(uint32_t timestamp);
+
+    /**
+     * @brief 内容が変化していない送信をハートビートへ置き換える
+     * @details
+     * 有効にすると SendPacket() は前回送信した搬送データと同一の場合に、
+     * パケットの代わりにハートビートを送る。前回のパケットが失われた場合に備え、
+     * ハートビートが refreshInterval 回連続したら次は必ずパケットを送る。
+     * @param enable          有効/無効
+     * @param refreshInterval パケットを再送するまでのハートビート連続回数（1以上）
+     * @return ステータスコード (Status)
+     */
+    Status SetHeartbeatSuppression(bool enable, uint8_t refreshInterval);
+
+    /**
+     * @brief リンク状態の判定条件を設定
+     * @details Init() は degradedAfterMs = timeoutMS / 2, lostAfterMs = timeoutMS, recoverFrames = 3 で初期化する
+     * @param config 判定条件
+     * @return ステータスコード (Status)
+     */
+    Status SetLinkConfig(const LinkConfig& config);
+
+    /**
+     * @brief リンク状態遷移時のコールバックを設定
+     * @param callback コールバック関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetLinkStateCallback(LinkStateCallback callback);
+
+    /**
+     * @brief 現在時刻でリンク状態を更新して返す
+     * @details 受信がない間の経過時間による遷移（Up→Degraded→Lost）を反映する。受信APIからも呼ばれる
+     * @param nowMillis 現在時刻（millis）
+     * @return 更新後のリンク状態
+     */
+    LinkState UpdateLinkState(uint32_t nowMillis);
+
+    /**
+     * @brief 最後に更新されたリンク状態を取得（ISRからも呼び出し可）
+     * @return リンク状態
+     */
+    LinkState GetLinkState(void);
+
+    /**
+     * @brief 前方誤り訂正（冗長送信）を設定
+     * @details
+     * 有効にすると SendPacket() は直前に送った搬送データを同じフレームに含めて送る。
+     * 受信側は1フレームの欠落を再送要求なしに復元できる。追加バイト数は直前の搬送データサイズ + 7。
+     * 最新値のみが意味を持つ指令ストリーム向け。型付き形式で送信するため、従来版の受信側には届かない。
+     * @param enable 有効/無効
+     * @return ステータスコード (Status)
+     */
+    Status SetRedundancy(bool enable);
+
+    /**
+     * @brief 前方誤り訂正の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetFecStats(FecStats* stats);
+
+    /**
+     * @brief 拡張フレームの受信ハンドラを登録する（RPC などの拡張モジュール用）
+     * @details 組み込みのフレーム種別（データ・優先・生存通知・一斉送信）には登録できない
+     * @param frameType フレーム種別（Wire::FrameType の値）
+     * @param handler   ハンドラ（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetFrameHandler(uint8_t frameType, FrameHandler handler);
+
+    /**
+     * @brief 拡張フレームを通信相手へ送信する（RPC などの拡張モジュール用）
+     * @details 送信待ちの優先フレームがあれば先に送る
+     * @param frameType フレーム種別（Wire::FrameType の値）
+     * @param body      本体
+     * @param size      本体長（最大 Wire::EXT_BODY_MAX・相手の最大搬送データサイズ（SetPeerMaxPayload()））
+     * @return ステータスコード (Status)
+     */
+    Status SendExtFrame(uint8_t frameType, const uint8_t* body, uint8_t size);
+
+    /**
+     * @brief 受信フレームを受信コールバックと同じ経路で処理する
+     * @details
+     * CRC検証・リンク状態の更新・受信バッファへの格納まで実際の受信と同じ処理を行う。
+     * キャプチャの再生（tools/wcom_replay.cpp）や試験で使う。受信コールバックと同時に呼ばないこと
+     * @param frame 受信フレーム
+     * @param len   受信フレーム長（最大 250）
+     * @return ステータスコード (Status)
+     */
+    Status InjectFrame(const uint8_t* frame, int len);
+
     /**
      * @brief パケット受信
+     * @details 未読の優先パケットがあれば、受信バッファより先にそれを取り出す
      * @param nowMillis 現在時刻（millis）
      * @param timestamp 受信パケットのタイムスタンプ格納先
      * @param address   送信元アドレス格納先（6バイト）
@@ -85,6 +518,9 @@ namespace ROBO_WCOM
 
     /**
      * @brief バッファの最新データをチェックする。バッファは操作しない。
+     * @details
+     * 優先パケットが通常パケットより後に届いていれば、優先パケットを返す。
+     * バッファが空の場合はゼロ埋めして Status::BufferEmpty を返す
      * 
      * @param nowMillis 現在時刻（millis）
      * @param timestamp 受信パケットのタイムスタンプ格納先
@@ -95,6 +531,47 @@ namespace ROBO_WCOM
      */
     Status PeekLatestPacket(uint32_t nowMillis, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size);
 
+    /**
+     * @brief 最後に受信したパケットを参照する（割り込みから呼べる版）
+     * @details
+     * ロックを取らず、待たずに戻る。受信処理は最新パケットの控えを2面に交互に書き、
+     * ここでは書き込み中でない面を読む。読んでいる間に次の2つが届いて読んでいる面が
+     * 上書きされた場合だけ読み直し、数回続けば Status::Busy を返す。
+     *
+     * - 優先パケットを含め、最後に届いたパケットを返す（PeekLatestPacket() と違い、取り出し済みの優先パケットも返す）
+     * - リンク状態は更新しない。最後の受信から途絶とみなす時間が過ぎていれば Status::Timeout を返す
+     * - 何も受信していない・FlushBuffer() の後はゼロ埋めして Status::BufferEmpty を返す
+     * - Status::Busy・Status::CrcError の場合、格納先の内容は不定
+     * @param nowMillis 現在時刻（millis）
+     * @param timestamp 受信パケットのタイムスタンプ格納先
+     * @param address   送信元アドレス格納先（6バイト）
+     * @param data      受信データ格納先
+     * @param size      受信データサイズ格納先
+     * @return ステータスコード (Status)
+     */
+    Status PeekLatestPacketFromISR(uint32_t nowMillis, uint32_t* timestamp, uint8_t* address, uint8_t* data, uint8_t* size);
+
+    /**
+     * @brief 受信処理を専用タスクへ移す
+     * @details
+     * ESP-NOW の受信コールバック（Wi-Fiタスク）では、事前確保したバッファへフレームを写して
+     * 番号をキューへ積むだけにし、検証・受信バッファへの格納・ハンドラの呼び出し・統計は
+     * 指定コアに固定した受信タスクで行う。Wi-Fiタスクを短時間で返し、受信処理を制御と同じコアへ寄せられる。
+     *
+     * - Init() の後に呼ぶ。一度起動したら止めない（既に起動していれば何もせず Status::Ok）
+     * - ROBO_WCOM_RECEIVE_TASK_FRAMES が 0 の場合と ESP32 以外では Status::TaskFail を返す
+     * @param config 設定
+     * @return ステータスコード (Status)
+     */
+    Status StartReceiveTask(const ReceiveTaskConfig& config);
+
+    /**
+     * @brief 受信タスクの統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetReceiveTaskStats(ReceiveTaskStats* stats);
+
     /**
      * @brief バッファのクリア
      * 
@@ -113,6 +590,11 @@ namespace ROBO_WCOM
      * @brief ステータスを人間可読な文字列へ変換
      */
     const char* ToString(Status s);
+
+    /**
+     * @brief リンク状態を人間可読な文字列へ変換
+     */
+    const char* ToString(LinkState s);
 }
 
 #endif /* ROBO_WCOM_H */
@@ -0,0 +1,175 @@
+#include "ROBO_WCOM_Bridge.h"
+#include "ROBO_WCOM_Codec.h"
+#include <cstring>
+
+namespace ROBO_WCOM
+{
+    constexpr size_t BRIDGE_BATCH_BYTES = ROBO_WCOM_BRIDGE_BATCH_BYTES;
+    static_assert(BRIDGE_BATCH_BYTES >= Bridge::MAX_ENCODED_SIZE,
+                  "ROBO_WCOM_BRIDGE_BATCH_BYTES must hold at least one message");
+
+    //=== 内部状態 ===//
+    static Stream*  bridgePort = nullptr;               ///< PC と接続したシリアル
+    static Bridge::StreamDecoder commandDecoder;        ///< コマンドの切り出し
+    static uint8_t  batch[BRIDGE_BATCH_BYTES];          ///< 送信バッファ
+    static size_t   batchLen = 0;                       ///< 送信バッファの使用バイト数
+    static LinkState reportedLink = LinkState::Recovering; ///< 最後に PC へ通知したリンク状態
+    static BridgeStats bridgeStats{};                   ///< 統計
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief 送信バッファをシリアルへ書き出す
+     */
+    static void flushBatch(void)
+    {
+        if (batchLen == 0)
+        {
+            return;
+        }
+        bridgePort->write(batch, batchLen);
+        bridgeStats.batches++;
+        bridgeStats.bytes += batchLen;
+        batchLen = 0;
+    }
+
+    /**
+     * @brief メッセージを送信バッファへ追加する。入りきらない場合は先に書き出す
+     */
+    static void queueMessage(Bridge::MessageType type, const uint8_t* body, size_t bodyLen)
+    {
+        if (BRIDGE_BATCH_BYTES - batchLen < Bridge::MAX_ENCODED_SIZE)
+        {
+            flushBatch();
+        }
+        batchLen += Bridge::encodeMessage(type, body, bodyLen, batch + batchLen);
+    }
+
+    /**
+     * @brief PC からのコマンドを実行し、結果を Ack で返す
+     */
+    static void executeCommand(uint32_t nowMillis)
+    {
+        const uint8_t* body = commandDecoder.body();
+        size_t size = commandDecoder.bodySize();
+        Bridge::MessageType type = commandDecoder.type();
+        Status result;
+        if (size > CARRIED_DATA_MAX_SIZE)
+        {
+            result = Status::InvalidArg;
+        }
+        else if (type == Bridge::MessageType::Send)
+        {
+            result = SendPacket(nowMillis, body, static_cast<uint8_t>(size));
+        }
+        else if (type == Bridge::MessageType::SendPriority)
+        {
+            result = SendPriorityPacket(nowMillis, body, static_cast<uint8_t>(size));
+        }
+        else
+        {
+            result = Status::InvalidArg;
+        }
+        bridgeStats.commands++;
+
+        uint8_t ack[2] = { static_cast<uint8_t>(type), static_cast<uint8_t>(result) };
+        queueMessage(Bridge::MessageType::Ack, ack, sizeof(ack));
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief ブリッジを開始
+     * @param port PC と接続したシリアル
+     * @return ステータスコード (Status)
+     */
+    Status BridgeBegin(Stream& port)
+    {
+        bridgePort = &port;
+        commandDecoder = Bridge::StreamDecoder();
+        batchLen = 0;
+        reportedLink = GetLinkState();
+        bridgeStats = BridgeStats{};
+        return Status::Ok;
+    }
+
+    /**
+     * @brief ブリッジの周期処理
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status BridgeService(uint32_t nowMillis)
+    {
+        if (!bridgePort)
+        {
+            return Status::InvalidArg;
+        }
+
+        // PC からのコマンド
+        while (bridgePort->available() > 0)
+        {
+            int c = bridgePort->read();
+            if (c < 0)
+            {
+                break;
+            }
+            if (commandDecoder.push(static_cast<uint8_t>(c)))
+            {
+                executeCommand(nowMillis);
+            }
+        }
+        bridgeStats.decodeErrors = commandDecoder.errors();
+
+        // 受信パケットの転送
+        uint8_t body[Bridge::MAX_BODY_SIZE];
+        uint32_t timestamp;
+        uint8_t size;
+        Status status;
+        for (;;)
+        {
+            status = PopOldestPacket(nowMillis, &timestamp, body + 4, body + Bridge::PACKET_BODY_HEADER, &size);
+            if (status == Status::Ok)
+            {
+                Codec::storeLE32(body, timestamp);
+                body[Bridge::PACKET_BODY_HEADER - 1] = size;
+                queueMessage(Bridge::MessageType::Packet, body, Bridge::PACKET_BODY_HEADER + size);
+                bridgeStats.forwarded++;
+            }
+            else if (status == Status::CrcError)
+            {
+                bridgeStats.crcErrors++;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        // リンク状態の変化を通知
+        LinkState link = GetLinkState();
+        if (link != reportedLink)
+        {
+            uint8_t linkBody[2] = { static_cast<uint8_t>(link), static_cast<uint8_t>(status) };
+            queueMessage(Bridge::MessageType::Link, linkBody, sizeof(linkBody));
+            reportedLink = link;
+        }
+
+        flushBatch();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief ブリッジの統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetBridgeStats(BridgeStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        *stats = bridgeStats;
+        return Status::Ok;
+    }
+}
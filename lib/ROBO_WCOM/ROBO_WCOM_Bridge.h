@@ -0,0 +1,68 @@
+#ifndef ROBO_WCOM_BRIDGE_H
+#define ROBO_WCOM_BRIDGE_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_BridgeFormat.h"
+
+/**
+ * @brief シリアルへまとめて書き出す送信バッファのバイト数
+ * @details ビルドフラグ（-DROBO_WCOM_BRIDGE_BATCH_BYTES=...）で変更可能
+ */
+#ifndef ROBO_WCOM_BRIDGE_BATCH_BYTES
+#define ROBO_WCOM_BRIDGE_BATCH_BYTES 1024
+#endif
+
+/**
+ * @file ROBO_WCOM_Bridge.h
+ * @brief 受信フレームを PC へ中継するバイナリのシリアルブリッジ
+ * @details
+ * 受信パケットを文字列へ整形せず、COBS でフレーミングしたバイナリメッセージ
+ * （ROBO_WCOM_BridgeFormat.h）としてシリアルへ転送する。PC からの送信コマンドも同じ形式で受け付ける。
+ *
+ * - 複数のメッセージを送信バッファへ溜めてから1回の write() で書き出すため、
+ *   UART ドライバの送信リングバッファ（DMA）へ大きな単位で渡せる
+ * - 921600 baud 以上で使う場合は Serial.setTxBufferSize() で送信バッファも広げておくこと
+ * - PC側は tools/bridge/ のライブラリ・CLI で復号する
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief ブリッジの統計
+     */
+    struct BridgeStats {
+        uint32_t forwarded;     ///< PC へ転送したパケット数
+        uint32_t crcErrors;     ///< CRCエラーのため転送しなかったパケット数
+        uint32_t batches;       ///< write() の回数
+        uint32_t bytes;         ///< 書き出したバイト数
+        uint32_t commands;      ///< 実行したコマンド数
+        uint32_t decodeErrors;  ///< 破棄したコマンド（フレーミング不正・CRC不一致）
+    };
+
+    /**
+     * @brief ブリッジを開始
+     * @details 通信速度の設定（Serial.begin()）はアプリ側で行う。Init() の後に呼ぶこと
+     * @param port PC と接続したシリアル
+     * @return ステータスコード (Status)
+     */
+    Status BridgeBegin(Stream& port);
+
+    /**
+     * @brief ブリッジの周期処理
+     * @details
+     * PC からのコマンドを実行し、受信バッファのパケットをすべて PC へ転送する。
+     * リンク状態が変化した場合は Link メッセージも送る。受信バッファを取り出すので、
+     * ブリッジ使用中はアプリ側で PopOldestPacket() を呼ばないこと
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status BridgeService(uint32_t nowMillis);
+
+    /**
+     * @brief ブリッジの統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetBridgeStats(BridgeStats* stats);
+}
+
+#endif /* ROBO_WCOM_BRIDGE_H */
@@ -0,0 +1,211 @@
+#ifndef ROBO_WCOM_BRIDGE_FORMAT_H
+#define ROBO_WCOM_BRIDGE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "ROBO_WCOM_Codec.h"
+
+/**
+ * @file ROBO_WCOM_BridgeFormat.h
+ * @brief シリアルブリッジのメッセージ形式と COBS フレーミング
+ * @details
+ * Arduino に依存しないため、PC側のブリッジ（tools/bridge/）からもそのまま利用できる。
+ *
+ * - メッセージ : [種別 1][本体][CRC16 (LE) 2]
+ * - 回線上     : メッセージを COBS で符号化し、区切りとして 0x00 を1バイト付ける
+ *
+ * COBS により符号化後のデータは 0x00 を含まないため、受信側は 0x00 までを1メッセージとして
+ * 切り出せる。途中から受信を始めた場合や破損した場合も、次の 0x00 で同期が戻る。
+ */
+namespace ROBO_WCOM
+{
+namespace Bridge
+{
+    /**
+     * @brief メッセージ種別
+     * @details 0x80 未満はデバイス→PC、0x80 以上は PC→デバイス
+     */
+    enum class MessageType : uint8_t {
+        Packet       = 0x01,    ///< 受信パケット [タイムスタンプ 4][送信元MAC 6][サイズ 1][搬送データ]
+        Link         = 0x02,    ///< リンク状態 [LinkState 1][Status 1]
+        Ack          = 0x03,    ///< コマンドの実行結果 [コマンド種別 1][Status 1]
+        Send         = 0x81,    ///< パケット送信 [搬送データ]
+        SendPriority = 0x82,    ///< 優先パケット送信 [搬送データ]
+    };
+
+    constexpr size_t PACKET_BODY_HEADER = 4 + 6 + 1;   ///< Packet 本体のヘッダ長
+    constexpr size_t CRC_SIZE           = 2;           ///< CRC16 長
+    constexpr size_t MAX_BODY_SIZE      = PACKET_BODY_HEADER + 200;       ///< 本体の最大長
+    constexpr size_t MAX_MESSAGE_SIZE   = 1 + MAX_BODY_SIZE + CRC_SIZE;   ///< メッセージの最大長
+
+    /**
+     * @brief COBS 符号化後の最大長（区切りを除く）
+     */
+    constexpr size_t cobsMaxEncodedSize(size_t len)
+    {
+        return len + len / 254 + 1;
+    }
+
+    constexpr size_t MAX_ENCODED_SIZE = cobsMaxEncodedSize(MAX_MESSAGE_SIZE) + 1; ///< 区切りを含む回線上の最大長
+
+    /**
+     * @brief COBS 符号化
+     * @param src 元データ
+     * @param len 元データ長
+     * @param dst 出力先（cobsMaxEncodedSize(len) バイト以上）
+     * @return 符号化後の長さ（区切りは含まない）
+     */
+    inline size_t cobsEncode(const uint8_t* src, size_t len, uint8_t* dst)
+    {
+        size_t codePos = 0;
+        size_t out = 1;
+        uint8_t code = 1;
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (src[i] == 0)
+            {
+                dst[codePos] = code;
+                codePos = out++;
+                code = 1;
+                continue;
+            }
+            dst[out++] = src[i];
+            if (++code == 0xFF)
+            {
+                dst[codePos] = code;
+                codePos = out++;
+                code = 1;
+            }
+        }
+        dst[codePos] = code;
+        return out;
+    }
+
+    /**
+     * @brief COBS 復号
+     * @param src    符号化データ（区切りを含まない）
+     * @param len    符号化データ長
+     * @param dst    出力先（len バイト以上）
+     * @param outLen 復号後の長さ
+     * @return true:成功 / false:符号化データ不正
+     */
+    inline bool cobsDecode(const uint8_t* src, size_t len, uint8_t* dst, size_t& outLen)
+    {
+        size_t in = 0;
+        size_t out = 0;
+        while (in < len)
+        {
+            uint8_t code = src[in++];
+            if (code == 0 || in + code - 1 > len)
+            {
+                return false;
+            }
+            for (uint8_t i = 1; i < code; ++i)
+            {
+                dst[out++] = src[in++];
+            }
+            if (code != 0xFF && in < len)
+            {
+                dst[out++] = 0;
+            }
+        }
+        outLen = out;
+        return true;
+    }
+
+    /**
+     * @brief メッセージを組み立てて回線上の形式へ符号化する
+     * @param type    メッセージ種別
+     * @param body    本体（nullptr 可）
+     * @param bodyLen 本体長（最大 MAX_BODY_SIZE）
+     * @param dst     出力先（MAX_ENCODED_SIZE バイト以上）
+     * @return 区切りを含む符号化後の長さ（本体が長すぎる場合は 0）
+     */
+    inline size_t encodeMessage(MessageType type, const uint8_t* body, size_t bodyLen, uint8_t* dst)
+    {
+        if (bodyLen > MAX_BODY_SIZE)
+        {
+            return 0;
+        }
+        uint8_t raw[MAX_MESSAGE_SIZE];
+        raw[0] = static_cast<uint8_t>(type);
+        if (bodyLen > 0)
+        {
+            memcpy(raw + 1, body, bodyLen);
+        }
+        Codec::storeLE16(raw + 1 + bodyLen, Codec::crc16(raw, 1 + bodyLen));
+        size_t len = cobsEncode(raw, 1 + bodyLen + CRC_SIZE, dst);
+        dst[len++] = 0;
+        return len;
+    }
+
+    /**
+     * @brief 回線上のバイト列からメッセージを1バイトずつ切り出す
+     */
+    class StreamDecoder
+    {
+    public:
+        StreamDecoder() : length_(0), messageSize_(0), errors_(0), overflow_(false) {}
+
+        /**
+         * @brief 1バイト入力する
+         * @param byte 受信バイト
+         * @return true: 正しいメッセージが揃った（message() / size() で参照）
+         */
+        bool push(uint8_t byte)
+        {
+            if (byte != 0)
+            {
+                if (length_ < sizeof(encoded_))
+                {
+                    encoded_[length_++] = byte;
+                }
+                else
+                {
+                    overflow_ = true;
+                }
+                return false;
+            }
+
+            // 区切りを受信したら、それまでのバイト列を1メッセージとして検証する
+            size_t len = length_;
+            bool overflow = overflow_;
+            length_ = 0;
+            overflow_ = false;
+            if (len == 0)
+            {
+                return false;
+            }
+            size_t decoded = 0;
+            if (overflow || !cobsDecode(encoded_, len, message_, decoded) || decoded < 1 + CRC_SIZE ||
+                Codec::loadLE16(message_ + decoded - CRC_SIZE) != Codec::crc16(message_, decoded - CRC_SIZE))
+            {
+                errors_++;
+                return false;
+            }
+            messageSize_ = decoded - CRC_SIZE;
+            return true;
+        }
+
+        /** @brief メッセージ種別 */
+        MessageType type() const { return static_cast<MessageType>(message_[0]); }
+        /** @brief メッセージ本体 */
+        const uint8_t* body() const { return message_ + 1; }
+        /** @brief メッセージ本体長 */
+        size_t bodySize() const { return messageSize_ - 1; }
+        /** @brief 破棄したメッセージ数（COBS不正・CRC不一致・長さ超過） */
+        uint32_t errors() const { return errors_; }
+
+    private:
+        uint8_t  encoded_[MAX_ENCODED_SIZE];    ///< 区切りまでの受信バイト列
+        uint8_t  message_[MAX_ENCODED_SIZE];    ///< 復号したメッセージ
+        size_t   length_;                       ///< encoded_ の有効長
+        size_t   messageSize_;                  ///< 復号したメッセージ長（CRCを除く）
+        uint32_t errors_;                       ///< 破棄したメッセージ数
+        bool     overflow_;                     ///< 区切りまでに長さを超過したか
+    };
+}
+}
+
+#endif /* ROBO_WCOM_BRIDGE_FORMAT_H */
@@ -0,0 +1,621 @@
+#include "ROBO_WCOM_Bulk.h"
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_Lz.h"
+#include <cstring>
+
+namespace ROBO_WCOM
+{
+    typedef LzEncoder<BULK_WINDOW_BITS, BULK_LOOKAHEAD_BITS> BulkEncoder;
+    typedef LzDecoder<BULK_WINDOW_BITS, BULK_LOOKAHEAD_BITS> BulkDecoder;
+
+    /**
+     * @brief 読み出し関数から一度に受け取るバイト数
+     */
+    constexpr size_t BULK_READ_CHUNK = 64;
+
+    /**
+     * @brief 伸長したデータを書き込み関数へ一度に渡すバイト数
+     */
+    constexpr size_t BULK_WRITE_CHUNK = 64;
+
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE bulkMux = portMUX_INITIALIZER_UNLOCKED;  ///< Wi-Fiタスクとの受け渡し保護
+    #define BULK_LOCK()     portENTER_CRITICAL(&bulkMux)
+    #define BULK_UNLOCK()   portEXIT_CRITICAL(&bulkMux)
+#else
+    #define BULK_LOCK()
+    #define BULK_UNLOCK()
+#endif
+
+    static uint32_t     retryMillis = 100;              ///< 送り直すまでの時間
+
+    // 送信側
+    static bool             sending = false;            ///< 送信中の転送があるか
+    static BulkReader       sendReader = nullptr;       ///< 読み出し関数
+    static BulkSentCallback sendCallback = nullptr;     ///< 完了コールバック
+    static void*            sendContext = nullptr;      ///< 読み出し関数・完了コールバックへ渡すポインタ
+    static bool             sendCompress = false;       ///< 圧縮して送るか
+    static uint8_t          sendTransfer = 0;           ///< 転送番号
+    static uint16_t         sendSeq = 0;                ///< 送信中のフレームのシーケンス番号
+    static bool             frameReady = false;         ///< 送信中のフレームを作ったか
+    static bool             frameAcked = false;         ///< 送信中のフレームの確認が届いたか（Wi-Fiタスクが設定）
+    static uint8_t          frame[Wire::EXT_BODY_MAX];  ///< 送信中のフレームの本体（再送用に保持）
+    static size_t           frameSize = 0;              ///< 送信中のフレームの本体長
+    static uint32_t         frameSentMillis = 0;        ///< 送信中のフレームを送った時刻
+    static uint8_t          frameRetries = 0;           ///< 送信中のフレームを送り直した回数
+    static bool             readerEnded = false;        ///< 読み出し関数が 0 を返したか
+    static uint8_t          readBuf[BULK_READ_CHUNK];   ///< 読み出したデータ（圧縮器へ渡す前）
+    static size_t           readLen = 0;                ///< readBuf の有効バイト数
+    static size_t           readPos = 0;                ///< readBuf の圧縮器へ渡した位置
+    static uint32_t         sendRawSize = 0;            ///< 読み出したバイト数
+    static uint32_t         sendRawCrc = 0;             ///< 読み出したデータの CRC32（途中値）
+    static BulkEncoder      encoder;                    ///< 圧縮器
+
+    // 受信側
+    static BulkWriter           recvWriter = nullptr;   ///< 書き込み関数
+    static BulkReceivedCallback recvCallback = nullptr; ///< 完了コールバック
+    static void*                recvContext = nullptr;  ///< 書き込み関数・完了コールバックへ渡すポインタ
+    static bool             rxPending = false;          ///< 未処理の受信フレームがあるか（Wi-Fiタスクが設定）
+    static uint8_t          rxBody[Wire::EXT_BODY_MAX]; ///< 未処理の受信フレームの本体
+    static uint8_t          rxSize = 0;                 ///< 未処理の受信フレームの本体長
+    static bool             ackPending = false;         ///< 確認を返す必要があるか
+    static uint8_t          ackTransfer = 0;            ///< 返す確認の転送番号
+    static uint16_t         ackSeq = 0;                 ///< 返す確認のシーケンス番号
+    static bool             receiving = false;          ///< 受信中の転送があるか
+    static bool             rxKnown = false;            ///< rxTransfer が有効か
+    static uint8_t          rxTransfer = 0;             ///< 受信中（または直前に受信した）転送番号
+    static uint16_t         rxExpected = 0;             ///< 次に受け取るシーケンス番号
+    static bool             rxCompressed = false;       ///< 受信中の転送が圧縮されているか
+    static uint32_t         rxRawSize = 0;              ///< 書き込み関数へ渡したバイト数
+    static uint32_t         rxRawCrc = 0;               ///< 書き込み関数へ渡したデータの CRC32（途中値）
+    static BulkDecoder      decoder;                    ///< 伸長器
+
+    static BulkStats        bulkStats{};                ///< 統計
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief 本体を送信する
+     */
+    static Status sendBody(const uint8_t* body, size_t size)
+    {
+        return SendExtFrame(static_cast<uint8_t>(Wire::FrameType::Bulk), body, static_cast<uint8_t>(size));
+    }
+
+    /**
+     * @brief 読み出し関数からデータを受け取る
+     * @return true:データがある / false:データの終わり
+     */
+    static bool readMore(void)
+    {
+        if (readPos < readLen)
+        {
+            return true;
+        }
+        if (readerEnded)
+        {
+            return false;
+        }
+        readLen = sendReader(readBuf, sizeof(readBuf), sendContext);
+        if (readLen > sizeof(readBuf))
+        {
+            readLen = sizeof(readBuf);
+        }
+        readPos = 0;
+        if (readLen == 0)
+        {
+            readerEnded = true;
+            return false;
+        }
+        sendRawSize += static_cast<uint32_t>(readLen);
+        sendRawCrc = Codec::crc32Update(sendRawCrc, readBuf, readLen);
+        bulkStats.rawBytesSent += static_cast<uint32_t>(readLen);
+        return true;
+    }
+
+    /**
+     * @brief 圧縮したデータでフレームを埋める
+     * @return データのバイト数
+     */
+    static size_t fillCompressed(uint8_t* out, size_t capacity, bool* last)
+    {
+        size_t n = 0;
+        for (;;)
+        {
+            n += encoder.poll(out + n, capacity - n);
+            if (n >= capacity)
+            {
+                break;
+            }
+            if (encoder.done())
+            {
+                *last = true;
+                break;
+            }
+            if (readMore())
+            {
+                readPos += encoder.sink(readBuf + readPos, readLen - readPos);
+            }
+            else
+            {
+                encoder.finish();
+            }
+        }
+        return n;
+    }
+
+    /**
+     * @brief 読み出したデータをそのままフレームへ詰める
+     * @return データのバイト数
+     */
+    static size_t fillRaw(uint8_t* out, size_t capacity, bool* last)
+    {
+        size_t n = 0;
+        while (n < capacity)
+        {
+            if (!readMore())
+            {
+                *last = true;
+                break;
+            }
+            size_t take = readLen - readPos;
+            if (take > capacity - n)
+            {
+                take = capacity - n;
+            }
+            memcpy(out + n, readBuf + readPos, take);
+            readPos += take;
+            n += take;
+        }
+        return n;
+    }
+
+    /**
+     * @brief 1フレームに載せるデータの最大長
+     * @details 相手が受信できる最大搬送データサイズ（GetPeerMaxPayload()）に収める
+     */
+    static size_t payloadCapacity(void)
+    {
+        size_t limit = GetPeerMaxPayload();
+        if (limit <= Wire::BULK_HEADER_SIZE + Wire::BULK_TRAILER_SIZE)
+        {
+            // 収まらない相手には1バイトずつ送る（SendExtFrame() が拒否し、送り直しの末に失敗する）
+            return 1;
+        }
+        limit -= Wire::BULK_HEADER_SIZE + Wire::BULK_TRAILER_SIZE;
+        return (limit < Wire::BULK_PAYLOAD_MAX) ? limit : Wire::BULK_PAYLOAD_MAX;
+    }
+
+    /**
+     * @brief 次のデータフレームを作る
+     */
+    static void buildFrame(void)
+    {
+        bool last = false;
+        uint8_t* payload = frame + Wire::BULK_OFFSET_PAYLOAD;
+        size_t capacity = payloadCapacity();
+        size_t n = sendCompress ? fillCompressed(payload, capacity, &last)
+                                : fillRaw(payload, capacity, &last);
+        // ちょうど埋まった直後に終わる場合も、次のフレームを待たずに最後とする
+        if (!last && readPos == readLen && (sendCompress ? encoder.done() : readerEnded))
+        {
+            last = true;
+        }
+
+        uint8_t flags = last ? Wire::BULK_FLAG_LAST : 0;
+        if (sendCompress)
+        {
+            flags |= Wire::BULK_FLAG_COMPRESSED | static_cast<uint8_t>(BULK_WINDOW_BITS << Wire::BULK_FLAG_WINDOW_SHIFT);
+        }
+        frame[Wire::BULK_OFFSET_KIND] = Wire::BULK_KIND_DATA;
+        frame[Wire::BULK_OFFSET_TRANSFER] = sendTransfer;
+        Codec::storeLE16(frame + Wire::BULK_OFFSET_SEQ, sendSeq);
+        frame[Wire::BULK_OFFSET_FLAGS] = flags;
+        frameSize = Wire::BULK_HEADER_SIZE + n;
+        if (last)
+        {
+            Codec::storeLE32(frame + frameSize, sendRawSize);
+            Codec::storeLE32(frame + frameSize + 4, Codec::crc32Final(sendRawCrc));
+            frameSize += Wire::BULK_TRAILER_SIZE;
+        }
+        bulkStats.payloadBytesSent += static_cast<uint32_t>(n);
+        frameReady = true;
+        frameRetries = 0;
+    }
+
+    /**
+     * @brief 送信を終える
+     */
+    static void finishSend(Status status)
+    {
+        BulkSentCallback callback = sendCallback;
+        void* context = sendContext;
+        BULK_LOCK();
+        sending = false;
+        frameReady = false;
+        frameAcked = false;
+        BULK_UNLOCK();
+        if (status == Status::Ok)
+        {
+            bulkStats.transfersSent++;
+        }
+        if (callback)
+        {
+            callback(status, context);
+        }
+    }
+
+    /**
+     * @brief 受信を終える
+     */
+    static void finishReceive(Status status)
+    {
+        receiving = false;
+        bulkStats.transfersReceived++;
+        if (recvCallback)
+        {
+            recvCallback(status, rxRawSize, recvContext);
+        }
+    }
+
+    /**
+     * @brief データを書き込み関数へ渡す
+     */
+    static void deliver(const uint8_t* data, size_t size)
+    {
+        rxRawSize += static_cast<uint32_t>(size);
+        rxRawCrc = Codec::crc32Update(rxRawCrc, data, size);
+        bulkStats.rawBytesReceived += static_cast<uint32_t>(size);
+        if (recvWriter)
+        {
+            recvWriter(data, size, recvContext);
+        }
+    }
+
+    /**
+     * @brief 受信したデータフレームを処理する
+     */
+    static void processData(const uint8_t* body, uint8_t size)
+    {
+        uint8_t transfer = body[Wire::BULK_OFFSET_TRANSFER];
+        uint16_t seq = Codec::loadLE16(body + Wire::BULK_OFFSET_SEQ);
+        uint8_t flags = body[Wire::BULK_OFFSET_FLAGS];
+        bool last = (flags & Wire::BULK_FLAG_LAST) != 0;
+        size_t payloadSize = size - Wire::BULK_HEADER_SIZE;
+        if (last)
+        {
+            if (payloadSize < Wire::BULK_TRAILER_SIZE)
+            {
+                return;
+            }
+            payloadSize -= Wire::BULK_TRAILER_SIZE;
+        }
+
+        bool sameTransfer = rxKnown && transfer == rxTransfer;
+        if (sameTransfer && static_cast<int16_t>(seq - rxExpected) < 0 && !(seq == 0 && rxExpected > 1))
+        {
+            // 確認が失われて送り直されたフレーム。確認だけ返す
+            ackTransfer = transfer;
+            ackSeq = seq;
+            ackPending = true;
+            return;
+        }
+        if (sameTransfer && seq == 0 && !receiving && rxExpected == 0)
+        {
+            // 受け付けなかった転送の送り直し
+            return;
+        }
+        if (seq == 0)
+        {
+            if (receiving)
+            {
+                finishReceive(Status::BulkAborted);
+            }
+            receiving = true;
+            rxKnown = true;
+            rxTransfer = transfer;
+            rxExpected = 0;
+            rxCompressed = (flags & Wire::BULK_FLAG_COMPRESSED) != 0;
+            rxRawSize = 0;
+            rxRawCrc = 0xFFFFFFFF;
+            decoder.reset();
+            if (rxCompressed && (flags >> Wire::BULK_FLAG_WINDOW_SHIFT) != BULK_WINDOW_BITS)
+            {
+                // 伸長できないので確認を返さず、相手はタイムアウトで終わる
+                finishReceive(Status::InvalidArg);
+                return;
+            }
+        }
+        else if (!receiving || !sameTransfer || seq != rxExpected)
+        {
+            return;
+        }
+
+        const uint8_t* payload = body + Wire::BULK_OFFSET_PAYLOAD;
+        if (rxCompressed)
+        {
+            uint8_t out[BULK_WRITE_CHUNK];
+            size_t consumed = 0;
+            for (;;)
+            {
+                consumed += decoder.sink(payload + consumed, payloadSize - consumed);
+                size_t n = decoder.poll(out, sizeof(out));
+                if (n > 0)
+                {
+                    deliver(out, n);
+                }
+                else if (consumed >= payloadSize)
+                {
+                    break;
+                }
+            }
+        }
+        else if (payloadSize > 0)
+        {
+            deliver(payload, payloadSize);
+        }
+        bulkStats.framesReceived++;
+        rxExpected = seq + 1;
+        ackTransfer = transfer;
+        ackSeq = seq;
+        ackPending = true;
+
+        if (last)
+        {
+            const uint8_t* trailer = payload + payloadSize;
+            bool ok = Codec::loadLE32(trailer) == rxRawSize &&
+                      Codec::loadLE32(trailer + 4) == Codec::crc32Final(rxRawCrc);
+            finishReceive(ok ? Status::Ok : Status::CrcError);
+        }
+    }
+
+    /**
+     * @brief 一括転送フレームの受信ハンドラ（Wi-Fiタスクから呼ばれる）
+     * @details データは保存だけ行い、伸長と書き込みは BulkService() で行う
+     */
+    static void onBulkFrame(const uint8_t* body, uint8_t size)
+    {
+        if (size < Wire::BULK_ACK_SIZE)
+        {
+            return;
+        }
+        BULK_LOCK();
+        if (body[Wire::BULK_OFFSET_KIND] == Wire::BULK_KIND_ACK)
+        {
+            if (size == Wire::BULK_ACK_SIZE && sending && frameReady &&
+                body[Wire::BULK_OFFSET_TRANSFER] == sendTransfer &&
+                Codec::loadLE16(body + Wire::BULK_OFFSET_SEQ) == sendSeq)
+            {
+                frameAcked = true;
+            }
+        }
+        else if (body[Wire::BULK_OFFSET_KIND] == Wire::BULK_KIND_DATA &&
+                 size >= Wire::BULK_HEADER_SIZE && !rxPending)
+        {
+            // 処理待ちがあれば捨てる（確認が返らないので相手が送り直す）
+            memcpy(rxBody, body, size);
+            rxSize = size;
+            rxPending = true;
+        }
+        BULK_UNLOCK();
+    }
+
+    /**
+     * @brief 送信側の処理
+     */
+    static Status serviceSend(uint32_t nowMillis)
+    {
+        BULK_LOCK();
+        bool active = sending;
+        bool acked = frameAcked;
+        frameAcked = false;
+        BULK_UNLOCK();
+        if (!active)
+        {
+            return Status::Ok;
+        }
+
+        if (frameReady && acked)
+        {
+            if (frame[Wire::BULK_OFFSET_FLAGS] & Wire::BULK_FLAG_LAST)
+            {
+                finishSend(Status::Ok);
+                return Status::Ok;
+            }
+            BULK_LOCK();
+            frameReady = false;
+            sendSeq++;
+            BULK_UNLOCK();
+        }
+        if (frameReady)
+        {
+            // 確認待ち。時間内に届かなければ送り直す
+            if ((nowMillis - frameSentMillis) < retryMillis)
+            {
+                return Status::Ok;
+            }
+            if (frameRetries >= BULK_RETRY_MAX)
+            {
+                finishSend(Status::Timeout);
+                return Status::Ok;
+            }
+            frameRetries++;
+            bulkStats.retries++;
+        }
+        else
+        {
+            buildFrame();
+        }
+
+        // 送信に失敗した場合も確認待ちとして扱い、再送時間後に送り直す
+        frameSentMillis = nowMillis;
+        bulkStats.framesSent++;
+        return sendBody(frame, frameSize);
+    }
+
+    /**
+     * @brief 受信側の処理
+     */
+    static Status serviceReceive(void)
+    {
+        BULK_LOCK();
+        bool pending = rxPending;
+        BULK_UNLOCK();
+        if (pending)
+        {
+            // rxBody は rxPending を下ろすまで Wi-Fiタスクが書き換えない
+            processData(rxBody, rxSize);
+            BULK_LOCK();
+            rxPending = false;
+            BULK_UNLOCK();
+        }
+        if (!ackPending)
+        {
+            return Status::Ok;
+        }
+        uint8_t body[Wire::BULK_ACK_SIZE];
+        body[Wire::BULK_OFFSET_KIND] = Wire::BULK_KIND_ACK;
+        body[Wire::BULK_OFFSET_TRANSFER] = ackTransfer;
+        Codec::storeLE16(body + Wire::BULK_OFFSET_SEQ, ackSeq);
+        ackPending = false;
+        return sendBody(body, sizeof(body));
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief 一括転送を開始する
+     * @param retryMs 送り直すまでの時間（ミリ秒）
+     * @return ステータスコード (Status)
+     */
+    Status BulkBegin(uint32_t retryMs)
+    {
+        if (retryMs == 0)
+        {
+            return Status::InvalidArg;
+        }
+        BULK_LOCK();
+        retryMillis = retryMs;
+        sending = false;
+        frameReady = false;
+        frameAcked = false;
+        rxPending = false;
+        BULK_UNLOCK();
+        // 起動ごとに異なる転送番号から始め、再起動前の転送の確認と取り違えにくくする
+        sendTransfer = static_cast<uint8_t>(micros());
+        ackPending = false;
+        receiving = false;
+        rxKnown = false;
+        bulkStats = BulkStats{};
+        return SetFrameHandler(static_cast<uint8_t>(Wire::FrameType::Bulk), onBulkFrame);
+    }
+
+    /**
+     * @brief データの送信を始める
+     * @param reader   読み出し関数
+     * @param compress true:圧縮して送る
+     * @param callback 完了コールバック（nullptr 可）
+     * @param context  読み出し関数・完了コールバックへ渡す任意のポインタ
+     * @return ステータスコード (Status)
+     */
+    Status BulkSend(BulkReader reader, bool compress, BulkSentCallback callback, void* context)
+    {
+        if (!reader)
+        {
+            return Status::InvalidArg;
+        }
+        if (sending)
+        {
+            return Status::BulkBusy;
+        }
+        sendReader = reader;
+        sendCallback = callback;
+        sendContext = context;
+        sendCompress = compress;
+        readerEnded = false;
+        readLen = 0;
+        readPos = 0;
+        sendRawSize = 0;
+        sendRawCrc = 0xFFFFFFFF;
+        encoder.reset();
+        BULK_LOCK();
+        sendTransfer++;
+        sendSeq = 0;
+        frameReady = false;
+        frameAcked = false;
+        sending = true;
+        BULK_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信中の転送を取り消す
+     * @return ステータスコード (Status)
+     */
+    Status BulkCancel(void)
+    {
+        if (sending)
+        {
+            finishSend(Status::BulkAborted);
+        }
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信中の転送があるか
+     */
+    bool BulkIsSending(void)
+    {
+        return sending;
+    }
+
+    /**
+     * @brief 受信したデータの渡し先を設定する
+     * @param writer   書き込み関数（nullptr で受信しない）
+     * @param callback 完了コールバック（nullptr 可）
+     * @param context  書き込み関数・完了コールバックへ渡す任意のポインタ
+     * @return ステータスコード (Status)
+     */
+    Status SetBulkReceiver(BulkWriter writer, BulkReceivedCallback callback, void* context)
+    {
+        recvWriter = writer;
+        recvCallback = callback;
+        recvContext = context;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief データの送信・再送、受信データの伸長・書き込み・確認の返信を行う
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status BulkService(uint32_t nowMillis)
+    {
+        Status result = Status::Ok;
+        if (recvWriter && serviceReceive() != Status::Ok)
+        {
+            result = Status::SendFail;
+        }
+        if (serviceSend(nowMillis) != Status::Ok)
+        {
+            result = Status::SendFail;
+        }
+        return result;
+    }
+
+    /**
+     * @brief 一括転送の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetBulkStats(BulkStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        *stats = bulkStats;
+        return Status::Ok;
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef ROBO_WCOM_BULK_H
+#define ROBO_WCOM_BULK_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Wire.h"
+
+/**
+ * @brief 圧縮の窓のビット数（窓は 2^n バイト、5～12）
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_BULK_WINDOW_BITS=...）で変更可能。
+ * 一致長は4ビット固定で、後方参照の符号は 1 + n + 4 ビットになる。下限の 5 は、圧縮器が求める
+ * 「窓のビット数 > 一致長のビット数」を満たし、末尾の詰め物（7ビット以下）が後方参照として復号されないための値。
+ * 送信側は 2 * 2^n バイト、受信側は 2^n バイトの作業領域を使う。
+ * 受信側は自分と異なる窓で圧縮された転送を受け付けない。
+ */
+#ifndef ROBO_WCOM_BULK_WINDOW_BITS
+#define ROBO_WCOM_BULK_WINDOW_BITS 8
+#endif
+
+/**
+ * @brief 確認が届かない場合に送り直す最大回数
+ */
+#ifndef ROBO_WCOM_BULK_RETRY_MAX
+#define ROBO_WCOM_BULK_RETRY_MAX 20
+#endif
+
+/**
+ * @file ROBO_WCOM_Bulk.h
+ * @brief ログ・較正データなど、1フレームに収まらないデータの一括転送
+ * @details
+ * - データを BULK_PAYLOAD_MAX バイトずつ拡張フレーム（Wire::FrameType::Bulk）で送る
+ * - 1フレームごとに確認を待ち、届かなければ送り直す（停止待ち）
+ * - 送信側は読み出し関数から少しずつデータを受け取り、受信側は書き込み関数へ少しずつ渡すため、
+ *   メッセージ全体をメモリに置く必要はない
+ * - 圧縮を指定すると、読み出したデータをフレームを埋めるごとに LZSS（ROBO_WCOM_Lz.h）で圧縮する
+ * - 最後のフレームに元データのサイズと CRC32 を付け、受信側で全体を検証する
+ *
+ * 同時に行える転送は送信・受信それぞれ1つ。読み出し関数・書き込み関数・完了コールバックは
+ * すべて BulkService() の中で呼ばれる。
+ */
+namespace ROBO_WCOM
+{
+    constexpr unsigned BULK_WINDOW_BITS    = ROBO_WCOM_BULK_WINDOW_BITS;  ///< 圧縮の窓のビット数
+    constexpr unsigned BULK_LOOKAHEAD_BITS = 4;                           ///< 圧縮の一致長のビット数（固定）
+    constexpr uint8_t  BULK_RETRY_MAX      = ROBO_WCOM_BULK_RETRY_MAX;    ///< 送り直す最大回数
+
+    static_assert(BULK_WINDOW_BITS >= 5 && BULK_WINDOW_BITS <= 12, "ROBO_WCOM_BULK_WINDOW_BITS must be 5..12");
+
+    /**
+     * @brief 送信するデータの読み出し関数
+     * @param data    格納先
+     * @param maxSize 格納できる最大バイト数
+     * @param context BulkSend() に渡した任意のポインタ
+     * @return 格納したバイト数（0 でデータの終わり）
+     */
+    typedef size_t (*BulkReader)(uint8_t* data, size_t maxSize, void* context);
+
+    /**
+     * @brief 送信の完了コールバック
+     * @param status  Ok:相手が全データを受け取った / Timeout:送り直しても確認が届かなかった / BulkAborted:取り消した
+     * @param context BulkSend() に渡した任意のポインタ
+     */
+    typedef void (*BulkSentCallback)(Status status, void* context);
+
+    /**
+     * @brief 受信したデータの書き込み関数
+     * @details 伸長済みのデータが先頭から順に渡される
+     * @param data    データ
+     * @param size    バイト数
+     * @param context SetBulkReceiver() に渡した任意のポインタ
+     */
+    typedef void (*BulkWriter)(const uint8_t* data, size_t size, void* context);
+
+    /**
+     * @brief 受信の完了コールバック
+     * @param status  Ok:全データを検証できた / CrcError:サイズまたは CRC が一致しない /
+     *                BulkAborted:途中で相手が次の転送を始めた / InvalidArg:受け付けられない圧縮形式
+     * @param size    書き込み関数へ渡したバイト数
+     * @param context SetBulkReceiver() に渡した任意のポインタ
+     */
+    typedef void (*BulkReceivedCallback)(Status status, uint32_t size, void* context);
+
+    /**
+     * @brief 一括転送の統計
+     */
+    struct BulkStats {
+        uint32_t transfersSent;     ///< 送信を完了した転送数
+        uint32_t framesSent;        ///< 送信したデータフレーム数（再送を含む）
+        uint32_t retries;           ///< 確認が届かず送り直した回数
+        uint32_t rawBytesSent;      ///< 読み出し関数から受け取ったバイト数
+        uint32_t payloadBytesSent;  ///< 送信したデータのバイト数（圧縮後、再送を除く）
+        uint32_t transfersReceived; ///< 受信を完了した転送数（検証に失敗したものを含む）
+        uint32_t framesReceived;    ///< 受け取ったデータフレーム数（重複を除く）
+        uint32_t rawBytesReceived;  ///< 書き込み関数へ渡したバイト数
+    };
+
+    /**
+     * @brief 一括転送を開始する
+     * @details 拡張フレームのハンドラを登録し、送信中・受信中の転送を破棄する
+     * @param retryMs 確認が届かない場合に送り直すまでの時間（ミリ秒）
+     * @return ステータスコード (Status)
+     */
+    Status BulkBegin(uint32_t retryMs);
+
+    /**
+     * @brief データの送信を始める
+     * @details 送信は BulkService() の中で進む。読み出し関数が 0 を返すまで読み出す
+     * @param reader   読み出し関数
+     * @param compress true:圧縮して送る
+     * @param callback 完了コールバック（nullptr 可）
+     * @param context  読み出し関数・完了コールバックへ渡す任意のポインタ
+     * @return ステータスコード (Status)。送信中の転送があれば BulkBusy
+     */
+    Status BulkSend(BulkReader reader, bool compress, BulkSentCallback callback, void* context);
+
+    /**
+     * @brief 送信中の転送を取り消す
+     * @details 完了コールバックへ BulkAborted を渡す
+     * @return ステータスコード (Status)
+     */
+    Status BulkCancel(void);
+
+    /**
+     * @brief 送信中の転送があるか
+     */
+    bool BulkIsSending(void);
+
+    /**
+     * @brief 受信したデータの渡し先を設定する
+     * @param writer   書き込み関数（nullptr で受信しない）
+     * @param callback 完了コールバック（nullptr 可）
+     * @param context  書き込み関数・完了コールバックへ渡す任意のポインタ
+     * @return ステータスコード (Status)
+     */
+    Status SetBulkReceiver(BulkWriter writer, BulkReceivedCallback callback, void* context);
+
+    /**
+     * @brief データの送信・再送、受信データの伸長・書き込み・確認の返信を行う
+     * @details 制御ループなどから周期的に呼ぶ。1回の呼び出しで送受信それぞれ最大1フレームを処理する
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)。送信に失敗した場合は SendFail
+     */
+    Status BulkService(uint32_t nowMillis);
+
+    /**
+     * @brief 一括転送の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetBulkStats(BulkStats* stats);
+}
+
+#endif /* ROBO_WCOM_BULK_H */
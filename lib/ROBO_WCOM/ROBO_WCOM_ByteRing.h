@@ -0,0 +1,217 @@
+#ifndef ROBO_WCOM_BYTE_RING_H
+#define ROBO_WCOM_BYTE_RING_H
+
+#include "ROBO_WCOM.h"
+#include <string.h>
+
+/**
+ * @file ROBO_WCOM_ByteRing.h
+ * @brief 実際の長さで詰めて保持する可変長の受信リングバッファ
+ * @details
+ * PacketRing と同じ操作（push / pop / peekLatest / size / clear）を持ち、差し替えて使える。
+ *
+ * - レコード : [タイムスタンプ 4][送信元MAC 6][サイズ 1][CRC検証結果 1][搬送データ]
+ * - 末尾に収まらないレコードは先頭へ回し、末尾の余りは使わない（bip バッファ方式）
+ *
+ * 小さいパケットが多い場合、同じ RAM で固定長スロットより多くのパケットを保持できる。
+ * 取り出しは PacketRing と同じくコピーで行う。受信コールバックは空きが足りなければ最も古いレコードを
+ * 上書きするため、バッファ内への参照を受信バッファの排他の外へ渡すことはできない。
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 可変長の受信リングバッファ
+     * @tparam Bytes バッファのバイト数
+     */
+    template <size_t Bytes>
+    class PacketByteRing
+    {
+    public:
+        static constexpr size_t RECORD_HEADER_SIZE = 4 + 6 + 1 + 1;   ///< レコードのヘッダ長
+
+        static_assert(Bytes >= RECORD_HEADER_SIZE + CARRIED_DATA_MAX_SIZE, "PacketByteRing must hold at least one full packet");
+        static_assert(Bytes <= 0xFFFF, "PacketByteRing size out of range");
+
+        PacketByteRing() : head_(0), tail_(0), wrap_(Bytes), latest_(0), count_(0) {}
+
+        /**
+         * @brief 空にする
+         */
+        void clear()
+        {
+            head_ = 0;
+            tail_ = 0;
+            wrap_ = Bytes;
+            count_ = 0;
+        }
+
+        /**
+         * @brief パケットを追加する。空きが足りなければ古いパケットから捨てる
+         * @param data  パケットデータ
+         * @param crcOk CRC検証結果
+         */
+        void push(const PacketData& data, bool crcOk)
+        {
+            uint8_t size = (data.carriedSize <= CARRIED_DATA_MAX_SIZE) ? data.carriedSize : 0;
+            size_t need = RECORD_HEADER_SIZE + size;
+            while (!reserve(need))
+            {
+                dropOldest();
+            }
+
+            uint8_t* rec = buffer_ + head_;
+            memcpy(rec, &data.timestamp, 4);
+            memcpy(rec + 4, data.address, 6);
+            rec[10] = size;
+            rec[11] = (crcOk && size == data.carriedSize) ? 1 : 0;
+            memcpy(rec + RECORD_HEADER_SIZE, data.carriedData, size);
+
+            latest_ = head_;
+            head_ = static_cast<uint16_t>(head_ + need);
+            count_++;
+        }
+
+        /**
+         * @brief 最も古いパケットを取り出す
+         * @param data  取り出したパケットデータ
+         * @param crcOk CRC検証結果
+         * @return true:成功 / false:空
+         */
+        bool pop(PacketData& data, bool& crcOk)
+        {
+            if (count_ <= 0)
+            {
+                return false;
+            }
+            View view;
+            makeView(tail_, view);
+            copyOut(view, data, crcOk);
+            dropOldest();
+            return true;
+        }
+
+        /**
+         * @brief 最新のパケットを参照する（取り出さない）
+         * @param data  パケットデータ
+         * @param crcOk CRC検証結果
+         * @return true:成功 / false:空
+         */
+        bool peekLatest(PacketData& data, bool& crcOk) const
+        {
+            if (count_ <= 0)
+            {
+                return false;
+            }
+            View view;
+            makeView(latest_, view);
+            copyOut(view, data, crcOk);
+            return true;
+        }
+
+        /**
+         * @brief 保持しているパケット数
+         */
+        int16_t size() const
+        {
+            return count_;
+        }
+
+    private:
+        /**
+         * @brief バッファ内のレコードの参照（取り出し時のコピー元）
+         */
+        struct View {
+            uint32_t       timestamp;   ///< タイムスタンプ
+            const uint8_t* address;     ///< 送信元MAC
+            const uint8_t* data;        ///< 搬送データ
+            uint8_t        size;        ///< 搬送データサイズ
+            bool           crcOk;       ///< CRC検証結果
+        };
+
+        /**
+         * @brief 最も古いパケットを捨てる
+         */
+        void dropOldest()
+        {
+            if (count_ <= 0)
+            {
+                return;
+            }
+            tail_ = static_cast<uint16_t>(tail_ + RECORD_HEADER_SIZE + buffer_[tail_ + 10]);
+            if (--count_ == 0)
+            {
+                clear();
+            }
+            else if (tail_ == wrap_)
+            {
+                // 末尾の余りを飛ばして先頭へ
+                tail_ = 0;
+                wrap_ = Bytes;
+            }
+        }
+
+        /**
+         * @brief need バイトの連続領域を head_ に確保する
+         * @return true:確保できた / false:空きが足りない
+         */
+        bool reserve(size_t need)
+        {
+            if (count_ == 0)
+            {
+                clear();
+                return true;
+            }
+            if (head_ > tail_)
+            {
+                // 折り返していない: 末尾に収まらなければ先頭の空きを使う
+                if (head_ + need <= Bytes)
+                {
+                    return true;
+                }
+                if (need <= tail_)
+                {
+                    wrap_ = head_;
+                    head_ = 0;
+                    return true;
+                }
+                return false;
+            }
+            // 折り返し中: tail_ までが空き（head_ == tail_ は満杯）
+            return head_ + need <= tail_;
+        }
+
+        /**
+         * @brief pos のレコードの参照を作る
+         */
+        void makeView(uint16_t pos, View& view) const
+        {
+            const uint8_t* rec = buffer_ + pos;
+            memcpy(&view.timestamp, rec, 4);
+            view.address = rec + 4;
+            view.size = rec[10];
+            view.crcOk = rec[11] != 0;
+            view.data = rec + RECORD_HEADER_SIZE;
+        }
+
+        /**
+         * @brief 参照からパケットデータへ展開する
+         */
+        static void copyOut(const View& view, PacketData& data, bool& crcOk)
+        {
+            data.timestamp = view.timestamp;
+            memcpy(data.address, view.address, sizeof(data.address));
+            data.carriedSize = view.size;
+            memcpy(data.carriedData, view.data, view.size);
+            crcOk = view.crcOk;
+        }
+
+        uint8_t  buffer_[Bytes];        ///< レコード領域
+        volatile uint16_t head_;        ///< 次に書き込む位置
+        volatile uint16_t tail_;        ///< 最も古いレコードの位置
+        volatile uint16_t wrap_;        ///< 折り返し中の有効データ終端（折り返していなければ Bytes）
+        volatile uint16_t latest_;      ///< 最新のレコードの位置
+        volatile int16_t  count_;       ///< 保持数
+    };
+}
+
+#endif /* ROBO_WCOM_BYTE_RING_H */
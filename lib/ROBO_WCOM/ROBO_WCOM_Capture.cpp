@@ -0,0 +1,284 @@
+#include "ROBO_WCOM_Capture.h"
+#include "ROBO_WCOM_Codec.h"
+#include <cstring>
+
+namespace ROBO_WCOM
+{
+    constexpr size_t CAPTURE_RAM_BYTES = ROBO_WCOM_CAPTURE_RAM_BYTES;
+    static_assert(CAPTURE_RAM_BYTES >= Capture::RECORD_HEADER_SIZE + Capture::FRAME_MAX_SIZE,
+                  "ROBO_WCOM_CAPTURE_RAM_BYTES must hold at least one full frame");
+
+    /**
+     * @brief キャプチャの出力先
+     */
+    enum class CaptureSink : uint8_t { None, Stream, Ram };
+
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE captureMux = portMUX_INITIALIZER_UNLOCKED; ///< RAMバッファ保護
+    #define CAPTURE_LOCK()      portENTER_CRITICAL(&captureMux)
+    #define CAPTURE_UNLOCK()    portEXIT_CRITICAL(&captureMux)
+#else
+    #define CAPTURE_LOCK()
+    #define CAPTURE_UNLOCK()
+#endif
+
+    static volatile CaptureSink sink = CaptureSink::None;  ///< 現在の出力先（変更は CAPTURE_LOCK() の中で行う）
+    static Print*   streamOut = nullptr;                   ///< ストリーム出力先（CaptureService() が書き込む）
+    static uint32_t startMicros = 0;                       ///< キャプチャ開始時刻
+
+    static uint8_t  ramBuffer[CAPTURE_RAM_BYTES];          ///< RAM保存用リングバッファ
+    static size_t   ramHead = 0;                           ///< 次に書き込む位置
+    static size_t   ramTail = 0;                           ///< 最も古いレコードの位置
+    static size_t   ramUsed = 0;                           ///< 使用中バイト数
+    static uint32_t ramRecords = 0;                        ///< 保持しているレコード数
+    static uint32_t ramDropped = 0;                        ///< 上書きで捨てたレコード数
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief リングバッファへ書き込む（折り返しあり）
+     */
+    static void ringWrite(size_t pos, const uint8_t* src, size_t n)
+    {
+        size_t first = CAPTURE_RAM_BYTES - pos;
+        if (first > n)
+        {
+            first = n;
+        }
+        memcpy(ramBuffer + pos, src, first);
+        memcpy(ramBuffer, src + first, n - first);
+    }
+
+    /**
+     * @brief リングバッファから読み出す（折り返しあり）
+     */
+    static void ringRead(size_t pos, uint8_t* dst, size_t n)
+    {
+        size_t first = CAPTURE_RAM_BYTES - pos;
+        if (first > n)
+        {
+            first = n;
+        }
+        memcpy(dst, ramBuffer + pos, first);
+        memcpy(dst + first, ramBuffer, n - first);
+    }
+
+    /**
+     * @brief 指定位置のレコードのフレーム長を取得
+     * @details 書き込み時に Capture::FRAME_MAX_SIZE で切り詰めているが、読み出し側でも上限を守る
+     */
+    static size_t recordFrameSize(size_t pos)
+    {
+        uint8_t header[Capture::RECORD_HEADER_SIZE];
+        ringRead(pos, header, sizeof(header));
+        size_t len = Codec::loadLE16(header + Capture::RECORD_OFFSET_LENGTH);
+        return (len > Capture::FRAME_MAX_SIZE) ? Capture::FRAME_MAX_SIZE : len;
+    }
+
+    /**
+     * @brief 最も古いレコードの長さ（ヘッダ込み）を取得
+     */
+    static size_t oldestRecordSize(void)
+    {
+        return Capture::RECORD_HEADER_SIZE + recordFrameSize(ramTail);
+    }
+
+    /**
+     * @brief RAMバッファへ1レコードを追加する。空きが足りなければ古いレコードから捨てる
+     * @details 出力先の確認もロックの中で行い、CaptureDump() の読み出し中に書き込まないようにする
+     */
+    static void ramAppend(const uint8_t* header, const uint8_t* frame, size_t len)
+    {
+        size_t need = Capture::RECORD_HEADER_SIZE + len;
+        CAPTURE_LOCK();
+        if (sink == CaptureSink::None)
+        {
+            CAPTURE_UNLOCK();
+            return;
+        }
+        while (CAPTURE_RAM_BYTES - ramUsed < need)
+        {
+            size_t size = oldestRecordSize();
+            ramTail = (ramTail + size) % CAPTURE_RAM_BYTES;
+            ramUsed -= size;
+            ramRecords--;
+            ramDropped++;
+        }
+        ringWrite(ramHead, header, Capture::RECORD_HEADER_SIZE);
+        ringWrite((ramHead + Capture::RECORD_HEADER_SIZE) % CAPTURE_RAM_BYTES, frame, len);
+        ramHead = (ramHead + need) % CAPTURE_RAM_BYTES;
+        ramUsed += need;
+        ramRecords++;
+        CAPTURE_UNLOCK();
+    }
+
+    /**
+     * @brief RAMバッファを空にする
+     * @details CAPTURE_LOCK() の中から呼ぶ
+     */
+    static void ramClear(void)
+    {
+        ramHead = 0;
+        ramTail = 0;
+        ramUsed = 0;
+        ramRecords = 0;
+        ramDropped = 0;
+    }
+
+    /**
+     * @brief ファイルヘッダを出力
+     */
+    static void writeFileHeader(Print& out, uint32_t dropped)
+    {
+        uint8_t header[Capture::FILE_HEADER_SIZE];
+        memcpy(header, Capture::MAGIC, sizeof(Capture::MAGIC));
+        Codec::storeLE16(header + Capture::HEADER_OFFSET_VERSION, Capture::VERSION);
+        Codec::storeLE16(header + Capture::HEADER_OFFSET_RECORD_HEADER, Capture::RECORD_HEADER_SIZE);
+        Codec::storeLE32(header + Capture::HEADER_OFFSET_START_MICROS, startMicros);
+        Codec::storeLE32(header + Capture::HEADER_OFFSET_DROPPED, dropped);
+        out.write(header, sizeof(header));
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief 各フレームを順に出力するキャプチャを開始
+     * @param out 出力先
+     * @return ステータスコード (Status)
+     */
+    Status CaptureStartStream(Print& out)
+    {
+        CAPTURE_LOCK();
+        sink = CaptureSink::None;
+        ramClear();
+        CAPTURE_UNLOCK();
+        streamOut = &out;
+        startMicros = micros();
+        writeFileHeader(out, 0);
+        CAPTURE_LOCK();
+        sink = CaptureSink::Stream;
+        CAPTURE_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief RAM上のリングバッファへ保持するキャプチャを開始
+     * @return ステータスコード (Status)
+     */
+    Status CaptureStartRam(void)
+    {
+        CAPTURE_LOCK();
+        ramClear();
+        startMicros = micros();
+        sink = CaptureSink::Ram;
+        CAPTURE_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief キャプチャを停止
+     */
+    void CaptureStop(void)
+    {
+        CAPTURE_LOCK();
+        sink = CaptureSink::None;
+        CAPTURE_UNLOCK();
+    }
+
+    /**
+     * @brief ストリーム出力のキャプチャで、溜まったフレームを出力する
+     * @return 出力したレコード数
+     */
+    size_t CaptureService(void)
+    {
+        size_t written = 0;
+        uint8_t record[Capture::RECORD_HEADER_SIZE + Capture::FRAME_MAX_SIZE];
+        for (;;)
+        {
+            // 1レコードずつロックの中で取り出し、出力はロックの外で行う
+            CAPTURE_LOCK();
+            if (sink != CaptureSink::Stream || ramRecords == 0 || !streamOut)
+            {
+                CAPTURE_UNLOCK();
+                break;
+            }
+            size_t len = recordFrameSize(ramTail);
+            size_t size = Capture::RECORD_HEADER_SIZE + len;
+            ringRead(ramTail, record, size);
+            Codec::storeLE16(record + Capture::RECORD_OFFSET_LENGTH, static_cast<uint16_t>(len));
+            ramTail = (ramTail + size) % CAPTURE_RAM_BYTES;
+            ramUsed -= size;
+            ramRecords--;
+            CAPTURE_UNLOCK();
+
+            streamOut->write(record, size);
+            written++;
+        }
+        return written;
+    }
+
+    /**
+     * @brief RAM上のキャプチャをファイル形式で出力
+     * @param out 出力先
+     * @return 出力したレコード数
+     */
+    size_t CaptureDump(Print& out)
+    {
+        // 出力先を外すのと読み出し範囲の確定を同じロックの中で行う。
+        // 以降の ramAppend() は出力先を確認して何もしないため、出力中にレコードが上書きされない
+        CAPTURE_LOCK();
+        CaptureSink prevSink = sink;
+        sink = CaptureSink::None;
+        size_t pos = ramTail;
+        uint32_t records = ramRecords;
+        uint32_t dropped = ramDropped;
+        CAPTURE_UNLOCK();
+
+        writeFileHeader(out, dropped);
+        uint8_t record[Capture::RECORD_HEADER_SIZE + Capture::FRAME_MAX_SIZE];
+        for (uint32_t i = 0; i < records; ++i)
+        {
+            size_t len = recordFrameSize(pos);
+            size_t size = Capture::RECORD_HEADER_SIZE + len;
+            ringRead(pos, record, size);
+            Codec::storeLE16(record + Capture::RECORD_OFFSET_LENGTH, static_cast<uint16_t>(len));
+            out.write(record, size);
+            pos = (pos + size) % CAPTURE_RAM_BYTES;
+        }
+
+        CAPTURE_LOCK();
+        sink = prevSink;
+        CAPTURE_UNLOCK();
+        return records;
+    }
+
+    /**
+     * @brief フレームを1件キャプチャする
+     * @param direction 方向
+     * @param status    ステータス
+     * @param frame     フレーム本体
+     * @param len       フレーム長
+     */
+    void CaptureFrame(Capture::Direction direction, Status status, const uint8_t* frame, size_t len)
+    {
+        CaptureSink current = sink;
+        if (current == CaptureSink::None || !frame)
+        {
+            return;
+        }
+        if (len > Capture::FRAME_MAX_SIZE)
+        {
+            len = Capture::FRAME_MAX_SIZE;
+        }
+
+        uint8_t record[Capture::RECORD_HEADER_SIZE + Capture::FRAME_MAX_SIZE];
+        Codec::storeLE32(record + Capture::RECORD_OFFSET_TIME_MICROS, micros());
+        Codec::storeLE16(record + Capture::RECORD_OFFSET_LENGTH, static_cast<uint16_t>(len));
+        record[Capture::RECORD_OFFSET_DIRECTION] = static_cast<uint8_t>(direction);
+        record[Capture::RECORD_OFFSET_STATUS] = static_cast<uint8_t>(status);
+
+        // ストリーム出力でも受信コールバックからは書き込まず、CaptureService() が出力するまで RAM バッファへ積む
+        ramAppend(record, frame, len);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef ROBO_WCOM_CAPTURE_H
+#define ROBO_WCOM_CAPTURE_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_CaptureFormat.h"
+
+/**
+ * @brief RAM保存時のキャプチャバッファのバイト数
+ * @details ビルドフラグ（-DROBO_WCOM_CAPTURE_RAM_BYTES=...）で変更可能。1レコードはフレーム長 + 8バイト
+ */
+#ifndef ROBO_WCOM_CAPTURE_RAM_BYTES
+#define ROBO_WCOM_CAPTURE_RAM_BYTES 8192
+#endif
+
+/**
+ * @file ROBO_WCOM_Capture.h
+ * @brief 送受信した生フレームのキャプチャ
+ * @details
+ * 試合中の不具合を再現するため、送受信したすべてのフレームを時刻・ステータス付きで記録する。
+ * 出力先は次のいずれか。
+ *
+ * - ストリーム : loop() から呼ぶ CaptureService() が、溜まったフレームを Serial などへ順に出力する
+ *                （受信コールバックでは RAM バッファへ積むだけなので、出力が詰まっても受信処理は遅れない。
+ *                CaptureService() の間隔の間に RAM バッファがあふれた分は古い順に捨てる）
+ * - RAM        : リングバッファへ保持し、あふれた分は古い順に捨てる。CaptureDump() でまとめて出力する
+ *
+ * 出力は PC側の tools/wcom_replay.cpp で InjectFrame() を通して受信処理へ再投入できる。
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 各フレームを順に出力するキャプチャを開始
+     * @details 開始時にファイルヘッダを出力する。フレームの出力は CaptureService() で行う
+     * @param out 出力先（Serial など）
+     * @return ステータスコード (Status)
+     */
+    Status CaptureStartStream(Print& out);
+
+    /**
+     * @brief RAM上のリングバッファへ保持するキャプチャを開始
+     * @details 以前の保持内容は破棄する
+     * @return ステータスコード (Status)
+     */
+    Status CaptureStartRam(void);
+
+    /**
+     * @brief キャプチャを停止
+     * @details RAM保存の内容は CaptureDump() で出力できるよう残しておく
+     */
+    void CaptureStop(void);
+
+    /**
+     * @brief ストリーム出力のキャプチャで、溜まったフレームを出力する
+     * @details loop() など出力が詰まってもよいタスクから定期的に呼ぶ。RAM保存のキャプチャでは何もしない
+     * @return 出力したレコード数
+     */
+    size_t CaptureService(void);
+
+    /**
+     * @brief RAM上のキャプチャをファイル形式で出力
+     * @details 出力中はキャプチャを一時停止し、終了後に元の状態へ戻す
+     * @param out 出力先（Serial など）
+     * @return 出力したレコード数
+     */
+    size_t CaptureDump(Print& out);
+
+    /**
+     * @brief フレームを1件キャプチャする（ライブラリ内部の送受信処理から呼ばれる）
+     * @param direction 方向
+     * @param status    送信結果などのステータス
+     * @param frame     フレーム本体
+     * @param len       フレーム長（Capture::FRAME_MAX_SIZE を超えた分は切り捨て）
+     */
+    void CaptureFrame(Capture::Direction direction, Status status, const uint8_t* frame, size_t len);
+}
+
+#endif /* ROBO_WCOM_CAPTURE_H */
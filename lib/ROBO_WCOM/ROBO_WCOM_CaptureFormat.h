@@ -0,0 +1,51 @@
+#ifndef ROBO_WCOM_CAPTURE_FORMAT_H
+#define ROBO_WCOM_CAPTURE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ROBO_WCOM_CaptureFormat.h
+ * @brief 無線フレームのキャプチャ形式（pcap 風）
+ * @details
+ * Arduino に依存しないため、PC側の再生ツール（tools/wcom_replay.cpp）からもそのまま利用できる。
+ * 数値はすべてリトルエンディアン。
+ *
+ * - ファイルヘッダ : [マジック "RWCP" 4][版 2][レコードヘッダ長 2][開始時刻 µs 4][欠落レコード数 4]
+ * - レコード       : [時刻 µs 4][フレーム長 2][方向 1][ステータス 1][フレーム本体（フレーム長バイト）]
+ *
+ * フレーム本体は esp_now_send() に渡した / 受信コールバックに届いたバイト列そのもの。
+ * シリアルへ他のテキストと混在して出力されるため、読み出し側はマジックを探して先頭を見つける。
+ * ストリーム出力ではヘッダの欠落レコード数は常に 0 になる。
+ */
+namespace ROBO_WCOM
+{
+namespace Capture
+{
+    /**
+     * @brief フレームの方向
+     */
+    enum class Direction : uint8_t {
+        Rx = 0,     ///< 受信したフレーム
+        Tx = 1,     ///< 送信したフレーム（ステータスは esp_now_send() の結果）
+    };
+
+    constexpr uint8_t  MAGIC[4]            = { 'R', 'W', 'C', 'P' };  ///< ファイルヘッダのマジック
+    constexpr uint16_t VERSION             = 1;     ///< キャプチャ形式の版
+    constexpr size_t   FILE_HEADER_SIZE    = 16;    ///< ファイルヘッダ長
+    constexpr size_t   RECORD_HEADER_SIZE  = 8;     ///< レコードヘッダ長
+    constexpr size_t   FRAME_MAX_SIZE      = 250;   ///< 1レコードに格納できる最大フレーム長
+
+    constexpr size_t HEADER_OFFSET_VERSION       = 4;   ///< 版
+    constexpr size_t HEADER_OFFSET_RECORD_HEADER = 6;   ///< レコードヘッダ長
+    constexpr size_t HEADER_OFFSET_START_MICROS  = 8;   ///< 開始時刻
+    constexpr size_t HEADER_OFFSET_DROPPED       = 12;  ///< 欠落レコード数（RAM保存で上書きされた数）
+
+    constexpr size_t RECORD_OFFSET_TIME_MICROS = 0;     ///< 時刻
+    constexpr size_t RECORD_OFFSET_LENGTH      = 4;     ///< フレーム長
+    constexpr size_t RECORD_OFFSET_DIRECTION   = 6;     ///< 方向
+    constexpr size_t RECORD_OFFSET_STATUS      = 7;     ///< ステータス（ROBO_WCOM::Status）
+}
+}
+
+#endif /* ROBO_WCOM_CAPTURE_FORMAT_H */
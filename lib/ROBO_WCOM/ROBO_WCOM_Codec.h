@@ -0,0 +1,355 @@
+#ifndef ROBO_WCOM_CODEC_H
+#define ROBO_WCOM_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace ROBO_WCOM
+{
+namespace Codec
+{
+    //=== リトルエンディアン読み書き ===//
+
+    /**
+     * @brief 16bit値をリトルエンディアンで書き込む
+     * @details リトルエンディアン環境（ESP32等）ではそのままストア命令になる
+     */
+    inline void storeLE16(uint8_t* dst, uint16_t v)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        memcpy(dst, &v, sizeof(v));
+#else
+        dst[0] = static_cast<uint8_t>(v);
+        dst[1] = static_cast<uint8_t>(v >> 8);
+#endif
+    }
+
+    /**
+     * @brief 32bit値をリトルエンディアンで書き込む
+     */
+    inline void storeLE32(uint8_t* dst, uint32_t v)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        memcpy(dst, &v, sizeof(v));
+#else
+        dst[0] = static_cast<uint8_t>(v);
+        dst[1] = static_cast<uint8_t>(v >> 8);
+        dst[2] = static_cast<uint8_t>(v >> 16);
+        dst[3] = static_cast<uint8_t>(v >> 24);
+#endif
+    }
+
+    /**
+     * @brief リトルエンディアンの16bit値を読み出す
+     */
+    inline uint16_t loadLE16(const uint8_t* src)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        uint16_t v;
+        memcpy(&v, src, sizeof(v));
+        return v;
+#else
+        return static_cast<uint16_t>(src[0] | (src[1] << 8));
+#endif
+    }
+
+    /**
+     * @brief リトルエンディアンの32bit値を読み出す
+     */
+    inline uint32_t loadLE32(const uint8_t* src)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        uint32_t v;
+        memcpy(&v, src, sizeof(v));
+        return v;
+#else
+        return  static_cast<uint32_t>(src[0])        |
+               (static_cast<uint32_t>(src[1]) << 8)  |
+               (static_cast<uint32_t>(src[2]) << 16) |
+               (static_cast<uint32_t>(src[3]) << 24);
+#endif
+    }
+
+    //=== 検査値 ===//
+
+    /**
+     * @brief CRC32（IEEE 802.3、反射形）の途中値にバイト列を加える
+     * @details 途中値は 0xFFFFFFFF から始め、最後に crc32Final() で仕上げる。分割して加えても結果は同じ
+     * @param crc   途中値
+     * @param bytes 対象バイト列
+     * @param len   対象バイト数
+     * @return 新しい途中値
+     */
+    inline uint32_t crc32Update(uint32_t crc, const uint8_t* bytes, size_t len)
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            crc ^= bytes[i];
+            for (int j = 0; j < 8; ++j)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            }
+        }
+        return crc;
+    }
+
+    /**
+     * @brief CRC32 の途中値を仕上げる
+     */
+    inline uint32_t crc32Final(uint32_t crc)
+    {
+        return crc ^ 0xFFFFFFFF;
+    }
+
+    /**
+     * @brief CRC32 を計算する（フレーム・一括転送の検査値）
+     */
+    inline uint32_t crc32(const uint8_t* bytes, size_t len)
+    {
+        return crc32Final(crc32Update(0xFFFFFFFF, bytes, len));
+    }
+
+    /**
+     * @brief CRC16（CRC-16/CCITT-FALSE）を計算する（暗号化Peerのフレーム・シリアルブリッジの検査値）
+     * @details 4ビットずつ表引きする（表は32バイト）
+     */
+    inline uint16_t crc16(const uint8_t* bytes, size_t len)
+    {
+        static const uint16_t NIBBLE_TABLE[16] = {
+            0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+            0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+        };
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < len; ++i)
+        {
+            crc = static_cast<uint16_t>((crc << 4) ^ NIBBLE_TABLE[((crc >> 12) ^ (bytes[i] >> 4)) & 0x0F]);
+            crc = static_cast<uint16_t>((crc << 4) ^ NIBBLE_TABLE[((crc >> 12) ^ (bytes[i] & 0x0F)) & 0x0F]);
+        }
+        return crc;
+    }
+
+    //=== フィールド記述子 ===//
+
+    /**
+     * @brief float を int16 へ量子化するフィールド
+     * @details
+     * - [Min, Max] の範囲を int16 の全域へ線形に割り当てる
+     * - 範囲外の値は飽和させる
+     * - スケール/オフセットはコンパイル時に決まるため、実行時の除算は発生しない
+     * @tparam Offset 構造体内のバイトオフセット（offsetof で指定）
+     * @tparam Min    表現範囲の下限
+     * @tparam Max    表現範囲の上限
+     */
+    template <size_t Offset, int32_t Min, int32_t Max>
+    struct Fixed16
+    {
+        static_assert(Min < Max, "Fixed16: Min must be less than Max");
+
+        static constexpr size_t WIRE_SIZE = 2;                      ///< 送信バイト数
+        static constexpr float  SCALE     = (static_cast<float>(Max) - static_cast<float>(Min)) / 65535.0f; ///< 1LSBあたりの値
+        static constexpr float  BIAS      = (static_cast<float>(Max) + static_cast<float>(Min)) * 0.5f;    ///< 0 に対応する値
+
+        static void encode(const uint8_t* src, uint8_t* dst)
+        {
+            float v;
+            memcpy(&v, src + Offset, sizeof(v));
+            float q = (v - BIAS) * (1.0f / SCALE);
+            int32_t raw;
+            if (!(q > -32768.0f))       // NaN も下限に寄せる
+            {
+                raw = -32768;
+            }
+            else if (q >= 32767.0f)
+            {
+                raw = 32767;
+            }
+            else
+            {
+                raw = static_cast<int32_t>(q < 0.0f ? q - 0.5f : q + 0.5f);
+            }
+            storeLE16(dst, static_cast<uint16_t>(static_cast<int16_t>(raw)));
+        }
+
+        static void decode(const uint8_t* src, uint8_t* dst)
+        {
+            float v = static_cast<float>(static_cast<int16_t>(loadLE16(src))) * SCALE + BIAS;
+            memcpy(dst + Offset, &v, sizeof(v));
+        }
+    };
+
+    /**
+     * @brief 8bit整数フィールド（そのまま転送）
+     */
+    template <size_t Offset>
+    struct U8
+    {
+        static constexpr size_t WIRE_SIZE = 1;
+        static void encode(const uint8_t* src, uint8_t* dst) { dst[0] = src[Offset]; }
+        static void decode(const uint8_t* src, uint8_t* dst) { dst[Offset] = src[0]; }
+    };
+
+    /**
+     * @brief 16bit整数フィールド（リトルエンディアンで転送）
+     */
+    template <size_t Offset>
+    struct U16
+    {
+        static constexpr size_t WIRE_SIZE = 2;
+        static void encode(const uint8_t* src, uint8_t* dst)
+        {
+            uint16_t v;
+            memcpy(&v, src + Offset, sizeof(v));
+            storeLE16(dst, v);
+        }
+        static void decode(const uint8_t* src, uint8_t* dst)
+        {
+            uint16_t v = loadLE16(src);
+            memcpy(dst + Offset, &v, sizeof(v));
+        }
+    };
+
+    /**
+     * @brief 32bit整数フィールド（リトルエンディアンで転送）
+     */
+    template <size_t Offset>
+    struct U32
+    {
+        static constexpr size_t WIRE_SIZE = 4;
+        static void encode(const uint8_t* src, uint8_t* dst)
+        {
+            uint32_t v;
+            memcpy(&v, src + Offset, sizeof(v));
+            storeLE32(dst, v);
+        }
+        static void decode(const uint8_t* src, uint8_t* dst)
+        {
+            uint32_t v = loadLE32(src);
+            memcpy(dst + Offset, &v, sizeof(v));
+        }
+    };
+
+    /**
+     * @brief 単精度浮動小数点フィールド（IEEE754 のビット列をリトルエンディアンで転送）
+     */
+    template <size_t Offset>
+    struct F32
+    {
+        static constexpr size_t WIRE_SIZE = 4;
+        static void encode(const uint8_t* src, uint8_t* dst)
+        {
+            uint32_t v;
+            memcpy(&v, src + Offset, sizeof(v));
+            storeLE32(dst, v);
+        }
+        static void decode(const uint8_t* src, uint8_t* dst)
+        {
+            uint32_t v = loadLE32(src);
+            memcpy(dst + Offset, &v, sizeof(v));
+        }
+    };
+
+    /**
+     * @brief 固定長バイト列フィールド（MACアドレス等、並び順そのまま転送）
+     */
+    template <size_t Offset, size_t N>
+    struct Bytes
+    {
+        static constexpr size_t WIRE_SIZE = N;
+        static void encode(const uint8_t* src, uint8_t* dst) { memcpy(dst, src + Offset, N); }
+        static void decode(const uint8_t* src, uint8_t* dst) { memcpy(dst + Offset, src, N); }
+    };
+
+    //=== スキーマ ===//
+
+    template <typename... Fields>
+    struct FieldList;
+
+    template <>
+    struct FieldList<>
+    {
+        static constexpr size_t WIRE_SIZE = 0;
+        static void encode(const uint8_t*, uint8_t*) {}
+        static void decode(const uint8_t*, uint8_t*) {}
+    };
+
+    template <typename Head, typename... Tail>
+    struct FieldList<Head, Tail...>
+    {
+        static constexpr size_t WIRE_SIZE = Head::WIRE_SIZE + FieldList<Tail...>::WIRE_SIZE;
+
+        static void encode(const uint8_t* src, uint8_t* dst)
+        {
+            Head::encode(src, dst);
+            FieldList<Tail...>::encode(src, dst + Head::WIRE_SIZE);
+        }
+
+        static void decode(const uint8_t* src, uint8_t* dst)
+        {
+            Head::decode(src, dst);
+            FieldList<Tail...>::decode(src + Head::WIRE_SIZE, dst);
+        }
+    };
+
+    /**
+     * @brief 構造体の送信形式を宣言するスキーマ
+     * @details
+     * - フィールド記述子を並べた順にバイト列へ詰める（パディングなし）
+     * - encode/decode はテンプレート展開によりフィールドごとの直列コードになる
+     * - スキーマに含まれないフィールドは decode 時に変更されない
+     * @tparam T      対象の構造体
+     * @tparam Fields フィールド記述子（Fixed16, U8, U16, U32, F32, Bytes）
+     */
+    template <typename T, typename... Fields>
+    struct Schema
+    {
+        static_assert(sizeof...(Fields) > 0, "Schema: at least one field is required");
+
+        typedef T Type;
+
+        static constexpr size_t FIELD_COUNT = sizeof...(Fields);           ///< フィールド数
+        static constexpr size_t WIRE_SIZE   = FieldList<Fields...>::WIRE_SIZE; ///< 送信バイト数
+
+        /**
+         * @brief 送信形式における各フィールドのバイト数
+         * @param index フィールド番号（宣言順、0 始まり）
+         */
+        static size_t fieldSize(size_t index)
+        {
+            static const uint8_t sizes[] = { static_cast<uint8_t>(Fields::WIRE_SIZE)... };
+            return sizes[index];
+        }
+
+        /**
+         * @brief 構造体を送信形式へ変換
+         * @param src 変換元構造体
+         * @param dst 出力先（WIRE_SIZE バイト以上）
+         * @return 書き込んだバイト数
+         */
+        static size_t encode(const T& src, uint8_t* dst)
+        {
+            FieldList<Fields...>::encode(reinterpret_cast<const uint8_t*>(&src), dst);
+            return WIRE_SIZE;
+        }
+
+        /**
+         * @brief 送信形式から構造体を復元
+         * @param src  受信データ
+         * @param size 受信データサイズ
+         * @param dst  復元先構造体
+         * @return true:成功 / false:サイズ不一致
+         */
+        static bool decode(const uint8_t* src, size_t size, T& dst)
+        {
+            if (size != WIRE_SIZE)
+            {
+                return false;
+            }
+            FieldList<Fields...>::decode(src, reinterpret_cast<uint8_t*>(&dst));
+            return true;
+        }
+    };
+}
+}
+
+#endif /* ROBO_WCOM_CODEC_H */
@@ -0,0 +1,195 @@
+#ifndef ROBO_WCOM_DELTA_H
+#define ROBO_WCOM_DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "ROBO_WCOM_Codec.h"
+
+/**
+ * @file ROBO_WCOM_Delta.h
+ * @brief 変化したフィールドのみを送る差分テレメトリ
+ * @details
+ * Codec::Schema で記述した構造体を、キーフレームからの差分として符号化する。
+ *
+ * - キーフレーム : [種別 'K'][キー番号][全フィールド]
+ * - 差分フレーム : [種別 'D'][キー番号][変化ビットマスク][変化したフィールドのみ]
+ *
+ * 差分は常に直近のキーフレームとの比較で作るため、差分フレームが欠落しても
+ * 後続の差分フレームは復元できる。キーフレームが欠落した場合は次のキーフレームまで復元を保留する。
+ * 比較は送信形式（量子化後）のバイト列で行うので、量子化誤差以下の揺らぎは変化とみなさない。
+ */
+namespace ROBO_WCOM
+{
+    namespace Delta
+    {
+        constexpr uint8_t KIND_KEYFRAME = 'K'; ///< キーフレーム
+        constexpr uint8_t KIND_DELTA    = 'D'; ///< 差分フレーム
+        constexpr size_t  HEADER_SIZE   = 2;   ///< 種別 + キー番号
+    }
+
+    /**
+     * @brief 差分エンコーダ（送信側）
+     * @tparam S Codec::Schema
+     */
+    template <typename S>
+    class DeltaEncoder
+    {
+    public:
+        static constexpr size_t MASK_SIZE      = (S::FIELD_COUNT + 7) / 8;                        ///< ビットマスク長
+        static constexpr size_t MAX_FRAME_SIZE = Delta::HEADER_SIZE + MASK_SIZE + S::WIRE_SIZE; ///< 最大出力バイト数
+
+        /**
+         * @param keyframeInterval キーフレームを挿入する間隔（フレーム数、1 で毎回キーフレーム）
+         */
+        explicit DeltaEncoder(uint16_t keyframeInterval)
+            : interval(keyframeInterval == 0 ? 1 : keyframeInterval), sinceKeyframe(0), keySeq(0), hasKeyframe(false)
+        {
+        }
+
+        /**
+         * @brief 次のフレームを強制的にキーフレームにする（再接続時など）
+         */
+        void forceKeyframe()
+        {
+            hasKeyframe = false;
+        }
+
+        /**
+         * @brief 構造体を符号化
+         * @param value 送信する構造体
+         * @param out   出力先（MAX_FRAME_SIZE バイト以上）
+         * @return 出力バイト数
+         */
+        size_t encode(const typename S::Type& value, uint8_t* out)
+        {
+            uint8_t current[S::WIRE_SIZE];
+            S::encode(value, current);
+
+            if (!hasKeyframe || sinceKeyframe >= interval)
+            {
+                memcpy(reference, current, sizeof(reference));
+                hasKeyframe = true;
+                sinceKeyframe = 1;
+                keySeq++;
+                out[0] = Delta::KIND_KEYFRAME;
+                out[1] = keySeq;
+                memcpy(out + Delta::HEADER_SIZE, current, sizeof(current));
+                return Delta::HEADER_SIZE + S::WIRE_SIZE;
+            }
+
+            sinceKeyframe++;
+            uint8_t* mask = out + Delta::HEADER_SIZE;
+            uint8_t* body = mask + MASK_SIZE;
+            size_t pos = 0;
+            memset(mask, 0, MASK_SIZE);
+            for (size_t i = 0; i < S::FIELD_COUNT; ++i)
+            {
+                size_t n = S::fieldSize(i);
+                if (memcmp(current + pos, reference + pos, n) != 0)
+                {
+                    mask[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                    memcpy(body, current + pos, n);
+                    body += n;
+                }
+                pos += n;
+            }
+            out[0] = Delta::KIND_DELTA;
+            out[1] = keySeq;
+            return static_cast<size_t>(body - out);
+        }
+
+    private:
+        uint16_t interval;                  ///< キーフレーム間隔
+        uint16_t sinceKeyframe;             ///< 直近キーフレームからのフレーム数
+        uint8_t  keySeq;                    ///< キーフレーム番号
+        bool     hasKeyframe;               ///< 参照キーフレームの有無
+        uint8_t  reference[S::WIRE_SIZE];   ///< 参照キーフレーム（送信形式）
+    };
+
+    /**
+     * @brief 差分デコーダ（受信側）
+     * @tparam S Codec::Schema
+     */
+    template <typename S>
+    class DeltaDecoder
+    {
+    public:
+        static constexpr size_t MASK_SIZE = (S::FIELD_COUNT + 7) / 8; ///< ビットマスク長
+
+        DeltaDecoder() : keySeq(0), hasKeyframe(false) {}
+
+        /**
+         * @brief 受信フレームから構造体全体を復元
+         * @param in   受信データ
+         * @param size 受信データサイズ
+         * @param out  復元先構造体
+         * @return true:復元成功 / false:形式不正、または参照キーフレーム未受信
+         */
+        bool decode(const uint8_t* in, size_t size, typename S::Type& out)
+        {
+            if (size < Delta::HEADER_SIZE)
+            {
+                return false;
+            }
+
+            if (in[0] == Delta::KIND_KEYFRAME)
+            {
+                if (size != Delta::HEADER_SIZE + S::WIRE_SIZE)
+                {
+                    return false;
+                }
+                memcpy(reference, in + Delta::HEADER_SIZE, sizeof(reference));
+                keySeq = in[1];
+                hasKeyframe = true;
+                return S::decode(reference, sizeof(reference), out);
+            }
+
+            if (in[0] != Delta::KIND_DELTA || !hasKeyframe || in[1] != keySeq || size < Delta::HEADER_SIZE + MASK_SIZE)
+            {
+                return false;
+            }
+
+            uint8_t current[S::WIRE_SIZE];
+            const uint8_t* mask = in + Delta::HEADER_SIZE;
+            const uint8_t* body = mask + MASK_SIZE;
+            const uint8_t* end  = in + size;
+            size_t pos = 0;
+            memcpy(current, reference, sizeof(current));
+            for (size_t i = 0; i < S::FIELD_COUNT; ++i)
+            {
+                size_t n = S::fieldSize(i);
+                if (mask[i / 8] & (1u << (i % 8)))
+                {
+                    if (static_cast<size_t>(end - body) < n)
+                    {
+                        return false;
+                    }
+                    memcpy(current + pos, body, n);
+                    body += n;
+                }
+                pos += n;
+            }
+            if (body != end)
+            {
+                return false;
+            }
+            return S::decode(current, sizeof(current), out);
+        }
+
+        /**
+         * @brief 参照キーフレームを破棄する（再接続時など）
+         */
+        void reset()
+        {
+            hasKeyframe = false;
+        }
+
+    private:
+        uint8_t keySeq;                     ///< 参照キーフレーム番号
+        bool    hasKeyframe;                ///< 参照キーフレームの有無
+        uint8_t reference[S::WIRE_SIZE];    ///< 参照キーフレーム（送信形式）
+    };
+}
+
+#endif /* ROBO_WCOM_DELTA_H */
@@ -0,0 +1,307 @@
+#include "ROBO_WCOM_Hello.h"
+#include "ROBO_WCOM_Codec.h"
+#if ROBO_WCOM_RECEIVE_STORE_BYTES > 0
+#include "ROBO_WCOM_ByteRing.h"
+#endif
+
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 相手へ伝える受信バッファのパケット数
+     * @details 可変長の受信バッファでは最大サイズのパケットで数えた目安
+     */
+#if ROBO_WCOM_RECEIVE_STORE_BYTES > 0
+    constexpr size_t HELLO_RECEIVE_SLOTS = ROBO_WCOM_RECEIVE_STORE_BYTES /
+        (PacketByteRing<ROBO_WCOM_RECEIVE_STORE_BYTES>::RECORD_HEADER_SIZE + RECEIVE_PAYLOAD_MAX);
+#else
+    constexpr size_t HELLO_RECEIVE_SLOTS = RECEIVE_BUFFER_SIZE;
+#endif
+    static_assert(HELLO_RECEIVE_SLOTS <= 0xFFFF, "Receive slots do not fit the hello body");
+
+    /**
+     * @brief 相手から届いた通知・応答の内容
+     */
+    struct HelloPeer {
+        uint8_t  version;       ///< プロトコル版
+        uint16_t capabilities;  ///< 対応機能
+        uint8_t  maxPayload;    ///< 受信できる最大搬送データサイズ
+        uint16_t receiveSlots;  ///< 受信バッファのパケット数
+    };
+
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE helloMux = portMUX_INITIALIZER_UNLOCKED;  ///< 受信内容・状態保護
+    #define HELLO_LOCK()    portENTER_CRITICAL(&helloMux)
+    #define HELLO_UNLOCK()  portEXIT_CRITICAL(&helloMux)
+#else
+    #define HELLO_LOCK()
+    #define HELLO_UNLOCK()
+#endif
+
+    static HelloConfig helloConfig = { 200, 5, Wire::HELLO_CAPS_ALL };  ///< 設定
+    static HelloLink   helloLink{};             ///< 合意した内容
+    static uint8_t     attemptsLeft = 0;        ///< 従来版とみなすまでに送れる通知の残り回数
+    static bool        helloDue = false;        ///< 再送時間を待たずに通知を送るか
+    static uint32_t    helloSentMillis = 0;     ///< 最後に通知を送った時刻
+    static bool        linkWasLost = false;     ///< 前回の HelloService() で途絶していたか
+
+    static bool        peerPending = false;     ///< 相手の通知・応答を受け取り、まだ反映していないか
+    static bool        ackPending = false;      ///< 応答を返す必要があるか
+    static HelloPeer   receivedPeer{};          ///< 受け取った相手の内容
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief 相手へ伝える対応機能
+     */
+    static uint16_t localCapabilities(void)
+    {
+        return GetLocalCapabilities() & (helloConfig.capabilities | Wire::HELLO_CAP_ENCRYPTED);
+    }
+
+    /**
+     * @brief 通知・応答を送る
+     * @param kind 種類（Wire::HELLO_KIND_*）
+     */
+    static Status sendHello(uint8_t kind)
+    {
+        uint8_t body[Wire::HELLO_BODY_SIZE];
+        body[Wire::HELLO_OFFSET_KIND] = kind;
+        body[Wire::HELLO_OFFSET_VERSION] = Wire::PROTOCOL_VERSION;
+        Codec::storeLE16(body + Wire::HELLO_OFFSET_CAPABILITIES, localCapabilities());
+        body[Wire::HELLO_OFFSET_MAX_PAYLOAD] = static_cast<uint8_t>(RECEIVE_PAYLOAD_MAX);
+        Codec::storeLE16(body + Wire::HELLO_OFFSET_RECEIVE_SLOTS, static_cast<uint16_t>(HELLO_RECEIVE_SLOTS));
+        return SendExtFrame(static_cast<uint8_t>(Wire::FrameType::Hello), body, sizeof(body));
+    }
+
+    /**
+     * @brief 従来版の相手を前提とした設定に戻す
+     * @param state 戻した後の状態
+     */
+    static void applyLegacy(HelloState state)
+    {
+        SetPeerCapabilities(0);
+        SetPeerMaxPayload(static_cast<uint8_t>(CARRIED_DATA_MAX_SIZE));
+        SetIntegrityCheck(IntegrityCheck::Crc32);
+        HELLO_LOCK();
+        helloLink.state = state;
+        helloLink.version = 0;
+        helloLink.peerCapabilities = 0;
+        helloLink.peerMaxPayload = static_cast<uint8_t>(CARRIED_DATA_MAX_SIZE);
+        helloLink.peerReceiveSlots = 0;
+        helloLink.format = FrameFormat::Full;
+        helloLink.check = IntegrityCheck::Crc32;
+        HELLO_UNLOCK();
+    }
+
+    /**
+     * @brief 相手の内容から送信形式を選んで切り替える
+     * @details 整合性検査は双方向で同じ設定が必要なため、双方が対応するものだけから選ぶ
+     * @param peer 相手の内容
+     */
+    static void applyPeer(const HelloPeer& peer)
+    {
+        uint16_t local = localCapabilities();
+        uint16_t common = local & peer.capabilities;
+        bool encrypted = (common & Wire::HELLO_CAP_ENCRYPTED) != 0;
+
+        IntegrityCheck check = IntegrityCheck::Crc32;
+        if (encrypted && (common & Wire::HELLO_CAP_NO_CHECK))
+        {
+            check = IntegrityCheck::None;
+        }
+        else if (encrypted && (common & Wire::HELLO_CAP_CRC16))
+        {
+            check = IntegrityCheck::Crc16;
+        }
+        if (SetIntegrityCheck(check) != Status::Ok)
+        {
+            check = IntegrityCheck::Crc32;
+            SetIntegrityCheck(check);
+        }
+
+        // 送るフレームは相手が受け付けるかだけで決まる
+        FrameFormat format = (peer.capabilities & Wire::HELLO_CAP_COMPACT) ? FrameFormat::Compact : FrameFormat::Full;
+        SetFrameFormat(format);
+        SetPeerCapabilities(peer.capabilities);
+        // 受信できる大きさを超える送信は拒否させる。範囲外の値は受け付けず、制限しない
+        if (SetPeerMaxPayload(peer.maxPayload) != Status::Ok)
+        {
+            SetPeerMaxPayload(static_cast<uint8_t>(CARRIED_DATA_MAX_SIZE));
+        }
+
+        HELLO_LOCK();
+        // 通知と応答の両方を受け取るので、合意していない状態からの切り替えだけを数える
+        if (helloLink.state != HelloState::Negotiated)
+        {
+            helloLink.negotiations++;
+        }
+        helloLink.state = HelloState::Negotiated;
+        helloLink.version = (peer.version < Wire::PROTOCOL_VERSION) ? peer.version : Wire::PROTOCOL_VERSION;
+        helloLink.peerCapabilities = peer.capabilities & Wire::HELLO_CAPS_ALL;
+        helloLink.peerMaxPayload = GetPeerMaxPayload();
+        helloLink.peerReceiveSlots = peer.receiveSlots;
+        helloLink.format = format;
+        helloLink.check = check;
+        HELLO_UNLOCK();
+    }
+
+    /**
+     * @brief 合意し直す（従来形式に戻して通知を送り直す）
+     */
+    static void restart(void)
+    {
+        applyLegacy(HelloState::Negotiating);
+        attemptsLeft = helloConfig.attempts;
+        helloDue = true;
+    }
+
+    /**
+     * @brief ハンドシェイクフレームの受信ハンドラ（Wi-Fiタスクから呼ばれる）
+     */
+    static void onHelloFrame(const uint8_t* body, uint8_t size)
+    {
+        if (size < Wire::HELLO_BODY_SIZE)
+        {
+            return;
+        }
+        uint8_t kind = body[Wire::HELLO_OFFSET_KIND];
+        if (kind != Wire::HELLO_KIND_HELLO && kind != Wire::HELLO_KIND_ACK)
+        {
+            return;
+        }
+        HELLO_LOCK();
+        receivedPeer.version = body[Wire::HELLO_OFFSET_VERSION];
+        receivedPeer.capabilities = Codec::loadLE16(body + Wire::HELLO_OFFSET_CAPABILITIES);
+        receivedPeer.maxPayload = body[Wire::HELLO_OFFSET_MAX_PAYLOAD];
+        receivedPeer.receiveSlots = Codec::loadLE16(body + Wire::HELLO_OFFSET_RECEIVE_SLOTS);
+        peerPending = true;
+        // 相手が合意し直している（再起動など）ので、合意済みでも必ず応答する
+        if (kind == Wire::HELLO_KIND_HELLO)
+        {
+            ackPending = true;
+        }
+        HELLO_UNLOCK();
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief ハンドシェイクを開始する
+     * @param config 設定
+     * @return ステータスコード (Status)
+     */
+    Status HelloBegin(const HelloConfig& config)
+    {
+        if (config.retryMs == 0 || config.attempts == 0)
+        {
+            return Status::InvalidArg;
+        }
+        HELLO_LOCK();
+        helloConfig = config;
+        helloLink = HelloLink{};
+        peerPending = false;
+        ackPending = false;
+        HELLO_UNLOCK();
+        linkWasLost = false;
+        restart();
+        return SetFrameHandler(static_cast<uint8_t>(Wire::FrameType::Hello), onHelloFrame);
+    }
+
+    /**
+     * @brief 通知・応答の送信、通知の再送、合意した設定への切り替えを行う
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status HelloService(uint32_t nowMillis)
+    {
+        if (HelloGetState() == HelloState::Idle)
+        {
+            return Status::Ok;
+        }
+
+        // 途絶したら従来形式に戻して通知を送り続ける（相手だけが合意済みで、こちらの受信が
+        // 止まっている場合も応答で戻れる）。復帰したら相手が入れ替わっているかもしれないので合意し直す
+        bool lost = (UpdateLinkState(nowMillis) == LinkState::Lost);
+        if (lost != linkWasLost)
+        {
+            linkWasLost = lost;
+            restart();
+        }
+
+        HELLO_LOCK();
+        bool received = peerPending;
+        bool sendAck = ackPending;
+        HelloPeer peer = receivedPeer;
+        peerPending = false;
+        ackPending = false;
+        HelloState state = helloLink.state;
+        HELLO_UNLOCK();
+
+        Status result = Status::Ok;
+        if (received)
+        {
+            applyPeer(peer);
+            state = HelloState::Negotiated;
+        }
+        if (sendAck && sendHello(Wire::HELLO_KIND_ACK) != Status::Ok)
+        {
+            result = Status::SendFail;
+        }
+
+        // 応答を待つ間は再送時間ごとに通知を送り直し、回数を使い切ったら従来版とみなす。
+        // 途絶中は届かないのが当然なので回数を数えない
+        if (state != HelloState::Negotiating || (!helloDue && nowMillis - helloSentMillis < helloConfig.retryMs))
+        {
+            return result;
+        }
+        if (attemptsLeft == 0 && !lost)
+        {
+            HELLO_LOCK();
+            helloLink.state = HelloState::Legacy;
+            HELLO_UNLOCK();
+            return result;
+        }
+        // 送信に失敗した場合も1回と数え、再送時間後に送り直す
+        helloDue = false;
+        helloSentMillis = nowMillis;
+        if (!lost && attemptsLeft > 0)
+        {
+            attemptsLeft--;
+        }
+        if (sendHello(Wire::HELLO_KIND_HELLO) != Status::Ok)
+        {
+            result = Status::SendFail;
+        }
+        return result;
+    }
+
+    /**
+     * @brief ハンドシェイクの状態を取得
+     * @return 状態
+     */
+    HelloState HelloGetState(void)
+    {
+        HELLO_LOCK();
+        HelloState state = helloLink.state;
+        HELLO_UNLOCK();
+        return state;
+    }
+
+    /**
+     * @brief 合意した内容を取得
+     * @param link 格納先
+     * @return ステータスコード (Status)
+     */
+    Status HelloGetLink(HelloLink* link)
+    {
+        if (!link)
+        {
+            return Status::InvalidArg;
+        }
+        HELLO_LOCK();
+        *link = helloLink;
+        HELLO_UNLOCK();
+        return Status::Ok;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef ROBO_WCOM_HELLO_H
+#define ROBO_WCOM_HELLO_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Wire.h"
+
+/**
+ * @file ROBO_WCOM_Hello.h
+ * @brief リンク立ち上げ時のハンドシェイク（プロトコル版と対応機能の交換）
+ * @details
+ * コントローラとロボットが同じ版のファームウェアとは限らないため、リンクの立ち上げ時に
+ * プロトコル版・対応機能（受け付けられるフレームの種類）・受信できる最大搬送データサイズ・
+ * 受信バッファのパケット数を交換し、双方が同じ規則で送信形式を選ぶ。
+ *
+ * - 送信フレーム形式 : 相手が可変長データフレームを受け付けるなら FrameFormat::Compact、それ以外は Full
+ * - 整合性検査       : 双方が暗号化Peerで、双方が検査省略に対応するなら IntegrityCheck::None、
+ *                      CRC16 に対応するなら Crc16、それ以外は Crc32
+ * - 相手が受け付けないフレーム（冗長・優先・生存通知）は送らない（SetPeerCapabilities()）
+ * - 相手が受信できる最大搬送データサイズを超える送信は Status::InvalidArg で拒否する（SetPeerMaxPayload()）
+ *
+ * 合意するまでは従来形式（215バイト固定長）だけで送る。所定の回数通知しても応答がない相手は
+ * ハンドシェイクを知らない従来版とみなし、従来形式のまま通信を続ける（従来版は未知のフレームを読み捨てる）。
+ * その後に相手から通知が届けば（再起動・書き換えなど）改めて合意する。
+ * 通信途絶したときは従来形式に戻し、途絶している間は回数を数えずに通知を送り続ける
+ * （片方向だけ途絶した場合も、相手が応答すれば復帰する）。復帰したときは相手が入れ替わっている
+ * 可能性があるため、改めて合意し直す。
+ *
+ * 送受信は拡張フレーム（Wire::FrameType::Hello）で行い、通知・応答の送信と設定の切り替えは
+ * HelloService() の中で行う。受信側は合意した検査によらず受け付けてよい検査をすべて読む（SetIntegrityCheck()）ため、
+ * 片側だけが先に切り替えても、切り替えた側のフレームは読み捨てられない。
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief ハンドシェイクの状態
+     */
+    enum class HelloState : uint8_t {
+        Idle        = 0,    ///< 開始していない（SetPeerCapabilities() などの設定には触れない）
+        Negotiating = 1,    ///< 通知を送り、応答を待っている（従来形式で送信中）
+        Negotiated  = 2,    ///< 合意した
+        Legacy      = 3,    ///< 応答がなく、従来版の相手とみなした
+    };
+
+    /**
+     * @brief ハンドシェイクの設定
+     */
+    struct HelloConfig {
+        uint32_t retryMs;       ///< 応答が届かない場合に通知を送り直すまでの時間（ミリ秒）
+        uint8_t  attempts;      ///< 従来版の相手とみなすまでに通知を送る回数
+        uint16_t capabilities;  ///< 相手に送らせてよい機能（Wire::HELLO_CAP_* の論理和。通常は Wire::HELLO_CAPS_ALL）
+    };
+
+    /**
+     * @brief 合意した内容
+     */
+    struct HelloLink {
+        HelloState     state;               ///< 状態
+        uint8_t        version;             ///< 合意したプロトコル版（従来版の相手は 0）
+        uint16_t       peerCapabilities;    ///< 相手が受け付ける機能（Wire::HELLO_CAP_* の論理和）
+        uint8_t        peerMaxPayload;      ///< 相手が受信できる最大搬送データサイズ（これを超える送信は Status::InvalidArg で拒否する。SetPeerMaxPayload()）
+        uint16_t       peerReceiveSlots;    ///< 相手の受信バッファのパケット数（従来版の相手は 0 = 不明）
+        FrameFormat    format;              ///< 選んだ送信フレーム形式
+        IntegrityCheck check;               ///< 選んだ整合性検査
+        uint32_t       negotiations;        ///< 合意した回数（相手の再起動や途絶からの復帰で増える）
+    };
+
+    /**
+     * @brief ハンドシェイクを開始する
+     * @details
+     * Init()・SetEncryption() の後に呼ぶ。従来形式に戻して拡張フレームのハンドラを登録し、
+     * 次の HelloService() で通知を送る
+     * @param config 設定
+     * @return ステータスコード (Status)
+     */
+    Status HelloBegin(const HelloConfig& config);
+
+    /**
+     * @brief 通知・応答の送信、通知の再送、合意した設定への切り替えを行う
+     * @details 制御ループなどから周期的に呼ぶ。通信途絶中も通知を送り直す
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status HelloService(uint32_t nowMillis);
+
+    /**
+     * @brief ハンドシェイクの状態を取得
+     * @return 状態
+     */
+    HelloState HelloGetState(void);
+
+    /**
+     * @brief 合意した内容を取得
+     * @param link 格納先
+     * @return ステータスコード (Status)
+     */
+    Status HelloGetLink(HelloLink* link);
+}
+
+#endif /* ROBO_WCOM_HELLO_H */
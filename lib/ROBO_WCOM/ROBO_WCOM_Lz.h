@@ -0,0 +1,339 @@
+#ifndef ROBO_WCOM_LZ_H
+#define ROBO_WCOM_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file ROBO_WCOM_Lz.h
+ * @brief 固定長窓の逐次型 LZSS 圧縮・伸長
+ * @details
+ * ログや較正データを一括転送（ROBO_WCOM_Bulk.h）で送る際に、メッセージ全体を溜めずに
+ * フレーム単位で圧縮・伸長する。heatshrink と同じく、入力の投入（sink）と出力の取り出し（poll）を
+ * 任意の大きさで交互に行え、使うメモリは窓の大きさで決まる。
+ *
+ * 符号はビット列で、上位ビットから詰める。
+ * - リテラル : [1][バイト 8bit]
+ * - 後方参照 : [0][距離-1 WindowBits][長さ-MATCH_MIN LookaheadBits]
+ *
+ * 末尾は 0 で詰めてバイト境界に揃える。詰め物は7ビット以下で、どの符号よりも短いため復号されない。
+ * Arduino に依存しないため、PC側ツールからもそのまま利用できる。
+ *
+ * @tparam WindowBits    参照できる距離のビット数（窓は 2^WindowBits バイト）
+ * @tparam LookaheadBits 一致長のビット数（最長 2^LookaheadBits + 1 バイト）
+ */
+namespace ROBO_WCOM
+{
+    namespace Lz
+    {
+        constexpr size_t MATCH_MIN = 2;   ///< 後方参照にする最短の一致長（これ未満はリテラルの方が短い）
+    }
+
+    /**
+     * @brief 逐次型圧縮器
+     * @details 作業領域は 2 * 2^WindowBits バイト
+     */
+    template <unsigned WindowBits, unsigned LookaheadBits>
+    class LzEncoder
+    {
+        static_assert(WindowBits >= 4 && WindowBits <= 12, "WindowBits must be 4..12");
+        static_assert(LookaheadBits >= 2 && LookaheadBits < WindowBits, "LookaheadBits must be 2..WindowBits-1");
+        static_assert(1 + WindowBits + LookaheadBits > 7, "Back-reference must be longer than the 7-bit tail padding");
+
+    public:
+        static constexpr size_t WINDOW    = static_cast<size_t>(1) << WindowBits;                  ///< 窓のバイト数
+        static constexpr size_t MATCH_MAX = (static_cast<size_t>(1) << LookaheadBits) + Lz::MATCH_MIN - 1; ///< 最長の一致長
+
+        LzEncoder()
+        {
+            reset();
+        }
+
+        /**
+         * @brief 新しいメッセージの圧縮を始める
+         */
+        void reset()
+        {
+            fill = 0;
+            pos = 0;
+            bitBuf = 0;
+            bitCount = 0;
+            finishing = false;
+        }
+
+        /**
+         * @brief 入力を投入する
+         * @param in   入力
+         * @param size 入力バイト数
+         * @return 受け取ったバイト数（作業領域が埋まっていれば size 未満。poll() で取り出してから残りを渡す）
+         */
+        size_t sink(const uint8_t* in, size_t size)
+        {
+            if (finishing)
+            {
+                return 0;
+            }
+            if (fill == sizeof(buf) && pos > WINDOW)
+            {
+                // 窓より古い部分を捨てる
+                size_t shift = pos - WINDOW;
+                memmove(buf, buf + shift, fill - shift);
+                fill -= shift;
+                pos -= shift;
+            }
+            size_t n = sizeof(buf) - fill;
+            if (n > size)
+            {
+                n = size;
+            }
+            memcpy(buf + fill, in, n);
+            fill += n;
+            return n;
+        }
+
+        /**
+         * @brief 入力の終わりを伝える
+         * @details 以降は poll() で残りの符号と末尾の詰め物を取り出す
+         */
+        void finish()
+        {
+            finishing = true;
+        }
+
+        /**
+         * @brief 符号を取り出す
+         * @param out      出力先
+         * @param capacity 出力先のバイト数
+         * @return 出力したバイト数（0 なら入力の追加か finish() が必要、または完了）
+         */
+        size_t poll(uint8_t* out, size_t capacity)
+        {
+            size_t produced = 0;
+            while (produced < capacity)
+            {
+                if (bitCount >= 8)
+                {
+                    bitCount -= 8;
+                    out[produced++] = static_cast<uint8_t>(bitBuf >> bitCount);
+                    continue;
+                }
+                size_t avail = fill - pos;
+                if (avail > 0 && (avail >= MATCH_MAX || finishing))
+                {
+                    encodeOne(avail);
+                }
+                else if (finishing && avail == 0 && bitCount > 0)
+                {
+                    // 末尾を 0 で詰める
+                    out[produced++] = static_cast<uint8_t>(bitBuf << (8 - bitCount));
+                    bitCount = 0;
+                }
+                else
+                {
+                    break;
+                }
+            }
+            bitBuf &= (static_cast<uint32_t>(1) << bitCount) - 1;
+            return produced;
+        }
+
+        /**
+         * @brief finish() 後、すべての符号を取り出したか
+         */
+        bool done() const
+        {
+            return finishing && pos == fill && bitCount == 0;
+        }
+
+    private:
+        uint8_t  buf[2 * WINDOW];   ///< 窓（pos より前）と未圧縮の入力（pos 以降）
+        size_t   fill;              ///< buf の使用バイト数
+        size_t   pos;               ///< 次に圧縮する位置
+        uint32_t bitBuf;            ///< 出力待ちのビット（下位 bitCount ビット）
+        unsigned bitCount;          ///< 出力待ちのビット数
+        bool     finishing;         ///< 入力が終わったか
+
+        /**
+         * @brief ビットを出力待ちに加える
+         */
+        void putBits(uint32_t value, unsigned bits)
+        {
+            bitBuf = (bitBuf << bits) | value;
+            bitCount += bits;
+        }
+
+        /**
+         * @brief pos から1符号を作る
+         * @param avail 未圧縮の入力バイト数
+         */
+        void encodeOne(size_t avail)
+        {
+            size_t limit = (avail < MATCH_MAX) ? avail : MATCH_MAX;
+            size_t start = (pos > WINDOW) ? pos - WINDOW : 0;
+            size_t bestLen = 0;
+            size_t bestDist = 0;
+            const uint8_t* cur = buf + pos;
+
+            // 近い位置から探し、同じ長さなら近い方を残す
+            for (size_t i = pos; i-- > start;)
+            {
+                if (buf[i] != cur[0])
+                {
+                    continue;
+                }
+                size_t len = 1;
+                while (len < limit && buf[i + len] == cur[len])
+                {
+                    len++;
+                }
+                if (len > bestLen)
+                {
+                    bestLen = len;
+                    bestDist = pos - i;
+                    if (len == limit)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            if (bestLen >= Lz::MATCH_MIN)
+            {
+                putBits(0, 1);
+                putBits(static_cast<uint32_t>(bestDist - 1), WindowBits);
+                putBits(static_cast<uint32_t>(bestLen - Lz::MATCH_MIN), LookaheadBits);
+                pos += bestLen;
+            }
+            else
+            {
+                putBits(0x100u | cur[0], 9);
+                pos++;
+            }
+        }
+    };
+
+    /**
+     * @brief 逐次型伸長器
+     * @details 作業領域は 2^WindowBits バイト。圧縮器と同じテンプレート引数で使う
+     */
+    template <unsigned WindowBits, unsigned LookaheadBits>
+    class LzDecoder
+    {
+        static_assert(WindowBits >= 4 && WindowBits <= 12, "WindowBits must be 4..12");
+        static_assert(LookaheadBits >= 2 && LookaheadBits < WindowBits, "LookaheadBits must be 2..WindowBits-1");
+        static_assert(1 + WindowBits + LookaheadBits > 7, "Back-reference must be longer than the 7-bit tail padding");
+
+    public:
+        static constexpr size_t WINDOW = static_cast<size_t>(1) << WindowBits;   ///< 窓のバイト数
+
+        LzDecoder()
+        {
+            reset();
+        }
+
+        /**
+         * @brief 新しいメッセージの伸長を始める
+         */
+        void reset()
+        {
+            memset(window, 0, sizeof(window));
+            head = 0;
+            bitBuf = 0;
+            bitCount = 0;
+            copyDist = 0;
+            copyLeft = 0;
+        }
+
+        /**
+         * @brief 符号を投入する
+         * @param in   符号
+         * @param size 符号のバイト数
+         * @return 受け取ったバイト数（size 未満なら poll() で取り出してから残りを渡す）
+         */
+        size_t sink(const uint8_t* in, size_t size)
+        {
+            size_t n = 0;
+            while (n < size && bitCount <= 24)
+            {
+                bitBuf = (bitBuf << 8) | in[n++];
+                bitCount += 8;
+            }
+            return n;
+        }
+
+        /**
+         * @brief 伸長したデータを取り出す
+         * @param out      出力先
+         * @param capacity 出力先のバイト数
+         * @return 出力したバイト数（0 なら符号の追加が必要）
+         */
+        size_t poll(uint8_t* out, size_t capacity)
+        {
+            size_t produced = 0;
+            while (produced < capacity)
+            {
+                if (copyLeft > 0)
+                {
+                    put(window[(head - copyDist) & (WINDOW - 1)], out, produced);
+                    copyLeft--;
+                    continue;
+                }
+                if (bitCount < 1)
+                {
+                    break;
+                }
+                if (peekBits(1))
+                {
+                    if (bitCount < 9)
+                    {
+                        break;
+                    }
+                    takeBits(1);
+                    put(static_cast<uint8_t>(takeBits(8)), out, produced);
+                }
+                else
+                {
+                    if (bitCount < 1 + WindowBits + LookaheadBits)
+                    {
+                        break;
+                    }
+                    // 壊れた符号で出力前の位置を指した場合は 0 を読む（窓は 0 で初期化済み）
+                    takeBits(1);
+                    copyDist = takeBits(WindowBits) + 1;
+                    copyLeft = takeBits(LookaheadBits) + Lz::MATCH_MIN;
+                }
+            }
+            return produced;
+        }
+
+    private:
+        uint8_t  window[WINDOW];    ///< 直近の出力（リングバッファ）
+        size_t   head;              ///< 次に書き込む位置（出力の総バイト数）
+        uint32_t bitBuf;            ///< 未復号のビット（下位 bitCount ビット）
+        unsigned bitCount;          ///< 未復号のビット数
+        size_t   copyDist;          ///< コピー中の後方参照の距離
+        size_t   copyLeft;          ///< コピー中の後方参照の残りバイト数
+
+        uint32_t peekBits(unsigned bits) const
+        {
+            return (bitBuf >> (bitCount - bits)) & ((static_cast<uint32_t>(1) << bits) - 1);
+        }
+
+        uint32_t takeBits(unsigned bits)
+        {
+            uint32_t v = peekBits(bits);
+            bitCount -= bits;
+            return v;
+        }
+
+        void put(uint8_t b, uint8_t* out, size_t& produced)
+        {
+            window[head & (WINDOW - 1)] = b;
+            head++;
+            out[produced++] = b;
+        }
+    };
+}
+
+#endif /* ROBO_WCOM_LZ_H */
@@ -0,0 +1,562 @@
+#include "ROBO_WCOM_Param.h"
+#include "ROBO_WCOM_Codec.h"
+#include <cstring>
+
+namespace ROBO_WCOM
+{
+    /**
+     * @brief パラメータ表の要素
+     */
+    struct ParamEntry {
+        uint8_t  key;           ///< キー
+        bool     dirty;         ///< 相手へ送る必要があるか
+        bool     changed;       ///< 相手から届いた値を採用し、まだ通知していないか
+        uint16_t version;       ///< 版番号
+        uint32_t value;         ///< 値
+    };
+
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE paramMux = portMUX_INITIALIZER_UNLOCKED;  ///< パラメータ表保護
+    #define PARAM_LOCK()    portENTER_CRITICAL(&paramMux)
+    #define PARAM_UNLOCK()  portEXIT_CRITICAL(&paramMux)
+#else
+    #define PARAM_LOCK()
+    #define PARAM_UNLOCK()
+#endif
+
+    static ParamEntry entries[PARAM_MAX];               ///< パラメータ表
+    static uint8_t    entryCount = 0;                   ///< 登録数
+
+    static uint32_t   retryMillis = 100;                ///< 再送までの時間
+    static bool       batchOutstanding = false;         ///< 確認待ちの更新があるか
+    static uint16_t   batchSeq = 0;                     ///< 確認待ちの更新のバッチ番号
+    static uint32_t   batchSentMillis = 0;              ///< 確認待ちの更新の送信時刻
+    static uint8_t    batchCount = 0;                   ///< 確認待ちの更新のエントリ数
+    static uint8_t    batchIndex[Wire::PARAM_BATCH_MAX];    ///< 確認待ちの更新のエントリ位置
+    static uint16_t   batchVersion[Wire::PARAM_BATCH_MAX];  ///< 確認待ちの更新で送った版番号
+
+    static bool       ackPending = false;               ///< 確認を返す必要があるか
+    static uint16_t   ackSeq = 0;                       ///< 返す確認のバッチ番号
+    static bool       requestResync = false;            ///< 相手へ再同期要求を送る必要があるか
+    static bool       linkWasLost = false;              ///< 前回の ParamService() で途絶していたか
+    static ParamChangeCallback changeCallback = nullptr;///< 値の採用時のコールバック
+    static ParamStats paramStats{};                     ///< 統計
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief a が b より新しい版番号か（折り返しを考慮）
+     */
+    static bool isNewer(uint16_t a, uint16_t b)
+    {
+        return static_cast<int16_t>(a - b) > 0;
+    }
+
+    /**
+     * @brief 受信したエントリを採用するか
+     * @details
+     * 版番号が新しければ採用する。両側で同時に書き換えて版番号が同じになった場合は値の大きい方を残す。
+     * 両側が同じ規則で選ぶため、どちらの更新が先に届いても同じ値にそろう
+     */
+    static bool shouldAdopt(const ParamEntry& entry, uint16_t version, uint32_t value)
+    {
+        if (entry.version == 0 || isNewer(version, entry.version))
+        {
+            return true;
+        }
+        return version == entry.version && value > entry.value;
+    }
+
+    /**
+     * @brief キーからパラメータ表の要素を探す
+     */
+    static ParamEntry* findEntry(uint8_t key)
+    {
+        for (uint8_t i = 0; i < entryCount; ++i)
+        {
+            if (entries[i].key == key)
+            {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief キーの要素を探し、なければ追加する
+     * @return 要素（表が満杯なら nullptr）
+     */
+    static ParamEntry* findOrAddEntry(uint8_t key, uint32_t value)
+    {
+        ParamEntry* entry = findEntry(key);
+        if (entry || entryCount >= PARAM_MAX)
+        {
+            return entry;
+        }
+        entry = &entries[entryCount++];
+        entry->key = key;
+        entry->dirty = false;
+        entry->changed = false;
+        entry->version = 0;
+        entry->value = value;
+        return entry;
+    }
+
+    /**
+     * @brief 全エントリを送信対象にする
+     * @details 初期値のまま（版番号 0）のエントリは送らない。送ると双方の初期値が入れ替わるため
+     */
+    static void markAllDirty(void)
+    {
+        for (uint8_t i = 0; i < entryCount; ++i)
+        {
+            entries[i].dirty = (entries[i].version != 0);
+        }
+        batchOutstanding = false;
+    }
+
+    /**
+     * @brief 本体を送信し、統計へ加える
+     */
+    static Status sendBody(const uint8_t* body, size_t size)
+    {
+        Status status = SendExtFrame(static_cast<uint8_t>(Wire::FrameType::Param), body, static_cast<uint8_t>(size));
+        if (status == Status::Ok)
+        {
+            paramStats.bytesSent += size;
+        }
+        return status;
+    }
+
+    /**
+     * @brief 更新の受信処理（Wi-Fiタスクから呼ばれる）
+     */
+    static void receiveUpdate(const uint8_t* body, uint8_t size)
+    {
+        if (size < Wire::PARAM_UPDATE_HEADER_SIZE)
+        {
+            return;
+        }
+        uint8_t count = body[Wire::PARAM_OFFSET_COUNT];
+        if (size != Wire::PARAM_UPDATE_HEADER_SIZE + count * Wire::PARAM_ENTRY_SIZE)
+        {
+            return;
+        }
+        const uint8_t* e = body + Wire::PARAM_UPDATE_HEADER_SIZE;
+        for (uint8_t i = 0; i < count; ++i, e += Wire::PARAM_ENTRY_SIZE)
+        {
+            uint16_t version = Codec::loadLE16(e + Wire::PARAM_ENTRY_OFFSET_VERSION);
+            uint32_t value = Codec::loadLE32(e + Wire::PARAM_ENTRY_OFFSET_VALUE);
+            if (version == 0)
+            {
+                continue;
+            }
+            ParamEntry* entry = findOrAddEntry(e[Wire::PARAM_ENTRY_OFFSET_KEY], value);
+            if (!entry)
+            {
+                continue;
+            }
+            if (shouldAdopt(*entry, version, value))
+            {
+                // 相手はこの版を持っているので、送り返さない
+                entry->changed = entry->changed || entry->value != value || entry->version == 0;
+                entry->value = value;
+                entry->version = version;
+                entry->dirty = false;
+                paramStats.applied++;
+            }
+        }
+        // 再送された更新にも確認を返す
+        ackSeq = Codec::loadLE16(body + Wire::PARAM_OFFSET_BATCH);
+        ackPending = true;
+    }
+
+    /**
+     * @brief 確認の受信処理（Wi-Fiタスクから呼ばれる）
+     */
+    static void receiveAck(const uint8_t* body, uint8_t size)
+    {
+        if (size != Wire::PARAM_ACK_SIZE || !batchOutstanding ||
+            Codec::loadLE16(body + Wire::PARAM_OFFSET_BATCH) != batchSeq)
+        {
+            return;
+        }
+        for (uint8_t i = 0; i < batchCount; ++i)
+        {
+            // 送信後に書き換えられたエントリは送り直す
+            ParamEntry& entry = entries[batchIndex[i]];
+            if (entry.version == batchVersion[i])
+            {
+                entry.dirty = false;
+            }
+        }
+        batchOutstanding = false;
+    }
+
+    /**
+     * @brief パラメータ同期フレームの受信ハンドラ（Wi-Fiタスクから呼ばれる）
+     */
+    static void onParamFrame(const uint8_t* body, uint8_t size)
+    {
+        if (size < 1)
+        {
+            return;
+        }
+        PARAM_LOCK();
+        switch (body[Wire::PARAM_OFFSET_KIND])
+        {
+            case Wire::PARAM_KIND_UPDATE:
+                receiveUpdate(body, size);
+                break;
+            case Wire::PARAM_KIND_ACK:
+                receiveAck(body, size);
+                break;
+            case Wire::PARAM_KIND_RESYNC:
+                markAllDirty();
+                paramStats.resyncs++;
+                break;
+            default:
+                break;
+        }
+        PARAM_UNLOCK();
+    }
+
+    /**
+     * @brief 送信対象のエントリを1フレームにまとめて送る
+     */
+    static Status sendBatch(uint32_t nowMillis)
+    {
+        uint8_t body[Wire::EXT_BODY_MAX];
+        uint8_t* e = body + Wire::PARAM_UPDATE_HEADER_SIZE;
+        // 相手が受信できる最大搬送データサイズに収まる数だけまとめる（最低1つ）
+        size_t limit = GetPeerMaxPayload();
+        size_t batchMax = (limit >= Wire::PARAM_UPDATE_HEADER_SIZE + Wire::PARAM_ENTRY_SIZE)
+                        ? (limit - Wire::PARAM_UPDATE_HEADER_SIZE) / Wire::PARAM_ENTRY_SIZE : 1;
+        if (batchMax > Wire::PARAM_BATCH_MAX)
+        {
+            batchMax = Wire::PARAM_BATCH_MAX;
+        }
+        PARAM_LOCK();
+        batchCount = 0;
+        for (uint8_t i = 0; i < entryCount && batchCount < batchMax; ++i)
+        {
+            const ParamEntry& entry = entries[i];
+            if (!entry.dirty)
+            {
+                continue;
+            }
+            e[Wire::PARAM_ENTRY_OFFSET_KEY] = entry.key;
+            Codec::storeLE16(e + Wire::PARAM_ENTRY_OFFSET_VERSION, entry.version);
+            Codec::storeLE32(e + Wire::PARAM_ENTRY_OFFSET_VALUE, entry.value);
+            e += Wire::PARAM_ENTRY_SIZE;
+            batchIndex[batchCount] = i;
+            batchVersion[batchCount] = entry.version;
+            batchCount++;
+        }
+        if (batchCount == 0)
+        {
+            batchOutstanding = false;
+            PARAM_UNLOCK();
+            return Status::Ok;
+        }
+        batchSeq++;
+        batchSentMillis = nowMillis;
+        batchOutstanding = true;
+        uint8_t count = batchCount;
+        body[Wire::PARAM_OFFSET_KIND] = Wire::PARAM_KIND_UPDATE;
+        Codec::storeLE16(body + Wire::PARAM_OFFSET_BATCH, batchSeq);
+        body[Wire::PARAM_OFFSET_COUNT] = count;
+        PARAM_UNLOCK();
+
+        paramStats.updatesSent++;
+        paramStats.entriesSent += count;
+        // 送信に失敗した場合も確認待ちとして扱い、再送時間後に送り直す
+        return sendBody(body, Wire::PARAM_UPDATE_HEADER_SIZE + count * Wire::PARAM_ENTRY_SIZE);
+    }
+
+    /**
+     * @brief 値を設定する（版番号を進めるかを指定）
+     */
+    static Status setValue(uint8_t key, uint32_t value, bool define)
+    {
+        Status result = Status::Ok;
+        PARAM_LOCK();
+        ParamEntry* entry = findOrAddEntry(key, value);
+        if (!entry)
+        {
+            result = Status::ParamTableFull;
+        }
+        else if (define)
+        {
+            if (entry->version == 0)
+            {
+                entry->value = value;
+            }
+        }
+        else if (entry->version == 0 || entry->value != value)
+        {
+            entry->value = value;
+            entry->version++;
+            if (entry->version == 0)
+            {
+                // 0 は「未設定」を表すため使わない
+                entry->version = 1;
+            }
+            entry->dirty = true;
+        }
+        PARAM_UNLOCK();
+        return result;
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief パラメータ同期を開始する
+     * @param retryMs 再送までの時間（ミリ秒）
+     * @return ステータスコード (Status)
+     */
+    Status ParamBegin(uint32_t retryMs)
+    {
+        if (retryMs == 0)
+        {
+            return Status::InvalidArg;
+        }
+        PARAM_LOCK();
+        retryMillis = retryMs;
+        batchOutstanding = false;
+        ackPending = false;
+        requestResync = true;
+        linkWasLost = false;
+        paramStats = ParamStats{};
+        PARAM_UNLOCK();
+        return SetFrameHandler(static_cast<uint8_t>(Wire::FrameType::Param), onParamFrame);
+    }
+
+    /**
+     * @brief パラメータの初期値を定義する
+     * @param key   キー
+     * @param value 初期値
+     * @return ステータスコード (Status)
+     */
+    Status ParamDefine(uint8_t key, uint32_t value)
+    {
+        return setValue(key, value, true);
+    }
+
+    /**
+     * @brief パラメータを設定する
+     * @param key   キー
+     * @param value 値
+     * @return ステータスコード (Status)
+     */
+    Status ParamSet(uint8_t key, uint32_t value)
+    {
+        return setValue(key, value, false);
+    }
+
+    /**
+     * @brief パラメータを取得する
+     * @param key   キー
+     * @param value 値の格納先
+     * @return ステータスコード (Status)
+     */
+    Status ParamGet(uint8_t key, uint32_t* value)
+    {
+        if (!value)
+        {
+            return Status::InvalidArg;
+        }
+        Status result = Status::InvalidArg;
+        PARAM_LOCK();
+        const ParamEntry* entry = findEntry(key);
+        if (entry)
+        {
+            *value = entry->value;
+            result = Status::Ok;
+        }
+        PARAM_UNLOCK();
+        return result;
+    }
+
+    /**
+     * @brief float のパラメータの初期値を定義する
+     */
+    Status ParamDefineFloat(uint8_t key, float value)
+    {
+        uint32_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        return ParamDefine(key, raw);
+    }
+
+    /**
+     * @brief float のパラメータを設定する
+     */
+    Status ParamSetFloat(uint8_t key, float value)
+    {
+        uint32_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        return ParamSet(key, raw);
+    }
+
+    /**
+     * @brief float のパラメータを取得する
+     */
+    Status ParamGetFloat(uint8_t key, float* value)
+    {
+        uint32_t raw;
+        if (!value)
+        {
+            return Status::InvalidArg;
+        }
+        Status status = ParamGet(key, &raw);
+        if (status == Status::Ok)
+        {
+            memcpy(value, &raw, sizeof(raw));
+        }
+        return status;
+    }
+
+    /**
+     * @brief 相手から届いた値を採用したときのコールバックを設定
+     * @param callback コールバック関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetParamChangeCallback(ParamChangeCallback callback)
+    {
+        changeCallback = callback;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 全エントリを送り直す
+     * @return ステータスコード (Status)
+     */
+    Status ParamResync(void)
+    {
+        PARAM_LOCK();
+        markAllDirty();
+        paramStats.resyncs++;
+        PARAM_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 変化したエントリの送信・確認の返信・再送・変化の通知を行う
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status ParamService(uint32_t nowMillis)
+    {
+        Status result = Status::Ok;
+
+        // 相手から届いた値を通知する
+        for (uint8_t i = 0; i < entryCount; ++i)
+        {
+            PARAM_LOCK();
+            bool notify = entries[i].changed;
+            uint8_t key = entries[i].key;
+            uint32_t value = entries[i].value;
+            entries[i].changed = false;
+            PARAM_UNLOCK();
+            if (notify && changeCallback)
+            {
+                changeCallback(key, value);
+            }
+        }
+
+        // 途絶中は送らない。復帰したら双方が全エントリを送り直す
+        bool lost = (UpdateLinkState(nowMillis) == LinkState::Lost);
+        if (lost)
+        {
+            linkWasLost = true;
+            return Status::Ok;
+        }
+        if (linkWasLost)
+        {
+            linkWasLost = false;
+            requestResync = true;
+            ParamResync();
+        }
+
+        if (requestResync)
+        {
+            uint8_t body[1] = { Wire::PARAM_KIND_RESYNC };
+            if (sendBody(body, sizeof(body)) == Status::Ok)
+            {
+                requestResync = false;
+            }
+        }
+
+        PARAM_LOCK();
+        bool sendAck = ackPending;
+        uint16_t seq = ackSeq;
+        ackPending = false;
+        bool waiting = batchOutstanding && (nowMillis - batchSentMillis) < retryMillis;
+        bool retry = batchOutstanding && !waiting;
+        PARAM_UNLOCK();
+
+        if (sendAck)
+        {
+            uint8_t body[Wire::PARAM_ACK_SIZE];
+            body[Wire::PARAM_OFFSET_KIND] = Wire::PARAM_KIND_ACK;
+            Codec::storeLE16(body + Wire::PARAM_OFFSET_BATCH, seq);
+            if (sendBody(body, sizeof(body)) == Status::Ok)
+            {
+                paramStats.acksSent++;
+            }
+            else
+            {
+                result = Status::SendFail;
+            }
+        }
+
+        // 確認待ちの間は次を送らない（停止待ち）。時間内に確認が届かなければ送り直す
+        if (waiting)
+        {
+            return result;
+        }
+        if (retry)
+        {
+            paramStats.retries++;
+        }
+        if (sendBatch(nowMillis) != Status::Ok)
+        {
+            result = Status::SendFail;
+        }
+        return result;
+    }
+
+    /**
+     * @brief 未送信または確認待ちのエントリがないか
+     * @return true:相手と一致している（はず）
+     */
+    bool ParamIsSynced(void)
+    {
+        PARAM_LOCK();
+        bool synced = !batchOutstanding;
+        for (uint8_t i = 0; i < entryCount && synced; ++i)
+        {
+            synced = !entries[i].dirty;
+        }
+        PARAM_UNLOCK();
+        return synced;
+    }
+
+    /**
+     * @brief パラメータ同期の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetParamStats(ParamStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        PARAM_LOCK();
+        *stats = paramStats;
+        PARAM_UNLOCK();
+        return Status::Ok;
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef ROBO_WCOM_PARAM_H
+#define ROBO_WCOM_PARAM_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Wire.h"
+
+/**
+ * @brief 保持できるパラメータの最大数
+ * @details ビルドフラグ（-DROBO_WCOM_PARAM_MAX=...）で変更可能
+ */
+#ifndef ROBO_WCOM_PARAM_MAX
+#define ROBO_WCOM_PARAM_MAX 32
+#endif
+
+/**
+ * @file ROBO_WCOM_Param.h
+ * @brief コントローラとロボットで複製するパラメータ表
+ * @details
+ * ゲイン・速度制限・武器設定などを、書き換えのたびに指令へ載せたり書き込み直したりせずに共有する。
+ *
+ * - 各パラメータは 1バイトのキー、4バイトの値、版番号を持つ
+ * - ParamSet() で値が変わると版番号が増え、変化したエントリだけを1フレームにまとめて送る
+ * - 受信側は版番号が新しいものだけを採用し、確認を返す。確認が届くまで同じ内容を再送する
+ * - 全エントリの送り直しは、通信途絶からの復帰時と起動直後（相手への再同期要求）だけ行う
+ *
+ * 両側から書き込める。同じキーを両側で同時に書き換えて版番号が同じになった場合は、
+ * 値の大きい方が両側に残る（書いた側の意図とは関係なく決まるため、キーごとに書き込む側を決めておくのがよい）。
+ * 送受信は拡張フレーム（Wire::FrameType::Param）で行い、処理は ParamService() の中で行う。
+ */
+namespace ROBO_WCOM
+{
+    constexpr size_t PARAM_MAX = ROBO_WCOM_PARAM_MAX;   ///< 保持できるパラメータの最大数
+
+    /**
+     * @brief 相手から届いた値を採用したときに呼ばれるコールバック
+     * @details ParamService() から呼ばれる
+     */
+    typedef void (*ParamChangeCallback)(uint8_t key, uint32_t value);
+
+    /**
+     * @brief パラメータ同期の統計
+     */
+    struct ParamStats {
+        uint32_t updatesSent;   ///< 送信した更新フレーム数（再送を含む）
+        uint32_t entriesSent;   ///< 送信したエントリ数（再送を含む）
+        uint32_t bytesSent;     ///< 送信した本体のバイト数（更新・確認・再同期要求）
+        uint32_t retries;       ///< 確認が届かず再送した回数
+        uint32_t acksSent;      ///< 送信した確認数
+        uint32_t applied;       ///< 相手から届いて採用したエントリ数
+        uint32_t resyncs;       ///< 全エントリを送り直した回数
+    };
+
+    /**
+     * @brief パラメータ同期を開始する
+     * @details 拡張フレームのハンドラを登録し、次の ParamService() で相手に再同期を要求する
+     * @param retryMs 確認が届かない場合に再送するまでの時間（ミリ秒）
+     * @return ステータスコード (Status)
+     */
+    Status ParamBegin(uint32_t retryMs);
+
+    /**
+     * @brief パラメータの初期値を定義する
+     * @details 版番号 0 で登録し、送信はしない。相手が一度でも設定した値があればそちらが優先される
+     * @param key   キー
+     * @param value 初期値
+     * @return ステータスコード (Status)。表が満杯なら ParamTableFull
+     */
+    Status ParamDefine(uint8_t key, uint32_t value);
+
+    /**
+     * @brief パラメータを設定する
+     * @details 値が変わった場合だけ版番号を進め、次の ParamService() で相手へ送る
+     * @param key   キー
+     * @param value 値
+     * @return ステータスコード (Status)。表が満杯なら ParamTableFull
+     */
+    Status ParamSet(uint8_t key, uint32_t value);
+
+    /**
+     * @brief パラメータを取得する
+     * @param key   キー
+     * @param value 値の格納先
+     * @return ステータスコード (Status)。未登録のキーなら InvalidArg
+     */
+    Status ParamGet(uint8_t key, uint32_t* value);
+
+    /**
+     * @brief float のパラメータの初期値を定義する
+     */
+    Status ParamDefineFloat(uint8_t key, float value);
+
+    /**
+     * @brief float のパラメータを設定する
+     */
+    Status ParamSetFloat(uint8_t key, float value);
+
+    /**
+     * @brief float のパラメータを取得する
+     */
+    Status ParamGetFloat(uint8_t key, float* value);
+
+    /**
+     * @brief 相手から届いた値を採用したときのコールバックを設定
+     * @param callback コールバック関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status SetParamChangeCallback(ParamChangeCallback callback);
+
+    /**
+     * @brief 全エントリを送り直す
+     * @return ステータスコード (Status)
+     */
+    Status ParamResync(void);
+
+    /**
+     * @brief 変化したエントリの送信・確認の返信・再送・変化の通知を行う
+     * @details 制御ループなどから周期的に呼ぶ。通信途絶中は送信しない
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status ParamService(uint32_t nowMillis);
+
+    /**
+     * @brief 未送信または確認待ちのエントリがないか
+     * @return true:相手と一致している（はず）
+     */
+    bool ParamIsSynced(void);
+
+    /**
+     * @brief パラメータ同期の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetParamStats(ParamStats* stats);
+}
+
+#endif /* ROBO_WCOM_PARAM_H */
@@ -0,0 +1,361 @@
+#include "ROBO_WCOM_Publisher.h"
+#include "ROBO_WCOM_Trace.h"
+#include <cstring>
+#if defined(ESP_PLATFORM)
+#include <esp_timer.h>
+#endif
+
+namespace ROBO_WCOM
+{
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static esp_timer_handle_t publishTimer = nullptr;              ///< 周期送信タイマ
+    static portMUX_TYPE publishMux = portMUX_INITIALIZER_UNLOCKED; ///< 登録データ保護
+    #define PUBLISH_LOCK()      portENTER_CRITICAL(&publishMux)
+    #define PUBLISH_UNLOCK()    portEXIT_CRITICAL(&publishMux)
+#else
+    #define PUBLISH_LOCK()
+    #define PUBLISH_UNLOCK()
+#endif
+
+    static uint8_t  latestData[CARRIED_DATA_MAX_SIZE];  ///< 登録された最新データ
+    static uint8_t  latestSize = 0;                     ///< 登録された最新データサイズ
+    static uint32_t latestVersion = 0;                  ///< 登録のたびに増える版番号
+    static uint8_t  lastSentData[CARRIED_DATA_MAX_SIZE];///< 前回送信したデータ
+    static uint8_t  lastSentSize = 0;                   ///< 前回送信したデータサイズ
+    static uint32_t lastSentVersion = 0;                ///< 前回送信時に確認した版番号
+    static bool     hasSent = false;                    ///< 一度でも送信したか
+    static bool     dirty = false;                      ///< 未送信の変化があるか
+    static TrafficClass publishClass = TrafficClass::Command; ///< 送信データの種別
+    static PublisherEncoder publishEncoder = nullptr;   ///< 送信直前の変換
+    static uint8_t  txFrame[CARRIED_DATA_MAX_SIZE];     ///< 送信するフレーム（変換済み）
+    static uint8_t  txSize = 0;                         ///< 送信するフレームのサイズ
+    static bool     txPending = false;                  ///< txFrame が未送信か
+
+    static bool     running = false;                    ///< 動作中か
+    static uint32_t periodUs = 0;                       ///< 送信周期
+    static uint32_t heartbeatUs = 0;                    ///< ハートビート間隔（0 で無効）
+    static uint32_t lastTickMicros = 0;                 ///< 前回の周期処理時刻
+    static bool     hasTick = false;                    ///< 前回の周期処理時刻が有効か
+    static uint32_t lastTxMicros = 0;                   ///< 前回の送信時刻（パケット/ハートビート）
+
+    static PublisherStats stats;                        ///< 周期統計（集計途中の値を含む）
+    static uint64_t periodSumUs = 0;                    ///< 周期の総和
+    static uint64_t jitterSqSum = 0;                    ///< 周期ずれの二乗和
+    static uint32_t periodSamples = 0;                  ///< 周期の標本数
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief 周期統計へ1標本を追加
+     * @param intervalUs 前回の周期処理からの経過時間
+     */
+    static void recordPeriod(uint32_t intervalUs)
+    {
+        uint32_t deviation = (intervalUs > periodUs) ? intervalUs - periodUs : periodUs - intervalUs;
+        if (periodSamples == 0 || intervalUs < stats.periodMinUs)
+        {
+            stats.periodMinUs = intervalUs;
+        }
+        if (intervalUs > stats.periodMaxUs)
+        {
+            stats.periodMaxUs = intervalUs;
+        }
+        if (deviation > stats.jitterMaxUs)
+        {
+            stats.jitterMaxUs = deviation;
+        }
+        periodSumUs += intervalUs;
+        jitterSqSum += static_cast<uint64_t>(deviation) * deviation;
+        periodSamples++;
+    }
+
+    /**
+     * @brief 整数の平方根（切り捨て）
+     */
+    static uint32_t isqrt64(uint64_t v)
+    {
+        uint64_t r = 0;
+        uint64_t bit = 1ULL << 62;
+        while (bit > v)
+        {
+            bit >>= 2;
+        }
+        while (bit != 0)
+        {
+            if (v >= r + bit)
+            {
+                v -= r + bit;
+                r = (r >> 1) + bit;
+            }
+            else
+            {
+                r >>= 1;
+            }
+            bit >>= 2;
+        }
+        return static_cast<uint32_t>(r);
+    }
+
+#if defined(ESP_PLATFORM)
+    /**
+     * @brief esp_timer 周期コールバック
+     */
+    static void onPublishTimer(void*)
+    {
+        PublisherService(static_cast<uint32_t>(esp_timer_get_time()));
+    }
+#endif
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief パブリッシャを開始
+     * @param periodMicros    送信周期（マイクロ秒）
+     * @param heartbeatMillis ハートビート間隔（ミリ秒、0 で送らない）
+     * @return ステータスコード (Status)
+     */
+    Status PublisherStart(uint32_t periodMicros, uint32_t heartbeatMillis)
+    {
+        if (periodMicros == 0)
+        {
+            return Status::InvalidArg;
+        }
+        PublisherStop();
+
+        periodUs = periodMicros;
+        heartbeatUs = heartbeatMillis * 1000;
+        hasTick = false;
+        hasSent = false;
+        dirty = false;
+        txPending = false;
+        // 登録済みのデータがあれば最初の周期で送信する
+        lastSentVersion = (latestVersion != 0) ? latestVersion - 1 : latestVersion;
+        ResetPublisherStats();
+
+#if defined(ESP_PLATFORM)
+        if (publishTimer == nullptr)
+        {
+            esp_timer_create_args_t args = {};
+            args.callback = &onPublishTimer;
+            args.name = "robo_wcom_pub";
+            if (esp_timer_create(&args, &publishTimer) != ESP_OK)
+            {
+                publishTimer = nullptr;
+                return Status::TimerFail;
+            }
+        }
+        if (esp_timer_start_periodic(publishTimer, periodMicros) != ESP_OK)
+        {
+            return Status::TimerFail;
+        }
+#endif
+        running = true;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief パブリッシャを停止
+     * @return ステータスコード (Status)
+     */
+    Status PublisherStop(void)
+    {
+#if defined(ESP_PLATFORM)
+        if (publishTimer != nullptr && running)
+        {
+            esp_timer_stop(publishTimer);
+        }
+#endif
+        running = false;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信データの種別を設定
+     * @param trafficClass 送信データの種別
+     * @return ステータスコード (Status)
+     */
+    Status PublisherSetClass(TrafficClass trafficClass)
+    {
+        publishClass = trafficClass;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信直前の変換を登録
+     * @param encoder 変換関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status PublisherSetEncoder(PublisherEncoder encoder)
+    {
+        PUBLISH_LOCK();
+        publishEncoder = encoder;
+        txPending = false;
+        PUBLISH_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信する最新データを登録
+     * @param data 送信データへのポインタ
+     * @param size 送信データサイズ（最大 CARRIED_DATA_MAX_SIZE）
+     * @return ステータスコード (Status)
+     */
+    Status PublisherUpdate(const uint8_t* data, uint8_t size)
+    {
+        if (!data || size > CARRIED_DATA_MAX_SIZE || size > GetPeerMaxPayload())
+        {
+            return Status::InvalidArg;
+        }
+        PUBLISH_LOCK();
+        memcpy(latestData, data, size);
+        latestSize = size;
+        latestVersion++;
+        WCOM_TRACE(Update, latestVersion, size);
+        PUBLISH_UNLOCK();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 1周期分の送信処理
+     * @param nowMicros 現在時刻（マイクロ秒）
+     * @return ステータスコード (Status)。他のタスクが送信中で見送った場合は Status::Busy
+     */
+    Status PublisherService(uint32_t nowMicros)
+    {
+        if (!running)
+        {
+            return Status::Ok;
+        }
+
+        stats.ticks++;
+        if (hasTick)
+        {
+            recordPeriod(nowMicros - lastTickMicros);
+        }
+        lastTickMicros = nowMicros;
+        hasTick = true;
+
+        // 登録データに更新があれば取り込み、内容が変化したか判定する
+        PUBLISH_LOCK();
+        if (latestVersion != lastSentVersion)
+        {
+            lastSentVersion = latestVersion;
+            if (!hasSent || latestSize != lastSentSize || memcmp(latestData, lastSentData, latestSize) != 0)
+            {
+                memcpy(lastSentData, latestData, latestSize);
+                lastSentSize = latestSize;
+                dirty = true;
+            }
+        }
+        PUBLISH_UNLOCK();
+
+        Status result;
+        bool pending = dirty || txPending;
+        if (pending && !RateAllow(publishClass, millis()))
+        {
+            // 混雑中は見送る。dirty のまま残し、許可された周期で最新データを送る
+            stats.throttled++;
+            return Status::Ok;
+        }
+        else if (pending)
+        {
+            // 変換済みのフレームが未送信なら、それを送り終えるまで次の変換をしない
+            if (dirty && (!txPending || publishEncoder == nullptr))
+            {
+                if (publishEncoder != nullptr)
+                {
+                    txSize = publishEncoder(lastSentData, lastSentSize, txFrame);
+                }
+                else
+                {
+                    memcpy(txFrame, lastSentData, lastSentSize);
+                    txSize = lastSentSize;
+                }
+                dirty = false;
+                txPending = true;
+            }
+            // 送信に失敗した場合は txPending のまま残し、次の周期で再送する。
+            // タイマタスクを止めないよう、他のタスクが送信中なら待たずに見送る
+            if (!SendTryLock(0))
+            {
+                stats.lockBusy++;
+                result = Status::Busy;
+            }
+            else
+            {
+                uint32_t timestamp = millis();
+                WCOM_TRACE(Publish, timestamp, lastSentVersion);
+                result = SendPacket(timestamp, txFrame, txSize);
+                SendUnlock();
+            }
+            if (result == Status::Ok)
+            {
+                stats.sent++;
+                hasSent = true;
+                txPending = false;
+                lastTxMicros = nowMicros;
+            }
+        }
+        else if (hasSent && heartbeatUs != 0 && (nowMicros - lastTxMicros) >= heartbeatUs)
+        {
+            if (!SendTryLock(0))
+            {
+                stats.lockBusy++;
+                result = Status::Busy;
+            }
+            else
+            {
+                result = SendHeartbeat(millis());
+                SendUnlock();
+            }
+            if (result == Status::Ok)
+            {
+                stats.heartbeats++;
+                lastTxMicros = nowMicros;
+            }
+        }
+        else
+        {
+            stats.skipped++;
+            return Status::Ok;
+        }
+
+        if (result != Status::Ok)
+        {
+            stats.failed++;
+        }
+        return result;
+    }
+
+    /**
+     * @brief 送信周期統計を取得
+     * @param out 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetPublisherStats(PublisherStats* out)
+    {
+        if (!out)
+        {
+            return Status::InvalidArg;
+        }
+        *out = stats;
+        if (periodSamples > 0)
+        {
+            out->periodMeanUs = static_cast<uint32_t>(periodSumUs / periodSamples);
+            out->jitterRmsUs  = isqrt64(jitterSqSum / periodSamples);
+        }
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信周期統計をリセット
+     */
+    void ResetPublisherStats(void)
+    {
+        memset(&stats, 0, sizeof(stats));
+        periodSumUs = 0;
+        jitterSqSum = 0;
+        periodSamples = 0;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef ROBO_WCOM_PUBLISHER_H
+#define ROBO_WCOM_PUBLISHER_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Rate.h"
+
+/**
+ * @file ROBO_WCOM_Publisher.h
+ * @brief 一定周期で最新データを送信するパブリッシャ
+ * @details
+ * loop() の delay() による送信周期は他の処理（文字列整形やシリアル出力）の影響でぶれるため、
+ * 送信をタイマ駆動に切り出す。
+ *
+ * - アプリは PublisherUpdate() で最新データを登録するだけでよい
+ * - ESP32 では esp_timer の周期コールバックから PublisherService() が呼ばれる。
+ *   esp_timer のタスクを止めないよう送信経路の排他は待たずに取り（SendTryLock()）、
+ *   loop() などが送信中の周期は送信失敗として次の周期に送り直す
+ * - それ以外の環境（PC上のシミュレーション等）では仮想時計で PublisherService() を直接呼ぶ
+ * - 内容が前回送信から変化しておらず、ハートビート間隔も経過していない周期は送信を省略する
+ * - 種別をテレメトリにすると、レート制御（ROBO_WCOM_Rate.h）が混雑を検出した間は周期を間引く
+ * - 差分符号化（ROBO_WCOM_Delta.h）のように送るたびに状態が進む変換は PublisherSetEncoder() で登録し、
+ *   周期処理の中で送信直前に行う。変換したフレームは送信できるまで保持するため、キーフレームを取りこぼさない
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 送信直前に登録データを送信フレームへ変換する関数
+     * @param data 登録された最新データ
+     * @param size 登録された最新データサイズ
+     * @param out  変換結果の格納先（CARRIED_DATA_MAX_SIZE バイト）
+     * @return 変換結果のバイト数（最大 CARRIED_DATA_MAX_SIZE）
+     */
+    typedef uint8_t (*PublisherEncoder)(const uint8_t* data, uint8_t size, uint8_t* out);
+
+    /**
+     * @brief パブリッシャの送信周期統計
+     * @details 周期は PublisherService() が呼ばれた間隔（マイクロ秒）
+     */
+    struct PublisherStats {
+        uint32_t ticks;             ///< 周期処理の実行回数
+        uint32_t sent;              ///< パケット送信回数
+        uint32_t heartbeats;        ///< ハートビート送信回数
+        uint32_t skipped;           ///< 送信を省略した回数
+        uint32_t failed;            ///< 送信失敗回数（lockBusy を含む）
+        uint32_t lockBusy;          ///< 他のタスクが送信中で見送った回数
+        uint32_t throttled;         ///< レート制御で送信を見送った回数
+        uint32_t periodMinUs;       ///< 周期の最小値
+        uint32_t periodMaxUs;       ///< 周期の最大値
+        uint32_t periodMeanUs;      ///< 周期の平均値
+        uint32_t jitterMaxUs;       ///< 設定周期からのずれの最大値（絶対値）
+        uint32_t jitterRmsUs;       ///< 設定周期からのずれの二乗平均平方根
+    };
+
+    /**
+     * @brief パブリッシャを開始
+     * @details ESP32 では esp_timer を起動する。Init() の後に呼ぶこと。
+     * @param periodMicros    送信周期（マイクロ秒）
+     * @param heartbeatMillis 内容が変化しない場合にハートビートを送る間隔（ミリ秒、0 で送らない）
+     * @return ステータスコード (Status)
+     */
+    Status PublisherStart(uint32_t periodMicros, uint32_t heartbeatMillis);
+
+    /**
+     * @brief パブリッシャを停止
+     * @return ステータスコード (Status)
+     */
+    Status PublisherStop(void);
+
+    /**
+     * @brief 送信データの種別を設定
+     * @details
+     * 既定は TrafficClass::Command（間引かない）。TrafficClass::Telemetry にすると、
+     * RateAllow() が許可しない周期は送信を見送り、次に許可された周期でその時点の最新データを送る。
+     * ハートビートは間引かない
+     * @param trafficClass 送信データの種別
+     * @return ステータスコード (Status)
+     */
+    Status PublisherSetClass(TrafficClass trafficClass);
+
+    /**
+     * @brief 送信直前の変換を登録
+     * @details
+     * 変換は実際に送信する周期にだけ、PublisherService() と同じ文脈で呼ばれる。
+     * 送信に失敗した場合は同じ変換結果を次の周期で送り直し、その間に登録されたデータは後続の周期で変換する。
+     * nullptr（既定）なら登録データをそのまま送り、送信に失敗したら次の周期でその時点の最新データを送る
+     * @param encoder 変換関数（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status PublisherSetEncoder(PublisherEncoder encoder);
+
+    /**
+     * @brief 送信する最新データを登録
+     * @details 任意のタスクから呼び出せる。データはコピーされる。
+     * @param data 送信データへのポインタ
+     * @param size 送信データサイズ（最大 CARRIED_DATA_MAX_SIZE・相手の最大搬送データサイズ（SetPeerMaxPayload()））
+     * @return ステータスコード (Status)
+     */
+    Status PublisherUpdate(const uint8_t* data, uint8_t size);
+
+    /**
+     * @brief 1周期分の送信処理
+     * @details ESP32 ではタイマから呼ばれるため、アプリから呼ぶ必要はない
+     * @param nowMicros 現在時刻（マイクロ秒）
+     * @return ステータスコード (Status)。他のタスクが送信中で見送った場合は Status::Busy
+     */
+    Status PublisherService(uint32_t nowMicros);
+
+    /**
+     * @brief 送信周期統計を取得
+     * @param out 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetPublisherStats(PublisherStats* out);
+
+    /**
+     * @brief 送信周期統計をリセット
+     */
+    void ResetPublisherStats(void);
+}
+
+#endif /* ROBO_WCOM_PUBLISHER_H */
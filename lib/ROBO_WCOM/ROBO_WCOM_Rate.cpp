@@ -0,0 +1,280 @@
+#include "ROBO_WCOM_Rate.h"
+
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 送信許可の単位（1フレーム = 1e6）
+     * @details レート（mHz）× 経過時間（ms）がそのまま加算量になる
+     */
+    constexpr uint64_t RATE_CREDIT_FRAME = 1000000;
+
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE rateMux = portMUX_INITIALIZER_UNLOCKED;  ///< 送信完了通知との共有データ保護
+    #define RATE_LOCK()     portENTER_CRITICAL(&rateMux)
+    #define RATE_UNLOCK()   portEXIT_CRITICAL(&rateMux)
+#else
+    #define RATE_LOCK()
+    #define RATE_UNLOCK()
+#endif
+
+    static bool       enabled = false;          ///< レート制御が有効か
+    static RateConfig rateConfig = {
+        100,    // maxRateHz
+        2,      // minRateHz
+        5,      // increaseHz
+        50,     // decreasePercent
+        20,     // lossPercent
+        3,      // queueHigh
+        200,    // windowMs
+    };
+    static uint32_t   rateMilliHz = 100000;     ///< 現在のテレメトリのレート
+    static uint64_t   credit = 0;               ///< テレメトリの送信許可の残り
+    static uint32_t   creditMillis = 0;         ///< 送信許可を最後に加算した時刻
+    static uint32_t   windowStartMillis = 0;    ///< 判定窓の開始時刻
+    static bool       started = false;          ///< 判定窓・送信許可の時刻が有効か
+
+    // 判定窓内の集計（送信完了コールバックと共有）
+    static uint16_t   winDelivered = 0;         ///< 成功した送信完了通知
+    static uint16_t   winFailed = 0;            ///< 失敗した送信完了通知
+    static uint16_t   winRejected = 0;          ///< 拒否された送信要求
+    static uint8_t    winPeak = 0;              ///< 送信完了待ちの最大数
+    static uint16_t   winTelemetry = 0;         ///< 送信を許可したテレメトリ数
+    static uint8_t    inFlight = 0;             ///< 送信完了待ちのフレーム数
+    static uint32_t   lossCompleted = 0;        ///< 送信失敗率の判定に使う送信完了通知の数
+    static uint32_t   lossFailed = 0;           ///< 同うち失敗した数
+
+    static RateStats  rateStats{};              ///< 統計
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief テレメトリのレートを最大に戻し、判定窓をやり直す
+     */
+    static void resetRate(void)
+    {
+        rateMilliHz = static_cast<uint32_t>(rateConfig.maxRateHz) * 1000;
+        credit = 0;
+        started = false;
+        RATE_LOCK();
+        winDelivered = 0;
+        winFailed = 0;
+        winRejected = 0;
+        winPeak = inFlight;
+        winTelemetry = 0;
+        RATE_UNLOCK();
+        lossCompleted = 0;
+        lossFailed = 0;
+    }
+
+    /**
+     * @brief 判定窓が終わっていれば混雑を判定し、レートを更新する
+     */
+    static void evaluateWindow(uint32_t nowMillis)
+    {
+        if (!started)
+        {
+            started = true;
+            windowStartMillis = nowMillis;
+            creditMillis = nowMillis;
+            return;
+        }
+        uint32_t elapsed = nowMillis - windowStartMillis;
+        if (elapsed < rateConfig.windowMs)
+        {
+            return;
+        }
+
+        RATE_LOCK();
+        uint32_t delivered = winDelivered;
+        uint32_t failed = winFailed;
+        uint32_t rejected = winRejected;
+        uint8_t peak = winPeak;
+        uint32_t telemetry = winTelemetry;
+        winDelivered = 0;
+        winFailed = 0;
+        winRejected = 0;
+        winPeak = inFlight;
+        winTelemetry = 0;
+        RATE_UNLOCK();
+        windowStartMillis = nowMillis;
+
+        // 送信失敗率は標本が少ないと偶然の失敗で跳ね上がるため、
+        // ROBO_WCOM_RATE_LOSS_SAMPLES 件溜まるまで判定窓をまたいで集計する
+        uint32_t completed = delivered + failed;
+        lossCompleted += completed;
+        lossFailed += failed;
+        bool lossy = false;
+        if (lossCompleted >= ROBO_WCOM_RATE_LOSS_SAMPLES)
+        {
+            lossy = lossFailed * 100 >= static_cast<uint32_t>(rateConfig.lossPercent) * lossCompleted;
+            lossCompleted = 0;
+            lossFailed = 0;
+        }
+        bool congested = rejected > 0 || peak >= rateConfig.queueHigh || lossy;
+        uint32_t minRate = static_cast<uint32_t>(rateConfig.minRateHz) * 1000;
+        uint32_t maxRate = static_cast<uint32_t>(rateConfig.maxRateHz) * 1000;
+        if (congested)
+        {
+            // 実際に送っていたレートが上限より低ければ、そこから下げる
+            uint32_t measured = static_cast<uint32_t>(static_cast<uint64_t>(telemetry) * 1000000 / elapsed);
+            uint32_t base = (telemetry > 0 && measured < rateMilliHz) ? measured : rateMilliHz;
+            uint32_t next = static_cast<uint32_t>(static_cast<uint64_t>(base) * rateConfig.decreasePercent / 100);
+            rateMilliHz = (next > minRate) ? next : minRate;
+            rateStats.decreases++;
+        }
+        else if (completed > 0 && rateMilliHz < maxRate)
+        {
+            uint32_t next = rateMilliHz + static_cast<uint32_t>(rateConfig.increaseHz) * 1000;
+            rateMilliHz = (next < maxRate) ? next : maxRate;
+            rateStats.increases++;
+        }
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief レート制御の有効/無効を切り替える
+     * @param enable true:有効 / false:無効
+     * @return ステータスコード (Status)
+     */
+    Status SetRateControl(bool enable)
+    {
+        resetRate();
+        enabled = enable;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief レート制御の設定を変更する
+     * @param config 設定
+     * @return ステータスコード (Status)
+     */
+    Status SetRateConfig(const RateConfig& config)
+    {
+        if (config.minRateHz == 0 || config.minRateHz > config.maxRateHz ||
+            config.decreasePercent == 0 || config.decreasePercent >= 100 ||
+            config.queueHigh == 0 || config.windowMs == 0)
+        {
+            return Status::InvalidArg;
+        }
+        rateConfig = config;
+        resetRate();
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信してよいか判定する
+     * @param trafficClass 送信データの種別
+     * @param nowMillis    現在時刻（millis）
+     * @return true:送信してよい / false:今回は見送る
+     */
+    bool RateAllow(TrafficClass trafficClass, uint32_t nowMillis)
+    {
+        if (!enabled)
+        {
+            return true;
+        }
+        evaluateWindow(nowMillis);
+        if (trafficClass == TrafficClass::Command)
+        {
+            return true;
+        }
+
+        uint32_t elapsed = nowMillis - creditMillis;
+        creditMillis = nowMillis;
+        if (rateMilliHz < static_cast<uint32_t>(rateConfig.maxRateHz) * 1000)
+        {
+            // 1フレーム分まで貯める（長く止まっていた後にまとめて送らない）
+            credit += static_cast<uint64_t>(rateMilliHz) * elapsed;
+            if (credit > RATE_CREDIT_FRAME)
+            {
+                credit = RATE_CREDIT_FRAME;
+            }
+            if (credit < RATE_CREDIT_FRAME)
+            {
+                rateStats.throttled++;
+                return false;
+            }
+            credit -= RATE_CREDIT_FRAME;
+        }
+        RATE_LOCK();
+        winTelemetry++;
+        RATE_UNLOCK();
+        return true;
+    }
+
+    /**
+     * @brief レート制御の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetRateStats(RateStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        RATE_LOCK();
+        *stats = rateStats;
+        stats->inFlight = inFlight;
+        RATE_UNLOCK();
+        stats->rateMilliHz = rateMilliHz;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 送信要求の結果を記録する
+     * @param accepted true:esp_now_send() が受け付けた / false:拒否した
+     */
+    void RateNoteSubmit(bool accepted)
+    {
+        RATE_LOCK();
+        if (accepted)
+        {
+            rateStats.submitted++;
+            if (inFlight < UINT8_MAX)
+            {
+                inFlight++;
+            }
+            if (inFlight > winPeak)
+            {
+                winPeak = inFlight;
+            }
+            if (inFlight > rateStats.inFlightPeak)
+            {
+                rateStats.inFlightPeak = inFlight;
+            }
+        }
+        else
+        {
+            rateStats.rejected++;
+            winRejected++;
+        }
+        RATE_UNLOCK();
+    }
+
+    /**
+     * @brief 送信完了通知を記録する
+     * @param delivered true:相手へ届いた / false:届かなかった
+     */
+    void RateNoteComplete(bool delivered)
+    {
+        RATE_LOCK();
+        if (inFlight > 0)
+        {
+            inFlight--;
+        }
+        if (delivered)
+        {
+            rateStats.delivered++;
+            winDelivered++;
+        }
+        else
+        {
+            rateStats.failed++;
+            winFailed++;
+        }
+        RATE_UNLOCK();
+    }
+}
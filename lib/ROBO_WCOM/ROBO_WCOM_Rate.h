@@ -0,0 +1,119 @@
+#ifndef ROBO_WCOM_RATE_H
+#define ROBO_WCOM_RATE_H
+
+#include "ROBO_WCOM.h"
+
+/**
+ * @file ROBO_WCOM_Rate.h
+ * @brief 送信完了通知に基づく送信レート制御（AIMD）
+ * @details
+ * esp_now_send() は送信要求を受け付けたかどうかしか返さないため、チャネルが混雑していても
+ * 一定周期で送り続けると送信待ちが溜まり、指令まで遅れる。
+ * 送信完了コールバック（onDataSent）の成否と送信完了待ちのフレーム数から混雑を判定し、
+ * 優先度の低いテレメトリの送信レートだけを調整する。
+ *
+ * - 判定窓（windowMs）ごとに、送信失敗率・送信完了待ちの最大数・送信要求の拒否を調べる
+ * - 混雑していればテレメトリのレートを decreasePercent 倍にし（乗算減少）、
+ *   混雑していなければ increaseHz ずつ戻す（加算増加）
+ * - 指令（TrafficClass::Command）は間引かない
+ *
+ * パブリッシャは PublisherSetClass() で種別を設定すると自動で従う。
+ * SendPacket() などを直接呼ぶ場合は、送信前に RateAllow() で確認する。
+ */
+
+/**
+ * @brief 送信失敗率を判定するのに必要な送信完了通知の数
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_RATE_LOSS_SAMPLES=...）で変更可能。
+ * 判定窓内の数がこれに満たない場合は、次の判定窓と合わせて判定する。
+ */
+#ifndef ROBO_WCOM_RATE_LOSS_SAMPLES
+#define ROBO_WCOM_RATE_LOSS_SAMPLES 20
+#endif
+
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 送信データの種別
+     */
+    enum class TrafficClass : uint8_t {
+        Command   = 0,  ///< 指令（目標周期を保ち、間引かない）
+        Telemetry = 1,  ///< テレメトリ（混雑時に先に間引く）
+    };
+
+    /**
+     * @brief レート制御の設定
+     */
+    struct RateConfig {
+        uint16_t maxRateHz;         ///< テレメトリの最大レート（これ以上は制限しない）
+        uint16_t minRateHz;         ///< テレメトリの最低レート
+        uint16_t increaseHz;        ///< 混雑していない判定窓ごとに戻すレート
+        uint8_t  decreasePercent;   ///< 混雑した判定窓ごとにレートへ掛ける割合（50 で半減）
+        uint8_t  lossPercent;       ///< 送信失敗率がこれ以上なら混雑とみなす
+        uint8_t  queueHigh;         ///< 送信完了待ちのフレーム数がこれ以上になれば混雑とみなす
+        uint32_t windowMs;          ///< 判定窓（ミリ秒）
+    };
+
+    /**
+     * @brief レート制御の統計
+     */
+    struct RateStats {
+        uint32_t submitted;         ///< 送信要求を受け付けられたフレーム数
+        uint32_t rejected;          ///< 送信要求を拒否されたフレーム数（送信待ちの満杯など）
+        uint32_t delivered;         ///< 送信完了通知で成功したフレーム数
+        uint32_t failed;            ///< 送信完了通知で失敗したフレーム数
+        uint32_t throttled;         ///< RateAllow() でテレメトリの送信を見送った回数
+        uint32_t decreases;         ///< レートを下げた回数
+        uint32_t increases;         ///< レートを上げた回数
+        uint32_t rateMilliHz;       ///< 現在のテレメトリのレート（mHz）
+        uint8_t  inFlight;          ///< 現在の送信完了待ちのフレーム数
+        uint8_t  inFlightPeak;      ///< 送信完了待ちのフレーム数の最大値
+    };
+
+    /**
+     * @brief レート制御の有効/無効を切り替える
+     * @details 有効にするとテレメトリのレートを最大から始める。無効の間 RateAllow() は常に true を返す
+     * @param enable true:有効 / false:無効
+     * @return ステータスコード (Status)
+     */
+    Status SetRateControl(bool enable);
+
+    /**
+     * @brief レート制御の設定を変更する
+     * @param config 設定
+     * @return ステータスコード (Status)
+     */
+    Status SetRateConfig(const RateConfig& config);
+
+    /**
+     * @brief 送信してよいか判定する
+     * @details
+     * テレメトリは現在のレートを超えない範囲で true を返し、その分を送信したものとして数える。
+     * 指令は常に true を返す。判定窓の集計もここで行う
+     * @param trafficClass 送信データの種別
+     * @param nowMillis    現在時刻（millis）
+     * @return true:送信してよい / false:今回は見送る
+     */
+    bool RateAllow(TrafficClass trafficClass, uint32_t nowMillis);
+
+    /**
+     * @brief レート制御の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetRateStats(RateStats* stats);
+
+    /**
+     * @brief 送信要求の結果を記録する（ライブラリ内部の送信処理から呼ばれる）
+     * @param accepted true:esp_now_send() が受け付けた / false:拒否した
+     */
+    void RateNoteSubmit(bool accepted);
+
+    /**
+     * @brief 送信完了通知を記録する（送信完了コールバックから呼ばれる）
+     * @param delivered true:相手へ届いた / false:届かなかった
+     */
+    void RateNoteComplete(bool delivered);
+}
+
+#endif /* ROBO_WCOM_RATE_H */
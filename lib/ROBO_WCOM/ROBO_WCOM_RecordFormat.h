@@ -0,0 +1,72 @@
+#ifndef ROBO_WCOM_RECORD_FORMAT_H
+#define ROBO_WCOM_RECORD_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ROBO_WCOM_RecordFormat.h
+ * @brief フライトレコーダのダンプ形式
+ * @details
+ * Arduino に依存しないため、PC側のデコーダ（tools/wcom_rec2csv.cpp）からもそのまま利用できる。
+ * 数値はすべてリトルエンディアン。
+ *
+ * - ファイルヘッダ : [マジック "RWFR" 4][版 2][レコード長 2][レコード数 4][上書きで失われたレコード数 4]
+ * - レコード       : RECORD_SIZE バイト固定長をレコード数だけ並べる
+ *
+ * シリアルへ他のテキストと混在して出力されるため、デコーダはマジックを探して先頭を見つける。
+ */
+namespace ROBO_WCOM
+{
+namespace Record
+{
+    /**
+     * @brief レコードの種類
+     */
+    enum class Kind : uint8_t {
+        Sent     = 1,       ///< 送信したフレーム
+        Received = 2,       ///< 受信APIで取り出したフレーム
+        Failsafe = 3,       ///< リンク途絶を検出（以降の記録を停止）
+        User     = 0x80,    ///< アプリ定義（0x80 以降を自由に使う）
+    };
+
+    constexpr uint8_t  MAGIC[4]     = { 'R', 'W', 'F', 'R' };   ///< ファイルヘッダのマジック
+    constexpr uint16_t VERSION      = 1;                        ///< ダンプ形式の版
+    constexpr size_t   HEADER_SIZE  = 16;                       ///< ファイルヘッダ長
+    constexpr size_t   FIELD_MAX    = 4;                        ///< 1レコードに記録できるペイロード値の数
+
+    constexpr size_t HEADER_OFFSET_VERSION     = 4;     ///< 版
+    constexpr size_t HEADER_OFFSET_RECORD_SIZE = 6;     ///< レコード長
+    constexpr size_t HEADER_OFFSET_COUNT       = 8;     ///< レコード数
+    constexpr size_t HEADER_OFFSET_DROPPED     = 12;    ///< 上書きで失われたレコード数
+
+    /**
+     * @brief 1レコードの構造（RECORD_SIZE バイト）
+     */
+    struct __attribute__((packed)) Entry {
+        uint32_t seq;                   ///< 記録の通し番号（欠番は上書きされた記録）
+        uint32_t timeMicros;            ///< 記録時刻（記録した側の micros()）
+        uint32_t frameTimestamp;        ///< フレームヘッダのタイムスタンプ
+        uint8_t  kind;                  ///< レコードの種類（Kind）
+        int8_t   status;                ///< ステータスコード（ROBO_WCOM::Status）
+        uint8_t  carriedSize;           ///< 搬送データサイズ
+        uint8_t  fieldCount;            ///< fields の有効数
+        float    fields[FIELD_MAX];     ///< アプリが選んだペイロード値
+    };
+
+    constexpr size_t   RECORD_SIZE = 32;            ///< レコード長
+    constexpr uint32_t SEQ_INVALID = 0xFFFFFFFF;    ///< 書き込み途中でダンプされた無効レコードの通し番号
+    static_assert(sizeof(Entry) == RECORD_SIZE, "Record::Entry must be RECORD_SIZE bytes");
+
+    constexpr size_t ENTRY_OFFSET_SEQ             = 0;  ///< 通し番号
+    constexpr size_t ENTRY_OFFSET_TIME_MICROS     = 4;  ///< 記録時刻
+    constexpr size_t ENTRY_OFFSET_FRAME_TIMESTAMP = 8;  ///< フレームタイムスタンプ
+    constexpr size_t ENTRY_OFFSET_KIND            = 12; ///< 種類
+    constexpr size_t ENTRY_OFFSET_STATUS          = 13; ///< ステータス
+    constexpr size_t ENTRY_OFFSET_CARRIED_SIZE    = 14; ///< 搬送データサイズ
+    constexpr size_t ENTRY_OFFSET_FIELD_COUNT     = 15; ///< 有効値数
+    constexpr size_t ENTRY_OFFSET_FIELDS          = 16; ///< ペイロード値（float LE × FIELD_MAX）
+}
+}
+
+#endif /* ROBO_WCOM_RECORD_FORMAT_H */
@@ -0,0 +1,166 @@
+#include "ROBO_WCOM_Recorder.h"
+#include "ROBO_WCOM_Codec.h"
+#include <cstring>
+
+namespace ROBO_WCOM
+{
+    constexpr size_t RECORDER_RECORDS = ROBO_WCOM_RECORDER_RECORDS;
+    static_assert(RECORDER_RECORDS > 0, "ROBO_WCOM_RECORDER_RECORDS must be positive");
+
+    constexpr uint32_t SEQ_WRITING = Record::SEQ_INVALID; ///< 書き込み中のレコードの通し番号
+
+    //=== 内部状態 ===//
+    static Record::Entry records[RECORDER_RECORDS];     ///< 記録リングバッファ
+    static uint32_t writeSeq = 0;                       ///< 次に割り当てる通し番号
+    static volatile bool frozen = false;                ///< 記録停止中か
+    static volatile bool freezeOnFailsafe = false;      ///< リンク途絶で記録を停止するか
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief レコードを1件書き込む（ロックなし）
+     * @details
+     * 通し番号を原子的に確保してからスロットを書き、最後に通し番号を書き込んで確定させる。
+     * 読み出し側は通し番号が前後で一致したスロットのみ採用する。
+     */
+    static void writeRecord(Record::Kind kind, Status status, uint32_t frameTimestamp, uint8_t carriedSize,
+                            const float* fields, uint8_t fieldCount)
+    {
+        uint32_t seq = __atomic_fetch_add(&writeSeq, 1, __ATOMIC_RELAXED);
+        Record::Entry& rec = records[seq % RECORDER_RECORDS];
+
+        __atomic_store_n(&rec.seq, SEQ_WRITING, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        rec.timeMicros = micros();
+        rec.frameTimestamp = frameTimestamp;
+        rec.kind = static_cast<uint8_t>(kind);
+        rec.status = static_cast<int8_t>(status);
+        rec.carriedSize = carriedSize;
+        if (!fields || fieldCount > Record::FIELD_MAX)
+        {
+            fieldCount = fields ? Record::FIELD_MAX : 0;
+        }
+        rec.fieldCount = fieldCount;
+        for (uint8_t i = 0; i < Record::FIELD_MAX; ++i)
+        {
+            rec.fields[i] = (i < fieldCount) ? fields[i] : 0.0f;
+        }
+        __atomic_store_n(&rec.seq, seq, __ATOMIC_RELEASE);
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief 1レコードを記録
+     * @param kind           レコードの種類
+     * @param status         ステータスコード
+     * @param frameTimestamp フレームヘッダのタイムスタンプ
+     * @param carriedSize    搬送データサイズ
+     * @param fields         記録するペイロード値（nullptr 可）
+     * @param fieldCount     fields の数
+     */
+    void RecorderLog(Record::Kind kind, Status status, uint32_t frameTimestamp, uint8_t carriedSize,
+                     const float* fields, uint8_t fieldCount)
+    {
+        if (frozen)
+        {
+            return;
+        }
+        writeRecord(kind, status, frameTimestamp, carriedSize, fields, fieldCount);
+
+        // 途絶を検出したら、その時点までの記録を残して停止する
+        if (freezeOnFailsafe && GetLinkState() == LinkState::Lost)
+        {
+            writeRecord(Record::Kind::Failsafe, Status::Timeout, 0, 0, nullptr, 0);
+            frozen = true;
+        }
+    }
+
+    /**
+     * @brief リンク途絶を検出したら記録を停止する
+     * @param enable 有効/無効
+     */
+    void RecorderSetFreezeOnFailsafe(bool enable)
+    {
+        freezeOnFailsafe = enable;
+    }
+
+    /**
+     * @brief 記録の停止/再開
+     * @param freeze true:停止 / false:再開
+     */
+    void RecorderFreeze(bool freeze)
+    {
+        frozen = freeze;
+    }
+
+    /**
+     * @brief 記録が停止しているか
+     * @return true:停止中
+     */
+    bool RecorderIsFrozen(void)
+    {
+        return frozen;
+    }
+
+    /**
+     * @brief 記録をバイナリでダンプ
+     * @param out 出力先
+     * @return 出力したレコード数
+     */
+    size_t RecorderDump(Print& out)
+    {
+        bool wasFrozen = frozen;
+        frozen = true;
+
+        uint32_t end = __atomic_load_n(&writeSeq, __ATOMIC_ACQUIRE);
+        uint32_t begin = (end > RECORDER_RECORDS) ? end - RECORDER_RECORDS : 0;
+        uint32_t count = end - begin;
+
+        uint8_t header[Record::HEADER_SIZE];
+        memcpy(header, Record::MAGIC, sizeof(Record::MAGIC));
+        Codec::storeLE16(header + Record::HEADER_OFFSET_VERSION, Record::VERSION);
+        Codec::storeLE16(header + Record::HEADER_OFFSET_RECORD_SIZE, Record::RECORD_SIZE);
+        Codec::storeLE32(header + Record::HEADER_OFFSET_COUNT, count);
+        Codec::storeLE32(header + Record::HEADER_OFFSET_DROPPED, begin);
+        out.write(header, sizeof(header));
+
+        // 書き込み途中・上書き中のスロットは通し番号が一致しないので無効印を付けて出力する
+        for (uint32_t seq = begin; seq != end; ++seq)
+        {
+            const Record::Entry& slot = records[seq % RECORDER_RECORDS];
+            Record::Entry rec;
+            bool valid = false;
+            if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) == seq)
+            {
+                rec = slot;
+                // 読み出している間に書き込みが始まっていれば無効なレコードにする
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                valid = (__atomic_load_n(&slot.seq, __ATOMIC_RELAXED) == seq);
+            }
+            if (!valid)
+            {
+                memset(&rec, 0, sizeof(rec));
+                rec.seq = SEQ_WRITING;
+            }
+            out.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec));
+        }
+
+        frozen = wasFrozen;
+        return count;
+    }
+
+    /**
+     * @brief 記録を消去して再開
+     */
+    void RecorderClear(void)
+    {
+        frozen = true;
+        for (size_t i = 0; i < RECORDER_RECORDS; ++i)
+        {
+            records[i].seq = SEQ_WRITING;
+        }
+        __atomic_store_n(&writeSeq, 0, __ATOMIC_RELEASE);
+        frozen = false;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef ROBO_WCOM_RECORDER_H
+#define ROBO_WCOM_RECORDER_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_RecordFormat.h"
+
+/**
+ * @brief フライトレコーダの保持レコード数
+ * @details ビルドフラグ（-DROBO_WCOM_RECORDER_RECORDS=...）で変更可能。1レコード32バイト
+ */
+#ifndef ROBO_WCOM_RECORDER_RECORDS
+#define ROBO_WCOM_RECORDER_RECORDS 256
+#endif
+
+/**
+ * @file ROBO_WCOM_Recorder.h
+ * @brief RAM上のリングバッファに固定長バイナリで記録するフライトレコーダ
+ * @details
+ * ループごとに浮動小数点を文字列整形してシリアルへ書く代わりに、32バイトのレコードを
+ * リングバッファへ書き込むだけにする。書き込みはロックを取らず、複数タスクや割り込みから呼べる。
+ * 記録はアプリの要求時、またはリンク途絶の検出後に RecorderDump() でまとめて出力し、
+ * PC側で tools/wcom_rec2csv.cpp により CSV へ変換する。
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 1レコードを記録
+     * @param kind           レコードの種類
+     * @param status         ステータスコード
+     * @param frameTimestamp フレームヘッダのタイムスタンプ
+     * @param carriedSize    搬送データサイズ
+     * @param fields         記録するペイロード値（nullptr 可）
+     * @param fieldCount     fields の数（Record::FIELD_MAX を超えた分は切り捨て）
+     */
+    void RecorderLog(Record::Kind kind, Status status, uint32_t frameTimestamp, uint8_t carriedSize,
+                     const float* fields, uint8_t fieldCount);
+
+    /**
+     * @brief リンク途絶（LinkState::Lost）を検出したら記録を停止する
+     * @details 有効時は RecorderLog() のたびにリンク状態を確認し、途絶時に Failsafe レコードを残して停止する
+     * @param enable 有効/無効
+     */
+    void RecorderSetFreezeOnFailsafe(bool enable);
+
+    /**
+     * @brief 記録の停止/再開
+     * @param freeze true:停止 / false:再開
+     */
+    void RecorderFreeze(bool freeze);
+
+    /**
+     * @brief 記録が停止しているか
+     * @return true:停止中
+     */
+    bool RecorderIsFrozen(void);
+
+    /**
+     * @brief 記録をバイナリでダンプ
+     * @details ダンプ中は記録を停止し、終了後に元の状態へ戻す
+     * @param out 出力先（Serial など）
+     * @return 出力したレコード数
+     */
+    size_t RecorderDump(Print& out);
+
+    /**
+     * @brief 記録を消去して再開
+     */
+    void RecorderClear(void);
+}
+
+#endif /* ROBO_WCOM_RECORDER_H */
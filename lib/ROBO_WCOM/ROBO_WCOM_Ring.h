@@ -0,0 +1,149 @@
+#ifndef ROBO_WCOM_RING_H
+#define ROBO_WCOM_RING_H
+
+#include "ROBO_WCOM.h"
+#include <string.h>
+
+/**
+ * @file ROBO_WCOM_Ring.h
+ * @brief スロット数・最大搬送データサイズを指定できる受信リングバッファ
+ * @details
+ * 1スロットはヘッダ12バイト + PayloadMax バイト。指令だけを受けるロボットなら
+ * 4スロット × 24バイト程度に縮められる（既定の 64 × 200 は約13KB）。
+ * 初期化は読み書き位置を戻すだけで、スロットの中身には触れない。
+ */
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 受信リングバッファ
+     * @tparam Slots      保持するパケット数
+     * @tparam PayloadMax 1パケットあたりの最大搬送データサイズ
+     */
+    template <size_t Slots, size_t PayloadMax>
+    class PacketRing
+    {
+        static_assert(Slots > 0 && Slots <= 0x7FFF, "PacketRing slot count out of range");
+        static_assert(PayloadMax > 0 && PayloadMax <= CARRIED_DATA_MAX_SIZE, "PacketRing payload size out of range");
+
+    public:
+        PacketRing() : head_(0), tail_(0), count_(0) {}
+
+        /**
+         * @brief 空にする
+         */
+        void clear()
+        {
+            head_ = 0;
+            tail_ = 0;
+            count_ = 0;
+        }
+
+        /**
+         * @brief パケットを追加する。満杯なら最も古いパケットを上書きする
+         * @details PayloadMax を超える搬送データは保持できないため、CRCエラーとして積む
+         * @param data  パケットデータ
+         * @param crcOk CRC検証結果
+         */
+        void push(const PacketData& data, bool crcOk)
+        {
+            Slot& slot = slots_[head_];
+            slot.timestamp = data.timestamp;
+            memcpy(slot.address, data.address, sizeof(slot.address));
+            if (data.carriedSize <= PayloadMax)
+            {
+                slot.carriedSize = data.carriedSize;
+                slot.crcOk = crcOk;
+                memcpy(slot.carriedData, data.carriedData, data.carriedSize);
+            }
+            else
+            {
+                slot.carriedSize = 0;
+                slot.crcOk = false;
+            }
+
+            head_ = (head_ + 1) % Slots;
+            if (count_ < static_cast<int16_t>(Slots))
+            {
+                count_++;
+            }
+            else
+            {
+                // 上書き時はtailも進める
+                tail_ = (tail_ + 1) % Slots;
+            }
+        }
+
+        /**
+         * @brief 最も古いパケットを取り出す
+         * @param data  取り出したパケットデータ
+         * @param crcOk CRC検証結果
+         * @return true:成功 / false:空
+         */
+        bool pop(PacketData& data, bool& crcOk)
+        {
+            if (count_ <= 0)
+            {
+                return false;
+            }
+            read(slots_[tail_], data, crcOk);
+            tail_ = (tail_ + 1) % Slots;
+            --count_;
+            return true;
+        }
+
+        /**
+         * @brief 最新のパケットを参照する（取り出さない）
+         * @param data  パケットデータ
+         * @param crcOk CRC検証結果
+         * @return true:成功 / false:空
+         */
+        bool peekLatest(PacketData& data, bool& crcOk) const
+        {
+            if (count_ <= 0)
+            {
+                return false;
+            }
+            read(slots_[(head_ + Slots - 1) % Slots], data, crcOk);
+            return true;
+        }
+
+        /**
+         * @brief 保持しているパケット数
+         */
+        int16_t size() const
+        {
+            return count_;
+        }
+
+    private:
+        /**
+         * @brief 1スロット分の保持形式
+         */
+        struct Slot {
+            uint32_t timestamp;                 ///< タイムスタンプ
+            uint8_t  address[6];                ///< 送信元MAC
+            uint8_t  carriedSize;               ///< 搬送データサイズ
+            bool     crcOk;                     ///< CRC検証結果
+            uint8_t  carriedData[PayloadMax];   ///< 搬送データ本体
+        };
+
+        /**
+         * @brief スロットからパケットデータへ展開する
+         */
+        static void read(const Slot& slot, PacketData& data, bool& crcOk)
+        {
+            data.timestamp = slot.timestamp;
+            memcpy(data.address, slot.address, sizeof(data.address));
+            data.carriedSize = slot.carriedSize;
+            memcpy(data.carriedData, slot.carriedData, slot.carriedSize);
+            crcOk = slot.crcOk;
+        }
+
+        Slot slots_[Slots];         ///< スロット
+        volatile uint16_t head_;    ///< 書き込み位置
+        volatile uint16_t tail_;    ///< 読み出し位置
+        volatile int16_t  count_;   ///< 保持数
+    };
+}
+
+#endif /* ROBO_WCOM_RING_H */
@@ -0,0 +1,445 @@
+#include "ROBO_WCOM_Rpc.h"
+#include "ROBO_WCOM_Codec.h"
+#include <cstring>
+
+namespace ROBO_WCOM
+{
+    /**
+     * @brief 応答待ちテーブルの要素の状態
+     */
+    enum class RpcSlotState : uint8_t { Free, Waiting, Done };
+
+    /**
+     * @brief 応答待ちテーブルの要素
+     */
+    struct RpcSlot {
+        volatile RpcSlotState state;        ///< 状態
+        RpcHandle   id;                     ///< 相関ID
+        uint32_t    deadline;               ///< タイムアウト時刻（millis）
+        RpcCallback callback;               ///< 完了コールバック
+        void*       context;                ///< 完了コールバックへ渡すポインタ
+        Status      status;                 ///< 完了ステータス
+        uint8_t     replySize;              ///< 応答データサイズ
+        uint8_t     reply[RPC_PAYLOAD_MAX]; ///< 応答データ
+    };
+
+    /**
+     * @brief 処理待ちの受信要求
+     */
+    struct RpcRequest {
+        RpcHandle id;                       ///< 相関ID
+        uint8_t   method;                   ///< メソッド番号
+        uint8_t   argSize;                  ///< 引数サイズ
+        uint8_t   args[RPC_PAYLOAD_MAX];    ///< 引数
+    };
+
+    //=== 内部状態 ===//
+#if defined(ESP_PLATFORM)
+    static portMUX_TYPE rpcMux = portMUX_INITIALIZER_UNLOCKED;  ///< テーブル保護
+    #define RPC_LOCK()      portENTER_CRITICAL(&rpcMux)
+    #define RPC_UNLOCK()    portEXIT_CRITICAL(&rpcMux)
+#else
+    #define RPC_LOCK()
+    #define RPC_UNLOCK()
+#endif
+
+    static RpcSlot    pending[RPC_PENDING_MAX];      ///< 応答待ちテーブル
+    static RpcHandle  nextId = 1;                    ///< 次に使う相関ID
+
+    static RpcRequest requests[RPC_QUEUE_MAX];       ///< 処理待ちの受信要求
+    static uint8_t    requestHead = 0;               ///< 次に書き込む位置
+    static uint8_t    requestCount = 0;              ///< 処理待ちの数
+
+    static uint8_t    methods[RPC_METHOD_MAX];       ///< 登録済みメソッド番号
+    static RpcHandler handlers[RPC_METHOD_MAX] = {}; ///< メソッドのハンドラ
+
+    static RpcStats   rpcStats{};                    ///< 統計
+
+    //=== 内部関数 ===//
+
+    /**
+     * @brief 相関IDから応答待ちテーブルの要素を探す
+     */
+    static RpcSlot* findSlot(RpcHandle id)
+    {
+        for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+        {
+            if (pending[i].state != RpcSlotState::Free && pending[i].id == id)
+            {
+                return &pending[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief 使われていない相関IDを払い出す（0 は使わない）
+     */
+    static RpcHandle allocateId(void)
+    {
+        for (;;)
+        {
+            RpcHandle id = nextId++;
+            if (id != RPC_HANDLE_INVALID && !findSlot(id))
+            {
+                return id;
+            }
+        }
+    }
+
+    /**
+     * @brief 応答を送信する
+     */
+    static Status sendResponse(RpcHandle id, uint8_t method, Status status, const uint8_t* reply, uint8_t replySize)
+    {
+        uint8_t body[Wire::RPC_HEADER_SIZE + RPC_PAYLOAD_MAX];
+        body[Wire::RPC_OFFSET_KIND] = Wire::RPC_KIND_RESPONSE;
+        Codec::storeLE16(body + Wire::RPC_OFFSET_ID, id);
+        body[Wire::RPC_OFFSET_METHOD] = method;
+        body[Wire::RPC_OFFSET_STATUS] = static_cast<uint8_t>(status);
+        memcpy(body + Wire::RPC_OFFSET_PAYLOAD, reply, replySize);
+        return SendExtFrame(static_cast<uint8_t>(Wire::FrameType::Rpc), body, Wire::RPC_HEADER_SIZE + replySize);
+    }
+
+    /**
+     * @brief RPC フレームの受信ハンドラ（Wi-Fiタスクから呼ばれる）
+     * @details 要求は処理待ちへ、応答は応答待ちテーブルへ保存するだけで、処理は RpcService() で行う
+     */
+    static void onRpcFrame(const uint8_t* body, uint8_t size)
+    {
+        if (size < Wire::RPC_HEADER_SIZE || size - Wire::RPC_HEADER_SIZE > RPC_PAYLOAD_MAX)
+        {
+            return;
+        }
+        RpcHandle id = Codec::loadLE16(body + Wire::RPC_OFFSET_ID);
+        uint8_t payloadSize = static_cast<uint8_t>(size - Wire::RPC_HEADER_SIZE);
+        const uint8_t* payload = body + Wire::RPC_OFFSET_PAYLOAD;
+
+        RPC_LOCK();
+        if (body[Wire::RPC_OFFSET_KIND] == Wire::RPC_KIND_REQUEST)
+        {
+            if (requestCount < RPC_QUEUE_MAX)
+            {
+                RpcRequest& req = requests[requestHead];
+                req.id = id;
+                req.method = body[Wire::RPC_OFFSET_METHOD];
+                req.argSize = payloadSize;
+                memcpy(req.args, payload, payloadSize);
+                requestHead = static_cast<uint8_t>((requestHead + 1) % RPC_QUEUE_MAX);
+                requestCount++;
+            }
+            else
+            {
+                rpcStats.dropped++;
+            }
+        }
+        else if (body[Wire::RPC_OFFSET_KIND] == Wire::RPC_KIND_RESPONSE)
+        {
+            RpcSlot* slot = findSlot(id);
+            if (slot && slot->state == RpcSlotState::Waiting)
+            {
+                slot->status = static_cast<Status>(static_cast<int8_t>(body[Wire::RPC_OFFSET_STATUS]));
+                slot->replySize = payloadSize;
+                memcpy(slot->reply, payload, payloadSize);
+                slot->state = RpcSlotState::Done;
+                rpcStats.completed++;
+            }
+            else
+            {
+                rpcStats.unmatched++;
+            }
+        }
+        RPC_UNLOCK();
+    }
+
+    /**
+     * @brief 処理待ちの受信要求を1件取り出す
+     */
+    static bool takeRequest(RpcRequest& out)
+    {
+        bool found = false;
+        RPC_LOCK();
+        if (requestCount > 0)
+        {
+            out = requests[(requestHead + RPC_QUEUE_MAX - requestCount) % RPC_QUEUE_MAX];
+            requestCount--;
+            found = true;
+        }
+        RPC_UNLOCK();
+        return found;
+    }
+
+    /**
+     * @brief メソッド番号からハンドラを探す
+     */
+    static RpcHandler findHandler(uint8_t method)
+    {
+        for (size_t i = 0; i < RPC_METHOD_MAX; ++i)
+        {
+            if (handlers[i] && methods[i] == method)
+            {
+                return handlers[i];
+            }
+        }
+        return nullptr;
+    }
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief RPC を開始する
+     * @return ステータスコード (Status)
+     */
+    Status RpcBegin(void)
+    {
+        RPC_LOCK();
+        for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+        {
+            pending[i].state = RpcSlotState::Free;
+        }
+        requestHead = 0;
+        requestCount = 0;
+        rpcStats = RpcStats{};
+        RPC_UNLOCK();
+        return SetFrameHandler(static_cast<uint8_t>(Wire::FrameType::Rpc), onRpcFrame);
+    }
+
+    /**
+     * @brief メソッドのハンドラを登録する
+     * @param method  メソッド番号
+     * @param handler ハンドラ（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status RpcRegister(uint8_t method, RpcHandler handler)
+    {
+        // 登録済みなら置き換え、未登録なら空きへ登録する
+        size_t slot = RPC_METHOD_MAX;
+        for (size_t i = 0; i < RPC_METHOD_MAX; ++i)
+        {
+            if (handlers[i] && methods[i] == method)
+            {
+                slot = i;
+                break;
+            }
+            if (!handlers[i] && slot == RPC_METHOD_MAX)
+            {
+                slot = i;
+            }
+        }
+        if (slot == RPC_METHOD_MAX)
+        {
+            return handler ? Status::RpcTableFull : Status::Ok;
+        }
+        methods[slot] = method;
+        handlers[slot] = handler;
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 要求を送信する
+     * @param method    メソッド番号
+     * @param args      引数
+     * @param argSize   引数サイズ
+     * @param nowMillis 現在時刻（millis）
+     * @param timeoutMs 応答を待つ時間（ミリ秒）
+     * @param callback  完了コールバック
+     * @param context   完了コールバックへ渡す任意のポインタ
+     * @param handle    ハンドルの格納先
+     * @return ステータスコード (Status)
+     */
+    Status RpcCall(uint8_t method, const uint8_t* args, uint8_t argSize, uint32_t nowMillis, uint32_t timeoutMs,
+                   RpcCallback callback, void* context, RpcHandle* handle)
+    {
+        if ((argSize > 0 && !args) || argSize > RPC_PAYLOAD_MAX)
+        {
+            return Status::InvalidArg;
+        }
+
+        // 応答待ちテーブルに空きを確保する（応答より先に登録しておく）
+        RpcSlot* slot = nullptr;
+        RpcHandle id = RPC_HANDLE_INVALID;
+        RPC_LOCK();
+        for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+        {
+            if (pending[i].state == RpcSlotState::Free)
+            {
+                slot = &pending[i];
+                break;
+            }
+        }
+        if (slot)
+        {
+            id = allocateId();
+            slot->id = id;
+            slot->deadline = nowMillis + timeoutMs;
+            slot->callback = callback;
+            slot->context = context;
+            slot->replySize = 0;
+            slot->state = RpcSlotState::Waiting;
+        }
+        RPC_UNLOCK();
+        if (!slot)
+        {
+            return Status::RpcTableFull;
+        }
+
+        uint8_t body[Wire::RPC_HEADER_SIZE + RPC_PAYLOAD_MAX];
+        body[Wire::RPC_OFFSET_KIND] = Wire::RPC_KIND_REQUEST;
+        Codec::storeLE16(body + Wire::RPC_OFFSET_ID, id);
+        body[Wire::RPC_OFFSET_METHOD] = method;
+        body[Wire::RPC_OFFSET_STATUS] = 0;
+        if (argSize > 0)
+        {
+            memcpy(body + Wire::RPC_OFFSET_PAYLOAD, args, argSize);
+        }
+        Status status = SendExtFrame(static_cast<uint8_t>(Wire::FrameType::Rpc), body, Wire::RPC_HEADER_SIZE + argSize);
+        if (status != Status::Ok)
+        {
+            RPC_LOCK();
+            slot->state = RpcSlotState::Free;
+            RPC_UNLOCK();
+            return status;
+        }
+
+        rpcStats.calls++;
+        if (handle)
+        {
+            *handle = id;
+        }
+        return Status::Ok;
+    }
+
+    /**
+     * @brief 要求の完了を確認する
+     * @param handle    ハンドル
+     * @param reply     応答データの格納先
+     * @param replySize 応答データサイズの格納先
+     * @return ステータスコード (Status)
+     */
+    Status RpcPoll(RpcHandle handle, uint8_t* reply, uint8_t* replySize)
+    {
+        Status result = Status::InvalidArg;
+        RPC_LOCK();
+        RpcSlot* slot = findSlot(handle);
+        if (slot && !slot->callback)
+        {
+            if (slot->state == RpcSlotState::Waiting)
+            {
+                result = Status::RpcPending;
+            }
+            else
+            {
+                result = slot->status;
+                if (reply)
+                {
+                    memcpy(reply, slot->reply, slot->replySize);
+                }
+                if (replySize)
+                {
+                    *replySize = slot->replySize;
+                }
+                slot->state = RpcSlotState::Free;
+            }
+        }
+        RPC_UNLOCK();
+        return result;
+    }
+
+    /**
+     * @brief 応答待ちの要求を取り消す
+     * @param handle ハンドル
+     * @return ステータスコード (Status)
+     */
+    Status RpcCancel(RpcHandle handle)
+    {
+        Status result = Status::InvalidArg;
+        RPC_LOCK();
+        RpcSlot* slot = findSlot(handle);
+        if (slot)
+        {
+            slot->state = RpcSlotState::Free;
+            result = Status::Ok;
+        }
+        RPC_UNLOCK();
+        return result;
+    }
+
+    /**
+     * @brief 受信要求の処理・完了コールバック・タイムアウト判定を行う
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)
+     */
+    Status RpcService(uint32_t nowMillis)
+    {
+        Status result = Status::Ok;
+
+        // サーバ側: 処理待ちの要求を実行して応答を返す
+        RpcRequest req;
+        while (takeRequest(req))
+        {
+            uint8_t reply[RPC_PAYLOAD_MAX];
+            uint8_t replySize = 0;
+            RpcHandler handler = findHandler(req.method);
+            Status status = Status::RpcNoHandler;
+            if (handler)
+            {
+                status = handler(req.args, req.argSize, reply, &replySize);
+                if (replySize > RPC_PAYLOAD_MAX)
+                {
+                    replySize = 0;
+                    status = Status::InvalidArg;
+                }
+            }
+            rpcStats.served++;
+            if (sendResponse(req.id, req.method, status, reply, replySize) != Status::Ok)
+            {
+                result = Status::SendFail;
+            }
+        }
+
+        // クライアント側: 完了・タイムアウトした要求を通知する
+        for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+        {
+            RpcSlot& slot = pending[i];
+            RPC_LOCK();
+            if (slot.state == RpcSlotState::Waiting && static_cast<int32_t>(nowMillis - slot.deadline) >= 0)
+            {
+                slot.status = Status::Timeout;
+                slot.replySize = 0;
+                slot.state = RpcSlotState::Done;
+                rpcStats.timeouts++;
+            }
+            // コールバック中の RpcCall() で同じ要素が再利用されてもよいよう、写してから解放する
+            bool notify = (slot.state == RpcSlotState::Done && slot.callback);
+            RpcSlot done;
+            if (notify)
+            {
+                done = slot;
+                slot.state = RpcSlotState::Free;
+            }
+            RPC_UNLOCK();
+            if (notify)
+            {
+                done.callback(done.id, done.status, done.reply, done.replySize, done.context);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief RPC の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetRpcStats(RpcStats* stats)
+    {
+        if (!stats)
+        {
+            return Status::InvalidArg;
+        }
+        RPC_LOCK();
+        *stats = rpcStats;
+        RPC_UNLOCK();
+        return Status::Ok;
+    }
+}
@@ -0,0 +1,172 @@
+#ifndef ROBO_WCOM_RPC_H
+#define ROBO_WCOM_RPC_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Wire.h"
+
+/**
+ * @brief 応答待ちにできる要求の最大数
+ * @details ビルドフラグ（-DROBO_WCOM_RPC_PENDING_MAX=...）で変更可能
+ */
+#ifndef ROBO_WCOM_RPC_PENDING_MAX
+#define ROBO_WCOM_RPC_PENDING_MAX 8
+#endif
+
+/**
+ * @brief 処理待ちにできる受信要求の最大数（サーバ側）
+ */
+#ifndef ROBO_WCOM_RPC_QUEUE_MAX
+#define ROBO_WCOM_RPC_QUEUE_MAX 4
+#endif
+
+/**
+ * @brief 登録できるメソッドの最大数（サーバ側）
+ */
+#ifndef ROBO_WCOM_RPC_METHOD_MAX
+#define ROBO_WCOM_RPC_METHOD_MAX 8
+#endif
+
+/**
+ * @brief 引数・応答データの最大バイト数
+ * @details 応答待ちの要求・受信要求ごとにこのサイズのバッファを持つ。最大 Wire::RPC_PAYLOAD_MAX
+ */
+#ifndef ROBO_WCOM_RPC_PAYLOAD_MAX
+#define ROBO_WCOM_RPC_PAYLOAD_MAX 64
+#endif
+
+/**
+ * @file ROBO_WCOM_Rpc.h
+ * @brief 相関ID付きの要求/応答（RPC）
+ * @details
+ * 「ロボットのパラメータXを読む」「モータの自己診断を実行して結果を返す」といった問い合わせを、
+ * SendPacket() / PopOldestPacket() の上で突き合わせ処理を書かずに行う。
+ *
+ * - 要求と応答は拡張フレーム（Wire::FrameType::Rpc）で送り、相関IDで対応付ける
+ * - クライアント : RpcCall() は送信するだけで戻る。完了はコールバックまたは RpcPoll() で受け取る
+ * - サーバ       : RpcRegister() でメソッド番号ごとにハンドラを登録する
+ * - ハンドラ・完了コールバック・タイムアウト判定はすべて RpcService() の中で行うため、
+ *   受信コールバック（Wi-Fiタスク）では受信データの保存しか行わない
+ *
+ * 複数の要求を同時に応答待ちにでき、制御ループを止めることはない。再送は行わないため、
+ * 要求または応答が失われた場合はタイムアウトとなる。
+ */
+namespace ROBO_WCOM
+{
+    constexpr size_t RPC_PENDING_MAX = ROBO_WCOM_RPC_PENDING_MAX;   ///< 応答待ちにできる要求の最大数
+    constexpr size_t RPC_QUEUE_MAX   = ROBO_WCOM_RPC_QUEUE_MAX;     ///< 処理待ちにできる受信要求の最大数
+    constexpr size_t RPC_METHOD_MAX  = ROBO_WCOM_RPC_METHOD_MAX;    ///< 登録できるメソッドの最大数
+    constexpr size_t RPC_PAYLOAD_MAX = ROBO_WCOM_RPC_PAYLOAD_MAX;   ///< 引数・応答データの最大バイト数
+
+    static_assert(RPC_PAYLOAD_MAX <= Wire::RPC_PAYLOAD_MAX, "ROBO_WCOM_RPC_PAYLOAD_MAX exceeds the frame size");
+
+    /**
+     * @brief 要求のハンドル（相関ID）
+     */
+    typedef uint16_t RpcHandle;
+
+    /**
+     * @brief 無効なハンドル
+     */
+    constexpr RpcHandle RPC_HANDLE_INVALID = 0;
+
+    /**
+     * @brief サーバ側のメソッドハンドラ
+     * @details RpcService() から呼ばれる。戻り値はそのままクライアントへの完了ステータスになる
+     * @param args      引数
+     * @param argSize   引数サイズ
+     * @param reply     応答データの格納先（最大 RPC_PAYLOAD_MAX）
+     * @param replySize 応答データサイズの格納先（0 で初期化済み）
+     * @return ステータスコード (Status)
+     */
+    typedef Status (*RpcHandler)(const uint8_t* args, uint8_t argSize, uint8_t* reply, uint8_t* replySize);
+
+    /**
+     * @brief クライアント側の完了コールバック
+     * @details RpcService() から呼ばれる
+     * @param handle    完了した要求のハンドル
+     * @param status    完了ステータス（サーバのハンドラの戻り値、Timeout、RpcNoHandler）
+     * @param reply     応答データ
+     * @param replySize 応答データサイズ
+     * @param context   RpcCall() に渡した任意のポインタ
+     */
+    typedef void (*RpcCallback)(RpcHandle handle, Status status, const uint8_t* reply, uint8_t replySize, void* context);
+
+    /**
+     * @brief RPC の統計
+     */
+    struct RpcStats {
+        uint32_t calls;         ///< 送信した要求数
+        uint32_t completed;     ///< 応答を受け取った要求数
+        uint32_t timeouts;      ///< タイムアウトした要求数
+        uint32_t served;        ///< 処理した受信要求数
+        uint32_t dropped;       ///< 処理待ちがあふれて捨てた受信要求数
+        uint32_t unmatched;     ///< 対応する要求がない応答数（タイムアウト後の応答など）
+    };
+
+    /**
+     * @brief RPC を開始する
+     * @details 拡張フレームのハンドラを登録し、応答待ち・処理待ちの要求を破棄する。登録済みメソッドは保持する
+     * @return ステータスコード (Status)
+     */
+    Status RpcBegin(void);
+
+    /**
+     * @brief メソッドのハンドラを登録する（サーバ側）
+     * @param method  メソッド番号
+     * @param handler ハンドラ（nullptr で解除）
+     * @return ステータスコード (Status)
+     */
+    Status RpcRegister(uint8_t method, RpcHandler handler);
+
+    /**
+     * @brief 要求を送信する（クライアント側）
+     * @details 送信したらすぐに戻る。callback を指定しない場合は RpcPoll() で完了を確認する
+     * @param method    メソッド番号
+     * @param args      引数（nullptr 可）
+     * @param argSize   引数サイズ（最大 RPC_PAYLOAD_MAX）
+     * @param nowMillis 現在時刻（millis）
+     * @param timeoutMs 応答を待つ時間（ミリ秒）
+     * @param callback  完了コールバック（nullptr で RpcPoll() による確認）
+     * @param context   完了コールバックへ渡す任意のポインタ
+     * @param handle    ハンドルの格納先（nullptr 可）
+     * @return ステータスコード (Status)。応答待ちが満杯なら RpcTableFull、
+     *         要求フレームが相手の最大搬送データサイズ（SetPeerMaxPayload()）を超えるなら InvalidArg
+     */
+    Status RpcCall(uint8_t method, const uint8_t* args, uint8_t argSize, uint32_t nowMillis, uint32_t timeoutMs,
+                   RpcCallback callback, void* context, RpcHandle* handle);
+
+    /**
+     * @brief 要求の完了を確認する（コールバックなしで送信した要求）
+     * @details 完了（応答受信・タイムアウト）を返した時点でハンドルは無効になる
+     * @param handle    ハンドル
+     * @param reply     応答データの格納先（RPC_PAYLOAD_MAX バイト以上、nullptr 可）
+     * @param replySize 応答データサイズの格納先（nullptr 可）
+     * @return RpcPending:応答待ち / InvalidArg:不明なハンドル / それ以外:完了ステータス
+     */
+    Status RpcPoll(RpcHandle handle, uint8_t* reply, uint8_t* replySize);
+
+    /**
+     * @brief 応答待ちの要求を取り消す
+     * @details 以降に届いた応答は捨てる
+     * @param handle ハンドル
+     * @return ステータスコード (Status)
+     */
+    Status RpcCancel(RpcHandle handle);
+
+    /**
+     * @brief 受信要求の処理・完了コールバック・タイムアウト判定を行う
+     * @details 制御ループなどから周期的に呼ぶ
+     * @param nowMillis 現在時刻（millis）
+     * @return ステータスコード (Status)。応答の送信に失敗した場合は SendFail
+     */
+    Status RpcService(uint32_t nowMillis);
+
+    /**
+     * @brief RPC の統計を取得
+     * @param stats 統計の格納先
+     * @return ステータスコード (Status)
+     */
+    Status GetRpcStats(RpcStats* stats);
+}
+
+#endif /* ROBO_WCOM_RPC_H */
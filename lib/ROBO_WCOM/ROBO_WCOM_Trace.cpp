@@ -0,0 +1,142 @@
+#include "ROBO_WCOM_Trace.h"
+#include "ROBO_WCOM_Codec.h"
+#include <cstring>
+#if ROBO_WCOM_TRACE
+#include <atomic>
+#endif
+
+namespace ROBO_WCOM
+{
+#if ROBO_WCOM_TRACE
+    constexpr uint32_t TRACE_EVENTS = ROBO_WCOM_TRACE_EVENTS;
+    static_assert(TRACE_EVENTS >= 2 && (TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0,
+                  "ROBO_WCOM_TRACE_EVENTS must be a power of two");
+
+    /**
+     * @brief 書き込み中のスロットを示す通し番号
+     */
+    constexpr uint32_t TRACE_SLOT_BUSY = 0;
+
+    /**
+     * @brief イベント1件分のスロット
+     * @details seq は書き込み完了後に「通し番号 + 1」になる。読み出し側は前後で seq を確かめ、
+     *          書き込み中・上書き中のスロットを読み飛ばす
+     */
+    struct TraceSlot {
+        std::atomic<uint32_t> seq;  ///< 書き込み済みの通し番号 + 1（0 は空または書き込み中）
+        uint32_t micros;            ///< 時刻
+        uint32_t id;                ///< 識別子
+        uint32_t aux;               ///< 補足
+        uint8_t  event;             ///< イベント
+        uint8_t  core;              ///< 記録したコア
+    };
+
+    //=== 内部状態 ===//
+    static TraceSlot slots[TRACE_EVENTS];           ///< イベントのリングバッファ
+    static std::atomic<uint32_t> nextSeq(0);        ///< 次に割り当てる通し番号
+    static std::atomic<uint32_t> clearedSeq(0);     ///< TraceClear() した時点の通し番号
+
+    //======= 公開API実装 =======//
+
+    /**
+     * @brief イベントを1件記録する
+     * @param event イベント
+     * @param id    識別子
+     * @param aux   補足
+     */
+    void TraceRecord(Trace::Event event, uint32_t id, uint32_t aux)
+    {
+        // 通し番号の確保だけを不可分に行い、スロットは書き込み側ごとに別々に埋める
+        uint32_t seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+        TraceSlot& slot = slots[seq & (TRACE_EVENTS - 1)];
+        slot.seq.store(TRACE_SLOT_BUSY, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.micros = micros();
+        slot.id = id;
+        slot.aux = aux;
+        slot.event = static_cast<uint8_t>(event);
+#if defined(ESP_PLATFORM)
+        slot.core = static_cast<uint8_t>(xPortGetCoreID());
+#else
+        slot.core = 0;
+#endif
+        slot.seq.store(seq + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 記録したイベントを破棄する
+     */
+    void TraceClear(void)
+    {
+        clearedSeq.store(nextSeq.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 記録したイベントをダンプ形式で出力
+     * @param out 出力先
+     * @return 出力したイベント数
+     */
+    size_t TraceDump(Print& out)
+    {
+        uint32_t end = nextSeq.load(std::memory_order_acquire);
+        uint32_t begin = clearedSeq.load(std::memory_order_relaxed);
+        uint32_t dropped = 0;
+        if (end - begin > TRACE_EVENTS)
+        {
+            dropped = end - begin - TRACE_EVENTS;
+            begin = end - TRACE_EVENTS;
+        }
+
+        uint8_t header[Trace::FILE_HEADER_SIZE];
+        memcpy(header, Trace::MAGIC, sizeof(Trace::MAGIC));
+        Codec::storeLE16(header + Trace::HEADER_OFFSET_VERSION, Trace::VERSION);
+        Codec::storeLE16(header + Trace::HEADER_OFFSET_RECORD_SIZE, Trace::RECORD_SIZE);
+        Codec::storeLE32(header + Trace::HEADER_OFFSET_COUNT, end - begin);
+        Codec::storeLE32(header + Trace::HEADER_OFFSET_DROPPED, dropped);
+        out.write(header, sizeof(header));
+
+        size_t count = 0;
+        for (uint32_t seq = begin; seq != end; ++seq)
+        {
+            const TraceSlot& slot = slots[seq & (TRACE_EVENTS - 1)];
+            uint8_t record[Trace::RECORD_SIZE] = {};
+            if (slot.seq.load(std::memory_order_acquire) == seq + 1)
+            {
+                Codec::storeLE32(record + Trace::RECORD_OFFSET_TIME_MICROS, slot.micros);
+                Codec::storeLE32(record + Trace::RECORD_OFFSET_ID, slot.id);
+                Codec::storeLE32(record + Trace::RECORD_OFFSET_AUX, slot.aux);
+                record[Trace::RECORD_OFFSET_EVENT] = slot.event;
+                record[Trace::RECORD_OFFSET_CORE] = slot.core;
+                // 読み出している間に上書きされていれば無効なレコードにする
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) != seq + 1)
+                {
+                    memset(record, 0, sizeof(record));
+                }
+            }
+            if (record[Trace::RECORD_OFFSET_EVENT] != static_cast<uint8_t>(Trace::Event::None))
+            {
+                count++;
+            }
+            out.write(record, sizeof(record));
+        }
+        return count;
+    }
+#else
+    /**
+     * @brief 記録したイベントを破棄する（トレース無効時は何もしない）
+     */
+    void TraceClear(void)
+    {
+    }
+
+    /**
+     * @brief 記録したイベントをダンプ形式で出力（トレース無効時は何もしない）
+     * @return 0
+     */
+    size_t TraceDump(Print&)
+    {
+        return 0;
+    }
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef ROBO_WCOM_TRACE_H
+#define ROBO_WCOM_TRACE_H
+
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_TraceFormat.h"
+
+/**
+ * @brief トレースを有効にするか（0 で無効）
+ * @details
+ * ビルドフラグ（-DROBO_WCOM_TRACE=1）で有効にする。
+ * 無効の場合 WCOM_TRACE() は何も生成せず（引数も評価しない）、イベントバッファも確保しない。
+ */
+#ifndef ROBO_WCOM_TRACE
+#define ROBO_WCOM_TRACE 0
+#endif
+
+/**
+ * @brief 保持するイベント数（2のべき乗）
+ * @details ビルドフラグ（-DROBO_WCOM_TRACE_EVENTS=...）で変更可能。1イベント 20 バイト
+ */
+#ifndef ROBO_WCOM_TRACE_EVENTS
+#define ROBO_WCOM_TRACE_EVENTS 512
+#endif
+
+/**
+ * @file ROBO_WCOM_Trace.h
+ * @brief フレームの送受信の各段階を記録するトレース
+ * @details
+ * コントローラでの入力からロボットでの出力までのどこで時間がかかっているかを調べるため、
+ * 次の段階で時刻を記録する（イベントの意味は ROBO_WCOM_TraceFormat.h を参照）。
+ *
+ * - 送信側 : PublisherUpdate() → パブリッシャの送信 → SendPacket() → esp_now_send() → 送信完了コールバック
+ * - 受信側 : 受信コールバック → 受信バッファへの格納 → PopOldestPacket() / PeekLatestPacket() → 利用側への反映
+ *
+ * 利用側への反映（Handoff）とアプリケーション独自のイベントは、アプリケーションが WCOM_TRACE() で記録する。
+ * イベントは固定長のリングバッファへロックなしで書き込み、あふれた分は古い順に上書きする。
+ * TraceDump() の出力を PC側の tools/wcom_trace2json.cpp で Chrome / Perfetto のトレース形式へ変換できる。
+ */
+namespace ROBO_WCOM
+{
+#if ROBO_WCOM_TRACE
+    /**
+     * @brief イベントを1件記録する（WCOM_TRACE() から呼ばれる）
+     * @details 割り込み・受信コールバックを含むどこからでも呼べる
+     * @param event イベント
+     * @param id    識別子
+     * @param aux   補足
+     */
+    void TraceRecord(Trace::Event event, uint32_t id, uint32_t aux);
+#endif
+
+    /**
+     * @brief 記録したイベントを破棄する
+     */
+    void TraceClear(void);
+
+    /**
+     * @brief 記録したイベントをダンプ形式で出力
+     * @details
+     * 出力中も記録は続く。出力前に上書きされたイベントはヘッダの欠落数に数え、
+     * 出力中に上書きされたイベントは無効なレコード（Trace::Event::None）として出力する
+     * @param out 出力先（Serial など）
+     * @return 出力した有効なイベント数（トレースが無効なら何も出力せず 0）
+     */
+    size_t TraceDump(Print& out);
+}
+
+/**
+ * @brief トレースポイント
+ * @param event Trace::Event の列挙子名（Update, SendPacket, Handoff など）
+ * @param id    識別子
+ * @param aux   補足
+ */
+#if ROBO_WCOM_TRACE
+#define WCOM_TRACE(event, id, aux) \
+    ::ROBO_WCOM::TraceRecord(::ROBO_WCOM::Trace::Event::event, static_cast<uint32_t>(id), static_cast<uint32_t>(aux))
+#else
+#define WCOM_TRACE(event, id, aux) do { } while (0)
+#endif
+
+#endif /* ROBO_WCOM_TRACE_H */
@@ -0,0 +1,62 @@
+#ifndef ROBO_WCOM_TRACE_FORMAT_H
+#define ROBO_WCOM_TRACE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ROBO_WCOM_TraceFormat.h
+ * @brief トレースのダンプ形式
+ * @details
+ * Arduino に依存しないため、PC側の変換ツール（tools/wcom_trace2json.cpp）からもそのまま利用できる。
+ * 数値はすべてリトルエンディアン。
+ *
+ * - ファイルヘッダ : [マジック "RWCT" 4][版 2][レコード長 2][レコード数 4][欠落イベント数 4]
+ * - レコード       : [時刻 µs 4][識別子 4][補足 4][イベント 1][コア 1][予約 2]
+ *
+ * 識別子はフレームを送受信の両側で対応付けるための値で、データフレームでは送信側が SendPacket() に
+ * 渡したタイムスタンプ（フレームに載って相手へ届く）を使う。
+ * 出力中に上書きされたイベントはイベント種別 None のレコードとして出力する（読み飛ばすこと）。
+ * シリアルへ他のテキストと混在して出力されるため、読み出し側はマジックを探して先頭を見つける。
+ */
+namespace ROBO_WCOM
+{
+namespace Trace
+{
+    /**
+     * @brief イベントの種類
+     */
+    enum class Event : uint8_t {
+        None       = 0,     ///< 無効なレコード（ダンプ中に上書きされた）
+        Update     = 1,     ///< PublisherUpdate()（識別子: 登録の版番号 / 補足: データサイズ）
+        Publish    = 2,     ///< パブリッシャがデータを送信（識別子: タイムスタンプ / 補足: 登録の版番号）
+        SendPacket = 3,     ///< SendPacket() の入口（識別子: タイムスタンプ / 補足: データサイズ）
+        EspNowSend = 4,     ///< esp_now_send() から戻った（識別子: フレームのタイムスタンプ / 補足: 1:受付 0:拒否 | フレーム種別 << 8）
+        SendDone   = 5,     ///< 送信完了コールバック（識別子: 0 / 補足: 1:成功 0:失敗）。受け付けた送信と順に対応する
+        Recv       = 6,     ///< 受信コールバックの入口（識別子: フレームのタイムスタンプ / 補足: フレーム長 | フレーム種別 << 16）
+        Push       = 7,     ///< 受信バッファ・優先スロットへ格納（識別子: タイムスタンプ / 補足: 1:CRC正常 | 2:優先）
+        Pop        = 8,     ///< PopOldestPacket() がパケットを返した（識別子: タイムスタンプ / 補足: ステータス）
+        Peek       = 9,     ///< PeekLatestPacket() がパケットを返した（識別子: タイムスタンプ / 補足: ステータス）
+        Handoff    = 10,    ///< 利用側が受信データを反映した（アプリケーションが記録する。識別子: タイムスタンプ）
+        User       = 32,    ///< アプリケーション独自のイベント（識別子・補足は自由）
+    };
+
+    constexpr uint8_t  MAGIC[4]           = { 'R', 'W', 'C', 'T' };  ///< ファイルヘッダのマジック
+    constexpr uint16_t VERSION            = 1;      ///< ダンプ形式の版
+    constexpr size_t   FILE_HEADER_SIZE   = 16;     ///< ファイルヘッダ長
+    constexpr size_t   RECORD_SIZE        = 16;     ///< レコード長
+
+    constexpr size_t HEADER_OFFSET_VERSION     = 4;     ///< 版
+    constexpr size_t HEADER_OFFSET_RECORD_SIZE = 6;     ///< レコード長
+    constexpr size_t HEADER_OFFSET_COUNT       = 8;     ///< レコード数
+    constexpr size_t HEADER_OFFSET_DROPPED     = 12;    ///< 欠落イベント数（ダンプ前に上書きされた数）
+
+    constexpr size_t RECORD_OFFSET_TIME_MICROS = 0;     ///< 時刻
+    constexpr size_t RECORD_OFFSET_ID          = 4;     ///< 識別子
+    constexpr size_t RECORD_OFFSET_AUX         = 8;     ///< 補足
+    constexpr size_t RECORD_OFFSET_EVENT       = 12;    ///< イベント
+    constexpr size_t RECORD_OFFSET_CORE        = 13;    ///< 記録したコア
+}
+}
+
+#endif /* ROBO_WCOM_TRACE_FORMAT_H */
@@ -0,0 +1,271 @@
+#ifndef ROBO_WCOM_WIRE_H
+#define ROBO_WCOM_WIRE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file ROBO_WCOM_Wire.h
+ * @brief 無線上のフレーム形式の定義
+ * @details
+ * Arduino に依存しないため、PC側ツールからもそのまま利用できる。
+ *
+ * - 従来形式（Full）: PacketData + CRC32 の固定 LEGACY_FRAME_SIZE バイト
+ * - 型付き形式      : 先頭1バイトのフレーム種別で内容を判別する可変長フレーム
+ *
+ * 受信側はフレーム長が LEGACY_FRAME_SIZE の場合のみ従来形式として扱う。
+ * 型付きフレームの長さが LEGACY_FRAME_SIZE と一致する場合は、末尾に1バイト詰め物を付けて区別する。
+ */
+namespace ROBO_WCOM
+{
+namespace Wire
+{
+    /**
+     * @brief 型付きフレームの種別（フレーム先頭1バイト）
+     */
+    enum class FrameType : uint8_t {
+        Data      = 0xD0,   ///< 可変長データフレーム
+        Redundant = 0xD1,   ///< 直前の搬送データを冗長に含むデータフレーム（前方誤り訂正）
+        Priority  = 0xE0,   ///< 優先データフレーム（緊急停止など、データフレームと同一レイアウト）
+        Heartbeat = 0xB0,   ///< 生存通知フレーム
+        Fleet     = 0xF0,   ///< 複数ロボット宛ての一斉送信フレーム（ロボットごとの搬送データを含む）
+        Rpc       = 0xC0,   ///< 要求/応答フレーム（拡張フレーム）
+        Param     = 0xA0,   ///< パラメータ同期フレーム（拡張フレーム）
+        Bulk      = 0x90,   ///< 一括転送フレーム（拡張フレーム）
+        Hello     = 0x80,   ///< ハンドシェイクフレーム（拡張フレーム。整合性検査は設定によらず常に CRC32）
+    };
+
+    /**
+     * @brief 搬送データの最大バイト数
+     */
+    constexpr size_t CARRIED_MAX_SIZE   = 200;
+
+    /**
+     * @brief パケットヘッダ長
+     * @details [タイムスタンプ 4 (LE)][送信元MAC 6][搬送データサイズ 1]
+     */
+    constexpr size_t PACKET_HEADER_SIZE = 4 + 6 + 1;
+
+    /**
+     * @brief CRC32 トレーラ長
+     */
+    constexpr size_t CRC32_SIZE         = 4;
+
+    /**
+     * @brief CRC16 トレーラ長
+     * @details
+     * 暗号化Peerでは型付きフレーム（一斉送信を除く）の CRC32 を CRC16 (LE) に置き換えるか、省略できる。
+     * 以下のレイアウトは既定の CRC32 の場合を示す。
+     */
+    constexpr size_t CRC16_SIZE         = 2;
+
+    /**
+     * @brief 従来形式フレームのバイト数
+     * @details [パケットヘッダ][搬送データ 200（未使用部分も送信）][CRC32 (LE)]
+     */
+    constexpr size_t LEGACY_FRAME_SIZE  = PACKET_HEADER_SIZE + CARRIED_MAX_SIZE + CRC32_SIZE;
+
+    constexpr size_t LEGACY_OFFSET_HEADER  = 0;                                     ///< パケットヘッダ
+    constexpr size_t LEGACY_OFFSET_CARRIED = PACKET_HEADER_SIZE;                    ///< 搬送データ本体
+    constexpr size_t LEGACY_OFFSET_CRC     = PACKET_HEADER_SIZE + CARRIED_MAX_SIZE; ///< CRC32（先頭からここまでが対象）
+
+    /**
+     * @brief 型付きデータフレームのヘッダ長
+     * @details [種別 1][パケットヘッダ]
+     */
+    constexpr size_t DATA_HEADER_SIZE   = 1 + PACKET_HEADER_SIZE;
+
+    constexpr size_t DATA_OFFSET_TYPE      = 0;  ///< フレーム種別
+    constexpr size_t DATA_OFFSET_HEADER    = 1;  ///< パケットヘッダ
+    constexpr size_t DATA_OFFSET_TIMESTAMP = 1;  ///< タイムスタンプ（LE）
+    constexpr size_t DATA_OFFSET_ADDRESS   = 5;  ///< 送信元MAC
+    constexpr size_t DATA_OFFSET_SIZE      = 11; ///< 搬送データサイズ
+    constexpr size_t DATA_OFFSET_CARRIED   = DATA_HEADER_SIZE; ///< 搬送データ本体（続いて CRC32 (LE)）
+
+    /**
+     * @brief 冗長データフレームのヘッダ長
+     * @details
+     * [種別 1][パケットヘッダ][シーケンス番号 2 (LE)][前回タイムスタンプ 4 (LE)][前回サイズ 1]
+     * に続けて [搬送データ][前回の搬送データ][CRC32 (LE)] を置く。
+     * 受信側はシーケンス番号が1つ飛んだ場合に前回の搬送データから欠落フレームを復元する。
+     */
+    constexpr size_t REDUNDANT_HEADER_SIZE = DATA_HEADER_SIZE + 2 + 4 + 1;
+
+    constexpr size_t REDUNDANT_OFFSET_SEQ            = DATA_HEADER_SIZE;      ///< シーケンス番号
+    constexpr size_t REDUNDANT_OFFSET_PREV_TIMESTAMP = DATA_HEADER_SIZE + 2;  ///< 前回タイムスタンプ
+    constexpr size_t REDUNDANT_OFFSET_PREV_SIZE      = DATA_HEADER_SIZE + 6;  ///< 前回サイズ
+    constexpr size_t REDUNDANT_OFFSET_CARRIED        = REDUNDANT_HEADER_SIZE; ///< 搬送データ本体
+
+    /**
+     * @brief 前回の搬送データを含まないことを示す前回サイズ値
+     */
+    constexpr uint8_t REDUNDANT_NO_PREVIOUS = 0xFF;
+
+    /**
+     * @brief 生存通知フレーム長
+     * @details [種別 1][シーケンス番号 2 (LE)][タイムスタンプ 4 (LE)][CRC32 (LE)]
+     */
+    constexpr size_t HEARTBEAT_FRAME_SIZE = 1 + 2 + 4 + CRC32_SIZE;
+
+    constexpr size_t HEARTBEAT_OFFSET_SEQ       = 1; ///< シーケンス番号
+    constexpr size_t HEARTBEAT_OFFSET_TIMESTAMP = 3; ///< タイムスタンプ
+    constexpr size_t HEARTBEAT_OFFSET_CRC       = 7; ///< CRC32（先頭からここまでが対象）
+
+    /**
+     * @brief 一斉送信フレームのヘッダ長
+     * @details
+     * [種別 1][タイムスタンプ 4 (LE)][送信元MAC 6][エントリ数 1] に続けて、エントリごとに
+     * [ロボットID 1][サイズ 1][搬送データ] を並べ、最後に [CRC32 (LE)] を置く。
+     * 受信側は自分のIDのエントリ（なければ FLEET_ID_ALL のエントリ）だけを取り出す。
+     */
+    constexpr size_t FLEET_HEADER_SIZE       = 1 + 4 + 6 + 1;
+    constexpr size_t FLEET_ENTRY_HEADER_SIZE = 2;   ///< エントリのヘッダ長 [ロボットID][サイズ]
+
+    constexpr size_t FLEET_OFFSET_TIMESTAMP  = 1;   ///< タイムスタンプ
+    constexpr size_t FLEET_OFFSET_ADDRESS    = 5;   ///< 送信元MAC
+    constexpr size_t FLEET_OFFSET_COUNT      = 11;  ///< エントリ数
+    constexpr size_t FLEET_OFFSET_ENTRIES    = FLEET_HEADER_SIZE; ///< 最初のエントリ
+
+    constexpr uint8_t FLEET_ID_ALL  = 0xFF;         ///< 全ロボット宛てのエントリを示すID
+    constexpr uint8_t FLEET_ID_NONE = 0xFE;         ///< ID未設定（全ロボット宛てのエントリのみ受け取る）
+
+    /**
+     * @brief ESP-NOW の1フレームあたり最大バイト数
+     */
+    constexpr size_t MAX_FRAME_SIZE     = 250;
+
+    /**
+     * @brief 拡張フレームのヘッダ長
+     * @details
+     * [種別 1][本体長 1][本体][CRC32 (LE)]
+     * 本体の解釈はフレーム種別ごとの拡張モジュール（RPC など）に任せる。
+     * 本体長を持つため、従来形式と同じ長さを避ける詰め物があっても本体の終端が分かる。
+     */
+    constexpr size_t EXT_HEADER_SIZE    = 1 + 1;
+
+    constexpr size_t EXT_OFFSET_LENGTH  = 1;                ///< 本体長
+    constexpr size_t EXT_OFFSET_BODY    = EXT_HEADER_SIZE;  ///< 本体
+
+    /**
+     * @brief 拡張フレーム本体の最大バイト数（詰め物1バイト分を除く）
+     */
+    constexpr size_t EXT_BODY_MAX       = MAX_FRAME_SIZE - EXT_HEADER_SIZE - CRC32_SIZE - 1;
+
+    /**
+     * @brief RPC 本体のヘッダ長
+     * @details [種類 1][相関ID 2 (LE)][メソッド 1][ステータス 1] に続けて引数または応答データを置く
+     */
+    constexpr size_t RPC_HEADER_SIZE    = 1 + 2 + 1 + 1;
+
+    constexpr size_t RPC_OFFSET_KIND    = 0;    ///< 種類（RPC_KIND_*）
+    constexpr size_t RPC_OFFSET_ID      = 1;    ///< 相関ID（要求と応答で同じ値）
+    constexpr size_t RPC_OFFSET_METHOD  = 3;    ///< メソッド番号
+    constexpr size_t RPC_OFFSET_STATUS  = 4;    ///< 応答のステータス（要求では 0）
+    constexpr size_t RPC_OFFSET_PAYLOAD = RPC_HEADER_SIZE; ///< 引数または応答データ
+
+    constexpr uint8_t RPC_KIND_REQUEST  = 0x00; ///< 要求
+    constexpr uint8_t RPC_KIND_RESPONSE = 0x01; ///< 応答
+
+    /**
+     * @brief RPC の引数・応答データの最大バイト数
+     */
+    constexpr size_t RPC_PAYLOAD_MAX    = EXT_BODY_MAX - RPC_HEADER_SIZE;
+
+    /**
+     * @brief パラメータ同期の本体の種類（本体先頭1バイト）
+     * @details
+     * - 更新 : [種類 1][バッチ番号 2 (LE)][エントリ数 1] に続けて、エントリごとに
+     *          [キー 1][版番号 2 (LE)][値 4 (LE)] を並べる
+     * - 確認 : [種類 1][バッチ番号 2 (LE)]（更新を受け取ったことを返す）
+     * - 再同期要求 : [種類 1]（相手に全エントリの送信を求める）
+     */
+    constexpr uint8_t PARAM_KIND_UPDATE = 0x00; ///< 更新
+    constexpr uint8_t PARAM_KIND_ACK    = 0x01; ///< 確認
+    constexpr uint8_t PARAM_KIND_RESYNC = 0x02; ///< 再同期要求
+
+    constexpr size_t PARAM_OFFSET_KIND    = 0;  ///< 種類
+    constexpr size_t PARAM_OFFSET_BATCH   = 1;  ///< バッチ番号
+    constexpr size_t PARAM_OFFSET_COUNT   = 3;  ///< エントリ数（更新のみ）
+    constexpr size_t PARAM_UPDATE_HEADER_SIZE = 1 + 2 + 1;  ///< 更新のヘッダ長
+    constexpr size_t PARAM_ACK_SIZE       = 1 + 2;          ///< 確認の長さ
+    constexpr size_t PARAM_ENTRY_SIZE     = 1 + 2 + 4;      ///< 1エントリの長さ
+
+    constexpr size_t PARAM_ENTRY_OFFSET_KEY     = 0;    ///< キー
+    constexpr size_t PARAM_ENTRY_OFFSET_VERSION = 1;    ///< 版番号
+    constexpr size_t PARAM_ENTRY_OFFSET_VALUE   = 3;    ///< 値
+
+    /**
+     * @brief 1フレームの更新に含められる最大エントリ数
+     */
+    constexpr size_t PARAM_BATCH_MAX = (EXT_BODY_MAX - PARAM_UPDATE_HEADER_SIZE) / PARAM_ENTRY_SIZE;
+
+    /**
+     * @brief 一括転送の本体の種類（本体先頭1バイト）
+     * @details
+     * - データ : [種類 1][転送番号 1][シーケンス番号 2 (LE)][フラグ 1][データ]
+     *            最後のデータは末尾に [元のサイズ 4 (LE)][元データの CRC32 4 (LE)] を付ける
+     * - 確認   : [種類 1][転送番号 1][シーケンス番号 2 (LE)]（データを受け取ったことを返す）
+     */
+    constexpr uint8_t BULK_KIND_DATA    = 0x00; ///< データ
+    constexpr uint8_t BULK_KIND_ACK     = 0x01; ///< 確認
+
+    constexpr size_t BULK_OFFSET_KIND     = 0;  ///< 種類
+    constexpr size_t BULK_OFFSET_TRANSFER = 1;  ///< 転送番号（転送ごとに変わる）
+    constexpr size_t BULK_OFFSET_SEQ      = 2;  ///< シーケンス番号（転送の先頭が 0）
+    constexpr size_t BULK_OFFSET_FLAGS    = 4;  ///< フラグ（データのみ）
+    constexpr size_t BULK_OFFSET_PAYLOAD  = 5;  ///< データ（データのみ）
+    constexpr size_t BULK_HEADER_SIZE     = 1 + 1 + 2 + 1;  ///< データのヘッダ長
+    constexpr size_t BULK_TRAILER_SIZE    = 4 + 4;          ///< 最後のデータの末尾長
+    constexpr size_t BULK_ACK_SIZE        = 1 + 1 + 2;      ///< 確認の長さ
+
+    constexpr uint8_t BULK_FLAG_COMPRESSED = 0x01; ///< データが LZSS 圧縮されている（上位4bitが窓のビット数）
+    constexpr uint8_t BULK_FLAG_LAST       = 0x02; ///< 最後のデータ
+    constexpr unsigned BULK_FLAG_WINDOW_SHIFT = 4; ///< 窓のビット数の位置
+
+    /**
+     * @brief 1フレームのデータの最大バイト数（最後のデータの末尾分を常に空けておく）
+     */
+    constexpr size_t BULK_PAYLOAD_MAX = EXT_BODY_MAX - BULK_HEADER_SIZE - BULK_TRAILER_SIZE;
+
+    /**
+     * @brief プロトコル版
+     * @details ハンドシェイクで交換する。ハンドシェイクに応じない従来の相手は 0 とみなす
+     */
+    constexpr uint8_t PROTOCOL_VERSION = 1;
+
+    /**
+     * @brief ハンドシェイクの本体の種類（本体先頭1バイト）
+     * @details
+     * 通知・応答とも [種類 1][プロトコル版 1][対応機能 2 (LE)][最大搬送データサイズ 1][受信バッファのパケット数 2 (LE)]。
+     * 通知を受け取った側は必ず応答を返し、双方が相手の内容から同じ規則で送信形式を選ぶ。
+     * 後の版で末尾に項目を足せるよう、受信側は HELLO_BODY_SIZE より長い本体も受け付ける。
+     */
+    constexpr uint8_t HELLO_KIND_HELLO  = 0x00; ///< 通知
+    constexpr uint8_t HELLO_KIND_ACK    = 0x01; ///< 応答
+
+    constexpr size_t HELLO_OFFSET_KIND          = 0;    ///< 種類
+    constexpr size_t HELLO_OFFSET_VERSION       = 1;    ///< プロトコル版
+    constexpr size_t HELLO_OFFSET_CAPABILITIES  = 2;    ///< 対応機能（HELLO_CAP_*）
+    constexpr size_t HELLO_OFFSET_MAX_PAYLOAD   = 4;    ///< 受信できる最大搬送データサイズ
+    constexpr size_t HELLO_OFFSET_RECEIVE_SLOTS = 5;    ///< 受信バッファに保持できるパケット数
+    constexpr size_t HELLO_BODY_SIZE            = 1 + 1 + 2 + 1 + 2;    ///< 本体長
+
+    /**
+     * @brief ハンドシェイクで交換する対応機能（受け付けられるフレームの種類）
+     */
+    constexpr uint16_t HELLO_CAP_COMPACT   = 0x0001;    ///< 可変長データフレーム（FrameType::Data）
+    constexpr uint16_t HELLO_CAP_REDUNDANT = 0x0002;    ///< 冗長データフレーム（FrameType::Redundant）
+    constexpr uint16_t HELLO_CAP_PRIORITY  = 0x0004;    ///< 優先データフレーム（FrameType::Priority）
+    constexpr uint16_t HELLO_CAP_HEARTBEAT = 0x0008;    ///< 生存通知フレーム（FrameType::Heartbeat）
+    constexpr uint16_t HELLO_CAP_CRC16     = 0x0010;    ///< 型付きフレームの CRC16
+    constexpr uint16_t HELLO_CAP_NO_CHECK  = 0x0020;    ///< 型付きフレームの検査省略
+    constexpr uint16_t HELLO_CAPS_ALL      = 0x003F;    ///< この版が対応する機能すべて
+
+    /**
+     * @brief 暗号化Peerとして登録しているか（機能ではなく状態。双方が立てた場合だけ弱い検査を選べる）
+     */
+    constexpr uint16_t HELLO_CAP_ENCRYPTED = 0x8000;
+}
+}
+
+#endif /* ROBO_WCOM_WIRE_H */
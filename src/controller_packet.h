@@ -77,4 +77,19 @@ typedef struct __attribute__((packed)) RoboCommand_st
     uint16_t hp;  ///< ロボットのHP（体力・耐久値）
 } RoboCommand_t;
 
+/**
+ * @brief 武器フラグ（WEAPON_FLAGS.FLAGS）のビット位置
+ *
+ * ビットフィールドの割り当て順はコンパイラ依存のため、
+ * ESP32 以外の環境ではこちらのマスクで FLAGS を読み書きする。
+ */
+#define WEAPON_FLAG_WPL03   (1u << 0)   ///< 左武器4
+#define WEAPON_FLAG_WPL02   (1u << 1)   ///< 左武器3
+#define WEAPON_FLAG_WPL01   (1u << 2)   ///< 左武器2
+#define WEAPON_FLAG_WPL00   (1u << 3)   ///< 左武器1
+#define WEAPON_FLAG_WPR03   (1u << 4)   ///< 右武器4
+#define WEAPON_FLAG_WPR02   (1u << 5)   ///< 右武器3
+#define WEAPON_FLAG_WPR01   (1u << 6)   ///< 右武器2
+#define WEAPON_FLAG_WPR00   (1u << 7)   ///< 右武器1
+
 #endif /* __CONTROLLER_PACKET_H__ */
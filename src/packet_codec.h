@@ -0,0 +1,83 @@
+#ifndef __PACKET_CODEC_H__
+#define __PACKET_CODEC_H__
+#include <stddef.h>
+#include <stdint.h>
+#include <ROBO_WCOM_Codec.h>
+#include "controller_packet.h"
+#include "robo_packet.h"
+
+/**
+ * @brief RoboCommand_t の可搬な送信形式（全精度）
+ *
+ * 各フィールドをリトルエンディアンで宣言順に並べる。ESP32 上の packed 構造体の
+ * メモリ配置と同一のバイト列になるため、従来の memcpy 送信と互換。
+ * 武器フラグ・スイッチは整数として転送し、ビットの意味は WEAPON_FLAG_* / MANSWICH_* で解釈する。
+ */
+typedef ROBO_WCOM::Codec::Schema<RoboCommand_t,
+    ROBO_WCOM::Codec::F32<offsetof(RoboCommand_t, velocity.x)>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboCommand_t, velocity.y)>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboCommand_t, velocity.omega)>,
+    ROBO_WCOM::Codec::U8<offsetof(RoboCommand_t, WEAPON_FLAGS.FLAGS)>,
+    ROBO_WCOM::Codec::U32<offsetof(RoboCommand_t, RGBLED.RGB_DATAS)>,
+    ROBO_WCOM::Codec::U16<offsetof(RoboCommand_t, hp)>
+> RoboCommandPortable;
+
+/**
+ * @brief RoboStatus_t の可搬な送信形式（全精度）
+ *
+ * RoboCommandPortable と同様、ESP32 上の memcpy 送信と同一のバイト列になる。
+ */
+typedef ROBO_WCOM::Codec::Schema<RoboStatus_t,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, Power.voltage)>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, Power.current)>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, Power.wh)>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[0])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[1])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[2])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[3])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[4])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[5])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[6])>,
+    ROBO_WCOM::Codec::F32<offsetof(RoboStatus_t, motors[7])>,
+    ROBO_WCOM::Codec::U8<offsetof(RoboStatus_t, WEAPON_FLAGS.FLAGS)>,
+    ROBO_WCOM::Codec::U16<offsetof(RoboStatus_t, MANSWICH.SWITCHES)>
+> RoboStatusPortable;
+
+/**
+ * @brief RoboCommand_t のコンパクト送信形式
+ *
+ * 速度指令を int16 固定小数点へ量子化し、19バイトを13バイトへ縮める。
+ * 分解能は約 0.003（±100 の範囲）。
+ */
+typedef ROBO_WCOM::Codec::Schema<RoboCommand_t,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboCommand_t, velocity.x),     -100, 100>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboCommand_t, velocity.y),     -100, 100>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboCommand_t, velocity.omega), -100, 100>,
+    ROBO_WCOM::Codec::U8<offsetof(RoboCommand_t, WEAPON_FLAGS.FLAGS)>,
+    ROBO_WCOM::Codec::U32<offsetof(RoboCommand_t, RGBLED.RGB_DATAS)>,
+    ROBO_WCOM::Codec::U16<offsetof(RoboCommand_t, hp)>
+> RoboCommandCompact;
+
+/**
+ * @brief RoboStatus_t のコンパクト送信形式
+ *
+ * 電源情報・モータ出力を int16 固定小数点へ量子化し、47バイトを25バイトへ縮める。
+ * モータ出力は速度指令の和差（±200）を想定。
+ */
+typedef ROBO_WCOM::Codec::Schema<RoboStatus_t,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, Power.voltage),    0,  20>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, Power.current),    0, 100>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, Power.wh),         0, 100>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[0]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[1]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[2]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[3]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[4]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[5]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[6]),     -200, 200>,
+    ROBO_WCOM::Codec::Fixed16<offsetof(RoboStatus_t, motors[7]),     -200, 200>,
+    ROBO_WCOM::Codec::U8<offsetof(RoboStatus_t, WEAPON_FLAGS.FLAGS)>,
+    ROBO_WCOM::Codec::U16<offsetof(RoboStatus_t, MANSWICH.SWITCHES)>
+> RoboStatusCompact;
+
+#endif /* __PACKET_CODEC_H__ */
@@ -90,5 +90,35 @@ typedef struct __attribute__((packed)) RoboStatus_st
     } MANSWICH;
 } RoboStatus_t;
 
+/**
+ * @brief 操作スイッチ（MANSWICH.SWITCHES）のビット位置
+ *
+ * ビットフィールドの割り当て順はコンパイラ依存のため、
+ * ESP32 以外の環境ではこちらのマスクで SWITCHES を読み書きする。
+ * 武器フラグのマスクは controller_packet.h の WEAPON_FLAG_* を共用する。
+ */
+#define MANSWICH_S4         (1u << 0)   ///< スイッチ4
+#define MANSWICH_S3         (1u << 1)   ///< スイッチ3
+#define MANSWICH_S2         (1u << 2)   ///< スイッチ2
+#define MANSWICH_S1         (1u << 3)   ///< スイッチ1
+#define MANSWICH_SQUARE     (1u << 4)   ///< 四角ボタン
+#define MANSWICH_CIRCLE     (1u << 5)   ///< 丸ボタン
+#define MANSWICH_CROSS      (1u << 6)   ///< ×ボタン
+#define MANSWICH_TRIANGLE   (1u << 7)   ///< △ボタン
+#define MANSWICH_LEFT       (1u << 8)   ///< 左
+#define MANSWICH_RIGHT      (1u << 9)   ///< 右
+#define MANSWICH_DOWN       (1u << 10)  ///< 下
+#define MANSWICH_UP         (1u << 11)  ///< 上
+
+/**
+ * @brief ロボットが受け付ける RPC のメソッド番号（ROBO_WCOM_Rpc.h）
+ */
+#define ROBO_RPC_READ_POWER 0x01        ///< 電源情報（RoboStatus_t::Power と同じ並び）を返す
+
+/**
+ * @brief コントローラとロボットで共有するパラメータのキー（ROBO_WCOM_Param.h）
+ */
+#define ROBO_PARAM_MOTOR_LIMIT 0x01     ///< モータ出力の上限（float、コントローラが設定）
+
 
 #endif /* __ROBO_PACKET_H__ */
@@ -0,0 +1,199 @@
+/**
+ * @file wcom_bridge_cli.cpp
+ * @brief シリアルブリッジの PC側 CLI
+ * @details
+ * ブリッジから届いたメッセージを1行1メッセージの CSV で標準出力へ書く。
+ * 標準入力からは次のコマンドを受け付ける（データは16進）。
+ *
+ *   send 0102A0FF   … パケット送信
+ *   prio 00         … 優先パケット送信
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I lib/ROBO_WCOM -I tools/bridge -o wcom_bridge \
+ *       tools/bridge/wcom_bridge_cli.cpp tools/bridge/wcom_bridge_host.cpp
+ * 使い方:
+ *   wcom_bridge /dev/ttyUSB0 [baud=921600]
+ *
+ * 実機がない場合は pty を開いたプロセスをデバイス代わりにして、スレーブ側のパスを渡せばよい。
+ * wcom_bridge_pty.cpp は、PC上でビルドした BridgeService() を pty のマスター側で動かしてこの構成を試す。
+ */
+#include "wcom_bridge_host.h"
+#include "ROBO_WCOM_Wire.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace ROBO_WCOM;
+
+/**
+ * @brief リンク状態の表示名（ROBO_WCOM::LinkState と同じ並び）
+ */
+static const char* linkName(uint8_t state)
+{
+    static const char* const names[] = { "Up", "Degraded", "Lost", "Recovering" };
+    return (state < sizeof(names) / sizeof(names[0])) ? names[state] : "Unknown";
+}
+
+/**
+ * @brief 受信メッセージを CSV で出力
+ */
+static void printMessage(const BridgeHost::Message& message, void*)
+{
+    switch (message.type)
+    {
+    case Bridge::MessageType::Packet:
+    {
+        if (message.size < Bridge::PACKET_BODY_HEADER)
+        {
+            break;
+        }
+        const uint8_t* mac = message.body + 4;
+        uint8_t size = message.body[Bridge::PACKET_BODY_HEADER - 1];
+        printf("packet,%u,%02X:%02X:%02X:%02X:%02X:%02X,%u,",
+               Codec::loadLE32(message.body), mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], size);
+        for (size_t i = Bridge::PACKET_BODY_HEADER; i < message.size; ++i)
+        {
+            printf("%02X", message.body[i]);
+        }
+        printf("\n");
+        break;
+    }
+    case Bridge::MessageType::Link:
+        if (message.size >= 2)
+        {
+            printf("link,%s,%d\n", linkName(message.body[0]), static_cast<int8_t>(message.body[1]));
+        }
+        break;
+    case Bridge::MessageType::Ack:
+        if (message.size >= 2)
+        {
+            printf("ack,0x%02X,%d\n", message.body[0], static_cast<int8_t>(message.body[1]));
+        }
+        break;
+    default:
+        printf("unknown,0x%02X,%zu\n", static_cast<uint8_t>(message.type), message.size);
+        break;
+    }
+    fflush(stdout);
+}
+
+/**
+ * @brief 16進文字列をバイト列へ変換
+ * @return 変換したバイト数（不正な場合は -1）
+ */
+static int parseHex(const char* text, uint8_t* out, size_t max)
+{
+    size_t n = 0;
+    while (*text == ' ')
+    {
+        text++;
+    }
+    while (text[0] && text[0] != '\n' && text[0] != '\r')
+    {
+        char byte[3] = { text[0], text[1], 0 };
+        char* end;
+        if (!text[1] || n >= max)
+        {
+            return -1;
+        }
+        out[n++] = static_cast<uint8_t>(strtoul(byte, &end, 16));
+        if (*end)
+        {
+            return -1;
+        }
+        text += 2;
+    }
+    return static_cast<int>(n);
+}
+
+/**
+ * @brief 標準入力の1行を実行
+ */
+static void runCommand(BridgeHost::Port& port, const char* line)
+{
+    uint8_t data[Wire::CARRIED_MAX_SIZE];
+    Bridge::MessageType type;
+    if (strncmp(line, "send", 4) == 0)
+    {
+        type = Bridge::MessageType::Send;
+    }
+    else if (strncmp(line, "prio", 4) == 0)
+    {
+        type = Bridge::MessageType::SendPriority;
+    }
+    else
+    {
+        fprintf(stderr, "unknown command: %s", line);
+        return;
+    }
+    int n = parseHex(line + 4, data, sizeof(data));
+    if (n < 0 || !port.send(type, data, static_cast<size_t>(n)))
+    {
+        fprintf(stderr, "bad command: %s", line);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s device [baud=921600]\n", argv[0]);
+        return 2;
+    }
+    uint32_t baud = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 921600;
+
+    BridgeHost::Port port;
+    if (!port.open(argv[1], baud))
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    char line[1024];
+    size_t lineLen = 0;
+    bool stdinOpen = true;
+    for (;;)
+    {
+        pollfd fds[2] = { { port.fd(), POLLIN, 0 }, { STDIN_FILENO, POLLIN, 0 } };
+        if (::poll(fds, stdinOpen ? 2 : 1, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            if (port.poll(printMessage, nullptr) < 0 || (fds[0].revents & (POLLHUP | POLLERR)))
+            {
+                break;
+            }
+        }
+        if (stdinOpen && (fds[1].revents & (POLLIN | POLLHUP)))
+        {
+            char c;
+            ssize_t n = ::read(STDIN_FILENO, &c, 1);
+            if (n <= 0)
+            {
+                stdinOpen = false;
+                continue;
+            }
+            if (lineLen < sizeof(line) - 1)
+            {
+                line[lineLen++] = c;
+            }
+            if (c == '\n')
+            {
+                line[lineLen] = 0;
+                runCommand(port, line);
+                lineLen = 0;
+            }
+        }
+    }
+    fprintf(stderr, "disconnected (%u bad messages)\n", port.errors());
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file wcom_bridge_host.cpp
+ * @brief シリアルブリッジの PC側（Linux）ライブラリの実装
+ */
+#include "wcom_bridge_host.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace ROBO_WCOM
+{
+namespace BridgeHost
+{
+    /**
+     * @brief 通信速度を termios の定数へ変換
+     */
+    static speed_t toSpeed(uint32_t baud)
+    {
+        switch (baud)
+        {
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        case 1000000: return B1000000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        default:      return B0;
+        }
+    }
+
+    Port::Port() : fd_(-1) {}
+
+    Port::~Port()
+    {
+        close();
+    }
+
+    bool Port::open(const char* path, uint32_t baud)
+    {
+        close();
+        speed_t speed = toSpeed(baud);
+        if (speed == B0)
+        {
+            errno = EINVAL;
+            return false;
+        }
+        fd_ = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+
+        termios tio;
+        if (tcgetattr(fd_, &tio) != 0)
+        {
+            close();
+            return false;
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        if (tcsetattr(fd_, TCSANOW, &tio) != 0)
+        {
+            close();
+            return false;
+        }
+        tcflush(fd_, TCIOFLUSH);
+        decoder_ = Bridge::StreamDecoder();
+        return true;
+    }
+
+    void Port::close()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int Port::poll(MessageHandler handler, void* context)
+    {
+        uint8_t buf[4096];
+        int messages = 0;
+        for (;;)
+        {
+            ssize_t n = ::read(fd_, buf, sizeof(buf));
+            if (n < 0)
+            {
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? messages : -1;
+            }
+            if (n == 0)
+            {
+                return messages;
+            }
+            for (ssize_t i = 0; i < n; ++i)
+            {
+                if (decoder_.push(buf[i]))
+                {
+                    Message message = { decoder_.type(), decoder_.body(), decoder_.bodySize() };
+                    handler(message, context);
+                    messages++;
+                }
+            }
+        }
+    }
+
+    bool Port::send(Bridge::MessageType type, const uint8_t* body, size_t bodyLen)
+    {
+        uint8_t encoded[Bridge::MAX_ENCODED_SIZE];
+        size_t len = Bridge::encodeMessage(type, body, bodyLen, encoded);
+        if (len == 0)
+        {
+            return false;
+        }
+        size_t written = 0;
+        while (written < len)
+        {
+            ssize_t n = ::write(fd_, encoded + written, len - written);
+            if (n < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    tcdrain(fd_);
+                    continue;
+                }
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+}
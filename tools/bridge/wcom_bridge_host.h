@@ -0,0 +1,90 @@
+#ifndef WCOM_BRIDGE_HOST_H
+#define WCOM_BRIDGE_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ROBO_WCOM_BridgeFormat.h"
+
+/**
+ * @file wcom_bridge_host.h
+ * @brief シリアルブリッジの PC側（Linux）ライブラリ
+ * @details
+ * termios でシリアルデバイスを raw モードに設定し、ROBO_WCOM_BridgeFormat.h の
+ * メッセージを送受信する。デバイスの代わりに pty を開いても同じように動作するため、
+ * 実機なしでの試験にも使える。
+ */
+namespace ROBO_WCOM
+{
+namespace BridgeHost
+{
+    /**
+     * @brief 受信したメッセージ
+     */
+    struct Message {
+        Bridge::MessageType type;   ///< メッセージ種別
+        const uint8_t* body;        ///< 本体
+        size_t size;                ///< 本体長
+    };
+
+    /**
+     * @brief メッセージ受信時に呼ばれるハンドラ
+     */
+    typedef void (*MessageHandler)(const Message& message, void* context);
+
+    /**
+     * @brief ブリッジと接続したシリアルポート
+     */
+    class Port
+    {
+    public:
+        Port();
+        ~Port();
+
+        /**
+         * @brief シリアルデバイスを開く
+         * @param path デバイスパス（/dev/ttyUSB0、pty のスレーブ側など）
+         * @param baud 通信速度（115200 / 230400 / 460800 / 921600 / 1000000 / 2000000 など）
+         * @return true:成功 / false:失敗（errno を参照）
+         */
+        bool open(const char* path, uint32_t baud);
+
+        /**
+         * @brief シリアルデバイスを閉じる
+         */
+        void close();
+
+        /**
+         * @brief ファイルディスクリプタ（poll() 用）
+         */
+        int fd() const { return fd_; }
+
+        /**
+         * @brief 受信済みのバイトを読み、揃ったメッセージごとにハンドラを呼ぶ
+         * @param handler ハンドラ
+         * @param context ハンドラへ渡す任意のポインタ
+         * @return 処理したメッセージ数（切断・エラー時は -1）
+         */
+        int poll(MessageHandler handler, void* context);
+
+        /**
+         * @brief メッセージを送信
+         * @param type    メッセージ種別（Send / SendPriority）
+         * @param body    本体
+         * @param bodyLen 本体長
+         * @return true:成功 / false:失敗
+         */
+        bool send(Bridge::MessageType type, const uint8_t* body, size_t bodyLen);
+
+        /**
+         * @brief 破棄したメッセージ数（フレーミング不正・CRC不一致）
+         */
+        uint32_t errors() const { return decoder_.errors(); }
+
+    private:
+        int fd_;                            ///< ファイルディスクリプタ
+        Bridge::StreamDecoder decoder_;     ///< メッセージの切り出し
+    };
+}
+}
+
+#endif /* WCOM_BRIDGE_HOST_H */
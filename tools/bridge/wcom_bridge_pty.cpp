@@ -0,0 +1,381 @@
+/**
+ * @file wcom_bridge_pty.cpp
+ * @brief シリアルブリッジを pty 越しに往復させて確かめる PC側ツール
+ * @details
+ * pty のマスター側を PC上でビルドした BridgeService() のシリアルとし、スレーブ側を CLI と同じ
+ * BridgeHost::Port で開く。実機なしで、デバイス側とPC側の実装をそのまま繋いで次を確かめる。
+ *
+ * - 受信させたフレームが Packet メッセージとして届き、タイムスタンプ・送信元・搬送データが一致する
+ * - リンク状態の変化が Link メッセージとして届く
+ * - Send / SendPriority コマンドが実行されて無線フレームになり、Ack で結果が返る
+ * - 不正なバイト列（区切りのない断片・CRC不一致・区切りだけ）を挟んでも次の区切りで同期し直し、
+ *   後続のメッセージを取りこぼさない（PC→デバイス・デバイス→PC の両方向）
+ *
+ * 1つでも外れれば終了コード 1 を返す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -pthread -I tools/host -I tools/bridge -I lib/ROBO_WCOM -I src -o wcom_bridge_pty \
+ *       tools/bridge/wcom_bridge_pty.cpp tools/bridge/wcom_bridge_host.cpp \
+ *       tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_bridge_pty
+ */
+#include <Arduino.h>
+#include "wcom_bridge_host.h"
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Bridge.h"
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_Wire.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t BAUD          = 921600;  ///< スレーブ側に設定する通信速度（pty では意味を持たない）
+constexpr int      WAIT_ROUNDS   = 200;     ///< メッセージを待つ最大回数
+constexpr int      WAIT_STEP_MS  = 5;       ///< 1回あたりの待ち時間
+constexpr size_t   MESSAGES_MAX  = 32;      ///< 控えておく受信メッセージ数
+
+static const uint8_t OWN_ADDR[6]  = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+
+/**
+ * @brief PC側で受信したメッセージの控え
+ */
+struct Received {
+    Bridge::MessageType type;               ///< メッセージ種別
+    uint8_t body[Bridge::MAX_BODY_SIZE];    ///< 本体
+    size_t  size;                           ///< 本体長
+};
+
+static Received received[MESSAGES_MAX];     ///< 受信メッセージ
+static size_t   receivedCount = 0;          ///< received の件数
+static uint8_t  airFrame[Wire::MAX_FRAME_SIZE]; ///< 最後に無線へ送ったフレーム
+static size_t   airLength = 0;              ///< airFrame の長さ
+static uint32_t airFrames = 0;              ///< 無線へ送ったフレーム数
+static int      failures = 0;               ///< 外れた確認の数
+
+/**
+ * @brief pty のマスター側を Arduino の Stream として見せる（デバイス側のシリアル）
+ */
+class PtyStream : public Stream
+{
+public:
+    explicit PtyStream(int fd) : fd_(fd), pos_(0), len_(0) {}
+
+    int available(void) override
+    {
+        fill();
+        return static_cast<int>(len_ - pos_);
+    }
+
+    int read(void) override
+    {
+        fill();
+        return (pos_ < len_) ? buf_[pos_++] : -1;
+    }
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        size_t written = 0;
+        while (written < size)
+        {
+            ssize_t n = ::write(fd_, buffer + written, size - written);
+            if (n < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    break;
+                }
+                pollfd pfd = { fd_, POLLOUT, 0 };
+                ::poll(&pfd, 1, WAIT_STEP_MS);
+                continue;
+            }
+            written += static_cast<size_t>(n);
+        }
+        return written;
+    }
+
+private:
+    /**
+     * @brief 読み終えていれば、届いている分を読み込む
+     */
+    void fill(void)
+    {
+        if (pos_ < len_)
+        {
+            return;
+        }
+        ssize_t n = ::read(fd_, buf_, sizeof(buf_));
+        pos_ = 0;
+        len_ = (n > 0) ? static_cast<size_t>(n) : 0;
+    }
+
+    int     fd_;            ///< マスター側のファイルディスクリプタ
+    uint8_t buf_[256];      ///< 読み込んだバイト
+    size_t  pos_;           ///< buf_ の次に返す位置
+    size_t  len_;           ///< buf_ の有効長
+};
+
+/**
+ * @brief esp_now_send() のフック。無線へ送ったフレームを控える
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    memcpy(airFrame, data, len);
+    airLength = len;
+    airFrames++;
+}
+
+/**
+ * @brief 受信メッセージを控える
+ */
+static void collect(const BridgeHost::Message& message, void*)
+{
+    if (receivedCount < MESSAGES_MAX && message.size <= Bridge::MAX_BODY_SIZE)
+    {
+        Received& r = received[receivedCount++];
+        r.type = message.type;
+        memcpy(r.body, message.body, message.size);
+        r.size = message.size;
+    }
+}
+
+/**
+ * @brief 確認結果を表示し、外れた数を数える
+ */
+static void expect(bool ok, const char* what)
+{
+    printf("  %-56s %s\n", what, ok ? "ok" : "NG");
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+/**
+ * @brief BridgeService() を回しながら、PC側に count 件のメッセージが揃うまで待つ
+ */
+static bool serviceUntil(BridgeHost::Port& port, size_t count)
+{
+    for (int i = 0; i < WAIT_ROUNDS; ++i)
+    {
+        BridgeService(millis());
+        if (port.poll(collect, nullptr) < 0)
+        {
+            return false;
+        }
+        if (receivedCount >= count)
+        {
+            return true;
+        }
+        usleep(WAIT_STEP_MS * 1000);
+    }
+    return false;
+}
+
+/**
+ * @brief 通信相手から届いたことにする従来形式のフレームを受信させる
+ */
+static void injectPeerFrame(uint32_t timestamp, const uint8_t* data, uint8_t size)
+{
+    uint8_t frame[Wire::LEGACY_FRAME_SIZE] = {};
+    Codec::storeLE32(frame, timestamp);
+    memcpy(frame + 4, PEER_ADDR, sizeof(PEER_ADDR));
+    frame[Wire::PACKET_HEADER_SIZE - 1] = size;
+    memcpy(frame + Wire::LEGACY_OFFSET_CARRIED, data, size);
+    Codec::storeLE32(frame + Wire::LEGACY_OFFSET_CRC, Codec::crc32(frame, Wire::LEGACY_OFFSET_CRC));
+    InjectFrame(frame, static_cast<int>(sizeof(frame)));
+}
+
+/**
+ * @brief 控えたメッセージが、指定の内容の Packet か
+ */
+static bool isPacket(const Received& r, uint32_t timestamp, const uint8_t* data, uint8_t size)
+{
+    return r.type == Bridge::MessageType::Packet && r.size == Bridge::PACKET_BODY_HEADER + size &&
+           Codec::loadLE32(r.body) == timestamp && memcmp(r.body + 4, PEER_ADDR, sizeof(PEER_ADDR)) == 0 &&
+           r.body[Bridge::PACKET_BODY_HEADER - 1] == size &&
+           memcmp(r.body + Bridge::PACKET_BODY_HEADER, data, size) == 0;
+}
+
+/**
+ * @brief 控えたメッセージが、指定のコマンドの Ack か
+ */
+static bool isAck(const Received& r, Bridge::MessageType command, Status status)
+{
+    return r.type == Bridge::MessageType::Ack && r.size == 2 && r.body[0] == static_cast<uint8_t>(command) &&
+           static_cast<int8_t>(r.body[1]) == static_cast<int8_t>(status);
+}
+
+/**
+ * @brief 無線へ最後に送ったフレームが data を搬送しているか（通常は従来形式、優先は優先データフレーム）
+ */
+static bool airCarries(const uint8_t* data, uint8_t size, bool priority = false)
+{
+    if (priority)
+    {
+        return airFrame[Wire::DATA_OFFSET_TYPE] == static_cast<uint8_t>(Wire::FrameType::Priority) &&
+               airFrame[Wire::DATA_OFFSET_SIZE] == size && memcmp(airFrame + Wire::DATA_OFFSET_CARRIED, data, size) == 0;
+    }
+    return airLength == Wire::LEGACY_FRAME_SIZE && airFrame[Wire::PACKET_HEADER_SIZE - 1] == size &&
+           memcmp(airFrame + Wire::LEGACY_OFFSET_CARRIED, data, size) == 0;
+}
+
+/**
+ * @brief デバイス→PC: 受信パケットとリンク状態の転送
+ */
+static void checkForward(BridgeHost::Port& port)
+{
+    printf("device -> pc\n");
+    const uint8_t data[3][4] = { { 0x10, 0x00, 0x20 }, { 0x00, 0x00, 0x00, 0x00 }, { 0xFF } };
+    const uint8_t sizes[3] = { 3, 4, 1 };
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        injectPeerFrame(1000 + i, data[i], sizes[i]);
+    }
+    receivedCount = 0;
+    bool arrived = serviceUntil(port, 4);
+    expect(arrived, "three packets and a link message arrive");
+    bool packets = arrived;
+    for (size_t i = 0; packets && i < 3; ++i)
+    {
+        packets = isPacket(received[i], 1000 + i, data[i], sizes[i]);
+    }
+    expect(packets, "packet timestamp, sender and data match");
+    expect(arrived && received[3].type == Bridge::MessageType::Link && received[3].size == 2 &&
+           received[3].body[0] == static_cast<uint8_t>(LinkState::Up), "link message reports Up");
+}
+
+/**
+ * @brief PC→デバイス: コマンドの実行と Ack
+ */
+static void checkCommands(BridgeHost::Port& port)
+{
+    printf("pc -> device\n");
+    const uint8_t data[5] = { 0xC0, 0x00, 0xFE, 0x00, 0x01 };
+    const uint8_t stop[1] = { 0x00 };
+
+    receivedCount = 0;
+    airFrames = 0;
+    port.send(Bridge::MessageType::Send, data, sizeof(data));
+    bool arrived = serviceUntil(port, 1);
+    expect(arrived && isAck(received[0], Bridge::MessageType::Send, Status::Ok), "send is acknowledged with Ok");
+    expect(airFrames == 1 && airCarries(data, sizeof(data)), "send goes out on the air with the data");
+
+    receivedCount = 0;
+    airFrames = 0;
+    port.send(Bridge::MessageType::SendPriority, stop, sizeof(stop));
+    arrived = serviceUntil(port, 1);
+    expect(arrived && isAck(received[0], Bridge::MessageType::SendPriority, Status::Ok),
+           "priority send is acknowledged with Ok");
+    expect(airFrames == 1 && airCarries(stop, sizeof(stop), true), "priority send goes out on the air");
+
+    uint8_t oversize[CARRIED_DATA_MAX_SIZE + 1] = {};
+    receivedCount = 0;
+    airFrames = 0;
+    port.send(Bridge::MessageType::Send, oversize, sizeof(oversize));
+    arrived = serviceUntil(port, 1);
+    expect(arrived && isAck(received[0], Bridge::MessageType::Send, Status::InvalidArg) && airFrames == 0,
+           "oversize send is refused with InvalidArg");
+}
+
+/**
+ * @brief 不正なバイト列の後で同期し直すか（両方向）
+ */
+static void checkResync(BridgeHost::Port& port, int master)
+{
+    printf("resync\n");
+    // 区切りのない断片、CRC を壊したメッセージ、区切りだけ、の順に混ぜる
+    uint8_t garbage[Bridge::MAX_ENCODED_SIZE * 2];
+    size_t len = 0;
+    const uint8_t noise[] = { 0x05, 0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97 };
+    memcpy(garbage, noise, sizeof(noise));
+    len += sizeof(noise);
+    garbage[len++] = 0x00;
+    const uint8_t body[2] = { 0x12, 0x34 };
+    size_t corrupt = Bridge::encodeMessage(Bridge::MessageType::Send, body, sizeof(body), garbage + len);
+    garbage[len + 2] ^= 0x40;
+    len += corrupt;
+    garbage[len++] = 0x00;
+    garbage[len++] = 0x00;
+
+    // PC→デバイス
+    BridgeStats before{};
+    GetBridgeStats(&before);
+    if (::write(port.fd(), garbage, len) != static_cast<ssize_t>(len))
+    {
+        expect(false, "write garbage to the device side");
+        return;
+    }
+    const uint8_t data[2] = { 0xAB, 0xCD };
+    receivedCount = 0;
+    airFrames = 0;
+    port.send(Bridge::MessageType::Send, data, sizeof(data));
+    bool arrived = serviceUntil(port, 1);
+    BridgeStats after{};
+    GetBridgeStats(&after);
+    expect(arrived && isAck(received[0], Bridge::MessageType::Send, Status::Ok) && airFrames == 1 &&
+           airCarries(data, sizeof(data)), "device executes the command after garbage");
+    expect(after.decodeErrors > before.decodeErrors && after.commands == before.commands + 1,
+           "device counts the garbage and runs nothing for it");
+
+    // デバイス→PC
+    uint32_t errorsBefore = port.errors();
+    if (::write(master, garbage, len) != static_cast<ssize_t>(len))
+    {
+        expect(false, "write garbage to the pc side");
+        return;
+    }
+    injectPeerFrame(2000, data, sizeof(data));
+    receivedCount = 0;
+    arrived = serviceUntil(port, 1);
+    expect(arrived && receivedCount == 1 && isPacket(received[0], 2000, data, sizeof(data)),
+           "pc decodes the packet after garbage");
+    expect(port.errors() > errorsBefore, "pc counts the garbage");
+}
+
+int main()
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        fprintf(stderr, "pty: %s\n", strerror(errno));
+        return 1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    const char* slave = ptsname(master);
+
+    BridgeHost::Port port;
+    if (!slave || !port.open(slave, BAUD))
+    {
+        fprintf(stderr, "%s: %s\n", slave ? slave : "ptsname", strerror(errno));
+        return 1;
+    }
+    printf("pty %s\n", slave);
+
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(OWN_ADDR, PEER_ADDR, millis(), 1000);
+    PtyStream serial(master);
+    BridgeBegin(serial);
+
+    checkForward(port);
+    checkCommands(port);
+    checkResync(port, master);
+
+    port.close();
+    ::close(master);
+    printf("%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#ifndef ROBO_WCOM_HOST_ARDUINO_H
+#define ROBO_WCOM_HOST_ARDUINO_H
+
+/**
+ * @file Arduino.h
+ * @brief PC上で ROBO_WCOM をビルドするための最小限の Arduino 互換層
+ * @details
+ * millis() / micros() は実時間ではなく HostShim::SetMicros() で進める仮想時計を返す。
+ * 再生ツールなどでキャプチャの時刻どおりに受信処理を再現するために使う。
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace HostShim
+{
+    /**
+     * @brief 仮想時計を設定
+     * @param nowMicros 現在時刻（マイクロ秒）
+     */
+    void SetMicros(uint32_t nowMicros);
+
+    /**
+     * @brief esp_now_send() に渡されたフレームを受け取るフック
+     */
+    typedef void (*SendHook)(const uint8_t* dest, const uint8_t* data, size_t len);
+
+    /**
+     * @brief 送信フックを設定（nullptr で解除）
+     * @details 2つのプロセスを繋いで送受信をシミュレーションする場合などに使う
+     */
+    void SetSendHook(SendHook hook);
+
+    /**
+     * @brief 送信完了待ちにできるフレーム数を設定（0 で無制限）
+     * @details 完了待ちがこの数に達している間、esp_now_send() は失敗を返す（送信キューの満杯を模擬）
+     */
+    void SetSendQueueLimit(size_t limit);
+
+    /**
+     * @brief 最も古い送信完了待ちのフレームを完了させ、送信完了コールバックを呼ぶ
+     * @param mac       送信先MAC
+     * @param delivered true:相手へ届いた / false:届かなかった
+     */
+    void CompleteSend(const uint8_t* mac, bool delivered);
+
+    /**
+     * @brief 送信元MAC付きでフレームを受信させる（登録された受信コールバックを呼ぶ）
+     * @details InjectFrame() は送信元を通信相手とみなすため、送信元による判定を試す場合に使う
+     * @param mac  送信元MAC
+     * @param data 受信フレーム
+     * @param len  受信フレーム長
+     */
+    void Receive(const uint8_t* mac, const uint8_t* data, int len);
+}
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+long random(long low, long high);
+
+/**
+ * @brief Arduino の Print 互換クラス
+ */
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t n = 0;
+        while (n < size && write(buffer[n]))
+        {
+            n++;
+        }
+        return n;
+    }
+    size_t print(const char* s)
+    {
+        return write(reinterpret_cast<const uint8_t*>(s), strlen(s));
+    }
+    size_t println(const char* s)
+    {
+        return print(s) + print("\r\n");
+    }
+    size_t println(void)
+    {
+        return print("\r\n");
+    }
+};
+
+/**
+ * @brief Arduino の Stream 互換クラス
+ */
+class Stream : public Print
+{
+public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+};
+
+/**
+ * @brief 標準出力へ書き出すシリアル
+ */
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available(void) override { return 0; }
+    int read(void) override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* ROBO_WCOM_HOST_ARDUINO_H */
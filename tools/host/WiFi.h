@@ -0,0 +1,18 @@
+#ifndef ROBO_WCOM_HOST_WIFI_H
+#define ROBO_WCOM_HOST_WIFI_H
+
+/**
+ * @file WiFi.h
+ * @brief PC上でビルドするための WiFi 互換層（何もしない）
+ */
+#define WIFI_STA 1
+
+class WiFiClass
+{
+public:
+    bool mode(int) { return true; }
+};
+
+extern WiFiClass WiFi;
+
+#endif /* ROBO_WCOM_HOST_WIFI_H */
@@ -0,0 +1,48 @@
+#ifndef ROBO_WCOM_HOST_ESP_NOW_H
+#define ROBO_WCOM_HOST_ESP_NOW_H
+
+/**
+ * @file esp_now.h
+ * @brief PC上でビルドするための ESP-NOW 互換層
+ * @details
+ * 送信は HostShim::SetSendQueueLimit() の上限に達していなければ成功し、
+ * HostShim::SetSendHook() のフックがあればそこへ渡す。送信完了コールバックは HostShim::CompleteSend() で呼ぶ。
+ * 受信は ROBO_WCOM::InjectFrame() で直接投入する。暗号化の設定は受け付けるだけで、フレームはそのまま渡す。
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+#define ESP_NOW_ETH_ALEN     6
+#define ESP_NOW_KEY_LEN      16
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef enum {
+    ESP_NOW_SEND_SUCCESS = 0,
+    ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+typedef struct {
+    uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+    uint8_t lmk[ESP_NOW_KEY_LEN];
+    uint8_t channel;
+    int     ifidx;
+    bool    encrypt;
+    void*   priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac, const uint8_t* data, int len);
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac, esp_now_send_status_t status);
+
+esp_err_t esp_now_init(void);
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_mod_peer(const esp_now_peer_info_t* peer);
+esp_err_t esp_now_set_pmk(const uint8_t* pmk);
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len);
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb);
+
+#endif /* ROBO_WCOM_HOST_ESP_NOW_H */
@@ -0,0 +1,116 @@
+/**
+ * @file host_shim.cpp
+ * @brief PC上でビルドするための Arduino / ESP-NOW 互換層の実装
+ */
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <cstdio>
+#include <cstdlib>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+
+static uint32_t virtualMicros = 0;  ///< 仮想時計
+static HostShim::SendHook sendHook = nullptr;   ///< 送信フック
+static esp_now_send_cb_t sendCallback = nullptr;///< 送信完了コールバック
+static esp_now_recv_cb_t recvCallback = nullptr;///< 受信コールバック
+static size_t sendQueueLimit = 0;               ///< 送信完了待ちにできるフレーム数（0 で無制限）
+static size_t sendPending = 0;                  ///< 送信完了待ちのフレーム数
+
+namespace HostShim
+{
+    void SetMicros(uint32_t nowMicros)
+    {
+        virtualMicros = nowMicros;
+    }
+
+    void SetSendHook(SendHook hook)
+    {
+        sendHook = hook;
+    }
+
+    void SetSendQueueLimit(size_t limit)
+    {
+        sendQueueLimit = limit;
+        sendPending = 0;
+    }
+
+    void Receive(const uint8_t* mac, const uint8_t* data, int len)
+    {
+        if (recvCallback)
+        {
+            recvCallback(mac, data, len);
+        }
+    }
+
+    void CompleteSend(const uint8_t* mac, bool delivered)
+    {
+        if (sendPending > 0)
+        {
+            sendPending--;
+        }
+        if (sendCallback)
+        {
+            sendCallback(mac, delivered ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL);
+        }
+    }
+}
+
+uint32_t millis(void)
+{
+    return virtualMicros / 1000;
+}
+
+uint32_t micros(void)
+{
+    return virtualMicros;
+}
+
+void delay(uint32_t ms)
+{
+    virtualMicros += ms * 1000;
+}
+
+long random(long low, long high)
+{
+    return (high > low) ? low + std::rand() % (high - low) : low;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return std::fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    return std::fwrite(buffer, 1, size, stdout);
+}
+
+esp_err_t esp_now_init(void) { return ESP_OK; }
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t*) { return ESP_OK; }
+esp_err_t esp_now_mod_peer(const esp_now_peer_info_t*) { return ESP_OK; }
+esp_err_t esp_now_set_pmk(const uint8_t*) { return ESP_OK; }
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len)
+{
+    if (sendQueueLimit != 0 && sendPending >= sendQueueLimit)
+    {
+        return ESP_FAIL;
+    }
+    sendPending++;
+    if (sendHook)
+    {
+        sendHook(peer_addr, data, len);
+    }
+    return ESP_OK;
+}
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    recvCallback = cb;
+    return ESP_OK;
+}
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    sendCallback = cb;
+    return ESP_OK;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file wcom_codec_bench.cpp
+ * @brief スキーマによる変換（ROBO_WCOM_Codec.h）と memcpy の1回あたりのコストを比べる PC側ツール
+ * @details
+ * src/packet_codec.h の4つのスキーマについて、次を表示する。
+ *
+ * - 送信形式のバイト数（memcpy で送る場合は構造体のサイズ）
+ * - encode / decode の時間と、同じバイト数の memcpy の時間
+ *
+ * 全精度の形式（*Portable）はリトルエンディアン環境では構造体のメモリ配置と同じバイト列になるはずなので、
+ * encode の出力が memcpy と一致し、decode で元の構造体に戻るかも確かめる。一致しなければ終了コード 1 を返す。
+ * 時間は PC 上の値であり、ESP32 上の絶対値ではなく形式間の比較に使う。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -I src -o wcom_codec_bench tools/wcom_codec_bench.cpp
+ * 使い方:
+ *   wcom_codec_bench [--iterations 繰り返し回数=2000000]
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <packet_codec.h>
+
+/**
+ * @brief 最適化で処理を消されないように結果を混ぜる先
+ */
+static volatile uint32_t sink = 0;
+
+/**
+ * @brief 1行分の測定結果
+ */
+struct Timing {
+    double encodeNs;    ///< encode 1回の時間
+    double decodeNs;    ///< decode 1回の時間
+    double copyNs;      ///< 構造体サイズの memcpy 1回の時間
+};
+
+/**
+ * @brief 経過秒数
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 試験用の指令
+ */
+static RoboCommand_t makeCommand(uint32_t i)
+{
+    RoboCommand_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.velocity.x = 12.5f + static_cast<float>(i % 7);
+    cmd.velocity.y = -3.25f;
+    cmd.velocity.omega = 0.125f * static_cast<float>(i % 13);
+    cmd.WEAPON_FLAGS.FLAGS = static_cast<uint8_t>(i);
+    cmd.RGBLED.RGB_DATAS = 0x00A0B0C0u + i;
+    cmd.hp = static_cast<uint16_t>(1000 - (i % 1000));
+    return cmd;
+}
+
+/**
+ * @brief 試験用のステータス
+ */
+static RoboStatus_t makeStatus(uint32_t i)
+{
+    RoboStatus_t st;
+    memset(&st, 0, sizeof(st));
+    st.Power.voltage = 11.8f;
+    st.Power.current = 3.5f + static_cast<float>(i % 5);
+    st.Power.wh = 0.75f;
+    for (int m = 0; m < MOTOR_NUM; ++m)
+    {
+        st.motors[m] = static_cast<float>(m * 10) - 35.0f + static_cast<float>(i % 3);
+    }
+    st.WEAPON_FLAGS.FLAGS = static_cast<uint8_t>(i);
+    st.MANSWICH.SWITCHES = static_cast<uint16_t>(i * 3);
+    return st;
+}
+
+/**
+ * @brief スキーマ1つを測る
+ * @tparam S スキーマ
+ * @param value      変換する値
+ * @param iterations 繰り返し回数
+ */
+template <typename S>
+static Timing measure(const typename S::Type& value, uint32_t iterations)
+{
+    typedef typename S::Type T;
+    uint8_t wire[sizeof(T) + 8];
+    T out = value;
+    Timing t;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        S::encode(value, wire);
+        sink = sink + wire[i % S::WIRE_SIZE];
+    }
+    t.encodeNs = secondsSince(start) * 1e9 / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        wire[0] = static_cast<uint8_t>(i);
+        S::decode(wire, S::WIRE_SIZE, out);
+        sink = sink + reinterpret_cast<const uint8_t*>(&out)[i % sizeof(T)];
+    }
+    t.decodeNs = secondsSince(start) * 1e9 / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        memcpy(wire, &value, sizeof(T));
+        wire[0] = static_cast<uint8_t>(i);
+        memcpy(&out, wire, sizeof(T));
+        sink = sink + reinterpret_cast<const uint8_t*>(&out)[i % sizeof(T)];
+    }
+    // 送信側と受信側の2回分なので半分にする
+    t.copyNs = secondsSince(start) * 1e9 / iterations / 2;
+    return t;
+}
+
+/**
+ * @brief 全精度の形式が memcpy と同じバイト列になり、元に戻るか
+ * @tparam S スキーマ
+ */
+template <typename S>
+static bool matchesMemcpy(const typename S::Type& value)
+{
+    typedef typename S::Type T;
+    static_assert(S::WIRE_SIZE == sizeof(T), "Portable schema must cover the whole struct");
+    uint8_t wire[S::WIRE_SIZE];
+    S::encode(value, wire);
+    if (memcmp(wire, &value, sizeof(T)) != 0)
+    {
+        return false;
+    }
+    T back;
+    memset(&back, 0xA5, sizeof(back));
+    return S::decode(wire, sizeof(wire), back) && memcmp(&back, &value, sizeof(T)) == 0;
+}
+
+/**
+ * @brief 1行表示する
+ */
+template <typename S>
+static void printRow(const char* name, const Timing& t)
+{
+    printf("%-22s %5u %5u %9.2f %9.2f %9.2f\n", name,
+           static_cast<unsigned>(S::WIRE_SIZE), static_cast<unsigned>(sizeof(typename S::Type)),
+           t.encodeNs, t.decodeNs, t.copyNs);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 2000000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--iterations") == 0)
+        {
+            iterations = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+    {
+        fprintf(stderr, "iterations must be >= 1\n");
+        return 2;
+    }
+
+    bool ok = true;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        if (!matchesMemcpy<RoboCommandPortable>(makeCommand(i)) || !matchesMemcpy<RoboStatusPortable>(makeStatus(i)))
+        {
+            printf("portable schema differs from memcpy layout (sample %u)\n", i);
+            ok = false;
+            break;
+        }
+    }
+
+    RoboCommand_t cmd = makeCommand(1);
+    RoboStatus_t st = makeStatus(1);
+    printf("%u iterations\n", iterations);
+    printf("%-22s %5s %5s %9s %9s %9s\n", "schema", "wire", "raw", "enc_ns", "dec_ns", "memcpy_ns");
+    printRow<RoboCommandPortable>("RoboCommandPortable", measure<RoboCommandPortable>(cmd, iterations));
+    printRow<RoboCommandCompact>("RoboCommandCompact", measure<RoboCommandCompact>(cmd, iterations));
+    printRow<RoboStatusPortable>("RoboStatusPortable", measure<RoboStatusPortable>(st, iterations));
+    printRow<RoboStatusCompact>("RoboStatusCompact", measure<RoboStatusCompact>(st, iterations));
+    printf("portable matches memcpy: %s\n", ok ? "yes" : "NO");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+/**
+ * @file wcom_codec_check.cpp
+ * @brief 指令・ステータスの送信形式（src/packet_codec.h）を境界値で往復させて確かめる PC側ツール
+ * @details
+ * 次を確かめ、1つでも合わなければ内容を表示して終了コード 1 を返す。
+ *
+ * - コンパクト形式の固定小数点フィールド（Fixed16）
+ *   - 範囲の下限・上限・中央・途中の値が、量子化誤差（1LSB の半分）以内で戻る
+ *   - 範囲外・±無限大は下限/上限へ飽和し、NaN は下限になる
+ * - 整数フィールド（U8 / U16 / U32）は最小値・最大値がそのまま戻る
+ * - 全精度形式（F32）は NaN・±無限大・-0・非正規化数もビット列ごと戻る
+ * - サイズの合わない受信データは decode() が false を返し、構造体を変更しない
+ * - 検査値（Codec::crc32 / Codec::crc16）が標準の確認値（"123456789"）と一致し、分割して計算しても同じ
+ * - 差分テレメトリ（ROBO_WCOM_Delta.h）で RoboStatus_t の走行トレースを送ったとき
+ *   - キーフレーム・差分フレームとも送信形式のまま復元できる
+ *   - 差分フレームが欠落しても後続の差分フレームは復元できる
+ *   - キーフレームが欠落すると、キー番号の合わない差分フレームを拒否し、次のキーフレームから復元を再開する
+ *   - 1フレームあたりの平均バイト数（表示する）が毎回キーフレームを送る場合より小さい
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -I src -o wcom_codec_check tools/wcom_codec_check.cpp
+ * 使い方:
+ *   wcom_codec_check
+ */
+#include <Arduino.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <packet_codec.h>
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_Delta.h"
+
+/**
+ * @brief 固定小数点フィールド1つ分の定義
+ */
+struct FixedField {
+    const char* name;   ///< 表示名
+    size_t      offset; ///< 構造体内のバイトオフセット
+    float       min;    ///< 表現範囲の下限
+    float       max;    ///< 表現範囲の上限
+};
+
+static const FixedField COMMAND_FIXED[] = {
+    { "velocity.x",     offsetof(RoboCommand_t, velocity.x),     -100.0f, 100.0f },
+    { "velocity.y",     offsetof(RoboCommand_t, velocity.y),     -100.0f, 100.0f },
+    { "velocity.omega", offsetof(RoboCommand_t, velocity.omega), -100.0f, 100.0f },
+};
+
+static const FixedField STATUS_FIXED[] = {
+    { "Power.voltage",  offsetof(RoboStatus_t, Power.voltage),   0.0f,  20.0f },
+    { "Power.current",  offsetof(RoboStatus_t, Power.current),   0.0f, 100.0f },
+    { "Power.wh",       offsetof(RoboStatus_t, Power.wh),        0.0f, 100.0f },
+    { "motors[0]",      offsetof(RoboStatus_t, motors[0]),    -200.0f, 200.0f },
+    { "motors[7]",      offsetof(RoboStatus_t, motors[7]),    -200.0f, 200.0f },
+};
+
+constexpr uint16_t DELTA_KEYFRAME_INTERVAL = 20;   ///< 差分テレメトリのキーフレーム間隔（examples/Robo と同じ）
+constexpr uint32_t DELTA_TRACE_FRAMES     = 400;  ///< 差分テレメトリのトレース長（20Hz で 20秒）
+
+static uint32_t checks = 0;     ///< 確かめた項目数
+static uint32_t failures = 0;   ///< 合わなかった項目数
+
+/**
+ * @brief 1項目の結果を数え、合わなければ表示する
+ */
+static void expect(bool ok, const char* schema, const char* what, double sent, double got)
+{
+    checks++;
+    if (!ok)
+    {
+        failures++;
+        printf("FAIL %-20s %-28s sent=%g got=%g\n", schema, what, sent, got);
+    }
+}
+
+/**
+ * @brief 構造体の指定位置の float を読む
+ */
+template <typename T>
+static float readFloat(const T& value, size_t offset)
+{
+    float v;
+    memcpy(&v, reinterpret_cast<const uint8_t*>(&value) + offset, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief 構造体の指定位置へ float を書く
+ */
+template <typename T>
+static void writeFloat(T& value, size_t offset, float v)
+{
+    memcpy(reinterpret_cast<uint8_t*>(&value) + offset, &v, sizeof(v));
+}
+
+/**
+ * @brief 送信形式へ変換して戻す
+ */
+template <typename S>
+static typename S::Type roundTrip(const typename S::Type& value)
+{
+    uint8_t wire[S::WIRE_SIZE];
+    S::encode(value, wire);
+    typename S::Type back;
+    memset(&back, 0, sizeof(back));
+    S::decode(wire, sizeof(wire), back);
+    return back;
+}
+
+/**
+ * @brief 固定小数点フィールドを境界値で往復させる
+ * @tparam S スキーマ（コンパクト形式）
+ */
+template <typename S>
+static void checkFixed(const char* schema, const FixedField* fields, size_t count)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (size_t f = 0; f < count; ++f)
+    {
+        const FixedField& field = fields[f];
+        float range = field.max - field.min;
+        // 量子化誤差は 1LSB の半分。float の丸め分だけ余裕を持たせる
+        float tolerance = range / 65535.0f * 0.5f + std::fabs(field.max) * 1e-6f + 1e-6f;
+        struct Case {
+            const char* label;
+            float       sent;
+            float       expected;
+        };
+        const Case cases[] = {
+            { "min",        field.min,                  field.min },
+            { "max",        field.max,                  field.max },
+            { "center",     field.min + range * 0.5f,   field.min + range * 0.5f },
+            { "inside",     field.min + range * 0.3f,   field.min + range * 0.3f },
+            { "below min",  field.min - range,          field.min },
+            { "above max",  field.max + range,          field.max },
+            { "+huge",      1e30f,                      field.max },
+            { "-huge",      -1e30f,                     field.min },
+            { "+inf",       inf,                        field.max },
+            { "-inf",       -inf,                       field.min },
+            { "nan",        nan,                        field.min },
+        };
+        for (const Case& c : cases)
+        {
+            typename S::Type value;
+            memset(&value, 0, sizeof(value));
+            writeFloat(value, field.offset, c.sent);
+            float got = readFloat(roundTrip<S>(value), field.offset);
+            char what[64];
+            snprintf(what, sizeof(what), "%s %s", field.name, c.label);
+            expect(std::fabs(got - c.expected) <= tolerance, schema, what, c.sent, got);
+        }
+    }
+}
+
+/**
+ * @brief 全精度形式で float のビット列が保たれるか
+ * @tparam S スキーマ（全精度形式）
+ */
+template <typename S>
+static void checkF32Bits(const char* schema, size_t offset)
+{
+    const float values[] = {
+        std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(),
+        -0.0f,
+        std::numeric_limits<float>::denorm_min(),
+        std::numeric_limits<float>::max(),
+        std::numeric_limits<float>::lowest(),
+    };
+    for (float v : values)
+    {
+        typename S::Type value;
+        memset(&value, 0, sizeof(value));
+        writeFloat(value, offset, v);
+        typename S::Type back = roundTrip<S>(value);
+        uint32_t sentBits, gotBits;
+        float got = readFloat(back, offset);
+        memcpy(&sentBits, &v, sizeof(sentBits));
+        memcpy(&gotBits, &got, sizeof(gotBits));
+        expect(sentBits == gotBits, schema, "f32 bits", v, got);
+    }
+}
+
+/**
+ * @brief 指令の整数フィールドを最小値・最大値で往復させる
+ */
+template <typename S>
+static void checkCommandIntegers(const char* schema)
+{
+    for (int edge = 0; edge < 2; ++edge)
+    {
+        RoboCommand_t cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.WEAPON_FLAGS.FLAGS = edge ? 0xFF : 0x00;
+        cmd.RGBLED.RGB_DATAS = edge ? 0xFFFFFFFFu : 0u;
+        cmd.hp = edge ? 0xFFFF : 0;
+        RoboCommand_t back = roundTrip<S>(cmd);
+        expect(back.WEAPON_FLAGS.FLAGS == cmd.WEAPON_FLAGS.FLAGS, schema, "WEAPON_FLAGS", cmd.WEAPON_FLAGS.FLAGS, back.WEAPON_FLAGS.FLAGS);
+        expect(back.RGBLED.RGB_DATAS == cmd.RGBLED.RGB_DATAS, schema, "RGB_DATAS", cmd.RGBLED.RGB_DATAS, back.RGBLED.RGB_DATAS);
+        expect(back.hp == cmd.hp, schema, "hp", cmd.hp, back.hp);
+    }
+}
+
+/**
+ * @brief ステータスの整数フィールドを最小値・最大値で往復させる
+ */
+template <typename S>
+static void checkStatusIntegers(const char* schema)
+{
+    for (int edge = 0; edge < 2; ++edge)
+    {
+        RoboStatus_t st;
+        memset(&st, 0, sizeof(st));
+        st.WEAPON_FLAGS.FLAGS = edge ? 0xFF : 0x00;
+        st.MANSWICH.SWITCHES = edge ? 0xFFFF : 0;
+        RoboStatus_t back = roundTrip<S>(st);
+        expect(back.WEAPON_FLAGS.FLAGS == st.WEAPON_FLAGS.FLAGS, schema, "WEAPON_FLAGS", st.WEAPON_FLAGS.FLAGS, back.WEAPON_FLAGS.FLAGS);
+        expect(back.MANSWICH.SWITCHES == st.MANSWICH.SWITCHES, schema, "SWITCHES", st.MANSWICH.SWITCHES, back.MANSWICH.SWITCHES);
+    }
+}
+
+/**
+ * @brief サイズの合わない受信データを拒否し、構造体を変更しないか
+ */
+template <typename S>
+static void checkSizeMismatch(const char* schema)
+{
+    uint8_t wire[S::WIRE_SIZE + 1] = {};
+    typename S::Type value;
+    memset(&value, 0x5A, sizeof(value));
+    typename S::Type before = value;
+    bool shortOk = S::decode(wire, S::WIRE_SIZE - 1, value);
+    bool longOk = S::decode(wire, S::WIRE_SIZE + 1, value);
+    bool untouched = memcmp(&value, &before, sizeof(value)) == 0;
+    expect(!shortOk && !longOk && untouched, schema, "size mismatch rejected", S::WIRE_SIZE, untouched ? 1 : 0);
+}
+
+/**
+ * @brief 検査値を標準の確認値と照合する
+ */
+static void checkCrc(void)
+{
+    using namespace ROBO_WCOM;
+    static const uint8_t INPUT[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    const uint32_t CRC32_CHECK = 0xCBF43926;    // CRC-32/ISO-HDLC
+    const uint16_t CRC16_CHECK = 0x29B1;        // CRC-16/CCITT-FALSE
+
+    uint32_t whole = Codec::crc32(INPUT, sizeof(INPUT));
+    expect(whole == CRC32_CHECK, "Codec", "crc32 check value", CRC32_CHECK, whole);
+    uint32_t split = Codec::crc32Update(0xFFFFFFFF, INPUT, 4);
+    split = Codec::crc32Final(Codec::crc32Update(split, INPUT + 4, sizeof(INPUT) - 4));
+    expect(split == CRC32_CHECK, "Codec", "crc32 split update", CRC32_CHECK, split);
+    uint16_t crc16 = Codec::crc16(INPUT, sizeof(INPUT));
+    expect(crc16 == CRC16_CHECK, "Codec", "crc16 check value", CRC16_CHECK, crc16);
+    expect(Codec::crc32(INPUT, 0) == 0 && Codec::crc16(INPUT, 0) == 0xFFFF, "Codec", "empty input", 0, 0);
+}
+
+/**
+ * @brief 走行中のロボットのステータスを模したトレースの k 番目（20Hz）
+ * @details
+ * 電圧は10フレームごと、消費電力量は20フレームごとに更新し、走行中（100フレーム中60フレーム）は
+ * 電流と駆動モータ4つが変化する。武器フラグとスイッチはときどき変わる
+ */
+static RoboStatus_t statusTrace(uint32_t k)
+{
+    RoboStatus_t st;
+    memset(&st, 0, sizeof(st));
+    bool driving = (k % 100) < 60;
+    float t = static_cast<float>(k) / 20.0f;
+    st.Power.voltage = 16.8f - 0.01f * static_cast<float>(k / 10);
+    st.Power.wh = 0.02f * static_cast<float>(k / 20);
+    st.Power.current = driving ? 8.0f + 3.0f * std::sin(t) : 0.4f;
+    for (int m = 0; m < 4 && driving; ++m)
+    {
+        st.motors[m] = 120.0f * std::sin(t + static_cast<float>(m));
+    }
+    st.WEAPON_FLAGS.FLAGS = static_cast<uint8_t>((k / 50) & 0x03);
+    st.MANSWICH.SWITCHES = static_cast<uint16_t>((k % 40) < 5 ? 0x0010 : 0);
+    return st;
+}
+
+/**
+ * @brief 復元した構造体が送った構造体と送信形式で一致するか
+ */
+template <typename S>
+static bool sameWire(const typename S::Type& a, const typename S::Type& b)
+{
+    uint8_t wa[S::WIRE_SIZE];
+    uint8_t wb[S::WIRE_SIZE];
+    S::encode(a, wa);
+    S::encode(b, wb);
+    return memcmp(wa, wb, sizeof(wa)) == 0;
+}
+
+/**
+ * @brief 差分テレメトリをトレースで往復させる
+ * @param dropped 届かなかったことにするフレーム番号（-1 で欠落なし）
+ * @param ok      復元できたフレームが送ったものと一致したか
+ * @param decoded 復元できたフレーム数
+ * @param firstAfter dropped 以降で最初に復元できたフレーム番号
+ * @param bytes   符号化したバイト数の合計
+ */
+template <typename S>
+static void runDelta(int32_t dropped, bool& ok, uint32_t& decoded, int32_t& firstAfter, size_t& bytes)
+{
+    ROBO_WCOM::DeltaEncoder<S> encoder(DELTA_KEYFRAME_INTERVAL);
+    ROBO_WCOM::DeltaDecoder<S> decoder;
+    uint8_t frame[ROBO_WCOM::DeltaEncoder<S>::MAX_FRAME_SIZE];
+    ok = true;
+    decoded = 0;
+    firstAfter = -1;
+    bytes = 0;
+    for (uint32_t k = 0; k < DELTA_TRACE_FRAMES; ++k)
+    {
+        RoboStatus_t sent = statusTrace(k);
+        size_t len = encoder.encode(sent, frame);
+        bytes += len;
+        if (static_cast<int32_t>(k) == dropped)
+        {
+            continue;
+        }
+        RoboStatus_t got;
+        memset(&got, 0, sizeof(got));
+        if (!decoder.decode(frame, len, got))
+        {
+            continue;
+        }
+        decoded++;
+        ok = ok && sameWire<S>(sent, got);
+        if (dropped >= 0 && firstAfter < 0 && static_cast<int32_t>(k) > dropped)
+        {
+            firstAfter = static_cast<int32_t>(k);
+        }
+    }
+}
+
+/**
+ * @brief 差分テレメトリの往復・欠落からの復帰・平均フレーム長を確かめる
+ */
+template <typename S>
+static void checkDelta(const char* schema)
+{
+    const uint32_t interval = DELTA_KEYFRAME_INTERVAL;
+    bool ok;
+    uint32_t decoded;
+    int32_t firstAfter;
+    size_t bytes;
+
+    runDelta<S>(-1, ok, decoded, firstAfter, bytes);
+    expect(ok && decoded == DELTA_TRACE_FRAMES, schema, "delta round trip", DELTA_TRACE_FRAMES, decoded);
+    double average = static_cast<double>(bytes) / DELTA_TRACE_FRAMES;
+    double full = static_cast<double>(ROBO_WCOM::Delta::HEADER_SIZE + S::WIRE_SIZE);
+    printf("%-20s delta average %.1f bytes/frame, keyframe %.0f bytes (%.0f%%)\n",
+           schema, average, full, 100.0 * average / full);
+    expect(average < full, schema, "delta smaller than keyframes", full, average);
+
+    // 差分フレームの欠落は後続に影響しない
+    int32_t lostDelta = static_cast<int32_t>(interval + 5);
+    runDelta<S>(lostDelta, ok, decoded, firstAfter, bytes);
+    expect(ok && decoded == DELTA_TRACE_FRAMES - 1 && firstAfter == lostDelta + 1, schema, "lost delta",
+           lostDelta + 1, firstAfter);
+
+    // キーフレームの欠落後は、次のキーフレームまでキー番号の合わない差分を拒否する
+    int32_t lostKey = static_cast<int32_t>(interval);
+    runDelta<S>(lostKey, ok, decoded, firstAfter, bytes);
+    expect(ok && decoded == DELTA_TRACE_FRAMES - interval, schema, "deltas rejected after lost keyframe",
+           DELTA_TRACE_FRAMES - interval, decoded);
+    expect(firstAfter == lostKey + static_cast<int32_t>(interval), schema, "recovers at next keyframe",
+           lostKey + interval, firstAfter);
+}
+
+int main(int argc, char**)
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: wcom_codec_check\n");
+        return 2;
+    }
+
+    checkFixed<RoboCommandCompact>("RoboCommandCompact", COMMAND_FIXED, sizeof(COMMAND_FIXED) / sizeof(COMMAND_FIXED[0]));
+    checkFixed<RoboStatusCompact>("RoboStatusCompact", STATUS_FIXED, sizeof(STATUS_FIXED) / sizeof(STATUS_FIXED[0]));
+    checkCommandIntegers<RoboCommandCompact>("RoboCommandCompact");
+    checkCommandIntegers<RoboCommandPortable>("RoboCommandPortable");
+    checkStatusIntegers<RoboStatusCompact>("RoboStatusCompact");
+    checkStatusIntegers<RoboStatusPortable>("RoboStatusPortable");
+    checkF32Bits<RoboCommandPortable>("RoboCommandPortable", offsetof(RoboCommand_t, velocity.omega));
+    checkF32Bits<RoboStatusPortable>("RoboStatusPortable", offsetof(RoboStatus_t, motors[7]));
+    checkSizeMismatch<RoboCommandCompact>("RoboCommandCompact");
+    checkSizeMismatch<RoboCommandPortable>("RoboCommandPortable");
+    checkSizeMismatch<RoboStatusCompact>("RoboStatusCompact");
+    checkSizeMismatch<RoboStatusPortable>("RoboStatusPortable");
+    checkCrc();
+    checkDelta<RoboStatusCompact>("RoboStatusCompact");
+    checkDelta<RoboStatusPortable>("RoboStatusPortable");
+
+    printf("%u checks, %u failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
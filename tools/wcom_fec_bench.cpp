@@ -0,0 +1,298 @@
+/**
+ * @file wcom_fec_bench.cpp
+ * @brief 冗長送信（SetRedundancy）による欠落の復元率を損失モデルごとに測る PC側ツール
+ * @details
+ * 1つのプロセスで送信したフレームに損失モデルを適用し、残ったものを InjectFrame() で受信させる。
+ * 冗長送信なし・ありで同じ損失パターンを使い、次を表示する。
+ *
+ * - bernoulli : 各フレームが独立に --loss % で失われる
+ * - burst     : Gilbert-Elliott モデル（良好状態の損失 1%、劣悪状態の損失 50%、平均 --loss % 付近）
+ *
+ * 続けて送信側の再起動を模擬し、再起動後のフレームが捨てられずに届くかを確かめる。
+ *
+ * - restart        : 途絶を挟まずに送信側のシーケンス番号が 0 へ戻る
+ * - restart+outage : 途絶（Lost）の後に番号が 0 へ戻る。再起動前の番号が小さく、戻り幅だけでは順序の逆転と区別できない
+ *
+ * 冗長送信ありの到達数がなしを下回った場合、または再起動後のフレームが届かなかった場合は終了コード 1 を返す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_fec_bench \
+ *       tools/wcom_fec_bench.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_fec_bench [--frames 送信数=20000] [--loss 百分率=10] [--seed S=1]
+ */
+#include <Arduino.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "ROBO_WCOM.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t FRAME_PRD_US = 20000;    ///< 送信周期
+constexpr uint8_t  PAYLOAD_SIZE = 32;       ///< 搬送データサイズ
+constexpr uint32_t TIMEOUT_MS   = 1000;     ///< Lost と判定するまでの時間
+
+static const uint8_t OWN_ADDR[6]  = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+
+typedef std::vector<uint8_t> Frame;
+
+static std::vector<Frame> sentFrames;   ///< 送信フックで受け取ったフレーム
+static uint32_t nowMicros = 0;          ///< 仮想時計
+
+/**
+ * @brief esp_now_send() のフック
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    sentFrames.push_back(Frame(data, data + len));
+}
+
+/**
+ * @brief 損失モデル用の乱数（xorshift32）
+ */
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed) : state(seed ? seed : 1) {}
+    /**
+     * @brief [0, 1) の一様乱数
+     */
+    double next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<double>(state) / 4294967296.0;
+    }
+};
+
+/**
+ * @brief 損失モデル
+ */
+struct LossModel {
+    const char* name;       ///< 表示名
+    bool        burst;      ///< Gilbert-Elliott モデルか
+};
+
+/**
+ * @brief フレーム1つ分の損失を決める
+ * @param model   損失モデル
+ * @param loss    平均損失率（0～1）
+ * @param rng     乱数
+ * @param bad     Gilbert-Elliott モデルの状態（true: 劣悪）
+ * @return true:失う
+ */
+static bool drop(const LossModel& model, double loss, Random& rng, bool& bad)
+{
+    if (!model.burst)
+    {
+        return rng.next() < loss;
+    }
+    // 劣悪状態は平均 1/P_BG フレーム続く。定常状態の損失率が loss 付近になるよう P_GB を決める
+    const double LOSS_GOOD = 0.01;
+    const double LOSS_BAD = 0.5;
+    const double P_BG = 0.3;
+    double badShare = (loss - LOSS_GOOD) / (LOSS_BAD - LOSS_GOOD);
+    if (badShare < 0.0)
+    {
+        badShare = 0.0;
+    }
+    double pGB = (badShare >= 1.0) ? 1.0 : P_BG * badShare / (1.0 - badShare);
+    bad = bad ? (rng.next() >= P_BG) : (rng.next() < pGB);
+    return rng.next() < (bad ? LOSS_BAD : LOSS_GOOD);
+}
+
+/**
+ * @brief 送信側として番号 first から count 個のパケットを送り、フレームを返す
+ * @param redundant 冗長送信するか
+ * @param first     搬送データに書く通し番号の先頭
+ * @param count     送信数
+ */
+static std::vector<Frame> makeStream(bool redundant, uint32_t first, uint32_t count)
+{
+    Init(OWN_ADDR, PEER_ADDR, millis(), TIMEOUT_MS);
+    SetFrameFormat(FrameFormat::Compact);
+    SetRedundancy(redundant);
+    uint8_t payload[PAYLOAD_SIZE] = {};
+    sentFrames.clear();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t id = first + i;
+        memcpy(payload, &id, sizeof(id));
+        SendPacket(id, payload, PAYLOAD_SIZE);
+    }
+    return sentFrames;
+}
+
+/**
+ * @brief 受信バッファを空にし、届いた通し番号に印を付ける
+ * @return 新たに届いた数
+ */
+static uint32_t drain(std::vector<bool>& seen, uint32_t base)
+{
+    uint32_t fresh = 0;
+    uint32_t ts;
+    uint8_t addr[6];
+    uint8_t data[CARRIED_DATA_MAX_SIZE];
+    uint8_t size;
+    while (PopOldestPacket(millis(), &ts, addr, data, &size) == Status::Ok)
+    {
+        uint32_t id;
+        memcpy(&id, data, sizeof(id));
+        if (size == PAYLOAD_SIZE && id >= base && id - base < seen.size() && !seen[id - base])
+        {
+            seen[id - base] = true;
+            fresh++;
+        }
+    }
+    return fresh;
+}
+
+/**
+ * @brief 受信側として1フレームを受け取る
+ */
+static void deliver(const Frame& frame)
+{
+    nowMicros += FRAME_PRD_US;
+    HostShim::SetMicros(nowMicros);
+    InjectFrame(frame.data(), static_cast<int>(frame.size()));
+}
+
+/**
+ * @brief 1つの損失モデル・設定で測る
+ */
+struct Result {
+    uint32_t delivered;     ///< 届いたパケット数
+    double   frameBytes;    ///< 1フレームの平均バイト数
+    FecStats fec;           ///< 前方誤り訂正の統計
+};
+
+static Result run(const LossModel& model, bool redundant, double loss, uint32_t frames, uint32_t seed)
+{
+    std::vector<Frame> stream = makeStream(redundant, 0, frames);
+    Init(OWN_ADDR, PEER_ADDR, millis(), TIMEOUT_MS);
+
+    Result r = {};
+    std::vector<bool> seen(frames, false);
+    Random rng(seed);
+    bool bad = false;
+    uint64_t bytes = 0;
+    for (const Frame& frame : stream)
+    {
+        bytes += frame.size();
+        if (drop(model, loss, rng, bad))
+        {
+            nowMicros += FRAME_PRD_US;
+            continue;
+        }
+        deliver(frame);
+        r.delivered += drain(seen, 0);
+    }
+    r.frameBytes = stream.empty() ? 0.0 : static_cast<double>(bytes) / stream.size();
+    GetFecStats(&r.fec);
+    return r;
+}
+
+/**
+ * @brief 送信側の再起動後のフレームが届くか確かめる
+ * @param outage true: 再起動の前に Lost になるまで途絶させる
+ * @return true:再起動後のフレームがすべて届いた
+ */
+static bool runRestart(bool outage)
+{
+    const uint32_t BEFORE = outage ? 6 : 300;
+    const uint32_t AFTER = 100;
+    const uint32_t AFTER_BASE = 100000;
+    // 途絶ありの場合、再起動後の番号 0 は再起動前の最後の番号より少しだけ小さく、順序の逆転と区別できない
+    std::vector<Frame> before = makeStream(true, 0, BEFORE);
+    std::vector<Frame> after = makeStream(true, AFTER_BASE, AFTER);
+    Init(OWN_ADDR, PEER_ADDR, millis(), TIMEOUT_MS);
+
+    std::vector<bool> seenBefore(BEFORE, false);
+    std::vector<bool> seenAfter(AFTER, false);
+    uint32_t deliveredBefore = 0;
+    uint32_t deliveredAfter = 0;
+    for (const Frame& frame : before)
+    {
+        deliver(frame);
+        deliveredBefore += drain(seenBefore, 0);
+    }
+    if (outage)
+    {
+        nowMicros += (TIMEOUT_MS + 500) * 1000;
+        HostShim::SetMicros(nowMicros);
+        UpdateLinkState(millis());
+    }
+    for (const Frame& frame : after)
+    {
+        deliver(frame);
+        deliveredAfter += drain(seenAfter, AFTER_BASE);
+    }
+    FecStats fec;
+    GetFecStats(&fec);
+    bool ok = (deliveredBefore == BEFORE && deliveredAfter == AFTER);
+    printf("%-16s %8u/%-4u %8u/%-4u %8u %8u   %s\n", outage ? "restart+outage" : "restart",
+           deliveredBefore, BEFORE, deliveredAfter, AFTER, fec.resyncs, fec.lost, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 20000;
+    uint32_t lossPercent = 10;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--frames") == 0)
+        {
+            frames = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--loss") == 0)
+        {
+            lossPercent = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            seed = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--frames N] [--loss PERCENT] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames == 0 || lossPercent > 90)
+    {
+        fprintf(stderr, "frames must be >= 1 and loss must be <= 90\n");
+        return 2;
+    }
+
+    HostShim::SetSendHook(onSend);
+    const LossModel models[] = { { "bernoulli", false }, { "burst", true } };
+    double loss = lossPercent / 100.0;
+    bool allOk = true;
+
+    printf("frames=%u loss=%u%% seed=%u payload=%u bytes\n", frames, lossPercent, seed, PAYLOAD_SIZE);
+    printf("%-10s %-6s %10s %9s %9s %9s %9s\n", "model", "fec", "delivered", "rate%", "recovered", "lost", "bytes");
+    for (const LossModel& model : models)
+    {
+        Result plain = run(model, false, loss, frames, seed);
+        Result fec = run(model, true, loss, frames, seed);
+        printf("%-10s %-6s %10u %9.2f %9s %9s %9.1f\n", model.name, "off",
+               plain.delivered, 100.0 * plain.delivered / frames, "-", "-", plain.frameBytes);
+        printf("%-10s %-6s %10u %9.2f %9u %9u %9.1f\n", model.name, "on",
+               fec.delivered, 100.0 * fec.delivered / frames, fec.fec.recovered, fec.fec.lost, fec.frameBytes);
+        if (fec.delivered < plain.delivered)
+        {
+            printf("%s: redundancy delivered fewer packets than plain frames\n", model.name);
+            allOk = false;
+        }
+    }
+
+    printf("\n%-16s %13s %13s %8s %8s\n", "scenario", "before", "after", "resyncs", "lost");
+    allOk = runRestart(false) && allOk;
+    allOk = runRestart(true) && allOk;
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file wcom_fleet_loopback.cpp
+ * @brief 一斉送信（SendFleetPacket()）を1つのプロセス内で折り返して確かめる PC側ツール
+ * @details
+ * 送信フックで受け取った一斉送信フレームを、ロボットIDを切り替えながら自分自身へ受信させる。
+ * 1つのプロセスが送信側と、IDの異なる各ロボットを順に兼ねる。
+ *
+ * - slices   : ロボット1・2はそれぞれ自分のエントリを受け取る（全ロボット宛てが先に並んでいても）
+ * - all      : エントリのないロボット・ID未設定のロボットは全ロボット宛てのエントリを受け取る
+ * - none     : 自分のエントリも全ロボット宛てもなければ何も積まない
+ * - corrupt  : CRC不一致・長さ不一致・エントリ長のはみ出しは何も積まない
+ * - stranger : 通信相手以外から届いたフレームは捨て、通信相手からのものは受け取る
+ * - build    : 収まらないフレーム・ID未設定のエントリ・空の配列は送らず InvalidArg を返す
+ *
+ * 1つでも合わなければ内容を表示して終了コード 1 を返す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -pthread -I tools/host -I lib/ROBO_WCOM -o wcom_fleet_loopback \
+ *       tools/wcom_fleet_loopback.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_fleet_loopback
+ */
+#include <Arduino.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Wire.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t TIMESTAMP = 0x12345678;  ///< 一斉送信のタイムスタンプ
+
+static const uint8_t OWN_ADDR[6]      = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6]     = { 0x02, 0, 0, 0, 0, 0x02 };
+static const uint8_t STRANGER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x99 };
+
+static const uint8_t SLICE_ALL[] = { 0xA0, 0xA1 };
+static const uint8_t SLICE_1[]   = { 0x11, 0x00, 0x13 };
+static const uint8_t SLICE_2[]   = { 0x21 };
+
+typedef std::vector<uint8_t> Frame;
+
+static Frame    sent;               ///< 最後に送信したフレーム
+static uint32_t sentFrames = 0;     ///< 送信したフレーム数
+static uint32_t checks = 0;         ///< 確かめた項目数
+static uint32_t failures = 0;       ///< 合わなかった項目数
+
+/**
+ * @brief 1項目の結果を数え、合わなければ表示する
+ */
+static void expect(bool ok, const char* scenario, const char* what)
+{
+    checks++;
+    if (!ok)
+    {
+        failures++;
+        printf("FAIL %-10s %s\n", scenario, what);
+    }
+}
+
+/**
+ * @brief esp_now_send() のフック
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    sent.assign(data, data + len);
+    sentFrames++;
+}
+
+/**
+ * @brief 受信バッファを空にする
+ */
+static void drain(void)
+{
+    FlushBuffer();
+}
+
+/**
+ * @brief 受信バッファに data だけが積まれているか
+ */
+static bool received(const uint8_t* data, uint8_t size)
+{
+    uint32_t timestamp;
+    uint8_t address[6];
+    uint8_t got[CARRIED_DATA_MAX_SIZE];
+    uint8_t gotSize;
+    if (PopOldestPacket(millis(), &timestamp, address, got, &gotSize) != Status::Ok)
+    {
+        return false;
+    }
+    bool match = timestamp == TIMESTAMP && memcmp(address, OWN_ADDR, sizeof(address)) == 0 &&
+                 gotSize == size && memcmp(got, data, size) == 0;
+    return match && PopOldestPacket(millis(), &timestamp, address, got, &gotSize) == Status::BufferEmpty;
+}
+
+/**
+ * @brief 受信バッファが空か
+ */
+static bool nothingReceived(void)
+{
+    uint32_t timestamp;
+    uint8_t address[6];
+    uint8_t got[CARRIED_DATA_MAX_SIZE];
+    uint8_t gotSize;
+    return PopOldestPacket(millis(), &timestamp, address, got, &gotSize) == Status::BufferEmpty;
+}
+
+/**
+ * @brief 一斉送信し、送信フレームを返す
+ */
+static Frame broadcast(const FleetEntry* entries, uint8_t count)
+{
+    sent.clear();
+    Status s = SendFleetPacket(TIMESTAMP, entries, count);
+    return (s == Status::Ok) ? sent : Frame();
+}
+
+/**
+ * @brief ロボットIDを切り替えて、フレームを通信相手から受信させる
+ */
+static void receiveAs(uint8_t robotId, const Frame& frame)
+{
+    drain();
+    SetRobotId(robotId);
+    InjectFrame(frame.data(), static_cast<int>(frame.size()));
+}
+
+/**
+ * @brief 全ロボット宛て・ロボット1・ロボット2のエントリを持つフレーム
+ */
+static Frame fleetFrame(void)
+{
+    const FleetEntry entries[] = {
+        { ROBOT_ID_ALL, SLICE_ALL, sizeof(SLICE_ALL) },
+        { 1, SLICE_1, sizeof(SLICE_1) },
+        { 2, SLICE_2, sizeof(SLICE_2) },
+    };
+    return broadcast(entries, 3);
+}
+
+/**
+ * @brief ロボットごとのエントリの受け取り
+ */
+static void scenarioSlices(void)
+{
+    Frame frame = fleetFrame();
+    expect(!frame.empty() && frame[0] == static_cast<uint8_t>(Wire::FrameType::Fleet), "slices", "fleet frame sent");
+    receiveAs(1, frame);
+    expect(received(SLICE_1, sizeof(SLICE_1)), "slices", "robot 1 gets its slice");
+    receiveAs(2, frame);
+    expect(received(SLICE_2, sizeof(SLICE_2)), "slices", "robot 2 gets its slice");
+}
+
+/**
+ * @brief 全ロボット宛てのエントリへの切り替え
+ */
+static void scenarioAll(void)
+{
+    Frame frame = fleetFrame();
+    receiveAs(7, frame);
+    expect(received(SLICE_ALL, sizeof(SLICE_ALL)), "all", "unlisted robot gets the ALL entry");
+    receiveAs(ROBOT_ID_NONE, frame);
+    expect(received(SLICE_ALL, sizeof(SLICE_ALL)), "all", "robot without an id gets the ALL entry");
+}
+
+/**
+ * @brief 受け取るエントリがない場合
+ */
+static void scenarioNone(void)
+{
+    const FleetEntry entries[] = { { 1, SLICE_1, sizeof(SLICE_1) }, { 2, SLICE_2, sizeof(SLICE_2) } };
+    Frame frame = broadcast(entries, 2);
+    receiveAs(7, frame);
+    expect(nothingReceived(), "none", "unlisted robot without ALL entry gets nothing");
+    receiveAs(2, frame);
+    expect(received(SLICE_2, sizeof(SLICE_2)), "none", "listed robot still gets its slice");
+}
+
+/**
+ * @brief 壊れたフレーム
+ */
+static void scenarioCorrupt(void)
+{
+    Frame frame = fleetFrame();
+
+    // 搬送データの1ビットを反転（CRC不一致）
+    Frame flipped = frame;
+    flipped[Wire::FLEET_OFFSET_ENTRIES + Wire::FLEET_ENTRY_HEADER_SIZE] ^= 0x01;
+    receiveAs(1, flipped);
+    expect(nothingReceived(), "corrupt", "crc mismatch pushes nothing");
+    receiveAs(7, flipped);
+    expect(nothingReceived(), "corrupt", "crc mismatch pushes nothing for ALL");
+
+    // 末尾を切り詰める・1バイト足す（長さ不一致）
+    Frame shortFrame(frame.begin(), frame.end() - 1);
+    receiveAs(1, shortFrame);
+    expect(nothingReceived(), "corrupt", "truncated frame pushes nothing");
+    Frame longFrame = frame;
+    longFrame.push_back(0);
+    receiveAs(1, longFrame);
+    expect(nothingReceived(), "corrupt", "padded frame pushes nothing");
+
+    // エントリ数を増やし、存在しないエントリを辿らせる
+    Frame counted = frame;
+    counted[Wire::FLEET_OFFSET_COUNT] = 0xFF;
+    receiveAs(1, counted);
+    expect(nothingReceived(), "corrupt", "entry count overrun pushes nothing");
+
+    // 壊れたフレームの後も正しいフレームは受け取れる
+    receiveAs(1, frame);
+    expect(received(SLICE_1, sizeof(SLICE_1)), "corrupt", "intact frame still accepted");
+}
+
+/**
+ * @brief 通信相手以外からのフレーム
+ */
+static void scenarioStranger(void)
+{
+    Frame frame = fleetFrame();
+    drain();
+    SetRobotId(1);
+    HostShim::Receive(STRANGER_ADDR, frame.data(), static_cast<int>(frame.size()));
+    expect(nothingReceived(), "stranger", "frame from a non-peer is dropped");
+    HostShim::Receive(PEER_ADDR, frame.data(), static_cast<int>(frame.size()));
+    expect(received(SLICE_1, sizeof(SLICE_1)), "stranger", "frame from the peer is accepted");
+}
+
+/**
+ * @brief 送信側の引数検査
+ */
+static void scenarioBuild(void)
+{
+    static uint8_t big[CARRIED_DATA_MAX_SIZE] = {};
+    const FleetEntry tooBig[] = { { 1, big, CARRIED_DATA_MAX_SIZE }, { 2, big, 40 } };
+    const FleetEntry noId[] = { { ROBOT_ID_NONE, SLICE_1, sizeof(SLICE_1) } };
+    const FleetEntry noData[] = { { 1, nullptr, 1 } };
+    uint32_t before = sentFrames;
+    expect(SendFleetPacket(TIMESTAMP, tooBig, 2) == Status::InvalidArg, "build", "oversize frame refused");
+    expect(SendFleetPacket(TIMESTAMP, noId, 1) == Status::InvalidArg, "build", "ROBOT_ID_NONE entry refused");
+    expect(SendFleetPacket(TIMESTAMP, noData, 1) == Status::InvalidArg, "build", "entry without data refused");
+    expect(SendFleetPacket(TIMESTAMP, noId, 0) == Status::InvalidArg, "build", "empty entry list refused");
+    expect(sentFrames == before, "build", "nothing sent for refused frames");
+}
+
+int main(int argc, char**)
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: wcom_fleet_loopback\n");
+        return 2;
+    }
+
+    // InjectFrame() は送信元を通信相手とみなす。フレーム内の送信元MACは自分のもの（OWN_ADDR）になる
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(OWN_ADDR, PEER_ADDR, 0, 1000);
+
+    scenarioSlices();
+    scenarioAll();
+    scenarioNone();
+    scenarioCorrupt();
+    scenarioStranger();
+    scenarioBuild();
+
+    printf("%u checks, %u failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
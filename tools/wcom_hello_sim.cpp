@@ -0,0 +1,465 @@
+/**
+ * @file wcom_hello_sim.cpp
+ * @brief ハンドシェイク（ROBO_WCOM_Hello.h）を版の異なる組み合わせで確かめる PC側ツール
+ * @details
+ * コントローラとロボットを2つのプロセスで動かし、送信フレームを socketpair で相手へ渡す。
+ * 仮想時計は 10ms 刻みで両プロセスが足並みを揃えて進めるため、結果は毎回同じになる。
+ * 両側とも 20ms ごとにデータパケット、50ms ごとに生存通知を送る（従来版は生存通知を送らない）。
+ *
+ * 次の組み合わせを順に動かす（ロボット側の設定だけを変える）。
+ *
+ * - modern    : 双方がハンドシェイクに対応
+ * - encrypted : 双方が暗号化Peer（整合性検査を省略できる）
+ * - enc+drop  : encrypted に加え、0～1.3秒のコントローラ→ロボットのフレームをすべて失う。
+ *               コントローラだけが合意した検査へ切り替え、ロボットは応答を受け取れないまま通知を使い切る
+ * - nocompact : ロボットが可変長データフレームを受け付けない（HelloConfig::capabilities で外す）
+ * - smallrx   : ロボットが最大搬送データサイズを 24 バイトと伝える（受信バッファを縮めたロボットの代わりに、
+ *               送信する通知の値を書き換える）。合意後、コントローラがこれを超える送信
+ *               （SendPacket・SendPriorityPacket・SendExtFrame・PublisherUpdate）を InvalidArg で拒否するかも確かめる
+ * - legacy    : ロボットが従来版（ハンドシェイクを知らず、215バイト以外のフレームを読み捨てる）
+ *
+ * 各組み合わせは 0～3秒で通信し、3～4.5秒で通信を断ち、4.5～7秒で復帰させる。
+ * 最後の1秒のデータフレームの平均バイト数と、相手が読めずに捨てたフレーム数、合意した内容を表示する。
+ * 次のいずれかなら失敗として終了コード 1 を返す。
+ *
+ * - 相手に読めないフレームが1つでもある
+ * - どちらかが通信を断つ直前の1秒、または最後の1秒にデータパケットを1つも受信できていない
+ *   （検査の食い違いなどで通信が止まり、通信途絶からの復帰まで戻らない）
+ * - ハンドシェイクに対応する側が、通信を断っている間に通知を送っていない（途絶中も送り続ける）
+ * - smallrx で、相手の最大搬送データサイズを超える送信が拒否されない
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -I src -o wcom_hello_sim \
+ *       tools/wcom_hello_sim.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_hello_sim
+ */
+#include <Arduino.h>
+#include <esp_now.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_Hello.h"
+#include "ROBO_WCOM_Publisher.h"
+#include "ROBO_WCOM_Wire.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t TICK_MS        = 10;     ///< 仮想時計の刻み
+constexpr uint32_t SEND_MS        = 20;     ///< データパケットの送信周期
+constexpr uint32_t HEARTBEAT_MS   = 50;     ///< 生存通知の周期
+constexpr uint32_t OUTAGE_START   = 3000;   ///< 通信を断つ時刻
+constexpr uint32_t OUTAGE_END     = 4500;   ///< 通信を戻す時刻
+constexpr uint32_t END_MS         = 7000;   ///< 終了時刻
+constexpr uint32_t MEASURE_MS     = 6000;   ///< この時刻以降のデータフレームを集計する
+constexpr uint32_t SETTLED_MS     = 2000;   ///< この時刻から通信を断つまでに受信が続いているかを見る
+constexpr uint8_t  PAYLOAD_SIZE   = 24;     ///< データパケットの搬送データサイズ
+constexpr uint16_t END_OF_TICK    = 0;      ///< 1刻み分の送信の終わりを示す長さ
+
+/**
+ * @brief ロボット側の設定の組み合わせ
+ */
+struct Scenario {
+    const char* name;           ///< 名前
+    bool        legacy;         ///< 従来版として動かすか
+    bool        encrypted;      ///< 双方を暗号化Peerにするか
+    uint16_t    capabilities;   ///< ロボットの HelloConfig::capabilities
+    uint32_t    dropToRobotMs;  ///< この時刻までコントローラ→ロボットのフレームを失う
+    uint8_t     robotMaxPayload;///< ロボットが通知で伝える最大搬送データサイズ（0: 書き換えない）
+};
+
+static const Scenario SCENARIOS[] = {
+    { "modern",    false, false, Wire::HELLO_CAPS_ALL, 0,    0 },
+    { "encrypted", false, true,  Wire::HELLO_CAPS_ALL, 0,    0 },
+    { "enc+drop",  false, true,  Wire::HELLO_CAPS_ALL, 1300, 0 },
+    { "nocompact", false, false, static_cast<uint16_t>(Wire::HELLO_CAPS_ALL & ~Wire::HELLO_CAP_COMPACT), 0, 0 },
+    { "smallrx",   false, false, Wire::HELLO_CAPS_ALL, 0,    PAYLOAD_SIZE },
+    { "legacy",    true,  false, 0, 0, 0 },
+};
+constexpr size_t SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+/**
+ * @brief 片側の結果
+ */
+struct Result {
+    HelloLink link;             ///< 合意した内容
+    uint32_t  firstAgreedMs;    ///< 最初に合意（または従来版と判断）した時刻（未決は 0xFFFFFFFF）
+    uint32_t  dataFrames;       ///< 集計区間に送ったデータフレーム数
+    uint32_t  dataBytes;        ///< 集計区間に送ったデータフレームのバイト数
+    uint32_t  received;         ///< 受信できたデータパケット数
+    uint32_t  receivedSettled;  ///< 通信を断つ直前の1秒に受信できたデータパケット数
+    uint32_t  receivedLate;     ///< 集計区間に受信できたデータパケット数
+    uint32_t  unreadable;       ///< 従来版として読み捨てたフレーム数
+    uint32_t  outageHellos;     ///< 通信を断っている間に送った通知数
+    bool      oversizeRejected; ///< 相手の最大搬送データサイズを超える送信がすべて拒否されたか
+};
+
+static int      peerFd = -1;    ///< 相手プロセスとの socket
+static bool     outage = false; ///< 通信を断っているか
+static uint32_t dropUntilMs = 0;///< この時刻まで自分の送信を失う
+static uint8_t  advertisedMaxPayload = 0; ///< 送る通知の最大搬送データサイズの書き換え（0: しない）
+static uint32_t nowMs = 0;      ///< 仮想時計
+static Result   result{};
+
+/**
+ * @brief 全バイトを書き込む
+ */
+static void writeAll(const void* data, size_t len)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::write(peerFd, p, len);
+        if (n <= 0)
+        {
+            perror("write");
+            exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief 全バイトを読み出す
+ */
+static void readAll(void* data, size_t len)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::read(peerFd, p, len);
+        if (n <= 0)
+        {
+            perror("read");
+            exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief データを運ぶフレームか（従来形式・可変長・冗長・優先）
+ */
+static bool isDataFrame(const uint8_t* data, size_t len)
+{
+    if (len == Wire::LEGACY_FRAME_SIZE)
+    {
+        return true;
+    }
+    uint8_t type = data[0];
+    return type == static_cast<uint8_t>(Wire::FrameType::Data)
+        || type == static_cast<uint8_t>(Wire::FrameType::Redundant)
+        || type == static_cast<uint8_t>(Wire::FrameType::Priority);
+}
+
+/**
+ * @brief ハンドシェイクの通知・応答なら最大搬送データサイズを書き換え、CRC32 を付け直す
+ */
+static void patchHello(uint8_t* frame, size_t len)
+{
+    if (advertisedMaxPayload == 0 || len != Wire::EXT_HEADER_SIZE + Wire::HELLO_BODY_SIZE + Wire::CRC32_SIZE ||
+        frame[0] != static_cast<uint8_t>(Wire::FrameType::Hello))
+    {
+        return;
+    }
+    frame[Wire::EXT_OFFSET_BODY + Wire::HELLO_OFFSET_MAX_PAYLOAD] = advertisedMaxPayload;
+    size_t body = len - Wire::CRC32_SIZE;
+    Codec::storeLE32(frame + body, Codec::crc32(frame, body));
+}
+
+/**
+ * @brief esp_now_send() のフック。相手プロセスへ渡す
+ */
+static void onSend(const uint8_t*, const uint8_t* sent, size_t len)
+{
+    uint8_t data[Wire::MAX_FRAME_SIZE];
+    memcpy(data, sent, len);
+    patchHello(data, len);
+    if (nowMs >= MEASURE_MS && isDataFrame(data, len))
+    {
+        result.dataFrames++;
+        result.dataBytes += static_cast<uint32_t>(len);
+    }
+    if (outage && len != Wire::LEGACY_FRAME_SIZE && data[0] == static_cast<uint8_t>(Wire::FrameType::Hello))
+    {
+        result.outageHellos++;
+    }
+    if (outage || nowMs < dropUntilMs)
+    {
+        return;
+    }
+    uint16_t n = static_cast<uint16_t>(len);
+    writeAll(&n, sizeof(n));
+    writeAll(data, len);
+}
+
+/**
+ * @brief 相手プロセスの1刻み分の送信を受信処理へ投入する
+ * @param legacy 従来版として、215バイト以外のフレームを読み捨てるか
+ */
+static void receiveTick(bool legacy)
+{
+    for (;;)
+    {
+        uint16_t len;
+        uint8_t frame[Wire::MAX_FRAME_SIZE];
+        readAll(&len, sizeof(len));
+        if (len == END_OF_TICK)
+        {
+            return;
+        }
+        if (len > sizeof(frame))
+        {
+            fprintf(stderr, "bad frame length %u\n", len);
+            exit(1);
+        }
+        readAll(frame, len);
+        // 従来版は型付きフレームを知らない。ハンドシェイクの通知は読み捨てられる前提なので数えない
+        if (legacy && len != Wire::LEGACY_FRAME_SIZE)
+        {
+            if (frame[0] != static_cast<uint8_t>(Wire::FrameType::Hello))
+            {
+                result.unreadable++;
+            }
+            continue;
+        }
+        InjectFrame(frame, len);
+    }
+}
+
+/**
+ * @brief 片側を動かす
+ * @param controller true:コントローラ / false:ロボット
+ * @param scenario   組み合わせ
+ */
+static void run(bool controller, const Scenario& scenario)
+{
+    const uint8_t ctrlAddr[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+    const uint8_t roboAddr[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+    const uint8_t pmk[ESP_NOW_KEY_LEN] = { 'p', 'm', 'k' };
+    const uint8_t lmk[ESP_NOW_KEY_LEN] = { 'l', 'm', 'k' };
+    bool legacy = !controller && scenario.legacy;
+
+    result = Result{};
+    result.firstAgreedMs = 0xFFFFFFFF;
+    dropUntilMs = controller ? scenario.dropToRobotMs : 0;
+    advertisedMaxPayload = controller ? 0 : scenario.robotMaxPayload;
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(controller ? ctrlAddr : roboAddr, controller ? roboAddr : ctrlAddr, 0, 1000);
+    if (scenario.encrypted)
+    {
+        SetEncryption(pmk, lmk);
+    }
+    if (legacy)
+    {
+        // 従来版は 215バイトのデータフレームしか送らない
+        SetPeerCapabilities(0);
+    }
+    else
+    {
+        HelloConfig config = { 200, 5, controller ? Wire::HELLO_CAPS_ALL : scenario.capabilities };
+        HelloBegin(config);
+    }
+
+    uint8_t payload[PAYLOAD_SIZE] = {};
+    for (nowMs = 0; nowMs < END_MS; nowMs += TICK_MS)
+    {
+        HostShim::SetMicros(nowMs * 1000);
+        outage = (nowMs >= OUTAGE_START && nowMs < OUTAGE_END);
+        if (nowMs % SEND_MS == 0)
+        {
+            payload[0] = static_cast<uint8_t>(nowMs / SEND_MS);
+            SendPacket(nowMs, payload, sizeof(payload));
+        }
+        else if (nowMs % HEARTBEAT_MS == 0 && !legacy)
+        {
+            SendHeartbeat(nowMs);
+        }
+        if (!legacy)
+        {
+            HelloService(nowMs);
+            HelloState state = HelloGetState();
+            if (result.firstAgreedMs == 0xFFFFFFFF && (state == HelloState::Negotiated || state == HelloState::Legacy))
+            {
+                result.firstAgreedMs = nowMs;
+            }
+        }
+        uint16_t end = END_OF_TICK;
+        writeAll(&end, sizeof(end));
+        receiveTick(legacy);
+
+        uint32_t timestamp;
+        uint8_t address[6];
+        uint8_t data[CARRIED_DATA_MAX_SIZE];
+        uint8_t size;
+        for (;;)
+        {
+            Status status = PopOldestPacket(nowMs, &timestamp, address, data, &size);
+            if (status == Status::Ok)
+            {
+                result.received++;
+                result.receivedSettled += (nowMs >= SETTLED_MS && nowMs < OUTAGE_START) ? 1 : 0;
+                result.receivedLate += (nowMs >= MEASURE_MS) ? 1 : 0;
+            }
+            else if (status != Status::CrcError)
+            {
+                break;
+            }
+        }
+    }
+    HelloGetLink(&result.link);
+
+    // 相手の最大搬送データサイズを超える送信は、送らずに拒否されなければならない
+    if (controller && scenario.robotMaxPayload != 0)
+    {
+        uint8_t big[CARRIED_DATA_MAX_SIZE] = {};
+        uint8_t over = static_cast<uint8_t>(scenario.robotMaxPayload + 1);
+        result.oversizeRejected = result.link.peerMaxPayload == scenario.robotMaxPayload
+            && GetPeerMaxPayload() == scenario.robotMaxPayload
+            && SendPacket(nowMs, big, over) == Status::InvalidArg
+            && SendPriorityPacket(nowMs, big, over) == Status::InvalidArg
+            && SendExtFrame(static_cast<uint8_t>(Wire::FrameType::Rpc), big, over) == Status::InvalidArg
+            && PublisherUpdate(big, over) == Status::InvalidArg;
+    }
+}
+
+/**
+ * @brief 状態の表示名
+ */
+static const char* stateName(HelloState state)
+{
+    switch (state)
+    {
+    case HelloState::Idle:        return "idle";
+    case HelloState::Negotiating: return "negotiating";
+    case HelloState::Negotiated:  return "negotiated";
+    case HelloState::Legacy:      return "legacy";
+    }
+    return "?";
+}
+
+/**
+ * @brief 整合性検査の表示名
+ */
+static const char* checkName(IntegrityCheck check)
+{
+    switch (check)
+    {
+    case IntegrityCheck::Crc32: return "crc32";
+    case IntegrityCheck::Crc16: return "crc16";
+    case IntegrityCheck::None:  return "none";
+    }
+    return "?";
+}
+
+/**
+ * @brief 片側の結果を1行で表示する
+ */
+static void printSide(const char* side, const Result& r, bool legacy)
+{
+    uint32_t average = r.dataFrames ? r.dataBytes / r.dataFrames : 0;
+    if (legacy)
+    {
+        printf("  %-10s %-11s %8s %8s %6s %6s %8u %8u %10u\n", side, "(baseline)", "-", "-", "-", "-",
+               average, r.received, r.unreadable);
+        return;
+    }
+    char agreed[16];
+    if (r.firstAgreedMs == 0xFFFFFFFF)
+    {
+        snprintf(agreed, sizeof(agreed), "-");
+    }
+    else
+    {
+        snprintf(agreed, sizeof(agreed), "%u", r.firstAgreedMs);
+    }
+    printf("  %-10s %-11s %8s %8s %6s %6u %8u %8u %10u\n", side, stateName(r.link.state), agreed,
+           r.link.format == FrameFormat::Compact ? "compact" : "full", checkName(r.link.check),
+           r.link.negotiations, average, r.received, r.unreadable);
+}
+
+int main(int argc, char**)
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: wcom_hello_sim\n");
+        return 2;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < SCENARIO_COUNT; ++i)
+    {
+        const Scenario& scenario = SCENARIOS[i];
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        {
+            perror("socketpair");
+            return 1;
+        }
+        fflush(stdout);
+        pid_t child = fork();
+        if (child < 0)
+        {
+            perror("fork");
+            return 1;
+        }
+        bool controller = (child != 0);
+        peerFd = controller ? fds[0] : fds[1];
+        close(controller ? fds[1] : fds[0]);
+
+        run(controller, scenario);
+        if (!controller)
+        {
+            // ロボット側の結果をコントローラへ渡して終わる
+            writeAll(&result, sizeof(result));
+            return 0;
+        }
+        Result robot;
+        readAll(&robot, sizeof(robot));
+        waitpid(child, nullptr, 0);
+        close(peerFd);
+
+        printf("%s\n", scenario.name);
+        printf("  %-10s %-11s %8s %8s %6s %6s %8s %8s %10s\n", "side", "state", "agreed", "format",
+               "check", "nego", "data_b", "recv", "unreadable");
+        printSide("controller", result, false);
+        printSide("robot", robot, scenario.legacy);
+        if (result.unreadable != 0 || robot.unreadable != 0)
+        {
+            ok = false;
+        }
+        if (result.outageHellos == 0 || (!scenario.legacy && robot.outageHellos == 0))
+        {
+            printf("  %s sent no hello while the link was lost\n", result.outageHellos == 0 ? "controller" : "robot");
+            ok = false;
+        }
+        if (scenario.robotMaxPayload != 0)
+        {
+            printf("  controller rejects payload > %u: %s (peer max %u)\n", scenario.robotMaxPayload,
+                   result.oversizeRejected ? "yes" : "NO", result.link.peerMaxPayload);
+            ok = ok && result.oversizeRejected;
+        }
+        if (result.receivedSettled == 0 || robot.receivedSettled == 0)
+        {
+            printf("  link stalled: %s received nothing in %u-%u ms\n",
+                   result.receivedSettled == 0 ? "controller" : "robot", SETTLED_MS, OUTAGE_START);
+            ok = false;
+        }
+        if (result.receivedLate == 0 || robot.receivedLate == 0)
+        {
+            printf("  link stalled: %s received nothing after %u ms\n",
+                   result.receivedLate == 0 ? "controller" : "robot", MEASURE_MS);
+            ok = false;
+        }
+    }
+    printf("all frames readable and delivered: %s\n", ok ? "yes" : "NO");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file wcom_integrity_bench.cpp
+ * @brief 型付きフレームの整合性検査（IntegrityCheck）ごとの1フレームあたりのコストを測る PC側ツール
+ * @details
+ * 可変長形式（FrameFormat::Compact）のデータフレームについて、整合性検査の設定ごとに次を表示する。
+ *
+ * - フレーム長と、1Mbps での通信時間
+ * - 送信処理（SendPacket: フレーム組み立てと検査値の計算）の時間
+ * - 受信処理（InjectFrame + PopOldestPacket: 検証と受信バッファ経由の取り出し）の時間
+ * - 1バイト壊したフレームを検出できるか
+ * - 通信相手以外の MAC から届いたフレームの扱い（CRC32 より弱い検査では捨てなければならない）
+ *
+ * 暗号化（CCMP）自体は ESP-NOW のハードウェアで行われるため、ここでは測らない。
+ * 時間は PC 上の値であり、ESP32 上の絶対値ではなく設定間の比較に使う。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_integrity_bench \
+ *       tools/wcom_integrity_bench.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_integrity_bench [--frames 繰り返し回数=200000]
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "ROBO_WCOM.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t BYTE_US = 8;     ///< 1バイトあたりの通信時間（1Mbps）
+
+/**
+ * @brief 測定する設定
+ */
+struct Mode {
+    const char*    name;        ///< 表示名
+    bool           encrypt;     ///< 暗号化Peerとして登録するか
+    IntegrityCheck check;       ///< 整合性検査
+};
+
+static const Mode MODES[] = {
+    { "crc32",         false, IntegrityCheck::Crc32 },
+    { "ccmp+crc32",    true,  IntegrityCheck::Crc32 },
+    { "ccmp+crc16",    true,  IntegrityCheck::Crc16 },
+    { "ccmp+none",     true,  IntegrityCheck::None  },
+};
+
+static const uint8_t PAYLOAD_SIZES[] = { 32, 120, 200 };
+
+static const uint8_t OWN_ADDR[6]  = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+static const uint8_t FOREIGN_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x66 };
+static const uint8_t PMK[16] = { 'r', 'o', 'b', 'o', '-', 'w', 'c', 'o', 'm', '-', 'p', 'm', 'k', '-', '0', '1' };
+static const uint8_t LMK[16] = { 'r', 'o', 'b', 'o', '-', 'w', 'c', 'o', 'm', '-', 'l', 'm', 'k', '-', '0', '1' };
+
+static std::vector<uint8_t> lastFrame;  ///< 最後に送信したフレーム
+static bool captureFrame = false;       ///< 送信フレームを lastFrame へ写すか
+
+/**
+ * @brief esp_now_send() のフック
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    if (captureFrame)
+    {
+        lastFrame.assign(data, data + len);
+    }
+}
+
+/**
+ * @brief 経過秒数
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 設定を適用する
+ * @return ステータスコード (Status)
+ */
+static Status applyMode(const Mode& mode)
+{
+    Init(OWN_ADDR, PEER_ADDR, millis(), 1000);
+    SetFrameFormat(FrameFormat::Compact);
+    if (mode.encrypt)
+    {
+        Status s = SetEncryption(PMK, LMK);
+        if (s != Status::Ok)
+        {
+            return s;
+        }
+    }
+    return SetIntegrityCheck(mode.check);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 200000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--frames") == 0)
+        {
+            frames = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--frames N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames == 0)
+    {
+        fprintf(stderr, "frames must be >= 1\n");
+        return 2;
+    }
+
+    HostShim::SetSendHook(onSend);
+
+    // 暗号化していなければ CRC32 より弱い検査は拒否される
+    Init(OWN_ADDR, PEER_ADDR, millis(), 1000);
+    Status refused = SetIntegrityCheck(IntegrityCheck::None);
+    printf("SetIntegrityCheck(None) without encryption: %s\n", ToString(refused));
+    if (refused != Status::NotEncrypted)
+    {
+        return 1;
+    }
+
+    bool allOk = true;
+    for (uint8_t payloadSize : PAYLOAD_SIZES)
+    {
+        printf("\npayload %u bytes, %u frames\n", payloadSize, frames);
+        printf("%-12s %7s %9s %9s %9s %9s %9s\n", "mode", "bytes", "air_us", "tx_ns", "rx_ns", "corrupt", "foreign");
+
+        uint8_t payload[CARRIED_DATA_MAX_SIZE];
+        for (uint8_t i = 0; i < payloadSize; ++i)
+        {
+            payload[i] = static_cast<uint8_t>(i * 37 + 11);
+        }
+
+        for (const Mode& mode : MODES)
+        {
+            Status s = applyMode(mode);
+            if (s != Status::Ok)
+            {
+                printf("%-12s setup failed: %s\n", mode.name, ToString(s));
+                allOk = false;
+                continue;
+            }
+
+            // 送信フレームを1つ取っておき、往復で元に戻るか確かめる
+            captureFrame = true;
+            SendPacket(1, payload, payloadSize);
+            captureFrame = false;
+            std::vector<uint8_t> frame = lastFrame;
+            uint32_t ts;
+            uint8_t addr[6];
+            uint8_t data[CARRIED_DATA_MAX_SIZE];
+            uint8_t size;
+            InjectFrame(frame.data(), static_cast<int>(frame.size()));
+            s = PopOldestPacket(millis(), &ts, addr, data, &size);
+            if (s != Status::Ok || size != payloadSize || memcmp(data, payload, size) != 0)
+            {
+                printf("%-12s round trip failed: %s\n", mode.name, ToString(s));
+                allOk = false;
+                continue;
+            }
+
+            // 搬送データの1バイトを壊したフレームを検出できるか
+            std::vector<uint8_t> corrupted = frame;
+            corrupted[corrupted.size() / 2] ^= 0x10;
+            InjectFrame(corrupted.data(), static_cast<int>(corrupted.size()));
+            Status corruptStatus = PopOldestPacket(millis(), &ts, addr, data, &size);
+            bool detected = (corruptStatus == Status::CrcError);
+            if (!detected && mode.check != IntegrityCheck::None)
+            {
+                allOk = false;
+            }
+
+            // 同じフレームを通信相手と、それ以外の MAC から受信させる
+            HostShim::Receive(PEER_ADDR, frame.data(), static_cast<int>(frame.size()));
+            bool peerAccepted = (PopOldestPacket(millis(), &ts, addr, data, &size) == Status::Ok);
+            HostShim::Receive(FOREIGN_ADDR, frame.data(), static_cast<int>(frame.size()));
+            bool foreignAccepted = (PopOldestPacket(millis(), &ts, addr, data, &size) != Status::BufferEmpty);
+            bool foreignExpected = (mode.check == IntegrityCheck::Crc32);
+            if (!peerAccepted || foreignAccepted != foreignExpected)
+            {
+                printf("%-12s sender check failed: peer %s, foreign %s\n", mode.name,
+                       peerAccepted ? "accepted" : "dropped", foreignAccepted ? "accepted" : "dropped");
+                allOk = false;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                payload[0] = static_cast<uint8_t>(i);
+                SendPacket(i, payload, payloadSize);
+            }
+            double txNs = secondsSince(start) * 1e9 / frames;
+
+            start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                InjectFrame(frame.data(), static_cast<int>(frame.size()));
+                PopOldestPacket(millis(), &ts, addr, data, &size);
+            }
+            double rxNs = secondsSince(start) * 1e9 / frames;
+
+            printf("%-12s %7u %9u %9.1f %9.1f %9s %9s\n", mode.name,
+                   static_cast<unsigned>(frame.size()), static_cast<unsigned>(frame.size() * BYTE_US),
+                   txNs, rxNs, detected ? "detected" : "missed", foreignAccepted ? "accepted" : "dropped");
+        }
+    }
+    return allOk ? 0 : 1;
+}
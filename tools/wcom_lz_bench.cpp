@@ -0,0 +1,406 @@
+/**
+ * @file wcom_lz_bench.cpp
+ * @brief 一括転送の圧縮（ROBO_WCOM_Lz.h）の圧縮率と速度を測る PC側ツール
+ * @details
+ * RoboStatus_t を 50Hz で記録したログを模擬して生成し（--file で任意のファイルも可）、
+ * 窓の大きさごとに次を表示する。
+ *
+ * - 圧縮率と、一括転送で必要なデータフレーム数（圧縮なしとの比較）
+ * - 圧縮・伸長の速度（一括転送と同じく 64 バイトずつ投入し、1フレーム分ずつ取り出す）
+ *
+ * 最後に ROBO_WCOM_Bulk の送受信を1プロセス内で折り返し（損失あり）、伸長結果が元と一致するかを確かめる。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -I src -o wcom_lz_bench \
+ *       tools/wcom_lz_bench.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_lz_bench [--seconds 記録秒数=60] [--loss 百分率=10] [--file ファイル]
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Bulk.h"
+#include "ROBO_WCOM_Lz.h"
+#include "robo_packet.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t LOG_RATE_HZ  = 50;   ///< ログの記録周期
+constexpr size_t   FEED_CHUNK   = 64;   ///< 圧縮器へ一度に投入するバイト数（一括転送と同じ）
+constexpr double   MIN_BENCH_S  = 0.3;  ///< 速度測定で最低限繰り返す時間
+
+/**
+ * @brief 再現性のある乱数（xorshift32）
+ */
+static uint32_t rngState = 1;
+static uint32_t rnd(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+/**
+ * @brief -1..1 の一様乱数
+ */
+static float rndUnit(void)
+{
+    return static_cast<float>(rnd() % 20001) / 10000.0f - 1.0f;
+}
+
+/**
+ * @brief RoboStatus_t のログを模擬して生成する
+ * @details
+ * - 電圧・電流は 12bit ADC の値を換算したもの（数カウントの揺らぎを含む）
+ * - 消費電力量は毎回積算されるため下位ビットが常に変わる
+ * - モータ出力はスティック操作を 0.01 刻みにしたもので、0.2～2秒ごとに変わる。武器用の2つは大半が 0
+ * - 武器フラグ・スイッチはまれに変わる
+ */
+static std::vector<uint8_t> makeStatusLog(uint32_t seconds)
+{
+    const float adcVolt = 3.3f / 4095.0f * 11.0f;   // 分圧 1/11
+    const float adcAmp  = 3.3f / 4095.0f * 20.0f;   // 50mV/A
+    std::vector<uint8_t> log;
+    RoboStatus_t s;
+    memset(&s, 0, sizeof(s));
+    float battery = 16.8f;
+    float wh = 0.0f;
+    float stick[MOTOR_NUM] = {};
+    uint32_t holdUntil = 0;
+
+    uint32_t records = seconds * LOG_RATE_HZ;
+    for (uint32_t i = 0; i < records; ++i)
+    {
+        if (i >= holdUntil)
+        {
+            for (int m = 0; m < MOTOR_NUM; ++m)
+            {
+                bool weapon = (m >= MOTOR_NUM - 2);
+                stick[m] = (weapon && rnd() % 4 != 0) ? 0.0f : std::round(rndUnit() * 100.0f) / 100.0f;
+            }
+            holdUntil = i + LOG_RATE_HZ / 5 + rnd() % (LOG_RATE_HZ * 2);
+        }
+        float load = 0.0f;
+        for (int m = 0; m < MOTOR_NUM; ++m)
+        {
+            s.motors[m] = stick[m];
+            load += std::fabs(stick[m]);
+        }
+        float amps = 0.5f + load * 2.5f;
+        battery -= amps * 0.000002f;
+        int voltCount = static_cast<int>((battery - amps * 0.05f) / adcVolt) + static_cast<int>(rnd() % 5) - 2;
+        int ampCount = static_cast<int>(amps / adcAmp) + static_cast<int>(rnd() % 5) - 2;
+        s.Power.voltage = voltCount * adcVolt;
+        s.Power.current = ampCount * adcAmp;
+        wh += s.Power.voltage * s.Power.current / (3600.0f * LOG_RATE_HZ);
+        s.Power.wh = wh;
+        if (rnd() % 500 == 0)
+        {
+            s.WEAPON_FLAGS.FLAGS ^= static_cast<uint8_t>(1u << (rnd() % 8));
+        }
+        if (rnd() % 100 == 0)
+        {
+            s.MANSWICH.SWITCHES ^= static_cast<uint16_t>(1u << (rnd() % 12));
+        }
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&s);
+        log.insert(log.end(), p, p + sizeof(s));
+    }
+    return log;
+}
+
+/**
+ * @brief ファイルを読み込む
+ */
+static bool readFile(const char* path, std::vector<uint8_t>& data)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        return false;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+/**
+ * @brief 経過秒数
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief 一括転送と同じ手順で圧縮する（FEED_CHUNK ずつ投入し、1フレーム分ずつ取り出す）
+ * @return 圧縮後のデータ（フレームごと）
+ */
+template <unsigned W>
+static std::vector<std::vector<uint8_t>> compressFrames(const std::vector<uint8_t>& in)
+{
+    static LzEncoder<W, BULK_LOOKAHEAD_BITS> enc;
+    enc.reset();
+    std::vector<std::vector<uint8_t>> frames;
+    uint8_t frame[Wire::BULK_PAYLOAD_MAX];
+    size_t used = 0;
+    size_t pos = 0;
+    for (;;)
+    {
+        used += enc.poll(frame + used, sizeof(frame) - used);
+        if (used == sizeof(frame) || (enc.done() && used > 0))
+        {
+            frames.push_back(std::vector<uint8_t>(frame, frame + used));
+            used = 0;
+            continue;
+        }
+        if (enc.done())
+        {
+            break;
+        }
+        if (pos < in.size())
+        {
+            size_t n = in.size() - pos;
+            pos += enc.sink(in.data() + pos, n < FEED_CHUNK ? n : FEED_CHUNK);
+        }
+        else
+        {
+            enc.finish();
+        }
+    }
+    return frames;
+}
+
+/**
+ * @brief フレームごとに伸長する
+ */
+template <unsigned W>
+static std::vector<uint8_t> decompressFrames(const std::vector<std::vector<uint8_t>>& frames)
+{
+    static LzDecoder<W, BULK_LOOKAHEAD_BITS> dec;
+    dec.reset();
+    std::vector<uint8_t> out;
+    uint8_t buf[64];
+    for (const std::vector<uint8_t>& f : frames)
+    {
+        size_t consumed = 0;
+        for (;;)
+        {
+            consumed += dec.sink(f.data() + consumed, f.size() - consumed);
+            size_t n = dec.poll(buf, sizeof(buf));
+            if (n > 0)
+            {
+                out.insert(out.end(), buf, buf + n);
+            }
+            else if (consumed >= f.size())
+            {
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief 1つの窓の大きさについて測定して1行表示する
+ * @return 伸長結果が元と一致したか
+ */
+template <unsigned W>
+static bool benchWindow(const std::vector<uint8_t>& data)
+{
+    std::vector<std::vector<uint8_t>> frames;
+    uint32_t rounds = 0;
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        frames = compressFrames<W>(data);
+        rounds++;
+    } while (secondsSince(start) < MIN_BENCH_S);
+    double encMBps = static_cast<double>(data.size()) * rounds / secondsSince(start) / 1e6;
+
+    std::vector<uint8_t> restored;
+    rounds = 0;
+    start = std::chrono::steady_clock::now();
+    do
+    {
+        restored = decompressFrames<W>(frames);
+        rounds++;
+    } while (secondsSince(start) < MIN_BENCH_S);
+    double decMBps = static_cast<double>(data.size()) * rounds / secondsSince(start) / 1e6;
+
+    size_t packed = 0;
+    for (const std::vector<uint8_t>& f : frames)
+    {
+        packed += f.size();
+    }
+    size_t rawFrames = (data.size() + Wire::BULK_PAYLOAD_MAX - 1) / Wire::BULK_PAYLOAD_MAX;
+    bool ok = (restored == data);
+    printf("%6u %7u %10zu %7.3f %8zu %8zu %9.1f %9.1f %s\n", 1u << W, 3u << W, packed,
+           static_cast<double>(packed) / data.size(), rawFrames, frames.size(), encMBps, decMBps, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+//=== 一括転送の折り返し ===//
+
+static std::deque<std::vector<uint8_t>> wire;   ///< 送信されたフレーム（次の刻みで受信側へ投入）
+static uint32_t lossPercent = 10;               ///< フレームを捨てる割合
+static uint32_t droppedFrames = 0;              ///< 捨てたフレーム数
+
+struct Source {
+    const std::vector<uint8_t>* data;
+    size_t pos;
+};
+
+struct Sink {
+    std::vector<uint8_t> data;
+    Status status;
+    bool done;
+};
+
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    if (rnd() % 100 < lossPercent)
+    {
+        droppedFrames++;
+        return;
+    }
+    wire.push_back(std::vector<uint8_t>(data, data + len));
+}
+
+static size_t readSource(uint8_t* data, size_t maxSize, void* context)
+{
+    Source* src = static_cast<Source*>(context);
+    size_t n = src->data->size() - src->pos;
+    n = (n < maxSize) ? n : maxSize;
+    memcpy(data, src->data->data() + src->pos, n);
+    src->pos += n;
+    return n;
+}
+
+static void writeSink(const uint8_t* data, size_t size, void* context)
+{
+    Sink* sink = static_cast<Sink*>(context);
+    sink->data.insert(sink->data.end(), data, data + size);
+}
+
+static void onReceived(Status status, uint32_t, void* context)
+{
+    Sink* sink = static_cast<Sink*>(context);
+    sink->status = status;
+    sink->done = true;
+}
+
+/**
+ * @brief ROBO_WCOM_Bulk で送受信し、所要時間（仮想時間）とフレーム数を表示する
+ * @return 受信結果が元と一致したか
+ */
+static bool loopback(const std::vector<uint8_t>& data, bool compress)
+{
+    const uint8_t addr[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(addr, addr, 0, 1000);
+    BulkBegin(20);
+    Source src = { &data, 0 };
+    Sink sink;
+    sink.status = Status::Ok;
+    sink.done = false;
+    SetBulkReceiver(writeSink, onReceived, &sink);
+    BulkSend(readSource, compress, nullptr, &src);
+    wire.clear();
+    droppedFrames = 0;
+
+    // 1ms ごとに BulkService() を呼び、送信されたフレームを次の刻みで投入する
+    uint32_t now = 0;
+    while ((BulkIsSending() || !sink.done) && now < 600000)
+    {
+        HostShim::SetMicros(now * 1000);
+        std::deque<std::vector<uint8_t>> arrived;
+        arrived.swap(wire);
+        for (const std::vector<uint8_t>& f : arrived)
+        {
+            InjectFrame(f.data(), static_cast<int>(f.size()));
+        }
+        BulkService(now);
+        now++;
+    }
+    BulkStats stats;
+    GetBulkStats(&stats);
+    bool ok = sink.done && sink.status == Status::Ok && sink.data == data;
+    printf("%-4s %8u %8u %8u %8u %9u ms  %s (%s)\n", compress ? "lz" : "raw", stats.payloadBytesSent,
+           stats.framesSent, stats.retries, droppedFrames, now, ok ? "ok" : "MISMATCH", ToString(sink.status));
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seconds = 60;
+    const char* file = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--seconds") == 0)
+        {
+            seconds = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--loss") == 0)
+        {
+            lossPercent = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--file") == 0)
+        {
+            file = argv[i + 1];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--seconds N] [--loss percent] [--file path]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (lossPercent >= 100)
+    {
+        fprintf(stderr, "loss must be 0..99\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (file)
+    {
+        if (!readFile(file, data))
+        {
+            perror(file);
+            return 1;
+        }
+        printf("input: %s, %zu bytes\n", file, data.size());
+    }
+    else
+    {
+        data = makeStatusLog(seconds);
+        printf("input: simulated RoboStatus_t log, %u s at %u Hz, %zu records x %zu bytes = %zu bytes\n",
+               seconds, LOG_RATE_HZ, data.size() / sizeof(RoboStatus_t), sizeof(RoboStatus_t), data.size());
+    }
+
+    printf("\n%6s %7s %10s %7s %8s %8s %9s %9s\n", "window", "ram_b", "packed_b", "ratio", "frames", "lz_frms",
+           "enc_MB/s", "dec_MB/s");
+    bool ok = true;
+    ok = benchWindow<6>(data) && ok;
+    ok = benchWindow<8>(data) && ok;
+    ok = benchWindow<10>(data) && ok;
+    ok = benchWindow<12>(data) && ok;
+
+    printf("\nbulk loopback (window %u, loss %u%%, retry 20 ms)\n", BULK_WINDOW_BITS, lossPercent);
+    printf("%-4s %8s %8s %8s %8s %12s\n", "mode", "payload", "frames", "retries", "dropped", "virtual");
+    ok = loopback(data, false) && ok;
+    ok = loopback(data, true) && ok;
+    return ok ? 0 : 1;
+}
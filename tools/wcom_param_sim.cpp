@@ -0,0 +1,329 @@
+/**
+ * @file wcom_param_sim.cpp
+ * @brief パラメータ同期（ROBO_WCOM_Param.h）の通信量を損失のある通信路で測る PC側ツール
+ * @details
+ * コントローラとロボットを2つのプロセスで動かし、送信フレームを socketpair で相手へ渡す。
+ * 仮想時計は 10ms 刻みで両プロセスが足並みを揃えて進めるため、同じ引数なら結果は毎回同じになる。
+ * 送信側で指定の割合のフレームを捨てる。
+ *
+ * 1. initial   : コントローラが全パラメータを設定する（0～2秒）
+ * 2. steady    : 100ms ごとに2つずつ書き換える（2～12秒）
+ * 3. outage    : 通信を完全に断ち、その間も書き換える（12～15秒）
+ * 4. reconnect : 通信を戻し、全エントリを送り直す（15～20秒、最後の1秒は書き換えない）
+ * 5. conflict  : 通信を断ち、両側が同じキーへ別の値を書く（20～21秒）。版番号が同じになる
+ * 6. rejoin    : 通信を戻し、衝突したキーが両側で同じ値にそろうのを待つ（21～25秒）
+ *
+ * 各区間の同期フレーム数・バイト数（拡張フレームのヘッダと CRC を含む）を、
+ * 全パラメータを指令に載せて 20ms ごとに送る場合と比べて表示する。最後に両側の表が一致したかを確認する。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_param_sim \
+ *       tools/wcom_param_sim.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_param_sim [--params N=32] [--loss 百分率=10] [--seed S=1]
+ */
+#include <Arduino.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Param.h"
+#include "ROBO_WCOM_Wire.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t TICK_MS        = 10;     ///< 仮想時計の刻み
+constexpr uint32_t HEARTBEAT_MS   = 50;     ///< 生存通知の周期
+constexpr uint32_t CHANGE_MS      = 100;    ///< 書き換えの周期
+constexpr uint32_t BASELINE_MS    = 20;     ///< 比較対象（指令に載せる場合）の送信周期
+constexpr uint32_t SETTLE_MS      = 1000;   ///< 最後にこの時間は書き換えず、同期の完了を待つ
+constexpr uint16_t END_OF_TICK    = 0;      ///< 1刻み分の送信の終わりを示す長さ
+
+/**
+ * @brief 区間
+ */
+struct Phase {
+    const char* name;   ///< 名前
+    uint32_t    endMs;  ///< 終了時刻
+    bool        outage; ///< 通信を断つか
+};
+
+static const Phase PHASES[] = {
+    { "initial",    2000,  false },
+    { "steady",     12000, false },
+    { "outage",     15000, true  },
+    { "reconnect",  20000, false },
+    { "conflict",   21000, true  },
+    { "rejoin",     25000, false },
+};
+constexpr size_t PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+constexpr size_t RECONNECT_PHASE = 3;       ///< 書き換えを続ける最後の区間
+constexpr size_t CONFLICT_PHASE  = 4;       ///< 両側が同じキーへ書く区間
+constexpr uint32_t CONFLICT_KEYS = 4;       ///< 両側が書くキーの数
+
+/**
+ * @brief 区間ごとの送信量
+ */
+struct Traffic {
+    uint32_t frames;    ///< 同期フレーム数
+    uint32_t bytes;     ///< 同期フレームのバイト数
+    uint32_t dropped;   ///< 捨てた同期フレーム数
+};
+
+static int      peerFd = -1;        ///< 相手プロセスとの socket
+static uint32_t lossPercent = 10;   ///< フレームを捨てる割合
+static bool     outage = false;     ///< 通信を断っているか
+static Traffic  traffic[PHASE_COUNT];
+static size_t   phase = 0;          ///< 現在の区間
+
+/**
+ * @brief 全バイトを書き込む
+ */
+static void writeAll(const void* data, size_t len)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::write(peerFd, p, len);
+        if (n <= 0)
+        {
+            perror("write");
+            exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief 全バイトを読み出す
+ */
+static void readAll(void* data, size_t len)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::read(peerFd, p, len);
+        if (n <= 0)
+        {
+            perror("read");
+            exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief esp_now_send() のフック。損失を与えて相手プロセスへ渡す
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    bool param = (len > 0 && data[0] == static_cast<uint8_t>(Wire::FrameType::Param));
+    bool drop = outage || static_cast<uint32_t>(std::rand() % 100) < lossPercent;
+    if (param)
+    {
+        traffic[phase].frames++;
+        traffic[phase].bytes += static_cast<uint32_t>(len);
+        traffic[phase].dropped += drop ? 1 : 0;
+    }
+    if (drop)
+    {
+        return;
+    }
+    uint16_t n = static_cast<uint16_t>(len);
+    writeAll(&n, sizeof(n));
+    writeAll(data, len);
+}
+
+/**
+ * @brief 相手プロセスの1刻み分の送信を受信処理へ投入する
+ */
+static void receiveTick(void)
+{
+    for (;;)
+    {
+        uint16_t len;
+        uint8_t frame[Wire::MAX_FRAME_SIZE];
+        readAll(&len, sizeof(len));
+        if (len == END_OF_TICK)
+        {
+            return;
+        }
+        if (len > sizeof(frame))
+        {
+            fprintf(stderr, "bad frame length %u\n", len);
+            exit(1);
+        }
+        readAll(frame, len);
+        InjectFrame(frame, len);
+    }
+}
+
+/**
+ * @brief パラメータ表の要約（キー順に値を混ぜたもの）
+ */
+static uint32_t tableHash(uint32_t params)
+{
+    uint32_t hash = 2166136261u;
+    for (uint32_t key = 0; key < params; ++key)
+    {
+        uint32_t value = 0;
+        ParamGet(static_cast<uint8_t>(key), &value);
+        hash = (hash ^ value) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 片側を動かす
+ * @param controller true:コントローラ（書き込む側） / false:ロボット
+ * @return 表の要約
+ */
+static uint32_t run(bool controller, uint32_t params, uint32_t seed)
+{
+    std::srand(seed * 2 + (controller ? 0 : 1));
+    const uint8_t ctrlAddr[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+    const uint8_t roboAddr[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(controller ? ctrlAddr : roboAddr, controller ? roboAddr : ctrlAddr, 0, 1000);
+    for (uint32_t key = 0; key < params; ++key)
+    {
+        ParamDefine(static_cast<uint8_t>(key), 0);
+    }
+    ParamBegin(100);
+
+    uint32_t now = 0;
+    for (phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        outage = PHASES[phase].outage;
+        for (; now < PHASES[phase].endMs; now += TICK_MS)
+        {
+            HostShim::SetMicros(now * 1000);
+            if (now % HEARTBEAT_MS == 0)
+            {
+                SendHeartbeat(now);
+            }
+            if (controller)
+            {
+                if (now == 0)
+                {
+                    for (uint32_t key = 0; key < params; ++key)
+                    {
+                        ParamSet(static_cast<uint8_t>(key), 1000 + key);
+                    }
+                }
+                else if (phase > 0 && phase <= RECONNECT_PHASE && now % CHANGE_MS == 0 &&
+                         now + SETTLE_MS < PHASES[RECONNECT_PHASE].endMs)
+                {
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        ParamSet(static_cast<uint8_t>(std::rand() % params), static_cast<uint32_t>(std::rand()));
+                    }
+                }
+            }
+            if (phase == CONFLICT_PHASE && now == PHASES[CONFLICT_PHASE - 1].endMs)
+            {
+                // 直前の区間で両側の版番号はそろっているため、同じ版番号で値だけが食い違う
+                for (uint32_t key = 0; key < CONFLICT_KEYS && key < params; ++key)
+                {
+                    ParamSet(static_cast<uint8_t>(key), (controller ? 0xC0000000u : 0x50000000u) + key);
+                }
+            }
+            ParamService(now);
+            uint16_t end = END_OF_TICK;
+            writeAll(&end, sizeof(end));
+            receiveTick();
+        }
+    }
+    return tableHash(params);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t params = 32;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--params") == 0)
+        {
+            params = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--loss") == 0)
+        {
+            lossPercent = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            seed = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--params N] [--loss percent] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (params == 0 || params > PARAM_MAX || lossPercent > 100)
+    {
+        fprintf(stderr, "params must be 1..%u, loss 0..100\n", static_cast<unsigned>(PARAM_MAX));
+        return 2;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0)
+    {
+        perror("fork");
+        return 1;
+    }
+    bool controller = (child != 0);
+    peerFd = controller ? fds[0] : fds[1];
+    close(controller ? fds[1] : fds[0]);
+
+    uint32_t hash = run(controller, params, seed);
+    ParamStats stats;
+    GetParamStats(&stats);
+
+    if (!controller)
+    {
+        // ロボット側の結果をコントローラへ渡して終わる
+        writeAll(&hash, sizeof(hash));
+        writeAll(traffic, sizeof(traffic));
+        writeAll(&stats, sizeof(stats));
+        return 0;
+    }
+
+    uint32_t roboHash;
+    Traffic roboTraffic[PHASE_COUNT];
+    ParamStats roboStats;
+    readAll(&roboHash, sizeof(roboHash));
+    readAll(roboTraffic, sizeof(roboTraffic));
+    readAll(&roboStats, sizeof(roboStats));
+    waitpid(child, nullptr, 0);
+
+    printf("params=%u loss=%u%% seed=%u\n", params, lossPercent, seed);
+    printf("%-10s %8s %8s %8s %8s %10s\n", "phase", "frames", "bytes", "dropped", "acks_b", "baseline_b");
+    uint32_t start = 0;
+    for (size_t i = 0; i < PHASE_COUNT; ++i)
+    {
+        uint32_t baseline = (PHASES[i].endMs - start) / BASELINE_MS * params * 4;
+        printf("%-10s %8u %8u %8u %8u %10u\n", PHASES[i].name, traffic[i].frames, traffic[i].bytes,
+               traffic[i].dropped, roboTraffic[i].bytes, baseline);
+        start = PHASES[i].endMs;
+    }
+    printf("controller: updates %u, entries %u, retries %u, resyncs %u\n",
+           stats.updatesSent, stats.entriesSent, stats.retries, stats.resyncs);
+    printf("robot     : applied %u, acks %u\n", roboStats.applied, roboStats.acksSent);
+    printf("converged : %s\n", (hash == roboHash) ? "yes" : "NO");
+    return (hash == roboHash) ? 0 : 1;
+}
@@ -0,0 +1,646 @@
+/**
+ * @file wcom_rate_sim.cpp
+ * @brief 混雑するチャネルでの送信レート制御（ROBO_WCOM_Rate.h）の効果を測る PC側ツール
+ * @details
+ * コントローラとロボットを2つのプロセスで動かし、コントローラ側のプロセスが共有チャネルを模擬する。
+ * 仮想時計は 1ms 刻みで両プロセスが足並みを揃えて進めるため、同じ引数なら結果は毎回同じになる。
+ *
+ * - コントローラ : 指令（従来形式 215 バイト）を 20ms 周期で送る（TrafficClass::Command）
+ * - ロボット     : テレメトリ（可変長形式）を --period 周期で送る（TrafficClass::Telemetry）
+ * - チャネル     : 各ノードの送信待ち（最大 --queue フレーム）から交互に1フレームずつ送り出す。
+ *                  1フレームの通信時間は 500us + 8us/バイト（1Mbps）。他の機器が使う時間は使えない。
+ *                  送り出したフレームは一定の割合で失敗し、どちらも送信完了コールバックで通知する
+ *
+ * 1. clear : 他の機器は使っていない（0～5秒）
+ * 2. busy  : 他の機器が --busy % の時間を使う（5～15秒）
+ * 3. clear : 元に戻る（15～20秒）
+ *
+ * レート制御なし・ありの順に実行し、区間ごとに指令とテレメトリの到達レート・遅延を表示する。
+ * ロボットは指令を 20ms 周期で PeekLatestPacket() し、コントローラはテレメトリを毎刻み PopOldestPacket() する。
+ *
+ * --trace を指定すると、各ノードのトレース（ROBO_WCOM_Trace.h）を <prefix>-<off|on>-<ctrl|robo>.bin へ書き出す。
+ * トレースを有効にしてビルドし、tools/wcom_trace2json.cpp で変換する（両ノードの時計は揃っている）。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_rate_sim \
+ *       tools/wcom_rate_sim.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ *   （トレースを取る場合は -DROBO_WCOM_TRACE=1 -DROBO_WCOM_TRACE_EVENTS=65536 を加える）
+ * 使い方:
+ *   wcom_rate_sim [--period テレメトリ周期ms=10] [--busy 百分率=80] [--loss 千分率=30] [--queue N=8] [--seed S=1]
+ *                 [--trace prefix]
+ */
+#include <Arduino.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Publisher.h"
+#include "ROBO_WCOM_Rate.h"
+#include "ROBO_WCOM_Trace.h"
+#include "ROBO_WCOM_Wire.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t TICK_MS          = 1;    ///< 仮想時計の刻み
+constexpr uint32_t COMMAND_PRD_MS   = 20;   ///< 指令の周期
+constexpr uint32_t FRAME_OVERHEAD_US = 500; ///< 1フレームあたりの固定の通信時間
+constexpr uint32_t BYTE_US          = 8;    ///< 1バイトあたりの通信時間
+constexpr uint8_t  TELEMETRY_SIZE   = 120;  ///< テレメトリの搬送データサイズ
+
+constexpr uint8_t  EVENT_END        = 0;    ///< 1刻み分の終わり
+constexpr uint8_t  EVENT_COMPLETE   = 1;    ///< 送信完了通知
+constexpr uint8_t  EVENT_FRAME      = 2;    ///< 受信フレーム
+
+/**
+ * @brief 区間
+ */
+struct Phase {
+    const char* name;   ///< 名前
+    uint32_t    endMs;  ///< 終了時刻
+    bool        busy;   ///< 他の機器がチャネルを使うか
+};
+
+static const Phase PHASES[] = {
+    { "clear", 5000,  false },
+    { "busy",  15000, true  },
+    { "clear", 20000, false },
+};
+constexpr size_t PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+
+/**
+ * @brief 区間ごと・ノードごとの到達状況（チャネル側で集計）
+ */
+struct Flow {
+    uint32_t queued;        ///< 送信待ちに入ったフレーム数（ハートビートを除く）
+    uint32_t delivered;     ///< 届いたフレーム数
+    uint32_t failed;        ///< 失敗したフレーム数
+    uint64_t latencySum;    ///< 送信待ちに入ってから届くまでの時間の合計（ms）
+    uint32_t latencyMax;    ///< 同最大
+};
+
+/**
+ * @brief 区間の終わりに各ノードが記録する値
+ */
+struct Snapshot {
+    RateStats      rate;        ///< レート制御の統計
+    PublisherStats publisher;   ///< パブリッシャの統計
+};
+
+/**
+ * @brief チャネルの送信待ちのフレーム
+ */
+struct Queued {
+    std::vector<uint8_t> frame; ///< フレーム
+    uint32_t submitMs;          ///< 送信待ちに入った時刻
+};
+
+static int      peerFd = -1;            ///< 相手プロセスとの socket
+static uint32_t telemetryPeriodMs = 10; ///< テレメトリの周期
+static uint32_t busyPercent = 80;       ///< busy 区間で他の機器が使う時間の割合
+static uint32_t lossPermille = 30;      ///< 送り出したフレームが失敗する割合
+static uint32_t queueLimit = 8;         ///< 各ノードの送信待ちの上限
+static const char* tracePrefix = nullptr;   ///< トレースの出力先（nullptr なら出力しない）
+static std::vector<std::vector<uint8_t>> outbox;   ///< この刻みで送信したフレーム
+
+static const uint8_t CTRL_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t ROBO_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+
+/**
+ * @brief 全バイトを書き込む
+ */
+static void writeAll(const void* data, size_t len)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::write(peerFd, p, len);
+        if (n <= 0)
+        {
+            perror("write");
+            exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief 全バイトを読み出す
+ */
+static void readAll(void* data, size_t len)
+{
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::read(peerFd, p, len);
+        if (n <= 0)
+        {
+            perror("read");
+            exit(1);
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief 長さ付きでフレームを書き込む
+ */
+static void writeFrame(const std::vector<uint8_t>& frame)
+{
+    uint16_t len = static_cast<uint16_t>(frame.size());
+    writeAll(&len, sizeof(len));
+    writeAll(frame.data(), frame.size());
+}
+
+/**
+ * @brief 長さ付きのフレームを読み出す
+ */
+static std::vector<uint8_t> readFrame(void)
+{
+    uint16_t len;
+    readAll(&len, sizeof(len));
+    if (len > Wire::MAX_FRAME_SIZE)
+    {
+        fprintf(stderr, "bad frame length %u\n", len);
+        exit(1);
+    }
+    std::vector<uint8_t> frame(len);
+    readAll(frame.data(), len);
+    return frame;
+}
+
+/**
+ * @brief esp_now_send() のフック。この刻みの送信として溜める
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    outbox.push_back(std::vector<uint8_t>(data, data + len));
+}
+
+/**
+ * @brief ハートビートか（集計から除く）
+ */
+static bool isHeartbeat(const std::vector<uint8_t>& frame)
+{
+    return frame.size() == Wire::HEARTBEAT_FRAME_SIZE && frame[0] == static_cast<uint8_t>(Wire::FrameType::Heartbeat);
+}
+
+/**
+ * @brief 1フレームの通信時間（マイクロ秒）
+ */
+static uint32_t airtimeUs(const std::vector<uint8_t>& frame)
+{
+    return FRAME_OVERHEAD_US + static_cast<uint32_t>(frame.size()) * BYTE_US;
+}
+
+/**
+ * @brief 共有チャネル（コントローラ側のプロセスだけが持つ）
+ */
+class Channel
+{
+public:
+    Flow flows[PHASE_COUNT][2] = {};    ///< 区間・ノードごとの到達状況（0:コントローラ 1:ロボット）
+
+    /**
+     * @brief 送信待ちへ加える
+     */
+    void submit(int node, const std::vector<uint8_t>& frame, uint32_t nowMs, size_t phase)
+    {
+        Queued q;
+        q.frame = frame;
+        q.submitMs = nowMs;
+        queues[node].push_back(q);
+        if (!isHeartbeat(frame))
+        {
+            flows[phase][node].queued++;
+        }
+    }
+
+    /**
+     * @brief 1刻み分送り出す
+     * @param completions ノードごとの送信完了通知（true:成功）
+     * @param delivered   ノードごとの受信フレーム
+     */
+    void step(uint32_t nowMs, size_t phase, std::vector<bool> completions[2], std::vector<std::vector<uint8_t>> delivered[2])
+    {
+        uint32_t freePercent = PHASES[phase].busy ? 100 - busyPercent : 100;
+        int32_t tickUs = static_cast<int32_t>(TICK_MS * 1000 * freePercent / 100);
+        airUs += tickUs;
+        for (;;)
+        {
+            int node;
+            if (!queues[0].empty() && !queues[1].empty())
+            {
+                node = turn;
+            }
+            else if (!queues[0].empty())
+            {
+                node = 0;
+            }
+            else if (!queues[1].empty())
+            {
+                node = 1;
+            }
+            else
+            {
+                // 空いている時間は貯めておけない
+                if (airUs > tickUs)
+                {
+                    airUs = tickUs;
+                }
+                break;
+            }
+            // 使える時間が残っていれば送り出し、超えた分は以降の刻みで返す
+            if (airUs <= 0)
+            {
+                break;
+            }
+            const Queued& head = queues[node].front();
+            airUs -= static_cast<int32_t>(airtimeUs(head.frame));
+            turn = 1 - node;
+
+            bool ok = static_cast<uint32_t>(std::rand() % 1000) >= lossPermille;
+            completions[node].push_back(ok);
+            if (!isHeartbeat(head.frame))
+            {
+                Flow& flow = flows[phase][node];
+                if (ok)
+                {
+                    uint32_t latency = nowMs - head.submitMs;
+                    flow.delivered++;
+                    flow.latencySum += latency;
+                    if (latency > flow.latencyMax)
+                    {
+                        flow.latencyMax = latency;
+                    }
+                }
+                else
+                {
+                    flow.failed++;
+                }
+            }
+            if (ok)
+            {
+                delivered[1 - node].push_back(head.frame);
+            }
+            queues[node].pop_front();
+        }
+    }
+
+private:
+    std::deque<Queued> queues[2];   ///< ノードごとの送信待ち
+    int32_t airUs = 0;              ///< 使える通信時間の残り（負は使い過ぎた分）
+    int turn = 0;                   ///< 両方に送信待ちがある場合に次に送るノード
+};
+
+/**
+ * @brief ファイルへ書き出す Print（TraceDump() の出力先）
+ */
+class FilePrint : public Print
+{
+public:
+    explicit FilePrint(FILE* file) : file(file) {}
+    size_t write(uint8_t c) override
+    {
+        return fputc(c, file) == EOF ? 0 : 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return fwrite(buffer, 1, size, file);
+    }
+
+private:
+    FILE* file;
+};
+
+/**
+ * @brief トレースをファイルへ書き出す
+ * @param controller true:コントローラ / false:ロボット
+ * @param control    レート制御を有効にしたか
+ */
+static void dumpTrace(bool controller, bool control)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s-%s-%s.bin", tracePrefix, control ? "on" : "off", controller ? "ctrl" : "robo");
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        perror(path);
+        return;
+    }
+    FilePrint out(file);
+    size_t events = TraceDump(out);
+    fclose(file);
+    fprintf(stderr, "%s: %zu events\n", path, events);
+}
+
+/**
+ * @brief 受け取った送信完了通知と受信フレームを処理する
+ */
+static void applyEvents(const uint8_t* peer, const std::vector<bool>& completions,
+                        const std::vector<std::vector<uint8_t>>& frames)
+{
+    for (bool ok : completions)
+    {
+        HostShim::CompleteSend(peer, ok);
+    }
+    for (const std::vector<uint8_t>& f : frames)
+    {
+        InjectFrame(f.data(), static_cast<int>(f.size()));
+    }
+}
+
+/**
+ * @brief 片側を動かす
+ * @param controller true:コントローラ（チャネルを持つ） / false:ロボット
+ * @param control    レート制御を有効にするか
+ * @param channel    チャネル（コントローラのみ）
+ * @param snapshots  区間の終わりの記録の格納先
+ */
+static void run(bool controller, bool control, Channel* channel, Snapshot snapshots[PHASE_COUNT])
+{
+    outbox.clear();
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    HostShim::SetSendQueueLimit(queueLimit);
+    Init(controller ? CTRL_ADDR : ROBO_ADDR, controller ? ROBO_ADDR : CTRL_ADDR, 0, 1000);
+
+    uint32_t periodMs = controller ? COMMAND_PRD_MS : telemetryPeriodMs;
+    RateConfig config = { static_cast<uint16_t>(1000 / periodMs), 2, 5, 50, 20, 3, 200 };
+    SetRateConfig(config);
+    SetRateControl(control);
+    if (controller)
+    {
+        // 指令は従来形式のまま送る（examples/Controller と同じ）
+        PublisherStart(COMMAND_PRD_MS * 1000, 200);
+    }
+    else
+    {
+        SetFrameFormat(FrameFormat::Compact);
+        PublisherSetClass(TrafficClass::Telemetry);
+        PublisherStart(telemetryPeriodMs * 1000, 500);
+    }
+
+    uint8_t payload[TELEMETRY_SIZE];
+    memset(payload, 0, sizeof(payload));
+    uint32_t ts;
+    uint8_t addr[6];
+    uint8_t data[CARRIED_DATA_MAX_SIZE];
+    uint8_t size;
+    uint32_t now = 0;
+    for (size_t phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        for (; now < PHASES[phase].endMs; now += TICK_MS)
+        {
+            HostShim::SetMicros(now * 1000);
+            // 毎刻み内容を変え、周期ごとに必ず送信させる
+            memcpy(payload, &now, sizeof(now));
+            PublisherUpdate(payload, controller ? 32 : TELEMETRY_SIZE);
+            if (now % periodMs == 0)
+            {
+                PublisherService(now * 1000);
+            }
+
+            std::vector<bool> completions[2];
+            std::vector<std::vector<uint8_t>> delivered[2];
+            if (controller)
+            {
+                for (const std::vector<uint8_t>& f : outbox)
+                {
+                    channel->submit(0, f, now, phase);
+                }
+                for (;;)
+                {
+                    uint16_t len;
+                    readAll(&len, sizeof(len));
+                    if (len == 0)
+                    {
+                        break;
+                    }
+                    std::vector<uint8_t> f(len);
+                    readAll(f.data(), len);
+                    channel->submit(1, f, now, phase);
+                }
+                channel->step(now, phase, completions, delivered);
+
+                // ロボット宛ての送信完了通知と受信フレームを渡す
+                for (bool ok : completions[1])
+                {
+                    uint8_t ev[2] = { EVENT_COMPLETE, static_cast<uint8_t>(ok ? 1 : 0) };
+                    writeAll(ev, sizeof(ev));
+                }
+                for (const std::vector<uint8_t>& f : delivered[1])
+                {
+                    uint8_t ev = EVENT_FRAME;
+                    writeAll(&ev, sizeof(ev));
+                    writeFrame(f);
+                }
+                uint8_t end = EVENT_END;
+                writeAll(&end, sizeof(end));
+                applyEvents(ROBO_ADDR, completions[0], delivered[0]);
+            }
+            else
+            {
+                for (const std::vector<uint8_t>& f : outbox)
+                {
+                    writeFrame(f);
+                }
+                uint16_t end = 0;
+                writeAll(&end, sizeof(end));
+                for (;;)
+                {
+                    uint8_t ev;
+                    readAll(&ev, sizeof(ev));
+                    if (ev == EVENT_END)
+                    {
+                        break;
+                    }
+                    if (ev == EVENT_COMPLETE)
+                    {
+                        uint8_t ok;
+                        readAll(&ok, sizeof(ok));
+                        completions[1].push_back(ok != 0);
+                    }
+                    else
+                    {
+                        delivered[1].push_back(readFrame());
+                    }
+                }
+                applyEvents(CTRL_ADDR, completions[1], delivered[1]);
+            }
+            outbox.clear();
+
+            // 受信側の利用（トレースの終点）
+            if (controller)
+            {
+                for (;;)
+                {
+                    Status s = PopOldestPacket(now, &ts, addr, data, &size);
+                    if (s == Status::Ok)
+                    {
+                        WCOM_TRACE(Handoff, ts, 0);
+                    }
+                    else if (s != Status::CrcError)
+                    {
+                        break;
+                    }
+                }
+            }
+            else if (now % COMMAND_PRD_MS == 0 && PeekLatestPacket(now, &ts, addr, data, &size) == Status::Ok)
+            {
+                WCOM_TRACE(Handoff, ts, 0);
+            }
+        }
+        GetRateStats(&snapshots[phase].rate);
+        GetPublisherStats(&snapshots[phase].publisher);
+    }
+    if (tracePrefix)
+    {
+        dumpTrace(controller, control);
+    }
+}
+
+/**
+ * @brief 1回分（レート制御なし/あり）を実行して表示する
+ */
+static void simulate(bool control, uint32_t seed)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        perror("socketpair");
+        exit(1);
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0)
+    {
+        perror("fork");
+        exit(1);
+    }
+    bool controller = (child != 0);
+    peerFd = controller ? fds[0] : fds[1];
+    close(controller ? fds[1] : fds[0]);
+    std::srand(seed);
+
+    Channel channel;
+    Snapshot snapshots[PHASE_COUNT];
+    run(controller, control, controller ? &channel : nullptr, snapshots);
+    if (!controller)
+    {
+        // ロボット側の記録をコントローラへ渡して終わる
+        writeAll(snapshots, sizeof(snapshots));
+        exit(0);
+    }
+    Snapshot robo[PHASE_COUNT];
+    readAll(robo, sizeof(robo));
+    waitpid(child, nullptr, 0);
+    close(peerFd);
+
+    printf("\nrate control: %s\n", control ? "on" : "off");
+    printf("%-6s | %7s %7s %7s %7s | %7s %7s %7s %7s %7s %8s\n", "phase",
+           "cmd_q/s", "cmd_ok/s", "lat_ms", "lat_max",
+           "tlm_q/s", "tlm_ok/s", "lat_ms", "lat_max", "rejects", "rate_hz");
+    uint32_t start = 0;
+    for (size_t i = 0; i < PHASE_COUNT; ++i)
+    {
+        double seconds = (PHASES[i].endMs - start) / 1000.0;
+        const Flow& cmd = channel.flows[i][0];
+        const Flow& tlm = channel.flows[i][1];
+        uint32_t rejects = robo[i].rate.rejected - (i > 0 ? robo[i - 1].rate.rejected : 0);
+        printf("%-6s | %7.1f %8.1f %7.1f %7u | %7.1f %8.1f %7.1f %7u %7u %8.1f\n", PHASES[i].name,
+               cmd.queued / seconds, cmd.delivered / seconds,
+               cmd.delivered ? static_cast<double>(cmd.latencySum) / cmd.delivered : 0.0, cmd.latencyMax,
+               tlm.queued / seconds, tlm.delivered / seconds,
+               tlm.delivered ? static_cast<double>(tlm.latencySum) / tlm.delivered : 0.0, tlm.latencyMax,
+               rejects, robo[i].rate.rateMilliHz / 1000.0);
+        start = PHASES[i].endMs;
+    }
+    const Snapshot& last = robo[PHASE_COUNT - 1];
+    printf("controller: commands rejected %u\n", snapshots[PHASE_COUNT - 1].rate.rejected);
+    printf("robot     : throttled %u, rate decreases %u, increases %u\n",
+           last.publisher.throttled, last.rate.decreases, last.rate.increases);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        uint32_t value = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        if (strcmp(argv[i], "--trace") == 0)
+        {
+            tracePrefix = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "--period") == 0)
+        {
+            telemetryPeriodMs = value;
+        }
+        else if (strcmp(argv[i], "--busy") == 0)
+        {
+            busyPercent = value;
+        }
+        else if (strcmp(argv[i], "--loss") == 0)
+        {
+            lossPermille = value;
+        }
+        else if (strcmp(argv[i], "--queue") == 0)
+        {
+            queueLimit = value;
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            seed = value;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--period ms] [--busy percent] [--loss permille] [--queue N] [--seed S] [--trace prefix]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (telemetryPeriodMs == 0 || telemetryPeriodMs > 1000 || busyPercent >= 100 || lossPermille > 1000 || queueLimit == 0)
+    {
+        fprintf(stderr, "period must be 1..1000, busy 0..99, loss 0..1000, queue >= 1\n");
+        return 2;
+    }
+#if !ROBO_WCOM_TRACE
+    if (tracePrefix)
+    {
+        fprintf(stderr, "--trace needs a build with -DROBO_WCOM_TRACE=1\n");
+        return 2;
+    }
+#endif
+
+    printf("command %u ms (legacy frame), telemetry %u ms (%u bytes), busy %u%%, loss %u/1000, queue %u\n",
+           COMMAND_PRD_MS, telemetryPeriodMs, TELEMETRY_SIZE, busyPercent, lossPermille, queueLimit);
+    for (int control = 0; control <= 1; ++control)
+    {
+        // ライブラリと HostShim の状態を持ち越さないよう、1回ごとに別プロセスで実行する
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0)
+        {
+            simulate(control != 0, seed);
+            fflush(stdout);
+            exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file wcom_rec2csv.cpp
+ * @brief フライトレコーダのダンプを CSV へ変換する PC側ツール
+ * @details
+ * シリアルログ（テキストとダンプが混在してよい）を読み、マジック "RWFR" を探して
+ * 見つかったダンプをすべて CSV として標準出力へ書き出す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I lib/ROBO_WCOM -o wcom_rec2csv tools/wcom_rec2csv.cpp
+ * 使い方:
+ *   wcom_rec2csv [ダンプファイル]   （省略時は標準入力）
+ */
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_RecordFormat.h"
+
+using namespace ROBO_WCOM;
+
+/**
+ * @brief レコード種別の表示名
+ */
+static const char* kindName(uint8_t kind)
+{
+    switch (static_cast<Record::Kind>(kind))
+    {
+    case Record::Kind::Sent:     return "Sent";
+    case Record::Kind::Received: return "Received";
+    case Record::Kind::Failsafe: return "Failsafe";
+    default:                     return (kind >= static_cast<uint8_t>(Record::Kind::User)) ? "User" : "Unknown";
+    }
+}
+
+/**
+ * @brief little-endian の float を読む
+ */
+static float loadFloat(const uint8_t* src)
+{
+    uint32_t bits = Codec::loadLE32(src);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief 1ダンプ分を CSV へ変換
+ * @param data   ダンプ先頭（マジック位置）
+ * @param remain data 以降のバイト数
+ * @param dump   ダンプの通し番号（複数ダンプを区別する）
+ * @return 消費したバイト数（不正なヘッダなら 0）
+ */
+static size_t convertDump(const uint8_t* data, size_t remain, unsigned dump)
+{
+    if (remain < Record::HEADER_SIZE)
+    {
+        return 0;
+    }
+    uint16_t version    = Codec::loadLE16(data + Record::HEADER_OFFSET_VERSION);
+    uint16_t recordSize = Codec::loadLE16(data + Record::HEADER_OFFSET_RECORD_SIZE);
+    uint32_t count      = Codec::loadLE32(data + Record::HEADER_OFFSET_COUNT);
+    uint32_t dropped    = Codec::loadLE32(data + Record::HEADER_OFFSET_DROPPED);
+    if (version != Record::VERSION || recordSize != Record::RECORD_SIZE)
+    {
+        fprintf(stderr, "dump %u: unsupported version %u / record size %u\n", dump, version, recordSize);
+        return 0;
+    }
+
+    size_t available = (remain - Record::HEADER_SIZE) / recordSize;
+    if (available < count)
+    {
+        fprintf(stderr, "dump %u: truncated (%zu of %u records)\n", dump, available, count);
+        count = static_cast<uint32_t>(available);
+    }
+    fprintf(stderr, "dump %u: %u records, %u overwritten\n", dump, count, dropped);
+
+    const uint8_t* rec = data + Record::HEADER_SIZE;
+    for (uint32_t i = 0; i < count; ++i, rec += recordSize)
+    {
+        uint32_t seq = Codec::loadLE32(rec + Record::ENTRY_OFFSET_SEQ);
+        if (seq == Record::SEQ_INVALID)
+        {
+            continue;
+        }
+        printf("%u,%u,%u,%u,%s,%d,%u",
+               dump, seq,
+               Codec::loadLE32(rec + Record::ENTRY_OFFSET_TIME_MICROS),
+               Codec::loadLE32(rec + Record::ENTRY_OFFSET_FRAME_TIMESTAMP),
+               kindName(rec[Record::ENTRY_OFFSET_KIND]),
+               static_cast<int8_t>(rec[Record::ENTRY_OFFSET_STATUS]),
+               rec[Record::ENTRY_OFFSET_CARRIED_SIZE]);
+        uint8_t fieldCount = rec[Record::ENTRY_OFFSET_FIELD_COUNT];
+        for (size_t f = 0; f < Record::FIELD_MAX; ++f)
+        {
+            if (f < fieldCount)
+            {
+                printf(",%g", loadFloat(rec + Record::ENTRY_OFFSET_FIELDS + f * sizeof(float)));
+            }
+            else
+            {
+                printf(",");
+            }
+        }
+        printf("\n");
+    }
+    return Record::HEADER_SIZE + static_cast<size_t>(count) * recordSize;
+}
+
+int main(int argc, char** argv)
+{
+    FILE* in = stdin;
+    if (argc > 1)
+    {
+        in = fopen(argv[1], "rb");
+        if (!in)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    printf("dump,seq,time_us,frame_ts,kind,status,size,f0,f1,f2,f3\n");
+    unsigned dumps = 0;
+    size_t pos = 0;
+    while (pos + sizeof(Record::MAGIC) <= data.size())
+    {
+        if (memcmp(&data[pos], Record::MAGIC, sizeof(Record::MAGIC)) != 0)
+        {
+            pos++;
+            continue;
+        }
+        size_t used = convertDump(&data[pos], data.size() - pos, dumps);
+        if (used == 0)
+        {
+            pos++;
+            continue;
+        }
+        dumps++;
+        pos += used;
+    }
+    if (dumps == 0)
+    {
+        fprintf(stderr, "no recorder dump found\n");
+        return 1;
+    }
+    return 0;
+}
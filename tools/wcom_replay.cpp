@@ -0,0 +1,249 @@
+/**
+ * @file wcom_replay.cpp
+ * @brief キャプチャした受信フレームを ROBO_WCOM の受信処理へ再投入する PC側ツール
+ * @details
+ * キャプチャ（ROBO_WCOM_CaptureFormat.h）の受信レコードを InjectFrame() で順に投入し、
+ * 受信バッファ・CRC検証・PopOldestPacket()/PeekLatestPacket() を実機と同じコードで通す。
+ * millis() はキャプチャの時刻を返すため、タイムアウト判定も含めて結果は毎回同じになる。
+ *
+ * - 取り出した各パケットを CSV で標準出力へ書くので、前回の出力と diff すれば回帰試験になる
+ * - --max で待ち時間なしに投入し、実際の通信内容での受信処理のスループットを測れる
+ * - 暗号化Peerで整合性検査を変えていた場合は --integrity で同じ設定にする
+ *   （キャプチャは復号後のフレームなので、鍵は不要）
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_replay \
+ *       tools/wcom_replay.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_replay [--max] [--peek] [--timeout ms] [--integrity crc32|crc16|none] キャプチャファイル
+ */
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_CaptureFormat.h"
+
+using namespace ROBO_WCOM;
+
+/**
+ * @brief 再生の集計
+ */
+struct ReplayStats {
+    uint32_t rxFrames;      ///< 投入した受信フレーム数
+    uint32_t txFrames;      ///< 読み飛ばした送信フレーム数
+    uint64_t rxBytes;       ///< 投入したバイト数
+    uint32_t ok;            ///< 正常に取り出したパケット数
+    uint32_t crcError;      ///< CRCエラー
+    uint32_t timeout;       ///< タイムアウト
+};
+
+/**
+ * @brief 取り出した1パケットを CSV で出力
+ */
+static void printPacket(uint32_t captureMicros, Status status, uint32_t timestamp, const uint8_t* data, uint8_t size)
+{
+    printf("%u,%s,%u,%u,", captureMicros, ToString(status), timestamp, size);
+    for (uint8_t i = 0; i < size; ++i)
+    {
+        printf("%02X", data[i]);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief 受信バッファを確認し、結果を集計する
+ * @param peek true: PeekLatestPacket() で最新のみ確認 / false: PopOldestPacket() で空になるまで取り出す
+ */
+static void drain(bool peek, uint32_t captureMicros, ReplayStats& stats)
+{
+    uint32_t timestamp;
+    uint8_t address[6];
+    uint8_t data[CARRIED_DATA_MAX_SIZE];
+    uint8_t size;
+    for (;;)
+    {
+        Status status = peek ? PeekLatestPacket(millis(), &timestamp, address, data, &size)
+                             : PopOldestPacket(millis(), &timestamp, address, data, &size);
+        if (status == Status::BufferEmpty)
+        {
+            return;
+        }
+        if (status == Status::Ok)
+        {
+            stats.ok++;
+            printPacket(captureMicros, status, timestamp, data, size);
+        }
+        else
+        {
+            if (status == Status::CrcError)
+            {
+                stats.crcError++;
+            }
+            else if (status == Status::Timeout)
+            {
+                stats.timeout++;
+            }
+            printPacket(captureMicros, status, 0, data, 0);
+        }
+        if (peek || status == Status::Timeout)
+        {
+            return;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool maxSpeed = false;
+    bool peek = false;
+    uint32_t timeoutMs = 1000;
+    IntegrityCheck integrity = IntegrityCheck::Crc32;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--max") == 0)
+        {
+            maxSpeed = true;
+        }
+        else if (strcmp(argv[i], "--peek") == 0)
+        {
+            peek = true;
+        }
+        else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc)
+        {
+            timeoutMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--integrity") == 0 && i + 1 < argc)
+        {
+            const char* name = argv[++i];
+            if (strcmp(name, "crc16") == 0)
+            {
+                integrity = IntegrityCheck::Crc16;
+            }
+            else if (strcmp(name, "none") == 0)
+            {
+                integrity = IntegrityCheck::None;
+            }
+            else if (strcmp(name, "crc32") != 0)
+            {
+                path = nullptr;
+                break;
+            }
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (!path)
+    {
+        fprintf(stderr, "usage: %s [--max] [--peek] [--timeout ms] [--integrity crc32|crc16|none] capture\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = fopen(path, "rb");
+    if (!in)
+    {
+        perror(path);
+        return 1;
+    }
+    std::vector<uint8_t> file;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    {
+        file.insert(file.end(), chunk, chunk + n);
+    }
+    fclose(in);
+
+    // 先頭のテキスト出力などを読み飛ばしてファイルヘッダを探す
+    size_t pos = 0;
+    while (pos + Capture::FILE_HEADER_SIZE <= file.size() &&
+           memcmp(&file[pos], Capture::MAGIC, sizeof(Capture::MAGIC)) != 0)
+    {
+        pos++;
+    }
+    if (pos + Capture::FILE_HEADER_SIZE > file.size() ||
+        Codec::loadLE16(&file[pos + Capture::HEADER_OFFSET_VERSION]) != Capture::VERSION)
+    {
+        fprintf(stderr, "%s: no capture found\n", path);
+        return 1;
+    }
+    size_t recordHeader = Codec::loadLE16(&file[pos + Capture::HEADER_OFFSET_RECORD_HEADER]);
+    uint32_t startMicros = Codec::loadLE32(&file[pos + Capture::HEADER_OFFSET_START_MICROS]);
+    uint32_t dropped = Codec::loadLE32(&file[pos + Capture::HEADER_OFFSET_DROPPED]);
+    if (recordHeader < Capture::RECORD_HEADER_SIZE)
+    {
+        fprintf(stderr, "%s: bad record header size %zu\n", path, recordHeader);
+        return 1;
+    }
+    pos += Capture::FILE_HEADER_SIZE;
+
+    const uint8_t own[6] = { 0 };
+    const uint8_t peer[6] = { 0 };
+    HostShim::SetMicros(startMicros);
+    Init(own, peer, millis(), timeoutMs);
+    if (integrity != IntegrityCheck::Crc32)
+    {
+        // CRC32 より弱い検査は暗号化Peerでしか設定できない（PC側の ESP-NOW 互換層は鍵を使わない）
+        const uint8_t key[16] = { 0 };
+        SetEncryption(key, key);
+        SetIntegrityCheck(integrity);
+    }
+
+    ReplayStats stats = {};
+    bool first = true;
+    uint32_t prevMicros = startMicros;
+    auto wallStart = std::chrono::steady_clock::now();
+    printf("capture_us,status,timestamp,size,data\n");
+    while (pos + recordHeader <= file.size())
+    {
+        const uint8_t* rec = &file[pos];
+        uint32_t t = Codec::loadLE32(rec + Capture::RECORD_OFFSET_TIME_MICROS);
+        uint16_t len = Codec::loadLE16(rec + Capture::RECORD_OFFSET_LENGTH);
+        uint8_t direction = rec[Capture::RECORD_OFFSET_DIRECTION];
+        if (len > Capture::FRAME_MAX_SIZE || pos + recordHeader + len > file.size())
+        {
+            fprintf(stderr, "%s: truncated record at offset %zu\n", path, pos);
+            break;
+        }
+        const uint8_t* frame = rec + recordHeader;
+        pos += recordHeader + len;
+
+        if (direction != static_cast<uint8_t>(Capture::Direction::Rx))
+        {
+            stats.txFrames++;
+            continue;
+        }
+        // 元の速度で再生する場合は、前の受信フレームからの経過時間だけ待つ
+        int32_t gap = static_cast<int32_t>(t - prevMicros);
+        if (!maxSpeed && !first && gap > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(gap));
+        }
+        first = false;
+        prevMicros = t;
+
+        HostShim::SetMicros(t);
+        InjectFrame(frame, len);
+        stats.rxFrames++;
+        stats.rxBytes += len;
+        drain(peek, t, stats);
+    }
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    fprintf(stderr, "rx frames  : %u (%llu bytes), tx frames skipped: %u, dropped at capture: %u\n",
+            stats.rxFrames, static_cast<unsigned long long>(stats.rxBytes), stats.txFrames, dropped);
+    fprintf(stderr, "packets    : ok %u, crc error %u, timeout %u\n", stats.ok, stats.crcError, stats.timeout);
+    if (wallSec > 0)
+    {
+        fprintf(stderr, "throughput : %.0f frames/s, %.2f MB/s (%.3f s)\n",
+                stats.rxFrames / wallSec, stats.rxBytes / wallSec / 1e6, wallSec);
+    }
+    return 0;
+}
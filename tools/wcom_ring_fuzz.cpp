@@ -0,0 +1,361 @@
+/**
+ * @file wcom_ring_fuzz.cpp
+ * @brief 受信リングバッファ（ROBO_WCOM_Ring.h / ROBO_WCOM_ByteRing.h）を std::deque の参照モデルと突き合わせる PC側ツール
+ * @details
+ * 乱数で push / pop / peekLatest / clear を混ぜて呼び、毎回の結果を参照モデルと比べる。
+ * 参照モデルは「満杯なら最も古いものを捨てる」「PayloadMax を超える搬送データはサイズ 0 の CRCエラーになる」
+ * という仕様をそのまま std::deque で書いたもの。
+ *
+ * 可変長の PacketByteRing は何件残るかが詰め方で決まるため、参照モデルは「捨てるのは古い側から」
+ * だけを仕様とし、push 後に残った件数までモデルの先頭を削る。そのうえで次も確かめる。
+ *
+ * - 保持しているレコードの合計がバッファのバイト数を超えない
+ * - 古いものを捨てたのは、空きが最大レコード2つ分（末尾の余りと確保先）を下回っていたときだけ
+ * - CARRIED_DATA_MAX_SIZE を超える搬送データはサイズ 0 の CRCエラーになる
+ *
+ * 構成（1スロット、2のべき乗でない数、既定値、最小のバイト数など）ごとに実行し、
+ * 食い違いがあれば最初の1件を表示して終了コード 1 を返す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_ring_fuzz tools/wcom_ring_fuzz.cpp
+ * 使い方:
+ *   wcom_ring_fuzz [--ops 1構成あたりの操作数=200000] [--seed S=1]
+ */
+#include <Arduino.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include "ROBO_WCOM_ByteRing.h"
+#include "ROBO_WCOM_Ring.h"
+
+using namespace ROBO_WCOM;
+
+/**
+ * @brief 参照モデルに保持する1パケット
+ */
+struct Entry {
+    PacketData data;    ///< パケットデータ（搬送データの未使用部分は比較しない）
+    bool       crcOk;   ///< CRC検証結果
+};
+
+/**
+ * @brief 操作列用の乱数（xorshift32）
+ */
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed) : state(seed ? seed : 1) {}
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t below(uint32_t n)
+    {
+        return next() % n;
+    }
+};
+
+/**
+ * @brief 試験用のパケットを作る
+ * @param rng    乱数
+ * @param serial 通し番号（タイムスタンプと搬送データに埋め込む）
+ */
+static Entry makeEntry(Random& rng, uint32_t serial)
+{
+    Entry e;
+    memset(&e, 0, sizeof(e));
+    e.data.timestamp = serial;
+    for (size_t i = 0; i < sizeof(e.data.address); ++i)
+    {
+        e.data.address[i] = static_cast<uint8_t>(serial >> (i * 4));
+    }
+    // 小さいサイズと上限付近を多めに出す
+    uint32_t pick = rng.below(8);
+    if (pick < 4)
+    {
+        e.data.carriedSize = static_cast<uint8_t>(rng.below(17));
+    }
+    else if (pick < 7)
+    {
+        e.data.carriedSize = static_cast<uint8_t>(rng.below(CARRIED_DATA_MAX_SIZE + 1));
+    }
+    else
+    {
+        // 上限の前後。上限を超えるものは格納時にサイズ 0 の CRCエラーになる
+        e.data.carriedSize = static_cast<uint8_t>(CARRIED_DATA_MAX_SIZE - 2 + rng.below(6));
+    }
+    for (uint8_t i = 0; i < e.data.carriedSize && i < CARRIED_DATA_MAX_SIZE; ++i)
+    {
+        e.data.carriedData[i] = static_cast<uint8_t>(serial * 31 + i);
+    }
+    e.crcOk = rng.below(5) != 0;
+    return e;
+}
+
+/**
+ * @brief リングに格納されたときの姿へ変換する
+ * @param payloadMax 1パケットあたりの最大搬送データサイズ
+ */
+static Entry stored(const Entry& e, size_t payloadMax)
+{
+    Entry s = e;
+    if (e.data.carriedSize > payloadMax)
+    {
+        s.data.carriedSize = 0;
+        s.crcOk = false;
+    }
+    return s;
+}
+
+/**
+ * @brief 2つのパケットが一致するか（搬送データはサイズ分だけ比べる）
+ */
+static bool sameEntry(const PacketData& data, bool crcOk, const Entry& expected)
+{
+    return data.timestamp == expected.data.timestamp &&
+           memcmp(data.address, expected.data.address, sizeof(data.address)) == 0 &&
+           data.carriedSize == expected.data.carriedSize &&
+           memcmp(data.carriedData, expected.data.carriedData, data.carriedSize) == 0 &&
+           crcOk == expected.crcOk;
+}
+
+/**
+ * @brief 比較結果の見出しと件数を表示する
+ */
+static void printOk(const char* name, uint32_t ops, uint32_t pushes, uint32_t pops)
+{
+    printf("%-26s %10u %10u %10u  ok\n", name, ops, pushes, pops);
+}
+
+/**
+ * @brief 1構成分の突き合わせ
+ * @tparam Slots      保持するパケット数
+ * @tparam PayloadMax 1パケットあたりの最大搬送データサイズ
+ * @return true:食い違いなし
+ */
+template <size_t Slots, size_t PayloadMax>
+static bool fuzzSlots(uint32_t ops, uint32_t seed)
+{
+    static PacketRing<Slots, PayloadMax> ring;
+    ring.clear();
+    std::deque<Entry> model;
+    Random rng(seed);
+    uint32_t serial = 0;
+    uint32_t pushes = 0;
+    uint32_t pops = 0;
+
+    for (uint32_t op = 0; op < ops; ++op)
+    {
+        uint32_t kind = rng.below(100);
+        PacketData data;
+        bool crcOk = false;
+        const char* failed = nullptr;
+        if (kind < 55)
+        {
+            Entry e = makeEntry(rng, ++serial);
+            ring.push(e.data, e.crcOk);
+            model.push_back(stored(e, PayloadMax));
+            if (model.size() > Slots)
+            {
+                model.pop_front();
+            }
+            pushes++;
+        }
+        else if (kind < 90)
+        {
+            bool got = ring.pop(data, crcOk);
+            if (got != !model.empty() || (got && !sameEntry(data, crcOk, model.front())))
+            {
+                failed = "pop";
+            }
+            if (!model.empty())
+            {
+                model.pop_front();
+            }
+            pops++;
+        }
+        else if (kind < 99)
+        {
+            bool got = ring.peekLatest(data, crcOk);
+            if (got != !model.empty() || (got && !sameEntry(data, crcOk, model.back())))
+            {
+                failed = "peekLatest";
+            }
+        }
+        else
+        {
+            ring.clear();
+            model.clear();
+        }
+
+        if (!failed && ring.size() != static_cast<int16_t>(model.size()))
+        {
+            failed = "size";
+        }
+        if (failed)
+        {
+            printf("PacketRing<%u,%u>: %s mismatch at op %u (ring size %d, model size %u)\n",
+                   static_cast<unsigned>(Slots), static_cast<unsigned>(PayloadMax), failed, op,
+                   ring.size(), static_cast<unsigned>(model.size()));
+            return false;
+        }
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "PacketRing<%u,%u>", static_cast<unsigned>(Slots), static_cast<unsigned>(PayloadMax));
+    printOk(name, ops, pushes, pops);
+    return true;
+}
+
+/**
+ * @brief 参照モデルに残っているレコードの合計バイト数
+ */
+template <size_t Bytes>
+static size_t recordBytes(const std::deque<Entry>& model)
+{
+    size_t total = 0;
+    for (const Entry& e : model)
+    {
+        total += PacketByteRing<Bytes>::RECORD_HEADER_SIZE + e.data.carriedSize;
+    }
+    return total;
+}
+
+/**
+ * @brief 可変長リング1構成分の突き合わせ
+ * @tparam Bytes バッファのバイト数
+ * @return true:食い違いなし
+ */
+template <size_t Bytes>
+static bool fuzzBytes(uint32_t ops, uint32_t seed)
+{
+    typedef PacketByteRing<Bytes> Ring;
+    const size_t RECORD_MAX = Ring::RECORD_HEADER_SIZE + CARRIED_DATA_MAX_SIZE;
+    static Ring ring;
+    ring.clear();
+    std::deque<Entry> model;
+    Random rng(seed);
+    uint32_t serial = 0;
+    uint32_t pushes = 0;
+    uint32_t pops = 0;
+
+    for (uint32_t op = 0; op < ops; ++op)
+    {
+        uint32_t kind = rng.below(100);
+        PacketData data;
+        bool crcOk = false;
+        const char* failed = nullptr;
+        if (kind < 60)
+        {
+            Entry e = stored(makeEntry(rng, ++serial), CARRIED_DATA_MAX_SIZE);
+            size_t usedBefore = recordBytes<Bytes>(model);
+            size_t countBefore = model.size();
+            ring.push(e.data, e.crcOk);
+            model.push_back(e);
+            if (ring.size() < 1 || static_cast<size_t>(ring.size()) > model.size())
+            {
+                failed = "push count";
+            }
+            else
+            {
+                while (model.size() > static_cast<size_t>(ring.size()))
+                {
+                    model.pop_front();
+                }
+                size_t need = Ring::RECORD_HEADER_SIZE + e.data.carriedSize;
+                if (recordBytes<Bytes>(model) > Bytes)
+                {
+                    failed = "push overfill";
+                }
+                else if (model.size() <= countBefore && usedBefore + need + 2 * RECORD_MAX <= Bytes)
+                {
+                    failed = "push dropped with room left";
+                }
+            }
+            pushes++;
+        }
+        else if (kind < 90)
+        {
+            bool got = ring.pop(data, crcOk);
+            if (got != !model.empty() || (got && !sameEntry(data, crcOk, model.front())))
+            {
+                failed = "pop";
+            }
+            if (!model.empty())
+            {
+                model.pop_front();
+            }
+            pops++;
+        }
+        else if (kind < 99)
+        {
+            bool got = ring.peekLatest(data, crcOk);
+            if (got != !model.empty() || (got && !sameEntry(data, crcOk, model.back())))
+            {
+                failed = "peekLatest";
+            }
+        }
+        else
+        {
+            ring.clear();
+            model.clear();
+        }
+
+        if (!failed && ring.size() != static_cast<int16_t>(model.size()))
+        {
+            failed = "size";
+        }
+        if (failed)
+        {
+            printf("PacketByteRing<%u>: %s mismatch at op %u (ring size %d, model size %u)\n",
+                   static_cast<unsigned>(Bytes), failed, op, ring.size(), static_cast<unsigned>(model.size()));
+            return false;
+        }
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "PacketByteRing<%u>", static_cast<unsigned>(Bytes));
+    printOk(name, ops, pushes, pops);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t ops = 200000;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--ops") == 0)
+        {
+            ops = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            seed = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--ops N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (ops == 0)
+    {
+        fprintf(stderr, "ops must be >= 1\n");
+        return 2;
+    }
+
+    printf("%-26s %10s %10s %10s\n", "ring", "ops", "pushes", "pops");
+    bool ok = true;
+    ok = fuzzSlots<1, 1>(ops, seed) && ok;
+    ok = fuzzSlots<3, 24>(ops, seed) && ok;
+    ok = fuzzSlots<7, 100>(ops, seed) && ok;
+    ok = fuzzSlots<RECEIVE_BUFFER_SIZE, RECEIVE_PAYLOAD_MAX>(ops, seed) && ok;
+    ok = fuzzSlots<250, CARRIED_DATA_MAX_SIZE>(ops, seed) && ok;
+    ok = fuzzBytes<PacketByteRing<256>::RECORD_HEADER_SIZE + CARRIED_DATA_MAX_SIZE>(ops, seed) && ok;
+    ok = fuzzBytes<1000>(ops, seed) && ok;
+    ok = fuzzBytes<4096>(ops, seed) && ok;
+    ok = fuzzBytes<0xFFFF>(ops, seed) && ok;
+    return ok ? 0 : 1;
+}
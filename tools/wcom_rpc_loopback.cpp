@@ -0,0 +1,495 @@
+/**
+ * @file wcom_rpc_loopback.cpp
+ * @brief 要求/応答（ROBO_WCOM_Rpc.h）を1つのプロセス内で折り返して確かめる PC側ツール
+ * @details
+ * 送信フックで受け取ったフレームを溜めておき、InjectFrame() で自分自身へ受信させる。
+ * 同じノードがクライアントとサーバを兼ねるため、要求は処理待ちへ、応答は応答待ちテーブルへ入る。
+ * フレームを渡す順番・捨てるフレームはシナリオごとに決める。
+ *
+ * - roundtrip : 応答待ちを満杯まで使い、応答を逆順に返しても相関IDで正しい要求に対応付く
+ * - poll      : コールバックなしの要求を RpcPoll() で待ち、完了後はハンドルが無効になる
+ * - status    : 未登録メソッド・ハンドラのエラー・大きすぎる応答の完了ステータス
+ * - full      : 応答待ちが満杯なら RpcTableFull、引数が不正なら InvalidArg
+ * - timeout   : 応答が失われるとタイムアウトし、後から届いた応答は対応なしとして捨てる
+ * - cancel    : 取り消した要求の応答ではコールバックを呼ばない
+ * - overflow  : サーバの処理待ちがあふれた要求は捨て、クライアント側はタイムアウトする
+ * - reentrant : 完了コールバックの中から次の要求を送れる
+ *
+ * 1つでも合わなければ内容を表示して終了コード 1 を返す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I tools/host -I lib/ROBO_WCOM -o wcom_rpc_loopback \
+ *       tools/wcom_rpc_loopback.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_rpc_loopback
+ */
+#include <Arduino.h>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Rpc.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t TIMEOUT_MS   = 100;  ///< 応答を待つ時間
+constexpr uint8_t  METHOD_ECHO  = 1;    ///< 引数を逆順にして返す
+constexpr uint8_t  METHOD_FAIL  = 2;    ///< BufferEmpty を返す
+constexpr uint8_t  METHOD_BIG   = 3;    ///< RPC_PAYLOAD_MAX を超える応答を返そうとする
+constexpr uint8_t  METHOD_NONE  = 9;    ///< 登録しない
+
+static const uint8_t OWN_ADDR[6]  = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+
+typedef std::vector<uint8_t> Frame;
+
+static std::deque<Frame> wire;      ///< 送信フックで受け取り、まだ受信させていないフレーム
+static uint32_t nowMs = 0;          ///< 仮想時計
+static uint32_t checks = 0;         ///< 確かめた項目数
+static uint32_t failures = 0;       ///< 合わなかった項目数
+
+/**
+ * @brief 1項目の結果を数え、合わなければ表示する
+ */
+static void expect(bool ok, const char* scenario, const char* what)
+{
+    checks++;
+    if (!ok)
+    {
+        failures++;
+        printf("FAIL %-10s %s\n", scenario, what);
+    }
+}
+
+/**
+ * @brief esp_now_send() のフック
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    wire.push_back(Frame(data, data + len));
+}
+
+/**
+ * @brief 仮想時計を進める
+ */
+static void advance(uint32_t ms)
+{
+    nowMs += ms;
+    HostShim::SetMicros(nowMs * 1000);
+}
+
+/**
+ * @brief 溜まったフレームをすべて受信させる
+ * @param reverse true: 送信と逆の順番で受信させる
+ * @return 受信させたフレーム数
+ */
+static size_t deliver(bool reverse = false)
+{
+    std::deque<Frame> frames;
+    if (reverse)
+    {
+        frames.assign(wire.rbegin(), wire.rend());
+        wire.clear();
+    }
+    else
+    {
+        frames.swap(wire);
+    }
+    for (const Frame& frame : frames)
+    {
+        InjectFrame(frame.data(), static_cast<int>(frame.size()));
+    }
+    return frames.size();
+}
+
+/**
+ * @brief 溜まったフレームを1つずつ受信させ、その都度 RpcService() を呼ぶ
+ * @details サーバの処理待ち（RPC_QUEUE_MAX）を超える数の要求を、あふれさせずに処理させる
+ */
+static void deliverServing(void)
+{
+    std::deque<Frame> frames;
+    frames.swap(wire);
+    for (const Frame& frame : frames)
+    {
+        InjectFrame(frame.data(), static_cast<int>(frame.size()));
+        RpcService(nowMs);
+    }
+}
+
+/**
+ * @brief 引数を逆順にして返すハンドラ
+ */
+static Status echoHandler(const uint8_t* args, uint8_t argSize, uint8_t* reply, uint8_t* replySize)
+{
+    for (uint8_t i = 0; i < argSize; ++i)
+    {
+        reply[i] = args[argSize - 1 - i];
+    }
+    *replySize = argSize;
+    return Status::Ok;
+}
+
+/**
+ * @brief エラーを返すハンドラ
+ */
+static Status failHandler(const uint8_t*, uint8_t, uint8_t*, uint8_t*)
+{
+    return Status::BufferEmpty;
+}
+
+/**
+ * @brief 大きすぎる応答を返そうとするハンドラ
+ */
+static Status bigHandler(const uint8_t*, uint8_t, uint8_t* reply, uint8_t* replySize)
+{
+    memset(reply, 0xAA, RPC_PAYLOAD_MAX);
+    *replySize = static_cast<uint8_t>(RPC_PAYLOAD_MAX + 1);
+    return Status::Ok;
+}
+
+/**
+ * @brief 1つの要求の期待値と完了結果
+ */
+struct Call {
+    RpcHandle handle;                   ///< ハンドル
+    uint8_t   argSize;                  ///< 引数サイズ
+    uint8_t   args[RPC_PAYLOAD_MAX];    ///< 引数
+    uint32_t  completions;              ///< 完了コールバックが呼ばれた回数
+    RpcHandle gotHandle;                ///< 完了コールバックで受け取ったハンドル
+    Status    status;                   ///< 完了ステータス
+    uint8_t   replySize;                ///< 応答データサイズ
+    uint8_t   reply[RPC_PAYLOAD_MAX];   ///< 応答データ
+};
+
+/**
+ * @brief 完了コールバック。context の Call へ結果を記録する
+ */
+static void onComplete(RpcHandle handle, Status status, const uint8_t* reply, uint8_t replySize, void* context)
+{
+    Call* call = static_cast<Call*>(context);
+    call->completions++;
+    call->gotHandle = handle;
+    call->status = status;
+    call->replySize = replySize;
+    memcpy(call->reply, reply, replySize);
+}
+
+/**
+ * @brief 引数を埋めた要求を用意する
+ */
+static void prepare(Call& call, uint8_t argSize, uint8_t salt)
+{
+    memset(&call, 0, sizeof(call));
+    call.argSize = argSize;
+    for (uint8_t i = 0; i < argSize; ++i)
+    {
+        call.args[i] = static_cast<uint8_t>(salt * 17 + i);
+    }
+}
+
+/**
+ * @brief ECHO の応答が引数を逆順にしたものか
+ */
+static bool echoed(const Call& call)
+{
+    if (call.replySize != call.argSize)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < call.argSize; ++i)
+    {
+        if (call.reply[i] != call.args[call.argSize - 1 - i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief シナリオの前に応答待ち・処理待ち・統計と溜まったフレームを捨てる
+ */
+static void reset(void)
+{
+    wire.clear();
+    RpcBegin();
+}
+
+/**
+ * @brief 応答待ちを満杯まで使い、応答を逆順に返す
+ */
+static void scenarioRoundtrip(void)
+{
+    const char* name = "roundtrip";
+    reset();
+    Call calls[RPC_PENDING_MAX];
+    for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+    {
+        // 引数サイズは 0・最大・途中の値を混ぜる
+        uint8_t size = (i == 0) ? 0 : (i == 1) ? static_cast<uint8_t>(RPC_PAYLOAD_MAX) : static_cast<uint8_t>(i * 3);
+        prepare(calls[i], size, static_cast<uint8_t>(i));
+        Status s = RpcCall(METHOD_ECHO, calls[i].args, calls[i].argSize, nowMs, TIMEOUT_MS,
+                           onComplete, &calls[i], &calls[i].handle);
+        expect(s == Status::Ok && calls[i].handle != RPC_HANDLE_INVALID, name, "call accepted");
+    }
+    deliverServing();
+    deliver(true);
+    advance(1);
+    RpcService(nowMs);
+    for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+    {
+        expect(calls[i].completions == 1, name, "completed exactly once");
+        expect(calls[i].gotHandle == calls[i].handle, name, "callback handle matches");
+        expect(calls[i].status == Status::Ok, name, "status Ok");
+        expect(echoed(calls[i]), name, "reply matches its own request");
+    }
+    RpcStats stats;
+    GetRpcStats(&stats);
+    expect(stats.calls == RPC_PENDING_MAX && stats.served == RPC_PENDING_MAX &&
+           stats.completed == RPC_PENDING_MAX && stats.timeouts == 0 && stats.unmatched == 0,
+           name, "stats");
+}
+
+/**
+ * @brief コールバックなしの要求を RpcPoll() で待つ
+ */
+static void scenarioPoll(void)
+{
+    const char* name = "poll";
+    reset();
+    Call call;
+    prepare(call, 5, 42);
+    expect(RpcCall(METHOD_ECHO, call.args, call.argSize, nowMs, TIMEOUT_MS, nullptr, nullptr, &call.handle) == Status::Ok,
+           name, "call accepted");
+    expect(RpcPoll(call.handle, call.reply, &call.replySize) == Status::RpcPending, name, "pending before delivery");
+    deliver();
+    RpcService(nowMs);
+    expect(RpcPoll(call.handle, call.reply, &call.replySize) == Status::RpcPending, name, "pending before response");
+    deliver();
+    call.status = RpcPoll(call.handle, call.reply, &call.replySize);
+    expect(call.status == Status::Ok && echoed(call), name, "reply after response");
+    expect(RpcPoll(call.handle, nullptr, nullptr) == Status::InvalidArg, name, "handle released after completion");
+    expect(RpcPoll(RPC_HANDLE_INVALID, nullptr, nullptr) == Status::InvalidArg, name, "invalid handle rejected");
+}
+
+/**
+ * @brief 完了ステータスがサーバから正しく戻るか
+ */
+static void scenarioStatus(void)
+{
+    const char* name = "status";
+    reset();
+    Call none, fail, big;
+    prepare(none, 1, 1);
+    prepare(fail, 1, 2);
+    prepare(big, 1, 3);
+    RpcCall(METHOD_NONE, none.args, none.argSize, nowMs, TIMEOUT_MS, onComplete, &none, nullptr);
+    RpcCall(METHOD_FAIL, fail.args, fail.argSize, nowMs, TIMEOUT_MS, onComplete, &fail, nullptr);
+    RpcCall(METHOD_BIG, big.args, big.argSize, nowMs, TIMEOUT_MS, onComplete, &big, nullptr);
+    deliver();
+    RpcService(nowMs);
+    deliver();
+    RpcService(nowMs);
+    expect(none.completions == 1 && none.status == Status::RpcNoHandler, name, "unregistered method -> RpcNoHandler");
+    expect(fail.completions == 1 && fail.status == Status::BufferEmpty, name, "handler status passed through");
+    expect(big.completions == 1 && big.status == Status::InvalidArg && big.replySize == 0, name, "oversized reply -> InvalidArg");
+}
+
+/**
+ * @brief 応答待ちの満杯と不正な引数
+ */
+static void scenarioFull(void)
+{
+    const char* name = "full";
+    reset();
+    uint8_t arg = 0;
+    for (size_t i = 0; i < RPC_PENDING_MAX; ++i)
+    {
+        RpcCall(METHOD_ECHO, &arg, 1, nowMs, TIMEOUT_MS, nullptr, nullptr, nullptr);
+    }
+    RpcHandle handle = RPC_HANDLE_INVALID;
+    expect(RpcCall(METHOD_ECHO, &arg, 1, nowMs, TIMEOUT_MS, nullptr, nullptr, &handle) == Status::RpcTableFull,
+           name, "table full -> RpcTableFull");
+    expect(handle == RPC_HANDLE_INVALID, name, "no handle when full");
+
+    reset();
+    uint8_t args[RPC_PAYLOAD_MAX + 1] = {};
+    expect(RpcCall(METHOD_ECHO, args, static_cast<uint8_t>(RPC_PAYLOAD_MAX + 1), nowMs, TIMEOUT_MS, nullptr, nullptr, nullptr)
+           == Status::InvalidArg, name, "oversized args -> InvalidArg");
+    expect(RpcCall(METHOD_ECHO, nullptr, 1, nowMs, TIMEOUT_MS, nullptr, nullptr, nullptr) == Status::InvalidArg,
+           name, "null args -> InvalidArg");
+    expect(wire.empty(), name, "rejected calls send nothing");
+}
+
+/**
+ * @brief 応答が失われたときのタイムアウトと遅れて届いた応答
+ */
+static void scenarioTimeout(void)
+{
+    const char* name = "timeout";
+    reset();
+    Call call;
+    prepare(call, 4, 7);
+    RpcCall(METHOD_ECHO, call.args, call.argSize, nowMs, TIMEOUT_MS, onComplete, &call, &call.handle);
+    deliver();
+    RpcService(nowMs);
+    std::deque<Frame> late;
+    late.swap(wire);
+
+    advance(TIMEOUT_MS - 1);
+    RpcService(nowMs);
+    expect(call.completions == 0, name, "no completion before deadline");
+    advance(1);
+    RpcService(nowMs);
+    expect(call.completions == 1 && call.status == Status::Timeout && call.replySize == 0, name, "timeout at deadline");
+
+    wire.swap(late);
+    deliver();
+    RpcService(nowMs);
+    RpcStats stats;
+    GetRpcStats(&stats);
+    expect(call.completions == 1, name, "late response ignored");
+    expect(stats.timeouts == 1 && stats.unmatched == 1 && stats.completed == 0, name, "stats");
+
+    // コールバックなしの要求は RpcPoll() まで結果を保持する。その間に届いた応答で上書きしない
+    reset();
+    Call polled;
+    prepare(polled, 4, 8);
+    RpcCall(METHOD_ECHO, polled.args, polled.argSize, nowMs, TIMEOUT_MS, nullptr, nullptr, &polled.handle);
+    deliver();
+    RpcService(nowMs);
+    late.swap(wire);
+    advance(TIMEOUT_MS);
+    RpcService(nowMs);
+    wire.swap(late);
+    deliver();
+    polled.status = RpcPoll(polled.handle, polled.reply, &polled.replySize);
+    expect(polled.status == Status::Timeout && polled.replySize == 0, name, "polled result kept as Timeout");
+}
+
+/**
+ * @brief 取り消した要求
+ */
+static void scenarioCancel(void)
+{
+    const char* name = "cancel";
+    reset();
+    Call call;
+    prepare(call, 2, 9);
+    RpcCall(METHOD_ECHO, call.args, call.argSize, nowMs, TIMEOUT_MS, onComplete, &call, &call.handle);
+    expect(RpcCancel(call.handle) == Status::Ok, name, "cancel accepted");
+    expect(RpcCancel(call.handle) == Status::InvalidArg, name, "second cancel rejected");
+    deliver();
+    RpcService(nowMs);
+    deliver();
+    advance(TIMEOUT_MS);
+    RpcService(nowMs);
+    RpcStats stats;
+    GetRpcStats(&stats);
+    expect(call.completions == 0, name, "no callback after cancel");
+    expect(stats.unmatched == 1 && stats.timeouts == 0, name, "stats");
+}
+
+/**
+ * @brief サーバの処理待ちがあふれた場合
+ */
+static void scenarioOverflow(void)
+{
+    const char* name = "overflow";
+    static_assert(RPC_PENDING_MAX > RPC_QUEUE_MAX, "overflow scenario needs more pending slots than queued requests");
+    reset();
+    const size_t count = RPC_QUEUE_MAX + 1;
+    Call calls[RPC_QUEUE_MAX + 1];
+    for (size_t i = 0; i < count; ++i)
+    {
+        prepare(calls[i], 3, static_cast<uint8_t>(i));
+        RpcCall(METHOD_ECHO, calls[i].args, calls[i].argSize, nowMs, TIMEOUT_MS, onComplete, &calls[i], &calls[i].handle);
+    }
+    deliver();
+    RpcService(nowMs);
+    deliver();
+    advance(TIMEOUT_MS);
+    RpcService(nowMs);
+    size_t ok = 0;
+    size_t timedOut = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        expect(calls[i].completions == 1, name, "completed exactly once");
+        if (calls[i].status == Status::Ok && echoed(calls[i]))
+        {
+            ok++;
+        }
+        else if (calls[i].status == Status::Timeout)
+        {
+            timedOut++;
+        }
+    }
+    RpcStats stats;
+    GetRpcStats(&stats);
+    expect(ok == RPC_QUEUE_MAX && timedOut == 1, name, "queued requests served, overflow times out");
+    expect(stats.dropped == 1 && stats.served == RPC_QUEUE_MAX, name, "stats");
+}
+
+static Call chained;    ///< reentrant シナリオで完了コールバックから送る要求
+
+/**
+ * @brief 完了コールバックの中から次の要求を送る
+ */
+static void onCompleteThenCall(RpcHandle handle, Status status, const uint8_t* reply, uint8_t replySize, void* context)
+{
+    onComplete(handle, status, reply, replySize, context);
+    RpcCall(METHOD_ECHO, chained.args, chained.argSize, nowMs, TIMEOUT_MS, onComplete, &chained, &chained.handle);
+}
+
+/**
+ * @brief 完了コールバックからの再入
+ */
+static void scenarioReentrant(void)
+{
+    const char* name = "reentrant";
+    reset();
+    Call first;
+    prepare(first, 6, 11);
+    prepare(chained, 8, 12);
+    RpcCall(METHOD_ECHO, first.args, first.argSize, nowMs, TIMEOUT_MS, onCompleteThenCall, &first, &first.handle);
+    deliver();
+    RpcService(nowMs);
+    deliver();
+    RpcService(nowMs);
+    expect(first.completions == 1 && echoed(first), name, "first call completed");
+    expect(chained.handle != RPC_HANDLE_INVALID && chained.handle != first.handle, name, "chained call got a new handle");
+    deliver();
+    RpcService(nowMs);
+    deliver();
+    RpcService(nowMs);
+    expect(chained.completions == 1 && echoed(chained), name, "chained call completed");
+}
+
+int main(int argc, char**)
+{
+    if (argc > 1)
+    {
+        fprintf(stderr, "usage: wcom_rpc_loopback\n");
+        return 2;
+    }
+
+    HostShim::SetSendHook(onSend);
+    Init(OWN_ADDR, PEER_ADDR, 0, 1000);
+    RpcRegister(METHOD_ECHO, echoHandler);
+    RpcRegister(METHOD_FAIL, failHandler);
+    RpcRegister(METHOD_BIG, bigHandler);
+
+    scenarioRoundtrip();
+    scenarioPoll();
+    scenarioStatus();
+    scenarioFull();
+    scenarioTimeout();
+    scenarioCancel();
+    scenarioOverflow();
+    scenarioReentrant();
+
+    printf("%u checks, %u failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
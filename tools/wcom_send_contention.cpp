@@ -0,0 +1,211 @@
+/**
+ * @file wcom_send_contention.cpp
+ * @brief 他のタスクが送信経路を使用中のときの振る舞いを確かめる PC側ツール
+ * @details
+ * 別スレッドが SendTryLock() で送信経路の排他を取ったまま保持し、その間に次を確かめる。
+ *
+ * - PublisherService() が待たずに Status::Busy を返し、送信失敗（failed・lockBusy）として数える
+ * - 変換済みのフレームを送信待ちのまま残し、排他が返された後の周期で変換し直さずに送る
+ * - SendPriorityPacket() が ROBO_WCOM_PRIORITY_SEND_WAIT_MS ほど待って Status::Busy を返し、
+ *   保留した優先パケット（呼び直した場合は最後のもの）を排他が返された後の送信で通常フレームより先に1度だけ送る
+ *
+ * 1つでも外れれば終了コード 1 を返す。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -pthread -I tools/host -I lib/ROBO_WCOM -I src -o wcom_send_contention \
+ *       tools/wcom_send_contention.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_send_contention
+ */
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Publisher.h"
+#include "ROBO_WCOM_Wire.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t PERIOD_US       = 10000;   ///< パブリッシャの送信周期
+constexpr long     NO_WAIT_MAX_MS  = 50;      ///< 待たずに戻ったとみなす経過時間の上限
+
+static const uint8_t OWN_ADDR[6]  = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+
+static uint32_t sentFrames = 0;                     ///< 送信されたフレーム数
+static uint8_t  sentTypes[8];                       ///< 送信されたフレームの先頭バイト（先頭から8つ）
+static uint8_t  sentFirstData[8];                   ///< 送信されたデータフレームの搬送データ先頭バイト
+static uint8_t  sentFrame[Wire::MAX_FRAME_SIZE];    ///< 最後に送信したフレーム
+static size_t   sentLength = 0;                     ///< sentFrame の長さ
+static uint32_t encodeCalls = 0;                    ///< 変換の呼び出し回数
+static int      failures = 0;                       ///< 外れた確認の数
+
+/**
+ * @brief esp_now_send() のフック
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    memcpy(sentFrame, data, len);
+    sentLength = len;
+    if (sentFrames < sizeof(sentTypes))
+    {
+        sentTypes[sentFrames] = data[0];
+        sentFirstData[sentFrames] = (len > Wire::DATA_OFFSET_CARRIED) ? data[Wire::DATA_OFFSET_CARRIED] : 0;
+    }
+    sentFrames++;
+}
+
+/**
+ * @brief 呼ばれた回数を先頭に付ける変換（変換し直したかを送信フレームから判別する）
+ */
+static uint8_t countingEncoder(const uint8_t* data, uint8_t size, uint8_t* out)
+{
+    encodeCalls++;
+    out[0] = static_cast<uint8_t>(encodeCalls);
+    memcpy(out + 1, data, size);
+    return static_cast<uint8_t>(size + 1);
+}
+
+/**
+ * @brief 確認結果を表示し、外れた数を数える
+ */
+static void expect(bool ok, const char* what)
+{
+    printf("  %-52s %s\n", what, ok ? "ok" : "NG");
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+/**
+ * @brief 送信経路の排他を別スレッドで保持する
+ */
+class LockHolder
+{
+public:
+    LockHolder() : held(false), release(false), thread(&LockHolder::run, this)
+    {
+        while (!held.load())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    ~LockHolder()
+    {
+        release.store(true);
+        thread.join();
+    }
+
+private:
+    void run(void)
+    {
+        while (!SendTryLock(0))
+        {
+            std::this_thread::yield();
+        }
+        held.store(true);
+        while (!release.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        SendUnlock();
+    }
+
+    std::atomic<bool> held;
+    std::atomic<bool> release;
+    std::thread thread;
+};
+
+/**
+ * @brief パブリッシャが送信経路の排他を待たないことを確かめる
+ */
+static void checkPublisher(void)
+{
+    printf("publisher\n");
+    const uint8_t data[4] = { 0x11, 0x22, 0x33, 0x44 };
+    uint32_t now = 0;
+    PublisherSetEncoder(countingEncoder);
+    PublisherStart(PERIOD_US, 0);
+    PublisherUpdate(data, sizeof(data));
+
+    PublisherStats stats{};
+    {
+        LockHolder holder;
+        auto start = std::chrono::steady_clock::now();
+        Status s = PublisherService(now);
+        long elapsedMs = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        GetPublisherStats(&stats);
+        expect(s == Status::Busy, "service returns Busy while the lock is held");
+        expect(elapsedMs < NO_WAIT_MAX_MS, "service does not wait for the lock");
+        expect(stats.failed == 1 && stats.lockBusy == 1, "counted as a failure (failed, lockBusy)");
+        expect(sentFrames == 0, "nothing sent while the lock is held");
+        now += PERIOD_US;
+        PublisherService(now);
+        GetPublisherStats(&stats);
+        expect(stats.lockBusy == 2 && encodeCalls == 1, "encoded frame kept, not re-encoded");
+    }
+
+    now += PERIOD_US;
+    Status s = PublisherService(now);
+    GetPublisherStats(&stats);
+    size_t body = Wire::LEGACY_OFFSET_CARRIED;
+    expect(s == Status::Ok && stats.sent == 1 && sentFrames == 1, "sent on the next period after release");
+    expect(encodeCalls == 1 && sentLength > body + sizeof(data) && sentFrame[body] == 1 &&
+           memcmp(sentFrame + body + 1, data, sizeof(data)) == 0, "the frame sent is the one encoded first");
+    PublisherStop();
+    PublisherSetEncoder(nullptr);
+}
+
+/**
+ * @brief 優先送信が送信経路の排他を待ちきれない場合に保留することを確かめる
+ */
+static void checkPriority(void)
+{
+    printf("priority\n");
+    const uint8_t first[2] = { 0xA1, 0x01 };
+    const uint8_t latest[2] = { 0xA2, 0x02 };
+    const uint8_t normal[2] = { 0x5A, 0x03 };
+    SetFrameFormat(FrameFormat::Compact);
+    sentFrames = 0;
+    {
+        LockHolder holder;
+        auto start = std::chrono::steady_clock::now();
+        Status s = SendPriorityPacket(1, first, sizeof(first));
+        long elapsedMs = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        expect(s == Status::Busy, "returns Busy while the lock is held");
+        expect(elapsedMs + 1 >= static_cast<long>(ROBO_WCOM_PRIORITY_SEND_WAIT_MS) && elapsedMs < NO_WAIT_MAX_MS,
+               "waits no longer than ROBO_WCOM_PRIORITY_SEND_WAIT_MS");
+        expect(SendPriorityPacket(2, latest, sizeof(latest)) == Status::Busy, "a second call is kept as well");
+        expect(sentFrames == 0, "nothing sent while the lock is held");
+    }
+
+    Status s = SendPacket(3, normal, sizeof(normal));
+    expect(s == Status::Ok && sentFrames == 2, "next send transmits two frames");
+    expect(sentTypes[0] == static_cast<uint8_t>(Wire::FrameType::Priority) && sentFirstData[0] == latest[0],
+           "the latest priority packet goes out first");
+    expect(sentTypes[1] == static_cast<uint8_t>(Wire::FrameType::Data) && sentFirstData[1] == normal[0],
+           "the normal packet follows it");
+    SendPacket(4, normal, sizeof(normal));
+    expect(sentFrames == 3 && sentTypes[2] == static_cast<uint8_t>(Wire::FrameType::Data),
+           "the priority packet is sent only once");
+}
+
+int main()
+{
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(OWN_ADDR, PEER_ADDR, millis(), 1000);
+
+    checkPublisher();
+    checkPriority();
+
+    printf("%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
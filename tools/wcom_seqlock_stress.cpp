@@ -0,0 +1,180 @@
+/**
+ * @file wcom_seqlock_stress.cpp
+ * @brief PeekLatestPacketFromISR() が書き込み途中の控えを返さないかを確かめる PC側ツール
+ * @details
+ * 書き込みスレッドが SendPacket() で組み立てたフレームを InjectFrame() で受信させ続け、
+ * 読み出しスレッドが待たずに PeekLatestPacketFromISR() を呼び続ける。
+ * 書き込み側は一定数ごとに FlushBuffer() も呼び、控えを無効にする書き込みも混ぜる。
+ *
+ * フレーム k は搬送データサイズが 1 + k % CARRIED_DATA_MAX_SIZE、搬送データの全バイトが k の下位8ビット。
+ * Status::Ok で読めたものについて次を確かめ、1つでも外れれば終了コード 1 を返す。
+ *
+ * - タイムスタンプ・サイズ・搬送データが同じフレームのものである（2つの控えが混ざっていない）
+ * - タイムスタンプが前回読めたものより戻らない
+ *
+ * 読み出しが1度も Status::Ok にならなかった場合も失敗とする。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -pthread -I tools/host -I lib/ROBO_WCOM -I src -o wcom_seqlock_stress \
+ *       tools/wcom_seqlock_stress.cpp tools/host/host_shim.cpp lib/ROBO_WCOM/ROBO_WCOM*.cpp
+ * 使い方:
+ *   wcom_seqlock_stress [--frames 書き込むフレーム数=300000]
+ */
+#include <Arduino.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "ROBO_WCOM.h"
+#include "ROBO_WCOM_Wire.h"
+
+using namespace ROBO_WCOM;
+
+constexpr uint32_t FLUSH_EVERY = 1000;  ///< この数ごとに FlushBuffer() を呼ぶ
+
+static const uint8_t OWN_ADDR[6]  = { 0x02, 0, 0, 0, 0, 0x01 };
+static const uint8_t PEER_ADDR[6] = { 0x02, 0, 0, 0, 0, 0x02 };
+
+static uint8_t  sentFrame[Wire::MAX_FRAME_SIZE];    ///< 最後に送信したフレーム（書き込みスレッドだけが触る）
+static size_t   sentLength = 0;                     ///< sentFrame の長さ
+
+/**
+ * @brief 読み出し側の集計
+ */
+struct ReadStats {
+    uint32_t ok;        ///< Status::Ok で読めた回数
+    uint32_t busy;      ///< Status::Busy の回数
+    uint32_t empty;     ///< Status::BufferEmpty の回数
+    uint32_t torn;      ///< 内容が食い違っていた回数
+    uint32_t backward;  ///< タイムスタンプが戻った回数
+};
+
+/**
+ * @brief esp_now_send() のフック。送信フレームを写す
+ */
+static void onSend(const uint8_t*, const uint8_t* data, size_t len)
+{
+    memcpy(sentFrame, data, len);
+    sentLength = len;
+}
+
+/**
+ * @brief フレーム k の搬送データサイズ
+ */
+static uint8_t frameSize(uint32_t k)
+{
+    return static_cast<uint8_t>(1 + k % CARRIED_DATA_MAX_SIZE);
+}
+
+/**
+ * @brief 書き込みスレッド
+ */
+static void writer(uint32_t frames, std::atomic<bool>& done)
+{
+    uint8_t payload[CARRIED_DATA_MAX_SIZE];
+    for (uint32_t k = 1; k <= frames; ++k)
+    {
+        memset(payload, static_cast<uint8_t>(k), sizeof(payload));
+        sentLength = 0;
+        SendPacket(k, payload, frameSize(k));
+        if (sentLength > 0)
+        {
+            InjectFrame(sentFrame, static_cast<int>(sentLength));
+        }
+        if (k % FLUSH_EVERY == 0)
+        {
+            FlushBuffer();
+        }
+    }
+    done.store(true);
+}
+
+/**
+ * @brief 読み出しスレッド
+ */
+static void reader(const std::atomic<bool>& done, ReadStats& stats)
+{
+    uint32_t last = 0;
+    uint32_t ts;
+    uint8_t addr[6];
+    uint8_t data[CARRIED_DATA_MAX_SIZE];
+    uint8_t size;
+    while (!done.load())
+    {
+        Status s = PeekLatestPacketFromISR(millis(), &ts, addr, data, &size);
+        if (s == Status::Busy)
+        {
+            stats.busy++;
+            continue;
+        }
+        if (s == Status::BufferEmpty)
+        {
+            stats.empty++;
+            continue;
+        }
+        if (s != Status::Ok)
+        {
+            continue;
+        }
+        stats.ok++;
+        bool consistent = (size == frameSize(ts)) && memcmp(addr, PEER_ADDR, sizeof(addr)) == 0;
+        for (uint8_t i = 0; consistent && i < size; ++i)
+        {
+            consistent = (data[i] == static_cast<uint8_t>(ts));
+        }
+        if (!consistent)
+        {
+            if (stats.torn == 0)
+            {
+                printf("torn read: timestamp %u, size %u, data[0] %u\n", ts, size, data[0]);
+            }
+            stats.torn++;
+        }
+        if (ts < last)
+        {
+            stats.backward++;
+        }
+        last = ts;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 300000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--frames") == 0)
+        {
+            frames = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--frames N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames == 0)
+    {
+        fprintf(stderr, "frames must be >= 1\n");
+        return 2;
+    }
+
+    // 受信側から見た送信元が通信相手になるよう、相手のアドレスで送る
+    HostShim::SetMicros(0);
+    HostShim::SetSendHook(onSend);
+    Init(PEER_ADDR, OWN_ADDR, millis(), 1000);
+
+    std::atomic<bool> done(false);
+    ReadStats stats{};
+    std::thread readThread(reader, std::cref(done), std::ref(stats));
+    std::thread writeThread(writer, frames, std::ref(done));
+    writeThread.join();
+    readThread.join();
+
+    printf("frames %u: ok %u, busy %u, empty %u, torn %u, backward %u\n",
+           frames, stats.ok, stats.busy, stats.empty, stats.torn, stats.backward);
+    bool ok = stats.ok > 0 && stats.torn == 0 && stats.backward == 0;
+    printf("consistent: %s\n", ok ? "yes" : "NO");
+    return ok ? 0 : 1;
+}
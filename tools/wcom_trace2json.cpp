@@ -0,0 +1,689 @@
+/**
+ * @file wcom_trace2json.cpp
+ * @brief トレースのダンプ（ROBO_WCOM_Trace.h）を Chrome / Perfetto のトレース形式（JSON）へ変換する PC側ツール
+ * @details
+ * ノードごとのダンプ（シリアルログにテキストと混在してよい）を読み、次を標準出力へ書き出す。
+ *
+ * - ノードごとのプロセスに、記録したイベントを瞬間イベントとして並べる（スレッドは記録したコア）
+ * - "latency" プロセスに、フレームごとの入力から反映までを段階に分けた区間として並べる
+ *   （queue: Update→SendPacket / encode: →esp_now_send / air: →相手の受信（無線ドライバの送信待ちを含む） / push: →受信バッファ /
+ *     buffer: →Pop・Peek / handoff: →利用側への反映）
+ *
+ * 標準エラーへは、送信元ノードごと・段階ごとの平均・中央値・最大を表示する。
+ *
+ * ノード間で時計は揃っていないため、同じフレームの送信完了（送信側）と受信（受信側）はほぼ同時に起きるとみなし、
+ * その差の中央値を時計のずれとして補正する。両方向の中央値を平均するので、ACK の時間による偏りはおおむね打ち消される。
+ * 1つ目のファイルの時計を基準にする（--no-align で補正しない）。
+ * 1ファイルに複数のダンプがあれば順につなげる（繰り返しダンプする場合は毎回 TraceClear() すること）。
+ * 出力は chrome://tracing または https://ui.perfetto.dev で開く。
+ *
+ * ビルド:
+ *   g++ -std=c++11 -O2 -I lib/ROBO_WCOM -o wcom_trace2json tools/wcom_trace2json.cpp
+ * 使い方:
+ *   wcom_trace2json [--no-align] [--label 名前]... ダンプファイル... > trace.json
+ */
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "ROBO_WCOM_Codec.h"
+#include "ROBO_WCOM_TraceFormat.h"
+
+using namespace ROBO_WCOM;
+
+constexpr int64_t MATCH_TOLERANCE_US = 5000;      ///< 時計のずれの補正誤差として許す時間
+constexpr int64_t MATCH_WINDOW_US    = 1000000;   ///< 同じ識別子を同じフレームとみなす時間
+constexpr uint8_t FRAME_TYPE_UNKNOWN = 0xFF;      ///< フレーム種別を持たないイベント
+
+/**
+ * @brief 読み込んだイベント
+ */
+struct Event {
+    int64_t  time;       ///< 時刻（µs。桁あふれを展開し、時計のずれを補正した値）
+    uint32_t id;         ///< 識別子（SendDone は対応する送信から補う）
+    uint32_t aux;        ///< 補足
+    uint8_t  type;       ///< イベント（Trace::Event）
+    uint8_t  core;       ///< 記録したコア
+    uint8_t  frameType;  ///< フレーム種別（EspNowSend / SendDone / Recv のみ）
+};
+
+/**
+ * @brief 1ノード分（1ファイル）のトレース
+ */
+struct Node {
+    std::string label;                                  ///< 表示名
+    std::vector<Event> events;                          ///< イベント
+    std::map<uint64_t, std::vector<size_t>> index;      ///< (イベント, 識別子) → events の添字
+    uint32_t dropped = 0;                               ///< 欠落イベント数
+    uint32_t lastRaw = 0;                               ///< 直前の時刻（桁あふれの検出用）
+    int64_t  wrapBase = 0;                              ///< 桁あふれで加える値
+};
+
+/**
+ * @brief 段階
+ */
+enum Stage {
+    STAGE_QUEUE,
+    STAGE_ENCODE,
+    STAGE_AIR,
+    STAGE_PUSH,
+    STAGE_BUFFER,
+    STAGE_HANDOFF,
+    STAGE_COUNT
+};
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = { "queue", "encode", "air", "push", "buffer", "handoff" };
+
+/**
+ * @brief フレーム1つ分の入力から反映までの時刻
+ */
+struct Chain {
+    size_t   source;                    ///< 送信元ノード
+    uint32_t id;                        ///< 識別子
+    int64_t  start;                     ///< 開始時刻（Update があればその時刻）
+    int64_t  marks[STAGE_COUNT];        ///< 各段階の終了時刻（-1 は未到達）
+};
+
+/**
+ * @brief イベントの表示名
+ */
+static const char* eventName(uint8_t type)
+{
+    switch (static_cast<Trace::Event>(type))
+    {
+    case Trace::Event::Update:     return "Update";
+    case Trace::Event::Publish:    return "Publish";
+    case Trace::Event::SendPacket: return "SendPacket";
+    case Trace::Event::EspNowSend: return "EspNowSend";
+    case Trace::Event::SendDone:   return "SendDone";
+    case Trace::Event::Recv:       return "Recv";
+    case Trace::Event::Push:       return "Push";
+    case Trace::Event::Pop:        return "Pop";
+    case Trace::Event::Peek:       return "Peek";
+    case Trace::Event::Handoff:    return "Handoff";
+    default:                       return (type >= static_cast<uint8_t>(Trace::Event::User)) ? "User" : "Unknown";
+    }
+}
+
+/**
+ * @brief 索引のキー
+ */
+static uint64_t indexKey(Trace::Event type, uint32_t id)
+{
+    return (static_cast<uint64_t>(type) << 32) | id;
+}
+
+/**
+ * @brief 1ダンプ分を読み込む
+ * @param data   ダンプ先頭（マジック位置）
+ * @param remain data 以降のバイト数
+ * @param node   格納先
+ * @return 消費したバイト数（不正なヘッダなら 0）
+ */
+static size_t parseDump(const uint8_t* data, size_t remain, Node& node)
+{
+    if (remain < Trace::FILE_HEADER_SIZE)
+    {
+        return 0;
+    }
+    uint16_t version    = Codec::loadLE16(data + Trace::HEADER_OFFSET_VERSION);
+    uint16_t recordSize = Codec::loadLE16(data + Trace::HEADER_OFFSET_RECORD_SIZE);
+    uint32_t count      = Codec::loadLE32(data + Trace::HEADER_OFFSET_COUNT);
+    uint32_t dropped    = Codec::loadLE32(data + Trace::HEADER_OFFSET_DROPPED);
+    if (version != Trace::VERSION || recordSize != Trace::RECORD_SIZE)
+    {
+        fprintf(stderr, "%s: unsupported version %u / record size %u\n", node.label.c_str(), version, recordSize);
+        return 0;
+    }
+
+    size_t available = (remain - Trace::FILE_HEADER_SIZE) / recordSize;
+    if (available < count)
+    {
+        fprintf(stderr, "%s: truncated (%zu of %u records)\n", node.label.c_str(), available, count);
+        count = static_cast<uint32_t>(available);
+    }
+    node.dropped += dropped;
+
+    const uint8_t* rec = data + Trace::FILE_HEADER_SIZE;
+    for (uint32_t i = 0; i < count; ++i, rec += recordSize)
+    {
+        if (rec[Trace::RECORD_OFFSET_EVENT] == static_cast<uint8_t>(Trace::Event::None))
+        {
+            continue;
+        }
+        uint32_t raw = Codec::loadLE32(rec + Trace::RECORD_OFFSET_TIME_MICROS);
+        // micros() は約71分で一周する
+        if (!node.events.empty() && raw < node.lastRaw && node.lastRaw - raw > 0x80000000u)
+        {
+            node.wrapBase += 0x100000000LL;
+        }
+        node.lastRaw = raw;
+
+        Event ev;
+        ev.time = node.wrapBase + raw;
+        ev.id = Codec::loadLE32(rec + Trace::RECORD_OFFSET_ID);
+        ev.aux = Codec::loadLE32(rec + Trace::RECORD_OFFSET_AUX);
+        ev.type = rec[Trace::RECORD_OFFSET_EVENT];
+        ev.core = rec[Trace::RECORD_OFFSET_CORE];
+        ev.frameType = FRAME_TYPE_UNKNOWN;
+        if (ev.type == static_cast<uint8_t>(Trace::Event::EspNowSend))
+        {
+            ev.frameType = static_cast<uint8_t>(ev.aux >> 8);
+        }
+        else if (ev.type == static_cast<uint8_t>(Trace::Event::Recv))
+        {
+            ev.frameType = static_cast<uint8_t>(ev.aux >> 16);
+        }
+        node.events.push_back(ev);
+    }
+    return Trace::FILE_HEADER_SIZE + static_cast<size_t>(count) * recordSize;
+}
+
+/**
+ * @brief ファイルを読み込み、見つかったダンプをすべて node へ格納
+ * @return 見つかったダンプ数（開けなければ -1）
+ */
+static int loadNode(const char* path, Node& node)
+{
+    FILE* in = fopen(path, "rb");
+    if (!in)
+    {
+        perror(path);
+        return -1;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(in);
+
+    int dumps = 0;
+    size_t pos = 0;
+    while (pos + sizeof(Trace::MAGIC) <= data.size())
+    {
+        if (memcmp(&data[pos], Trace::MAGIC, sizeof(Trace::MAGIC)) != 0)
+        {
+            pos++;
+            continue;
+        }
+        size_t used = parseDump(&data[pos], data.size() - pos, node);
+        if (used == 0)
+        {
+            pos++;
+            continue;
+        }
+        dumps++;
+        pos += used;
+    }
+    return dumps;
+}
+
+/**
+ * @brief 送信完了に識別子とフレーム種別を補う
+ * @details 送信完了は受け付けられた送信（EspNowSend の補足が 1）と同じ順で通知される
+ */
+static void pairSendDone(Node& node)
+{
+    std::deque<size_t> accepted;
+    for (size_t i = 0; i < node.events.size(); ++i)
+    {
+        Event& ev = node.events[i];
+        if (ev.type == static_cast<uint8_t>(Trace::Event::EspNowSend) && (ev.aux & 1))
+        {
+            accepted.push_back(i);
+        }
+        else if (ev.type == static_cast<uint8_t>(Trace::Event::SendDone) && !accepted.empty())
+        {
+            const Event& send = node.events[accepted.front()];
+            accepted.pop_front();
+            ev.id = send.id;
+            ev.frameType = send.frameType;
+        }
+    }
+}
+
+/**
+ * @brief (イベント, 識別子) の索引を作る
+ */
+static void buildIndex(Node& node)
+{
+    node.index.clear();
+    for (size_t i = 0; i < node.events.size(); ++i)
+    {
+        const Event& ev = node.events[i];
+        node.index[indexKey(static_cast<Trace::Event>(ev.type), ev.id)].push_back(i);
+    }
+}
+
+/**
+ * @brief from 以降で最初に起きた、指定のイベント・識別子（・フレーム種別）のイベント
+ * @return 見つからなければ nullptr
+ */
+static const Event* findAfter(const Node& node, Trace::Event type, uint32_t id, int64_t from,
+                              uint8_t frameType = FRAME_TYPE_UNKNOWN)
+{
+    auto it = node.index.find(indexKey(type, id));
+    if (it == node.index.end())
+    {
+        return nullptr;
+    }
+    const Event* best = nullptr;
+    for (size_t i : it->second)
+    {
+        const Event& ev = node.events[i];
+        if (ev.time < from || ev.time > from + MATCH_WINDOW_US)
+        {
+            continue;
+        }
+        if (frameType != FRAME_TYPE_UNKNOWN && ev.frameType != frameType)
+        {
+            continue;
+        }
+        if (!best || ev.time < best->time)
+        {
+            best = &ev;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief until 以前で最後に起きた、指定のイベント・識別子のイベント
+ * @return 見つからなければ nullptr
+ */
+static const Event* findBefore(const Node& node, Trace::Event type, uint32_t id, int64_t until)
+{
+    auto it = node.index.find(indexKey(type, id));
+    if (it == node.index.end())
+    {
+        return nullptr;
+    }
+    const Event* best = nullptr;
+    for (size_t i : it->second)
+    {
+        const Event& ev = node.events[i];
+        if (ev.time > until || ev.time < until - MATCH_WINDOW_US)
+        {
+            continue;
+        }
+        if (!best || ev.time > best->time)
+        {
+            best = &ev;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 中央値（values は並べ替える）
+ */
+static int64_t median(std::vector<int64_t>& values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+/**
+ * @brief sender の送信完了と receiver の受信の時刻差（sender - receiver）を集める
+ */
+static std::vector<int64_t> completionGaps(const Node& sender, const Node& receiver)
+{
+    std::vector<int64_t> gaps;
+    for (const Event& done : sender.events)
+    {
+        if (done.type != static_cast<uint8_t>(Trace::Event::SendDone) || !(done.aux & 1)
+            || done.frameType == FRAME_TYPE_UNKNOWN || done.id == 0)
+        {
+            continue;
+        }
+        auto it = receiver.index.find(indexKey(Trace::Event::Recv, done.id));
+        if (it == receiver.index.end())
+        {
+            continue;
+        }
+        for (size_t i : it->second)
+        {
+            if (receiver.events[i].frameType == done.frameType)
+            {
+                gaps.push_back(done.time - receiver.events[i].time);
+                break;
+            }
+        }
+    }
+    return gaps;
+}
+
+/**
+ * @brief node の時計を基準ノードへ合わせるずれを求める
+ * @param offset 求めたずれ（node の時刻に足す）
+ * @return 求められたか
+ */
+static bool estimateOffset(const Node& reference, const Node& node, int64_t* offset)
+{
+    // reference → node: reference の送信完了 ≒ node の受信 + offset
+    std::vector<int64_t> forward = completionGaps(reference, node);
+    // node → reference: reference の受信 ≒ node の送信完了 + offset
+    std::vector<int64_t> backward = completionGaps(node, reference);
+    for (int64_t& gap : backward)
+    {
+        gap = -gap;
+    }
+    if (forward.empty() && backward.empty())
+    {
+        return false;
+    }
+    if (forward.empty())
+    {
+        *offset = median(backward);
+    }
+    else if (backward.empty())
+    {
+        *offset = median(forward);
+    }
+    else
+    {
+        *offset = (median(forward) + median(backward)) / 2;
+    }
+    fprintf(stderr, "%s: clock offset %+lld us (%zu + %zu samples)\n", node.label.c_str(),
+            static_cast<long long>(*offset), forward.size(), backward.size());
+    return true;
+}
+
+/**
+ * @brief 送信元ノードの SendPacket ごとに、相手ノードでの反映までをたどる
+ * @param lost 相手で受信が見つからなかった数の格納先（ノードごと）
+ */
+static std::vector<Chain> traceChains(const std::vector<Node>& nodes, std::vector<uint32_t>& lost)
+{
+    std::vector<Chain> chains;
+    lost.assign(nodes.size(), 0);
+    for (size_t s = 0; s < nodes.size(); ++s)
+    {
+        const Node& src = nodes[s];
+        for (const Event& sp : src.events)
+        {
+            if (sp.type != static_cast<uint8_t>(Trace::Event::SendPacket))
+            {
+                continue;
+            }
+            const Event* send = findAfter(src, Trace::Event::EspNowSend, sp.id, sp.time);
+            if (!send || !(send->aux & 1))
+            {
+                continue;
+            }
+
+            Chain chain;
+            chain.source = s;
+            chain.id = sp.id;
+            chain.start = sp.time;
+            for (int64_t& mark : chain.marks)
+            {
+                mark = -1;
+            }
+            const Event* publish = findBefore(src, Trace::Event::Publish, sp.id, sp.time);
+            const Event* update = publish ? findBefore(src, Trace::Event::Update, publish->aux, publish->time) : nullptr;
+            if (update)
+            {
+                chain.start = update->time;
+                chain.marks[STAGE_QUEUE] = sp.time;
+            }
+            chain.marks[STAGE_ENCODE] = send->time;
+
+            const Event* recv = nullptr;
+            const Node* dst = nullptr;
+            for (size_t r = 0; r < nodes.size() && !recv; ++r)
+            {
+                if (r != s)
+                {
+                    recv = findAfter(nodes[r], Trace::Event::Recv, sp.id, send->time - MATCH_TOLERANCE_US,
+                                     send->frameType);
+                    dst = &nodes[r];
+                }
+            }
+            if (!recv)
+            {
+                lost[s]++;
+                continue;
+            }
+            chain.marks[STAGE_AIR] = recv->time;
+            const Event* push = findAfter(*dst, Trace::Event::Push, sp.id, recv->time);
+            if (push)
+            {
+                chain.marks[STAGE_PUSH] = push->time;
+                const Event* pop = findAfter(*dst, Trace::Event::Pop, sp.id, push->time);
+                const Event* peek = findAfter(*dst, Trace::Event::Peek, sp.id, push->time);
+                const Event* taken = (pop && (!peek || pop->time <= peek->time)) ? pop : peek;
+                if (taken)
+                {
+                    chain.marks[STAGE_BUFFER] = taken->time;
+                    const Event* handoff = findAfter(*dst, Trace::Event::Handoff, sp.id, taken->time);
+                    if (handoff)
+                    {
+                        chain.marks[STAGE_HANDOFF] = handoff->time;
+                    }
+                }
+            }
+            chains.push_back(chain);
+        }
+    }
+    return chains;
+}
+
+static bool firstEntry = true;  ///< traceEvents の最初の要素か
+
+/**
+ * @brief traceEvents の要素を1つ書き出す
+ */
+static void emit(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void emit(const char* fmt, ...)
+{
+    printf(firstEntry ? "\n" : ",\n");
+    firstEntry = false;
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+/**
+ * @brief 送信元ノードごと・段階ごとの統計を表示
+ */
+static void printSummary(const std::vector<Node>& nodes, const std::vector<Chain>& chains,
+                         const std::vector<uint32_t>& lost)
+{
+    for (size_t s = 0; s < nodes.size(); ++s)
+    {
+        std::vector<int64_t> durations[STAGE_COUNT + 1];
+        for (const Chain& chain : chains)
+        {
+            if (chain.source != s)
+            {
+                continue;
+            }
+            int64_t prev = chain.start;
+            for (int st = 0; st < STAGE_COUNT; ++st)
+            {
+                if (chain.marks[st] < 0)
+                {
+                    continue;
+                }
+                durations[st].push_back(chain.marks[st] - prev);
+                prev = chain.marks[st];
+            }
+            durations[STAGE_COUNT].push_back(prev - chain.start);
+        }
+        if (durations[STAGE_COUNT].empty())
+        {
+            continue;
+        }
+        fprintf(stderr, "\nfrom %s: %zu frames traced, %u not received\n", nodes[s].label.c_str(),
+                durations[STAGE_COUNT].size(), lost[s]);
+        fprintf(stderr, "%-8s %7s %9s %9s %9s\n", "stage", "count", "mean_ms", "med_ms", "max_ms");
+        for (int st = 0; st <= STAGE_COUNT; ++st)
+        {
+            std::vector<int64_t>& d = durations[st];
+            if (d.empty())
+            {
+                continue;
+            }
+            int64_t sum = 0;
+            for (int64_t v : d)
+            {
+                sum += v;
+            }
+            int64_t med = median(d);
+            fprintf(stderr, "%-8s %7zu %9.3f %9.3f %9.3f\n", st < STAGE_COUNT ? STAGE_NAMES[st] : "total",
+                    d.size(), sum / 1000.0 / d.size(), med / 1000.0, d.back() / 1000.0);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool align = true;
+    std::vector<std::string> labels;
+    std::vector<Node> nodes;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--no-align") == 0)
+        {
+            align = false;
+        }
+        else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+        {
+            labels.push_back(argv[++i]);
+        }
+        else if (argv[i][0] == '-')
+        {
+            fprintf(stderr, "usage: %s [--no-align] [--label name]... dump...\n", argv[0]);
+            return 2;
+        }
+        else
+        {
+            nodes.emplace_back();
+            Node& node = nodes.back();
+            node.label = (labels.size() >= nodes.size()) ? labels[nodes.size() - 1] : argv[i];
+            int dumps = loadNode(argv[i], node);
+            if (dumps < 0)
+            {
+                return 1;
+            }
+            fprintf(stderr, "%s: %d dumps, %zu events, %u overwritten\n", node.label.c_str(), dumps,
+                    node.events.size(), node.dropped);
+            if (dumps == 0)
+            {
+                fprintf(stderr, "%s: no trace dump found\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+    if (nodes.empty())
+    {
+        fprintf(stderr, "usage: %s [--no-align] [--label name]... dump...\n", argv[0]);
+        return 2;
+    }
+
+    for (Node& node : nodes)
+    {
+        pairSendDone(node);
+        buildIndex(node);
+    }
+    for (size_t k = 1; align && k < nodes.size(); ++k)
+    {
+        int64_t offset = 0;
+        if (!estimateOffset(nodes[0], nodes[k], &offset))
+        {
+            fprintf(stderr, "%s: no frames in common with %s, clock not aligned\n",
+                    nodes[k].label.c_str(), nodes[0].label.c_str());
+            continue;
+        }
+        for (Event& ev : nodes[k].events)
+        {
+            ev.time += offset;
+        }
+    }
+
+    std::vector<uint32_t> lost;
+    std::vector<Chain> chains = traceChains(nodes, lost);
+
+    // 表示は最も早いイベントを 0 にする
+    int64_t origin = INT64_MAX;
+    for (const Node& node : nodes)
+    {
+        for (const Event& ev : node.events)
+        {
+            origin = std::min(origin, ev.time);
+        }
+    }
+
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"latency\"}}");
+    for (size_t n = 0; n < nodes.size(); ++n)
+    {
+        const Node& node = nodes[n];
+        int pid = static_cast<int>(n) + 1;
+        // 表示名は JSON の文字列へそのまま埋め込むため、引用符とバックスラッシュは置き換える
+        std::string name = node.label;
+        std::replace(name.begin(), name.end(), '"', '\'');
+        std::replace(name.begin(), name.end(), '\\', '/');
+        emit("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"%s\"}}",
+             pid, name.c_str());
+        bool cores[256] = {};
+        for (const Event& ev : node.events)
+        {
+            if (!cores[ev.core])
+            {
+                cores[ev.core] = true;
+                emit("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"core %u\"}}",
+                     pid, ev.core, ev.core);
+            }
+            emit("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":%d,\"tid\":%u,"
+                 "\"args\":{\"id\":%u,\"aux\":%u}}",
+                 eventName(ev.type), static_cast<long long>(ev.time - origin), pid, ev.core, ev.id, ev.aux);
+        }
+    }
+    for (size_t c = 0; c < chains.size(); ++c)
+    {
+        const Chain& chain = chains[c];
+        // 時計の補正誤差で前後した段階は長さ 0 として表示する
+        int64_t prev = chain.start;
+        int64_t end = chain.start;
+        for (int64_t mark : chain.marks)
+        {
+            end = std::max(end, mark);
+        }
+        emit("{\"name\":\"frame %u\",\"cat\":\"latency\",\"ph\":\"b\",\"id\":%zu,\"ts\":%lld,\"pid\":0,\"tid\":%zu,"
+             "\"args\":{\"from\":%zu,\"total_us\":%lld}}",
+             chain.id, c, static_cast<long long>(chain.start - origin), chain.source + 1, chain.source + 1,
+             static_cast<long long>(end - chain.start));
+        for (int st = 0; st < STAGE_COUNT; ++st)
+        {
+            if (chain.marks[st] < 0)
+            {
+                continue;
+            }
+            int64_t mark = std::max(prev, chain.marks[st]);
+            emit("{\"name\":\"%s\",\"cat\":\"latency\",\"ph\":\"b\",\"id\":%zu,\"ts\":%lld,\"pid\":0,\"tid\":%zu}",
+                 STAGE_NAMES[st], c, static_cast<long long>(prev - origin), chain.source + 1);
+            emit("{\"name\":\"%s\",\"cat\":\"latency\",\"ph\":\"e\",\"id\":%zu,\"ts\":%lld,\"pid\":0,\"tid\":%zu}",
+                 STAGE_NAMES[st], c, static_cast<long long>(mark - origin), chain.source + 1);
+            prev = mark;
+        }
+        emit("{\"name\":\"frame %u\",\"cat\":\"latency\",\"ph\":\"e\",\"id\":%zu,\"ts\":%lld,\"pid\":0,\"tid\":%zu}",
+             chain.id, c, static_cast<long long>(end - origin), chain.source + 1);
+    }
+    printf("\n]}\n");
+
+    printSummary(nodes, chains, lost);
+    return 0;
+}